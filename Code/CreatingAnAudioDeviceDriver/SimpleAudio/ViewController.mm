@@ -44,6 +44,8 @@ loghandle(void) {
 @property io_object_t ioObject;
 @property io_connect_t ioConnection;
 @property (weak) IBOutlet NSTextField *userClientConnectionField;
+
+- (kern_return_t)updateParameters:(const SimpleAudioDriverParameterUpdate *)updates count:(size_t)count;
 @end
 
 @implementation ViewController
@@ -323,4 +325,28 @@ loghandle(void) {
 		_userClientConnectionField.stringValue = [NSString stringWithFormat:@"Failed to toggle device sample rate, error:%u.", error];
 	}
 }
+
+// Sends several parameter updates to the driver in a single call. The driver
+// validates the whole batch, then applies it together at its next buffer boundary.
+- (kern_return_t)updateParameters:(const SimpleAudioDriverParameterUpdate *)updates count:(size_t)count
+{
+	if (_ioConnection == IO_OBJECT_NULL)
+	{
+		_userClientConnectionField.stringValue = @"Cannot update parameters since user client is not connected.";
+		return kIOReturnNotOpen;
+	}
+	if (updates == nullptr || count == 0 || count > kSimpleAudioDriverMaxParameterUpdates)
+	{
+		return kIOReturnBadArgument;
+	}
+	
+	kern_return_t error = IOConnectCallStructMethod(_ioConnection,
+													static_cast<uint32_t>(SimpleAudioDriverExternalMethod_UpdateParameters),
+													updates, count * sizeof(SimpleAudioDriverParameterUpdate), nullptr, nullptr);
+	if (error != kIOReturnSuccess)
+	{
+		_userClientConnectionField.stringValue = [NSString stringWithFormat:@"Failed to update parameters, error:%u.", error];
+	}
+	return error;
+}
 @end
@@ -0,0 +1,100 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A bounded, lock-free queue that passes commands from any
+             number of threads to a single consumer.
+*/
+
+#ifndef SimpleAudioCommandQueue_h
+#define SimpleAudioCommandQueue_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A fixed-capacity multiple-producer, single-consumer queue. Push never blocks
+// and fails when the queue is full; Pop never blocks and fails when it's
+// empty. Each cell has a sequence number that tells producers whether the
+// cell is free and tells the consumer whether it holds a finished command, so
+// neither side takes a lock or allocates memory. Call Initialize before use.
+template <typename CommandType, size_t Capacity>
+class SimpleAudioCommandQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	void Initialize()
+	{
+		for (size_t i = 0; i < Capacity; i++)
+		{
+			__atomic_store_n(&m_cells[i].m_sequence, i, __ATOMIC_RELAXED);
+		}
+		__atomic_store_n(&m_enqueue_position, 0, __ATOMIC_RELAXED);
+		m_dequeue_position = 0;
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+
+	// Safe to call from any thread.
+	bool Push(const CommandType& in_command)
+	{
+		size_t position = __atomic_load_n(&m_enqueue_position, __ATOMIC_RELAXED);
+		Cell* cell = nullptr;
+		for (;;)
+		{
+			cell = &m_cells[position & (Capacity - 1)];
+			size_t sequence = __atomic_load_n(&cell->m_sequence, __ATOMIC_ACQUIRE);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (difference == 0)
+			{
+				// The cell is free; claim it by advancing the enqueue position.
+				if (__atomic_compare_exchange_n(&m_enqueue_position, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer hasn't freed this cell yet, so the queue is full.
+				return false;
+			}
+			else
+			{
+				// Another producer claimed this cell first.
+				position = __atomic_load_n(&m_enqueue_position, __ATOMIC_RELAXED);
+			}
+		}
+
+		cell->m_command = in_command;
+		__atomic_store_n(&cell->m_sequence, position + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	// Only call this from the consumer.
+	bool Pop(CommandType& out_command)
+	{
+		Cell* cell = &m_cells[m_dequeue_position & (Capacity - 1)];
+		size_t sequence = __atomic_load_n(&cell->m_sequence, __ATOMIC_ACQUIRE);
+		if (sequence != m_dequeue_position + 1)
+		{
+			return false;
+		}
+
+		out_command = cell->m_command;
+		__atomic_store_n(&cell->m_sequence, m_dequeue_position + Capacity, __ATOMIC_RELEASE);
+		m_dequeue_position += 1;
+		return true;
+	}
+
+private:
+	struct Cell
+	{
+		size_t		m_sequence;
+		CommandType	m_command;
+	};
+
+	Cell	m_cells[Capacity];
+	size_t	m_enqueue_position;
+	size_t	m_dequeue_position;
+};
+
+#endif /* SimpleAudioCommandQueue_h */
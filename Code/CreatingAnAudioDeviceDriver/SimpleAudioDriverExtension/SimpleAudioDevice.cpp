@@ -10,6 +10,13 @@ Implementation of an AudioDriverKit device that generates a
 #include "SimpleAudioDevice.h"
 #include "SimpleAudioDriver.h"
 #include "SimpleAudioDriverKeys.h"
+#include "SimpleAudioCommandQueue.h"
+#include "SimpleAudioParameterRamp.h"
+#include "SimpleAudioRingWriter.h"
+#include "SimpleAudioSampleClock.h"
+#include "SimpleAudioSampleConverter.h"
+#include "SimpleAudioSignalSource.h"
+#include "SimpleAudioTelemetry.h"
 
 // AudioDriverKit Includes
 #include <AudioDriverKit/AudioDriverKit.h>
@@ -21,17 +28,123 @@ Implementation of an AudioDriverKit device that generates a
 #define kSampleRate_1 44100.0
 #define kSampleRate_2 48000.0
 
+// The 44.1 kHz and 48 kHz families up to eight times the base rate.
+#define kNumSampleRates 8
+static const double k_sample_rates[kNumSampleRates] =
+{
+	kSampleRate_1, kSampleRate_2,
+	2 * kSampleRate_1, 2 * kSampleRate_2,
+	4 * kSampleRate_1, 4 * kSampleRate_2,
+	8 * kSampleRate_1, 8 * kSampleRate_2
+};
+
+// Returns how many times its family's base rate a sample rate is, so values
+// that are counted in frames can keep the same duration at every rate.
+static uint32_t SampleRateMultiple(double in_sample_rate)
+{
+	auto rate = llround(in_sample_rate);
+	auto base_rate = (rate % llround(kSampleRate_1) == 0) ? kSampleRate_1 : kSampleRate_2;
+	auto multiple = llround(in_sample_rate / base_rate);
+	return multiple > 0 ? static_cast<uint32_t>(multiple) : 1;
+}
+
 #define kToneGenerationBufferFrameSize 512
 
-#define kNumInputDataSources 2
+// How long a volume change takes to reach its new level, in seconds.
+#define kGainRampDuration 0.01
+
+#define kMinimumFillFrameSize 32
+#define kMaximumFillFrameSize 8192
+
+#define kNumInputDataSources 7
+
+#define kCommandQueueCapacity 64
+
+enum SimpleAudioDeviceCommand : uint32_t
+{
+	SimpleAudioDeviceCommand_ToggleDataSource,
+	SimpleAudioDeviceCommand_UpdateParameters
+};
+
+// A request from a user client or the driver that the device carries out on
+// its work queue. The object, client, and completion are retained while queued.
+struct SimpleAudioDeviceCommandEntry
+{
+	uint32_t		m_command;
+	uint64_t		m_argument;
+	OSObject*		m_object;
+	IOUserClient*	m_client;
+	OSAction*		m_completion;
+};
+
+// The tone's parameters as of the start of a fill. The controls are read once
+// per fill and the generator works only from this copy.
+struct SimpleAudioToneParameters
+{
+	float		m_gain;
+	double		m_frequency;
+	uint32_t	m_generator_type;
+};
+
+// What each input data source plays. The frequency only matters for sines.
+struct SimpleAudioDataSourceInfo
+{
+	IOUserAudioSelectorValue	m_value;
+	const char*					m_name;
+	uint32_t					m_generator_type;
+	double						m_frequency;
+};
+
+static const SimpleAudioDataSourceInfo k_data_source_info[kNumInputDataSources] =
+{
+	{ SimpleAudioDriverDataSource_Sine440, "Sine Tone 440", SimpleAudioDriverGeneratorType_Sine, 440.0 },
+	{ SimpleAudioDriverDataSource_Sine660, "Sine Tone 660", SimpleAudioDriverGeneratorType_Sine, 660.0 },
+	{ SimpleAudioDriverDataSource_WhiteNoise, "White Noise", SimpleAudioDriverGeneratorType_WhiteNoise, 0.0 },
+	{ SimpleAudioDriverDataSource_PinkNoise, "Pink Noise", SimpleAudioDriverGeneratorType_PinkNoise, 0.0 },
+	{ SimpleAudioDriverDataSource_Sweep, "Sweep", SimpleAudioDriverGeneratorType_Sweep, 0.0 },
+	{ SimpleAudioDriverDataSource_Multitone, "Multitone", SimpleAudioDriverGeneratorType_Multitone, 0.0 },
+	{ SimpleAudioDriverDataSource_ImpulseTrain, "Impulse Train", SimpleAudioDriverGeneratorType_ImpulseTrain, 0.0 },
+};
+
+static SimpleAudioSignalSource* CreateSignalSource(uint32_t in_generator_type)
+{
+	switch (in_generator_type)
+	{
+		case SimpleAudioDriverGeneratorType_Sine:
+			return new SimpleAudioSineSource();
+		case SimpleAudioDriverGeneratorType_WhiteNoise:
+			return new SimpleAudioWhiteNoiseSource();
+		case SimpleAudioDriverGeneratorType_PinkNoise:
+			return new SimpleAudioPinkNoiseSource();
+		case SimpleAudioDriverGeneratorType_Sweep:
+			return new SimpleAudioSweepSource();
+		case SimpleAudioDriverGeneratorType_Multitone:
+			return new SimpleAudioMultitoneSource();
+		case SimpleAudioDriverGeneratorType_ImpulseTrain:
+			return new SimpleAudioImpulseTrainSource();
+		default:
+			return nullptr;
+	}
+}
 
 struct SimpleAudioDevice_IVars
 {
 	OSSharedPtr<IOUserAudioDriver>	m_driver;
 	OSSharedPtr<IODispatchQueue>	m_work_queue;
 	
-	uint64_t	m_zts_host_ticks_per_buffer;
-	uint64_t	m_tone_host_ticks_per_buffer;
+	// The sample clock that drives the device timer.
+	SimpleAudioSampleClock	m_clock;
+	uint64_t	m_next_zts_sample_time;
+	
+	// The number of frames the timer fills each time it wakes, at the base rate
+	// of the sample rate's family. The timer scales it up with the rate so it
+	// wakes just as often at every rate.
+	uint32_t	m_fill_frame_size;
+	
+	// Commands waiting for the work queue. The timer drains them at each
+	// buffer boundary while IO runs; otherwise each enqueue schedules a drain.
+	SimpleAudioCommandQueue<SimpleAudioDeviceCommandEntry, kCommandQueueCapacity>	m_command_queue;
+	bool		m_io_is_running;
 	
 	OSSharedPtr<IOUserAudioStream>			m_input_stream;
 	OSSharedPtr<IOMemoryMap>				m_input_memory_map;
@@ -41,14 +154,31 @@ struct SimpleAudioDevice_IVars
 	OSSharedPtr<IOUserAudioSelectorControl> m_input_selector_control;
 	IOUserAudioSelectorValueDescription 	m_data_sources[kNumInputDataSources];
 	
-	OSSharedPtr<IOTimerDispatchSource>		m_zts_timer_event_source;
-	OSSharedPtr<OSAction>					m_zts_timer_occurred_action;
-	
-	OSSharedPtr<IOTimerDispatchSource>		m_tone_timer_event_source;
-	OSSharedPtr<OSAction>					m_tone_timer_occurred_action;
+	OSSharedPtr<IOTimerDispatchSource>		m_timer_event_source;
+	OSSharedPtr<OSAction>					m_timer_occurred_action;
 	
-	uint64_t	m_tone_host_time;
 	uint64_t	m_tone_sample_index;
+	
+	// The telemetry ring shared with user clients. Only the work queue writes it.
+	OSSharedPtr<IOBufferMemoryDescriptor>	m_telemetry_memory;
+	OSSharedPtr<IOMemoryMap>				m_telemetry_memory_map;
+	SimpleAudioTelemetryWriter				m_telemetry_writer;
+	
+	// A tone frequency set through a parameter update. Zero means the tone
+	// follows the data source selector.
+	double		m_tone_frequency_override;
+	
+	// One source per generator type. Data sources that share a type share the
+	// source, so switching between two sines keeps the phase continuous.
+	SimpleAudioSignalSource*	m_signal_sources[kSimpleAudioDriverNumGeneratorTypes];
+	
+	SimpleAudioToneParameters	m_tone_parameters;
+	SimpleAudioParameterRamp	m_gain_ramp;
+	float		m_tone_buffer[kToneGenerationBufferFrameSize];
+	int16_t		m_tone_integer_buffer[kToneGenerationBufferFrameSize];
+	
+	// Converts the input stream's float samples to the stream's integer format.
+	SimpleAudioSampleConverter	m_input_converter;
 };
 
 bool SimpleAudioDevice::init(IOUserAudioDriver* in_driver,
@@ -74,11 +204,8 @@ bool SimpleAudioDevice::init(IOUserAudioDriver* in_driver,
 	ivars->m_driver = OSSharedPtr(in_driver, OSRetain);
 	ivars->m_work_queue = GetWorkQueue();
 	
-	IOTimerDispatchSource* zts_timer_event_source = nullptr;
-	OSAction* zts_timer_occurred_action = nullptr;
-	
-	IOTimerDispatchSource* tone_timer_event_source = nullptr;
-	OSAction* tone_timer_occurred_action = nullptr;
+	IOTimerDispatchSource* timer_event_source = nullptr;
+	OSAction* timer_occurred_action = nullptr;
 	
 	OSSharedPtr<OSString> input_stream_name = OSSharedPtr(OSString::withCString("SimpleInputStream"), OSNoRetain);
 	OSSharedPtr<OSString> input_volume_control_name = OSSharedPtr(OSString::withCString("SimpleInputVolumeControl"), OSNoRetain);
@@ -94,39 +221,34 @@ bool SimpleAudioDevice::init(IOUserAudioDriver* in_driver,
 	OSSharedPtr<OSString> data = nullptr;
 
 	// Configure device and add stream objects.
-	auto data_source_0 = OSSharedPtr(OSString::withCString("Sine Tone 440"), OSNoRetain);
-	auto data_source_1 = OSSharedPtr(OSString::withCString("Sine Tone 660"), OSNoRetain);
-	ivars->m_data_sources[0] = { 440, data_source_0 };
-	ivars->m_data_sources[1] = { 660, data_source_1 };
+	for (auto data_source_index = 0; data_source_index < kNumInputDataSources; data_source_index++)
+	{
+		const auto& info = k_data_source_info[data_source_index];
+		auto data_source_name = OSSharedPtr(OSString::withCString(info.m_name), OSNoRetain);
+		ivars->m_data_sources[data_source_index] = { info.m_value, data_source_name };
+	}
 	
     // Setup stream formats and other stream related properties.
-	double sample_rates[] = {kSampleRate_1, kSampleRate_2};
-	SetAvailableSampleRates(sample_rates, 2);
+	SetAvailableSampleRates(k_sample_rates, kNumSampleRates);
 	SetSampleRate(kSampleRate_1);
 	const auto input_channels_per_frame = 1;
 	IOUserAudioChannelLabel input_channel_layout[input_channels_per_frame] = { IOUserAudioChannelLabel::Mono };
 	
-	IOUserAudioStreamBasicDescription input_stream_formats[] =
+    // Offer the same 16-bit mono format at every available rate.
+	IOUserAudioStreamBasicDescription input_stream_formats[kNumSampleRates];
+	for (auto rate_index = 0; rate_index < kNumSampleRates; rate_index++)
 	{
+		input_stream_formats[rate_index] =
 		{
-			kSampleRate_1, IOUserAudioFormatID::LinearPCM,
+			k_sample_rates[rate_index], IOUserAudioFormatID::LinearPCM,
 			static_cast<IOUserAudioFormatFlags>(IOUserAudioFormatFlags::FormatFlagIsSignedInteger | IOUserAudioFormatFlags::FormatFlagsNativeEndian),
 			static_cast<uint32_t>(sizeof(int16_t)*input_channels_per_frame),
 			1,
 			static_cast<uint32_t>(sizeof(int16_t)*input_channels_per_frame),
 			static_cast<uint32_t>(input_channels_per_frame),
 			16
-		},
-		{
-			kSampleRate_2, IOUserAudioFormatID::LinearPCM,
-			static_cast<IOUserAudioFormatFlags>(IOUserAudioFormatFlags::FormatFlagIsSignedInteger | IOUserAudioFormatFlags::FormatFlagsNativeEndian),
-			static_cast<uint32_t>(sizeof(int16_t)*input_channels_per_frame),
-			1,
-			static_cast<uint32_t>(sizeof(int16_t)*input_channels_per_frame),
-			static_cast<uint32_t>(input_channels_per_frame),
-			16
-		},
-	};
+		};
+	}
 	
     // Add custom property for the audio driver.
 	custom_property = IOUserAudioCustomProperty::Create(in_driver,
@@ -151,14 +273,29 @@ bool SimpleAudioDevice::init(IOUserAudioDriver* in_driver,
 	error = IOBufferMemoryDescriptor::Create(kIOMemoryDirectionInOut, buffer_size_bytes, 0, io_ring_buffer.attach());
 	FailIf(error != kIOReturnSuccess, , Failure, "Failed to create IOBufferMemoryDescriptor");
 	
+    // Create the shared memory for the telemetry ring and map it so the driver can write to it.
+	error = IOBufferMemoryDescriptor::Create(kIOMemoryDirectionInOut, sizeof(SimpleAudioTelemetryRing), 0, ivars->m_telemetry_memory.attach());
+	FailIf(error != kIOReturnSuccess, , Failure, "Failed to create telemetry IOBufferMemoryDescriptor");
+	error = ivars->m_telemetry_memory->CreateMapping(0, 0, 0, 0, 0, ivars->m_telemetry_memory_map.attach());
+	FailIf(error != kIOReturnSuccess, , Failure, "Failed to map telemetry IOBufferMemoryDescriptor");
+	ivars->m_telemetry_writer.Attach(reinterpret_cast<SimpleAudioTelemetryRing*>(ivars->m_telemetry_memory_map->GetAddress() + ivars->m_telemetry_memory_map->GetOffset()));
+	
+    // Create the signal source for each generator type.
+	for (uint32_t generator_type = 0; generator_type < kSimpleAudioDriverNumGeneratorTypes; generator_type++)
+	{
+		ivars->m_signal_sources[generator_type] = CreateSignalSource(generator_type);
+		FailIfNULL(ivars->m_signal_sources[generator_type], error = kIOReturnNoMemory, Failure, "Failed to create signal source");
+	}
+	
     // Create input stream object and pass in the IO ring buffer memory descriptor.
 	ivars->m_input_stream = IOUserAudioStream::Create(in_driver, IOUserAudioStreamDirection::Input, io_ring_buffer.get());
 	FailIfNULL(ivars->m_input_stream.get(), error = kIOReturnNoMemory, Failure, "failed to create input stream");
 	
 	//	Configure stream properties: name, available formats, and current format.
 	ivars->m_input_stream->SetName(input_stream_name.get());
-	ivars->m_input_stream->SetAvailableStreamFormats(input_stream_formats, 2);
+	ivars->m_input_stream->SetAvailableStreamFormats(input_stream_formats, kNumSampleRates);
 	ivars->m_input_stream_format = input_stream_formats[0];
+	ivars->m_input_converter.SetDitherMode(SimpleAudioDitherMode::TPDF);
 	ivars->m_input_stream->SetCurrentStreamFormat(&ivars->m_input_stream_format);
 	
 	// Add stream object to the driver.
@@ -187,7 +324,7 @@ bool SimpleAudioDevice::init(IOUserAudioDriver* in_driver,
 																		 IOUserAudioObjectPropertyScope::Input,
 																		 IOUserAudioClassID::DataSourceControl);
 	FailIfNULL(ivars->m_input_selector_control.get(), error = kIOReturnNoMemory, Failure, "Failed to create input data source control");
-	ivars->m_input_selector_control->AddControlValueDescriptions(ivars->m_data_sources, 2);
+	ivars->m_input_selector_control->AddControlValueDescriptions(ivars->m_data_sources, kNumInputDataSources);
     // Set data source selector current value to tone with frequency of 440 hz.
 	ivars->m_input_selector_control->SetCurrentSelectedValues(&ivars->m_data_sources[0].m_value, 1);
 	ivars->m_input_selector_control->SetName(input_data_source_control.get());
@@ -202,27 +339,19 @@ bool SimpleAudioDevice::init(IOUserAudioDriver* in_driver,
 	SetInputSafetyOffset(kToneGenerationBufferFrameSize/2);
 	SetTransportType(IOUserAudioTransportType::BuiltIn);
 	
-    // Initialize the timer that stands in for a real interrupt.
-	error = IOTimerDispatchSource::Create(ivars->m_work_queue.get(), &zts_timer_event_source);
-	FailIfError(error, , Failure, "failed to create the ZTS timer event source");
-	ivars->m_zts_timer_event_source = OSSharedPtr(zts_timer_event_source, OSNoRetain);
-	
-    // Create timer action to generate timestamps.
-	error = CreateActionZtsTimerOccurred(sizeof(void*), &zts_timer_occurred_action);
-	FailIfError(error, , Failure, "failed to create the timer event source action");
-	ivars->m_zts_timer_occurred_action = OSSharedPtr(zts_timer_occurred_action, OSNoRetain);
-	ivars->m_zts_timer_event_source->SetHandler(ivars->m_zts_timer_occurred_action.get());
-	
-    // Initialize the tone generation timer that stands in for a real interrupt.
-	error = IOTimerDispatchSource::Create(ivars->m_work_queue.get(), &tone_timer_event_source);
-	FailIfError(error, , Failure, "failed to create the tone timer event source");
-	ivars->m_tone_timer_event_source = OSSharedPtr(tone_timer_event_source, OSNoRetain);
+    // Initialize the timer that stands in for a real interrupt. It both
+    // publishes the zero timestamps and fills the input buffer with the tone.
+	ivars->m_fill_frame_size = kToneGenerationBufferFrameSize;
+	ivars->m_command_queue.Initialize();
+	error = IOTimerDispatchSource::Create(ivars->m_work_queue.get(), &timer_event_source);
+	FailIfError(error, , Failure, "failed to create the timer event source");
+	ivars->m_timer_event_source = OSSharedPtr(timer_event_source, OSNoRetain);
 	
-    // Create timer action to generate tone.
-	error = CreateActionToneTimerOccurred(sizeof(void*), &tone_timer_occurred_action);
+    // Create timer action to generate timestamps and tone.
+	error = CreateActionDeviceTimerOccurred(sizeof(void*), &timer_occurred_action);
 	FailIfError(error, , Failure, "failed to create the timer event source action");
-	ivars->m_tone_timer_occurred_action = OSSharedPtr(tone_timer_occurred_action, OSNoRetain);
-	ivars->m_tone_timer_event_source->SetHandler(ivars->m_tone_timer_occurred_action.get());
+	ivars->m_timer_occurred_action = OSSharedPtr(timer_occurred_action, OSNoRetain);
+	ivars->m_timer_event_source->SetHandler(ivars->m_timer_occurred_action.get());
 	return true;
 	
 Failure:
@@ -230,10 +359,16 @@ Failure:
 	ivars->m_input_stream.reset();
 	ivars->m_input_memory_map.reset();
 	ivars->m_input_volume_control.reset();
-	ivars->m_zts_timer_event_source.reset();
-	ivars->m_zts_timer_occurred_action.reset();
-	ivars->m_tone_timer_event_source.reset();
-	ivars->m_tone_timer_occurred_action.reset();
+	ivars->m_timer_event_source.reset();
+	ivars->m_timer_occurred_action.reset();
+	ivars->m_telemetry_writer.Attach(nullptr);
+	ivars->m_telemetry_memory_map.reset();
+	ivars->m_telemetry_memory.reset();
+	for (auto& signal_source : ivars->m_signal_sources)
+	{
+		delete signal_source;
+		signal_source = nullptr;
+	}
 	return false;
 }
 
@@ -246,11 +381,17 @@ void SimpleAudioDevice::free()
 		ivars->m_input_memory_map.reset();
 		ivars->m_input_volume_control.reset();
 		ivars->m_input_selector_control.reset();
-		ivars->m_zts_timer_event_source.reset();
-		ivars->m_zts_timer_occurred_action.reset();
-		ivars->m_tone_timer_event_source.reset();
-		ivars->m_tone_timer_occurred_action.reset();
+		ivars->m_timer_event_source.reset();
+		ivars->m_timer_occurred_action.reset();
+		ivars->m_telemetry_writer.Attach(nullptr);
+		ivars->m_telemetry_memory_map.reset();
+		ivars->m_telemetry_memory.reset();
 		ivars->m_work_queue.reset();
+		for (auto& signal_source : ivars->m_signal_sources)
+		{
+			delete signal_source;
+			signal_source = nullptr;
+		}
 	}
 	IOSafeDeleteNULL(ivars, SimpleAudioDevice_IVars, 1);
 	super::free();
@@ -320,8 +461,33 @@ kern_return_t SimpleAudioDevice::PerformDeviceConfigurationChange(uint64_t chang
 				DebugMsg("%s", change_info_string->getCStringNoCopy());
 			}
 			
-            // Toggle the sample rate of the device.
-			double rate_to_set = static_cast<uint64_t>(GetSampleRate()) != static_cast<uint64_t>(kSampleRate_1) ? kSampleRate_1 : kSampleRate_2;
+            // Step the sample rate of the device to the next available rate,
+            // wrapping around after the last one.
+			double rate_to_set = k_sample_rates[0];
+			for (auto rate_index = 0; rate_index < kNumSampleRates; rate_index++)
+			{
+				if (llround(GetSampleRate()) == llround(k_sample_rates[rate_index]))
+				{
+					rate_to_set = k_sample_rates[(rate_index + 1) % kNumSampleRates];
+					break;
+				}
+			}
+			ret = SetSampleRate(rate_to_set);
+			if (ret == kIOReturnSuccess)
+			{
+                // Update stream formats with the new rate.
+				ret = ivars->m_input_stream->DeviceSampleRateChanged(rate_to_set);
+			}
+		}
+			break;
+			
+		case k_sample_rate_config_change_action:
+		{
+            // Switch to the sample rate requested by a parameter update.
+			auto rate_number = OSDynamicCast(OSNumber, in_change_info);
+			FailIfNULL(rate_number, ret = kIOReturnBadArgument, Failure, "No sample rate in change info");
+			
+			double rate_to_set = static_cast<double>(rate_number->unsigned64BitValue());
 			ret = SetSampleRate(rate_to_set);
 			if (ret == kIOReturnSuccess)
 			{
@@ -336,8 +502,25 @@ kern_return_t SimpleAudioDevice::PerformDeviceConfigurationChange(uint64_t chang
 			break;
 	}
 	
-	// Update the cached format.
-	ivars->m_input_stream_format = ivars->m_input_stream->GetCurrentStreamFormat();
+Failure:
+	// Update the cached format and everything that depends on the rate on the
+	// work queue, so the timer never fills with a format that doesn't match
+	// the clock. If IO is running, the timer carries on at the new rate.
+	ivars->m_work_queue->DispatchSync(^(){
+		ivars->m_input_stream_format = ivars->m_input_stream->GetCurrentStreamFormat();
+		UpdateTimers();
+	});
+
+	// Record the change in the telemetry ring. The ring has a single writer,
+	// which is whatever is running on the work queue, so the record is written
+	// from there too, after the format above so that it reports the new rate.
+	ivars->m_work_queue->DispatchSync(^(){
+		ivars->m_telemetry_writer.Write(SimpleAudioTelemetryEventType_ConfigChange,
+										ivars->m_clock.GetSampleTime(),
+										mach_absolute_time(),
+										change_action,
+										static_cast<uint64_t>(GetSampleRate()));
+	});
 	
 	return ret;
 }
@@ -356,46 +539,34 @@ kern_return_t SimpleAudioDevice::HandleChangeSampleRate(double in_sample_rate)
 	return SetSampleRate(in_sample_rate);
 }
 
-inline int16_t SimpleAudioDevice::FloatToInt16(float in_sample)
-{
-	if (in_sample > 1.0f)
-	{
-		in_sample = 1.0f;
-	}
-	else if (in_sample < -1.0f)
-	{
-		in_sample = -1.0f;
-	}
-	return static_cast<int16_t>(in_sample * 0x7fff);
-}
-
 kern_return_t SimpleAudioDevice::StartTimers()
 {
 	kern_return_t error = kIOReturnSuccess;
 	
 	UpdateTimers();
 	
-	if(ivars->m_zts_timer_event_source.get() != nullptr &&
-	   ivars->m_tone_timer_event_source.get() != nullptr)
+	if(ivars->m_timer_event_source.get() != nullptr)
 	{
         // Clear the device's timestamps.
 		UpdateCurrentZeroTimestamp(0, 0);
-		auto current_time = mach_absolute_time();
 		
+        // Anchor the sample clock to now. The first zero timestamp is taken
+        // when the timer goes off.
+		auto current_time = mach_absolute_time();
+		ivars->m_clock.Start(current_time);
+		ivars->m_next_zts_sample_time = 0;
+		ivars->m_tone_sample_index = 0;
+		for (auto signal_source : ivars->m_signal_sources)
 		{
-            // Start the timer. The first time stamp is taken when it goes off.
-			ivars->m_zts_timer_event_source->WakeAtTime(kIOTimerClockMachAbsoluteTime, current_time + ivars->m_zts_host_ticks_per_buffer, 0);
-			ivars->m_zts_timer_event_source->SetEnable(true);
+			signal_source->Reset();
 		}
+		CaptureToneParameters();
+		ivars->m_gain_ramp.Reset(ivars->m_tone_parameters.m_gain);
 		
-		{
-			ivars->m_tone_sample_index = 0;
-			ivars->m_tone_host_time = 0;
-			
-            // Now run the timer.
-			ivars->m_tone_timer_event_source->WakeAtTime(kIOTimerClockMachAbsoluteTime, current_time, 0);
-			ivars->m_tone_timer_event_source->SetEnable(true);
-		}
+        // Now run the timer.
+		__atomic_store_n(&ivars->m_io_is_running, true, __ATOMIC_SEQ_CST);
+		ivars->m_timer_event_source->WakeAtTime(kIOTimerClockMachAbsoluteTime, current_time, 0);
+		ivars->m_timer_event_source->SetEnable(true);
 	}
 	else
 	{
@@ -407,12 +578,15 @@ kern_return_t SimpleAudioDevice::StartTimers()
 
 void	SimpleAudioDevice::StopTimers()
 {
-	if(ivars->m_zts_timer_event_source.get() != nullptr &&
-	   ivars->m_tone_timer_event_source.get() != nullptr)
+	if(ivars->m_timer_event_source.get() != nullptr)
 	{
-		ivars->m_zts_timer_event_source->SetEnable(false);
-		ivars->m_tone_timer_event_source->SetEnable(false);
+		ivars->m_timer_event_source->SetEnable(false);
 	}
+	
+	// Once IO is marked stopped, new commands schedule their own drain, so
+	// this drain picks up everything the timer didn't get to.
+	__atomic_store_n(&ivars->m_io_is_running, false, __ATOMIC_SEQ_CST);
+	DrainCommands();
 }
 
 void	SimpleAudioDevice::UpdateTimers()
@@ -420,118 +594,444 @@ void	SimpleAudioDevice::UpdateTimers()
 	struct mach_timebase_info timebase_info;
 	mach_timebase_info(&timebase_info);
 	
-	double sample_rate = ivars->m_input_stream_format.mSampleRate;
+    // Host ticks per frame is (NSEC_PER_SEC * denom) / (sample rate * numer).
+    // Keep it as a ratio of integers rather than a truncated tick count.
+	auto sample_rate = static_cast<uint64_t>(llround(ivars->m_input_stream_format.mSampleRate));
+	auto host_ticks_numerator = NSEC_PER_SEC * static_cast<uint64_t>(timebase_info.denom);
+	auto host_ticks_denominator = sample_rate * static_cast<uint64_t>(timebase_info.numer);
+	
+    // While IO runs, re-anchor the clock at the next fill. The timer's pending
+    // wake time and every zero timestamp already published stay valid, and
+    // the sample times carry on without a gap.
+	if (__atomic_load_n(&ivars->m_io_is_running, __ATOMIC_SEQ_CST))
 	{
-		double host_ticks_per_buffer = static_cast<double>(GetZeroTimestampPeriod() * NSEC_PER_SEC) / sample_rate;
-		host_ticks_per_buffer = (host_ticks_per_buffer * static_cast<double>(timebase_info.denom)) / static_cast<double>(timebase_info.numer);
-		ivars->m_zts_host_ticks_per_buffer = static_cast<uint64_t>(host_ticks_per_buffer);
+		ivars->m_clock.ChangeRate(host_ticks_numerator, host_ticks_denominator);
 	}
-	
+	else
 	{
-		double host_ticks_per_buffer = static_cast<double>(kToneGenerationBufferFrameSize * NSEC_PER_SEC) / sample_rate;
-		host_ticks_per_buffer = (host_ticks_per_buffer * static_cast<double>(timebase_info.denom)) / static_cast<double>(timebase_info.numer);
-		ivars->m_tone_host_ticks_per_buffer = static_cast<uint64_t>(host_ticks_per_buffer);
+		ivars->m_clock.SetRate(host_ticks_numerator, host_ticks_denominator);
 	}
+	
+    // Keep the latency and safety offset the same length in time at every rate.
+	auto rate_multiple = SampleRateMultiple(ivars->m_input_stream_format.mSampleRate);
+	SetInputLatency(kToneGenerationBufferFrameSize * rate_multiple);
+	SetInputSafetyOffset(kToneGenerationBufferFrameSize / 2 * rate_multiple);
 }
 
-void	SimpleAudioDevice::ZtsTimerOccurred_Impl(OSAction* action, uint64_t time)
+void	SimpleAudioDevice::DeviceTimerOccurred_Impl(OSAction* action, uint64_t time)
 {
-    // Get the current time.
-	auto current_time = time;
-	
-    // Increment the time stamps...
-	uint64_t current_sample_time = 0;
-	uint64_t current_host_time = 0;
-	GetCurrentZeroTimestamp(&current_sample_time, &current_host_time);
-	
-	auto host_ticks_per_buffer = ivars->m_zts_host_ticks_per_buffer;
-	
-	if(current_host_time != 0)
+    // Publish a zero timestamp for each period boundary the clock has reached.
+    // The host time comes from the sample clock, not from when the timer
+    // actually fired, so late wakeups don't skew the timestamps.
+	auto zts_period = GetZeroTimestampPeriod();
+	while (ivars->m_next_zts_sample_time <= ivars->m_clock.GetSampleTime())
 	{
-		current_sample_time += GetZeroTimestampPeriod();
-		current_host_time += host_ticks_per_buffer;
+		auto zts_host_time = ivars->m_clock.HostTimeForSampleTime(ivars->m_next_zts_sample_time);
+		UpdateCurrentZeroTimestamp(ivars->m_next_zts_sample_time, zts_host_time);
+		ivars->m_telemetry_writer.Write(SimpleAudioTelemetryEventType_ZeroTimestamp, ivars->m_next_zts_sample_time, zts_host_time, 0, 0);
+		ivars->m_next_zts_sample_time += zts_period;
 	}
-	else
+	
+	// Carry out queued commands at the buffer boundary, then take the
+	// parameters the fill will use.
+	DrainCommands();
+	CaptureToneParameters();
+	
+	// Fill the input buffer from the same clock.
+	auto sample_time = ivars->m_clock.GetSampleTime();
+	auto scheduled_host_time = ivars->m_clock.HostTimeForSampleTime(sample_time);
+	auto fill_start_time = mach_absolute_time();
+	// Never fill more than half of the IO ring buffer at once.
+	auto fill_frame_size = ivars->m_fill_frame_size * SampleRateMultiple(ivars->m_input_stream_format.mSampleRate);
+	auto max_fill_frame_size = GetZeroTimestampPeriod() / 2;
+	if (fill_frame_size > max_fill_frame_size)
 	{
-        // ...but not if it's the first one.
-		current_sample_time = 0;
-		current_host_time = current_time;
+		fill_frame_size = max_fill_frame_size;
 	}
+	GenerateToneForInput(fill_frame_size);
+	ivars->m_clock.Advance(fill_frame_size);
 	
-	// Update the device with the current timestamp.
-	UpdateCurrentZeroTimestamp(current_sample_time, current_host_time);
+	// Record how late the timer fired and how long the fill took.
+	auto lateness = time > scheduled_host_time ? time - scheduled_host_time : 0;
+	ivars->m_telemetry_writer.Write(SimpleAudioTelemetryEventType_TimerFired,
+									sample_time,
+									scheduled_host_time,
+									lateness,
+									mach_absolute_time() - fill_start_time);
 	
-    // Set the timer to go off in one buffer.
-	ivars->m_zts_timer_event_source->WakeAtTime(kIOTimerClockMachAbsoluteTime,
-												current_host_time + host_ticks_per_buffer, 0);
+	// Set the timer to go off when the clock reaches the next fill.
+	ivars->m_timer_event_source->WakeAtTime(kIOTimerClockMachAbsoluteTime,
+											ivars->m_clock.HostTimeForSampleTime(ivars->m_clock.GetSampleTime()), 0);
 }
 
-void	SimpleAudioDevice::ToneTimerOccurred_Impl(OSAction* action, uint64_t time)
+void SimpleAudioDevice::CaptureToneParameters()
 {
-    // Increment the tone's host time...
-    if (ivars->m_tone_host_time != 0)
+	// Get volume control scalar value to apply gain to the tone.
+	ivars->m_tone_parameters.m_gain = ivars->m_input_volume_control->GetScalarValue();
+	
+	// Get the generator and frequency from the data source selector control,
+	// unless a parameter update overrode the frequency.
+	IOUserAudioSelectorValue data_source_value = 0;
+	ivars->m_input_selector_control->GetCurrentSelectedValues(&data_source_value, 1);
+	const auto* info = &k_data_source_info[0];
+	for (const auto& data_source_info : k_data_source_info)
 	{
-		ivars->m_tone_host_time += ivars->m_tone_host_ticks_per_buffer;
+		if (data_source_info.m_value == data_source_value)
+		{
+			info = &data_source_info;
+			break;
+		}
 	}
-	else
+	ivars->m_tone_parameters.m_generator_type = info->m_generator_type;
+	ivars->m_tone_parameters.m_frequency = info->m_frequency;
+	if (ivars->m_tone_frequency_override > 0.0)
 	{
-		// ...but not if it's the first one.
-		ivars->m_tone_sample_index = 0;
-		ivars->m_tone_host_time = time;
+		ivars->m_tone_parameters.m_frequency = ivars->m_tone_frequency_override;
 	}
-	
-	// Update the device with the current timestamp.
-	GenerateToneForInput(kToneGenerationBufferFrameSize);
-	
-	// Set the timer to go off in one buffer.
-	ivars->m_tone_timer_event_source->WakeAtTime(kIOTimerClockMachAbsoluteTime,
-												 ivars->m_tone_host_time + ivars->m_tone_host_ticks_per_buffer, 0);
 }
 
 void SimpleAudioDevice::GenerateToneForInput(size_t in_frame_size)
 {
-	// Fill out the input buffer with a sine tone.
+	// Fill out the input buffer from the selected data source.
 	if (ivars->m_input_memory_map)
 	{
         // Get the pointer to the I/O buffer and use stream format information
         // to get the buffer length.
 		const auto& format = ivars->m_input_stream_format;
-		auto buffer_length = ivars->m_input_memory_map->GetLength() / (format.mBytesPerFrame / format.mChannelsPerFrame);
-		auto num_samples = in_frame_size;
+		auto buffer_frame_count = ivars->m_input_memory_map->GetLength() / format.mBytesPerFrame;
 		auto buffer = reinterpret_cast<int16_t*>(ivars->m_input_memory_map->GetAddress() + ivars->m_input_memory_map->GetOffset());
+		SimpleAudioRingWriter<int16_t> ring_writer(buffer, buffer_frame_count, format.mChannelsPerFrame);
 
-        // Get volume control dB value to apply gain to the tone.
-		auto input_volume_level = ivars->m_input_volume_control->GetScalarValue();
+        // A volume change ramps to its new level rather than stepping. A
+        // frequency change needs no ramp since the sine source keeps its phase.
+		const auto& parameters = ivars->m_tone_parameters;
+		auto gain_ramp_frame_count = static_cast<uint32_t>(kGainRampDuration * format.mSampleRate);
+		ivars->m_gain_ramp.SetTarget(parameters.m_gain, gain_ramp_frame_count);
 		
-        // Get the frequency of the tone from the data source selector control.
-		IOUserAudioSelectorValue tone_selector_value = 0;
-		ivars->m_input_selector_control->GetCurrentSelectedValues(&tone_selector_value, 1);
-		double frequency = static_cast<double>(tone_selector_value);
+		auto signal_source = ivars->m_signal_sources[parameters.m_generator_type];
+		SimpleAudioSignalContext context = { format.mSampleRate, parameters.m_frequency };
+		uint64_t render_host_ticks = 0;
 		
-		for(size_t i = 0; i < num_samples; i++)
+		size_t frames_remaining = in_frame_size;
+		while (frames_remaining > 0)
 		{
-			float float_value = input_volume_level * sin(2.0 * M_PI * frequency * static_cast<double>(ivars->m_tone_sample_index) / format.mSampleRate);
-			int16_t integer_value = FloatToInt16(float_value);
-			for (auto channel_index = 0; channel_index < format.mChannelsPerFrame; channel_index++)
-			{
-				auto buffer_index = (format.mChannelsPerFrame * (ivars->m_tone_sample_index) + channel_index) % buffer_length;
-				buffer[buffer_index] = integer_value;
-			}
-			ivars->m_tone_sample_index += 1;
+			size_t num_frames = frames_remaining < kToneGenerationBufferFrameSize ? frames_remaining : kToneGenerationBufferFrameSize;
+			float* tone_buffer = ivars->m_tone_buffer;
+			
+			// Render a block from the selected source into the scratch buffer,
+			// timing it so each source's cost shows up in the telemetry.
+			auto render_start_time = mach_absolute_time();
+			signal_source->Render(tone_buffer, num_frames, context);
+			render_host_ticks += mach_absolute_time() - render_start_time;
+			ivars->m_gain_ramp.Apply(tone_buffer, num_frames);
+			
+			// Convert the whole block in one pass, with the stream's dither.
+			int16_t* integer_buffer = ivars->m_tone_integer_buffer;
+			ivars->m_input_converter.ConvertToInt16(tone_buffer, integer_buffer, num_frames);
+			
+			// Copy the block to every channel of the IO ring buffer.
+			ring_writer.WriteMonoFrames(ivars->m_tone_sample_index, integer_buffer, num_frames);
+			ivars->m_tone_sample_index += num_frames;
+			
+			frames_remaining -= num_frames;
 		}
+		
+		ivars->m_telemetry_writer.Write(SimpleAudioTelemetryEventType_SourceRender,
+										ivars->m_tone_sample_index - in_frame_size,
+										mach_absolute_time(),
+										parameters.m_generator_type,
+										render_host_ticks);
 	}
 }
 
-kern_return_t SimpleAudioDevice::ToggleDataSource()
+kern_return_t SimpleAudioDevice::UpdateParameters(OSData* in_updates, IOUserClient* in_client, OSAction* in_completion)
 {
-	__block kern_return_t ret = kIOReturnSuccess;
-	GetWorkQueue()->DispatchSync(^(){
-		IOUserAudioSelectorValue current_data_source_value;
-		ivars->m_input_selector_control->GetCurrentSelectedValues(&current_data_source_value, 1);
-		IOUserAudioSelectorValue data_source_value_to_set =
-			(current_data_source_value == ivars->m_data_sources[0].m_value) ?
-				ivars->m_data_sources[1].m_value : ivars->m_data_sources[0].m_value;
-		ret = ivars->m_input_selector_control->SetCurrentSelectedValues(&data_source_value_to_set, 1);
-	});
+	// Reject the whole batch up front if any update is invalid. An update that
+	// fails when it's applied rolls back the rest, so the batch is either
+	// applied entirely or not at all.
+	kern_return_t ret = ValidateParameterUpdates(in_updates);
+	if (ret != kIOReturnSuccess)
+	{
+		return ret;
+	}
+	
+	// The updates take effect together at the next buffer boundary. If the
+	// caller supplied a completion, it receives the result.
+	return EnqueueCommand(SimpleAudioDeviceCommand_UpdateParameters, 0, in_updates, in_client, in_completion);
+}
+
+kern_return_t SimpleAudioDevice::CopyTelemetryMemory(IOMemoryDescriptor** out_memory)
+{
+	if (out_memory == nullptr)
+	{
+		return kIOReturnBadArgument;
+	}
+	if (ivars->m_telemetry_memory.get() == nullptr)
+	{
+		return kIOReturnNoResources;
+	}
+	
+	// The caller takes ownership of the returned reference.
+	ivars->m_telemetry_memory->retain();
+	*out_memory = ivars->m_telemetry_memory.get();
+	return kIOReturnSuccess;
+}
+
+kern_return_t SimpleAudioDevice::ToggleDataSource(IOUserClient* in_client, OSAction* in_completion)
+{
+	// The toggle happens later on the work queue. If the caller supplied a
+	// completion, it receives the result and the newly selected value.
+	return EnqueueCommand(SimpleAudioDeviceCommand_ToggleDataSource, 0, nullptr, in_client, in_completion);
+}
+
+kern_return_t SimpleAudioDevice::EnqueueCommand(uint32_t in_command, uint64_t in_argument, OSObject* in_object, IOUserClient* in_client, OSAction* in_completion)
+{
+	SimpleAudioDeviceCommandEntry entry = { in_command, in_argument, in_object, nullptr, nullptr };
+	if (entry.m_object != nullptr)
+	{
+		entry.m_object->retain();
+	}
+	if (in_client != nullptr && in_completion != nullptr)
+	{
+		entry.m_client = in_client;
+		entry.m_client->retain();
+		entry.m_completion = in_completion;
+		entry.m_completion->retain();
+	}
+	
+	if (!ivars->m_command_queue.Push(entry))
+	{
+		OSSafeReleaseNULL(entry.m_object);
+		OSSafeReleaseNULL(entry.m_client);
+		OSSafeReleaseNULL(entry.m_completion);
+		return kIOReturnNoSpace;
+	}
+	
+	// While IO runs, the timer drains the queue at the next buffer boundary.
+	// Otherwise, drain it on the work queue without waiting. The block holds a
+	// reference to the device, so the driver releasing the device can't free
+	// it while the drain is still queued.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!__atomic_load_n(&ivars->m_io_is_running, __ATOMIC_SEQ_CST))
+	{
+		retain();
+		ivars->m_work_queue->DispatchAsync(^(){
+			DrainCommands();
+			release();
+		});
+	}
+	return kIOReturnSuccess;
+}
+
+void SimpleAudioDevice::DrainCommands()
+{
+	SimpleAudioDeviceCommandEntry entry;
+	while (ivars->m_command_queue.Pop(entry))
+	{
+		kern_return_t ret = kIOReturnSuccess;
+		uint64_t result = 0;
+		switch (entry.m_command)
+		{
+			case SimpleAudioDeviceCommand_ToggleDataSource:
+				ret = PerformToggleDataSource(&result);
+				break;
+				
+			case SimpleAudioDeviceCommand_UpdateParameters:
+				ret = PerformUpdateParameters(OSDynamicCast(OSData, entry.m_object));
+				break;
+				
+			default:
+				ret = kIOReturnUnsupported;
+				break;
+		}
+		
+		if (entry.m_client != nullptr && entry.m_completion != nullptr)
+		{
+			IOUserClientAsyncArgumentsArray async_data = { result };
+			entry.m_client->AsyncCompletion(entry.m_completion, ret, async_data, 1);
+		}
+		OSSafeReleaseNULL(entry.m_object);
+		OSSafeReleaseNULL(entry.m_client);
+		OSSafeReleaseNULL(entry.m_completion);
+	}
+}
+
+kern_return_t SimpleAudioDevice::PerformToggleDataSource(uint64_t* out_selected_value)
+{
+	// Step to the next data source, wrapping around after the last one.
+	IOUserAudioSelectorValue current_data_source_value;
+	ivars->m_input_selector_control->GetCurrentSelectedValues(&current_data_source_value, 1);
+	IOUserAudioSelectorValue data_source_value_to_set = ivars->m_data_sources[0].m_value;
+	for (auto data_source_index = 0; data_source_index < kNumInputDataSources; data_source_index++)
+	{
+		if (ivars->m_data_sources[data_source_index].m_value == current_data_source_value)
+		{
+			data_source_value_to_set = ivars->m_data_sources[(data_source_index + 1) % kNumInputDataSources].m_value;
+			break;
+		}
+	}
+	*out_selected_value = data_source_value_to_set;
+	ivars->m_tone_frequency_override = 0.0;
+	return ivars->m_input_selector_control->SetCurrentSelectedValues(&data_source_value_to_set, 1);
+}
+
+kern_return_t SimpleAudioDevice::ValidateParameterUpdates(OSData* in_updates)
+{
+	if (in_updates == nullptr || in_updates->getLength() % sizeof(SimpleAudioDriverParameterUpdate) != 0)
+	{
+		return kIOReturnBadArgument;
+	}
+	
+	auto num_updates = in_updates->getLength() / sizeof(SimpleAudioDriverParameterUpdate);
+	if (num_updates == 0 || num_updates > kSimpleAudioDriverMaxParameterUpdates)
+	{
+		return kIOReturnBadArgument;
+	}
+	
+	auto updates = reinterpret_cast<const SimpleAudioDriverParameterUpdate*>(in_updates->getBytesNoCopy());
+	for (size_t i = 0; i < num_updates; i++)
+	{
+		auto value = updates[i].m_value;
+		bool is_valid = false;
+		switch (updates[i].m_parameter)
+		{
+			case SimpleAudioDriverParameter_InputVolume:
+				is_valid = value >= 0.0 && value <= 1.0;
+				break;
+				
+			case SimpleAudioDriverParameter_DataSource:
+				for (auto data_source_index = 0; data_source_index < kNumInputDataSources; data_source_index++)
+				{
+					is_valid = is_valid || value == static_cast<double>(ivars->m_data_sources[data_source_index].m_value);
+				}
+				break;
+				
+			case SimpleAudioDriverParameter_ToneFrequency:
+				is_valid = value > 0.0 && value < kSampleRate_1 / 2.0;
+				break;
+				
+			case SimpleAudioDriverParameter_SampleRate:
+				is_valid = false;
+				for (auto sample_rate : k_sample_rates)
+				{
+					is_valid = is_valid || value == sample_rate;
+				}
+				break;
+				
+			case SimpleAudioDriverParameter_GeneratorType:
+				is_valid = value >= 0.0 && value < kSimpleAudioDriverNumGeneratorTypes && value == floor(value);
+				break;
+				
+			case SimpleAudioDriverParameter_FillFrameSize:
+				is_valid = value >= kMinimumFillFrameSize && value <= kMaximumFillFrameSize && value == floor(value);
+				break;
+				
+			default:
+				break;
+		}
+		
+		if (!is_valid)
+		{
+			DebugMsg("Invalid parameter update %u", updates[i].m_parameter);
+			return kIOReturnBadArgument;
+		}
+	}
+	
+	return kIOReturnSuccess;
+}
+
+kern_return_t SimpleAudioDevice::PerformUpdateParameters(OSData* in_updates)
+{
+	if (in_updates == nullptr)
+	{
+		return kIOReturnBadArgument;
+	}
+	
+	kern_return_t ret = kIOReturnSuccess;
+	auto num_updates = in_updates->getLength() / sizeof(SimpleAudioDriverParameterUpdate);
+	auto updates = reinterpret_cast<const SimpleAudioDriverParameterUpdate*>(in_updates->getBytesNoCopy());
+	double rate_to_set = 0.0;
+	
+	// Save everything the batch can change, so a failure part way through
+	// can put it all back.
+	auto saved_volume = ivars->m_input_volume_control->GetScalarValue();
+	IOUserAudioSelectorValue saved_data_source_value = 0;
+	ivars->m_input_selector_control->GetCurrentSelectedValues(&saved_data_source_value, 1);
+	auto saved_tone_frequency_override = ivars->m_tone_frequency_override;
+	auto saved_fill_frame_size = ivars->m_fill_frame_size;
+	
+	// This runs on the work queue between two fills, so the next fill sees
+	// every update in the batch.
+	for (size_t i = 0; i < num_updates && ret == kIOReturnSuccess; i++)
+	{
+		auto value = updates[i].m_value;
+		switch (updates[i].m_parameter)
+		{
+			case SimpleAudioDriverParameter_InputVolume:
+				ret = ivars->m_input_volume_control->SetScalarValue(static_cast<float>(value));
+				break;
+				
+			case SimpleAudioDriverParameter_DataSource:
+			{
+				IOUserAudioSelectorValue data_source_value_to_set = static_cast<IOUserAudioSelectorValue>(value);
+				ivars->m_tone_frequency_override = 0.0;
+				ret = ivars->m_input_selector_control->SetCurrentSelectedValues(&data_source_value_to_set, 1);
+			}
+				break;
+				
+			case SimpleAudioDriverParameter_ToneFrequency:
+				ivars->m_tone_frequency_override = value;
+				break;
+				
+			case SimpleAudioDriverParameter_SampleRate:
+				rate_to_set = value;
+				break;
+				
+			case SimpleAudioDriverParameter_GeneratorType:
+			{
+				// Select the first data source that plays this generator type.
+				for (const auto& data_source_info : k_data_source_info)
+				{
+					if (data_source_info.m_generator_type == static_cast<uint32_t>(value))
+					{
+						IOUserAudioSelectorValue data_source_value_to_set = data_source_info.m_value;
+						ivars->m_tone_frequency_override = 0.0;
+						ret = ivars->m_input_selector_control->SetCurrentSelectedValues(&data_source_value_to_set, 1);
+						break;
+					}
+				}
+			}
+				break;
+				
+			case SimpleAudioDriverParameter_FillFrameSize:
+				// The new size takes effect at the timer's next wakeup.
+				ivars->m_fill_frame_size = static_cast<uint32_t>(value);
+				break;
+				
+			default:
+				ret = kIOReturnBadArgument;
+				break;
+		}
+	}
+	
+	// A requested configuration change can't be taken back, so the sample
+	// rate is only requested once the rest of the batch has been applied. The
+	// HAL decides when the change runs, so the new rate takes effect after
+	// the rest of the batch.
+	if (ret == kIOReturnSuccess && rate_to_set > 0.0 && llround(rate_to_set) != llround(GetSampleRate()))
+	{
+		auto rate_number = OSSharedPtr(OSNumber::withNumber(static_cast<uint64_t>(llround(rate_to_set)), 64), OSNoRetain);
+		ret = RequestDeviceConfigurationChange(k_sample_rate_config_change_action, rate_number.get());
+	}
+	
+	// Roll back whatever the batch changed before it failed.
+	if (ret != kIOReturnSuccess)
+	{
+		ivars->m_input_volume_control->SetScalarValue(saved_volume);
+		ivars->m_input_selector_control->SetCurrentSelectedValues(&saved_data_source_value, 1);
+		ivars->m_tone_frequency_override = saved_tone_frequency_override;
+		ivars->m_fill_frame_size = saved_fill_frame_size;
+	}
+	
 	return ret;
 }
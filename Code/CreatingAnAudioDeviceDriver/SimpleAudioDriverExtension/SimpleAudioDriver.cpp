@@ -166,13 +166,11 @@ kern_return_t SimpleAudioDriver::StopDevice(IOUserAudioObjectID in_object_id, IO
 	return ret;
 }
 
-kern_return_t SimpleAudioDriver::HandleToggleDataSource()
+kern_return_t SimpleAudioDriver::HandleToggleDataSource(IOUserClient* in_client, OSAction* in_completion)
 {
-	__block kern_return_t ret = kIOReturnSuccess;
-	ivars->m_work_queue->DispatchSync(^(){
-		ret = ivars->m_simple_audio_device->ToggleDataSource();
-	});
-	return ret;
+	// The device queues the toggle rather than blocking behind its timer, and
+	// reports the result through the completion if there is one.
+	return ivars->m_simple_audio_device->ToggleDataSource(in_client, in_completion);
 }
 
 kern_return_t SimpleAudioDriver::HandleTestConfigChange()
@@ -180,3 +178,13 @@ kern_return_t SimpleAudioDriver::HandleTestConfigChange()
 	auto change_info = OSSharedPtr(OSString::withCString("Toggle Sample Rate"), OSNoRetain);
 	return ivars->m_simple_audio_device->RequestDeviceConfigurationChange(k_custom_config_change_action, change_info.get());
 }
+
+kern_return_t SimpleAudioDriver::HandleUpdateParameters(OSData* in_updates, IOUserClient* in_client, OSAction* in_completion)
+{
+	return ivars->m_simple_audio_device->UpdateParameters(in_updates, in_client, in_completion);
+}
+
+kern_return_t SimpleAudioDriver::HandleCopyTelemetryMemory(IOMemoryDescriptor** out_memory)
+{
+	return ivars->m_simple_audio_device->CopyTelemetryMemory(out_memory);
+}
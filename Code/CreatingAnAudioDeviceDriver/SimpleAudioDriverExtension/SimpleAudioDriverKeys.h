@@ -17,12 +17,60 @@ Constants for identifiers used by both the user client and the driver.
 #define kSimpleAudioDriverCustomPropertyDataValue0 "Default-0"
 #define kSimpleAudioDriverCustomPropertyDataValue1 "Default-1"
 
+// Pass this memory type to IOConnectMapMemory64 to map the driver's telemetry
+// ring, laid out as described in SimpleAudioTelemetry.h, read-only into the client.
+#define kSimpleAudioDriverTelemetryMemoryType 1
+
 enum SimpleAudioDriverExternalMethod
 {
     SimpleAudioDriverExternalMethod_Open, // No arguments.
     SimpleAudioDriverExternalMethod_Close, // No arguments.
     SimpleAudioDriverExternalMethod_ToggleDataSource, // No argument. Used to switch between data source selection.
-    SimpleAudioDriverExternalMethod_TestConfigChange // No arguments. Used to switch between sample rates and excercise config change mechanism.
+    SimpleAudioDriverExternalMethod_TestConfigChange, // No arguments. Used to switch between sample rates and excercise config change mechanism.
+    SimpleAudioDriverExternalMethod_UpdateParameters // Structure input is an array of SimpleAudioDriverParameterUpdate. Applied together at the next buffer boundary; if any update fails, none are applied.
+};
+
+enum SimpleAudioDriverParameter
+{
+    SimpleAudioDriverParameter_InputVolume, // Scalar volume from 0 to 1.
+    SimpleAudioDriverParameter_DataSource, // One of the data source selector values.
+    SimpleAudioDriverParameter_ToneFrequency, // Frequency in Hz. Overrides the data source's tone until the data source changes.
+    SimpleAudioDriverParameter_SampleRate, // One of the device's available sample rates. Applied through a configuration change.
+    SimpleAudioDriverParameter_GeneratorType, // One of SimpleAudioDriverGeneratorType.
+    SimpleAudioDriverParameter_FillFrameSize // Frames the device fills per timer wakeup at 44.1 or 48 kHz, from 32 to 8192. Scaled up with the sample rate.
 };
 
+enum SimpleAudioDriverGeneratorType
+{
+    SimpleAudioDriverGeneratorType_Sine,
+    SimpleAudioDriverGeneratorType_WhiteNoise,
+    SimpleAudioDriverGeneratorType_PinkNoise,
+    SimpleAudioDriverGeneratorType_Sweep,
+    SimpleAudioDriverGeneratorType_Multitone,
+    SimpleAudioDriverGeneratorType_ImpulseTrain
+};
+
+#define kSimpleAudioDriverNumGeneratorTypes 6
+
+// The input data source selector values. Each data source plays one generator type.
+enum SimpleAudioDriverDataSource
+{
+    SimpleAudioDriverDataSource_Sine440 = 440,
+    SimpleAudioDriverDataSource_Sine660 = 660,
+    SimpleAudioDriverDataSource_WhiteNoise = 'wnoi',
+    SimpleAudioDriverDataSource_PinkNoise = 'pnoi',
+    SimpleAudioDriverDataSource_Sweep = 'swep',
+    SimpleAudioDriverDataSource_Multitone = 'mult',
+    SimpleAudioDriverDataSource_ImpulseTrain = 'impl'
+};
+
+struct SimpleAudioDriverParameterUpdate
+{
+    uint32_t m_parameter; // One of SimpleAudioDriverParameter.
+    uint32_t m_reserved;
+    double m_value;
+};
+
+#define kSimpleAudioDriverMaxParameterUpdates 32
+
 #endif /* SimpleAudioDriverKeys_h */
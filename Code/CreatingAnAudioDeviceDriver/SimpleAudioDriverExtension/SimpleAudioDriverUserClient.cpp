@@ -102,7 +102,7 @@ kern_return_t	SimpleAudioDriverUserClient::ExternalMethod(uint64_t in_selector,
 
 		case SimpleAudioDriverExternalMethod_ToggleDataSource:
 		{
-			ret = ivars->m_provider->HandleToggleDataSource();
+			ret = ivars->m_provider->HandleToggleDataSource(this, in_arguments->completion);
 			break;
 		}
 			
@@ -111,10 +111,54 @@ kern_return_t	SimpleAudioDriverUserClient::ExternalMethod(uint64_t in_selector,
 			ret = ivars->m_provider->HandleTestConfigChange();
 			break;
 		}
+			
+		case SimpleAudioDriverExternalMethod_UpdateParameters:
+		{
+			FailIfNULL(in_arguments->structureInput, ret = kIOReturnBadArgument, Failure, "No parameter updates");
+			ret = ivars->m_provider->HandleUpdateParameters(in_arguments->structureInput, this, in_arguments->completion);
+			break;
+		}
 
 		default:
 			ret = super::ExternalMethod(in_selector, in_arguments, in_dispatch, in_target, in_reference);
 	};
 	
+Failure:
+	return ret;
+}
+
+kern_return_t	SimpleAudioDriverUserClient::CopyClientMemoryForType_Impl(uint64_t in_type,
+																		  uint64_t* out_options,
+																		  IOMemoryDescriptor** out_memory)
+{
+	kern_return_t ret = kIOReturnSuccess;
+	
+	if (ivars == nullptr)
+	{
+		return kIOReturnNoResources;
+	}
+	if (ivars->m_provider.get() == nullptr)
+	{
+		return kIOReturnNotAttached;
+	}
+	
+	switch (in_type)
+	{
+		case kSimpleAudioDriverTelemetryMemoryType:
+		{
+			// The client only reads the telemetry ring; the driver is the sole writer.
+			ret = ivars->m_provider->HandleCopyTelemetryMemory(out_memory);
+			if (ret == kIOReturnSuccess)
+			{
+				*out_options = kIOUserClientMemoryReadOnly;
+			}
+			break;
+		}
+			
+		default:
+			ret = kIOReturnBadArgument;
+			break;
+	}
+	
 	return ret;
 }
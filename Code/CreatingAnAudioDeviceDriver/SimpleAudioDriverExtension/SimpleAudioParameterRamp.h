@@ -0,0 +1,98 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A linear ramp that smooths a gain parameter across blocks
+             of float samples.
+*/
+
+#ifndef SimpleAudioParameterRamp_h
+#define SimpleAudioParameterRamp_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Moves a parameter to a new target over a fixed number of frames instead of
+// in one step, so changing a gain doesn't put a click in the output. Within a
+// block each frame's value is computed from the block's starting value rather
+// than accumulated, so the apply loop has no loop-carried dependency and the
+// compiler can vectorize it. A ramp that's all zeros is valid and holds zero.
+class SimpleAudioParameterRamp
+{
+public:
+	// Jump straight to a value with no ramp.
+	void Reset(float in_value)
+	{
+		m_value = in_value;
+		m_target = in_value;
+		m_step = 0.0f;
+		m_frames_remaining = 0;
+	}
+
+	// Start ramping from the current value to a new target. Setting the target
+	// the ramp is already heading for doesn't restart it.
+	void SetTarget(float in_target, uint32_t in_ramp_frame_count)
+	{
+		if (in_target == m_target)
+		{
+			return;
+		}
+
+		m_target = in_target;
+		if (in_ramp_frame_count == 0)
+		{
+			Reset(in_target);
+		}
+		else
+		{
+			m_step = (m_target - m_value) / static_cast<float>(in_ramp_frame_count);
+			m_frames_remaining = in_ramp_frame_count;
+		}
+	}
+
+	float GetValue() const
+	{
+		return m_value;
+	}
+
+	// Multiply the samples by the ramp, advancing it by in_frame_count frames.
+	void Apply(float* io_samples, size_t in_frame_count)
+	{
+		// The last frame of a ramp gets the target itself rather than the sum
+		// of the steps, which can miss it by a rounding error, so only the
+		// frames before it are interpolated.
+		bool finishes = in_frame_count >= m_frames_remaining;
+		size_t ramp_frame_count = !finishes ? in_frame_count : (m_frames_remaining > 0 ? m_frames_remaining - 1 : 0);
+		float start_value = m_value;
+		float step = m_step;
+		for (size_t i = 0; i < ramp_frame_count; i++)
+		{
+			io_samples[i] *= start_value + step * static_cast<float>(i + 1);
+		}
+
+		if (finishes)
+		{
+			// The ramp finished in this block. Land exactly on the target and
+			// hold it for the rest of the block.
+			Reset(m_target);
+			float value = m_value;
+			for (size_t i = ramp_frame_count; i < in_frame_count; i++)
+			{
+				io_samples[i] *= value;
+			}
+		}
+		else
+		{
+			m_frames_remaining -= static_cast<uint32_t>(ramp_frame_count);
+			m_value = start_value + step * static_cast<float>(ramp_frame_count);
+		}
+	}
+
+private:
+	float		m_value;
+	float		m_target;
+	float		m_step;
+	uint32_t	m_frames_remaining;
+};
+
+#endif /* SimpleAudioParameterRamp_h */
@@ -0,0 +1,139 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A writer that copies blocks of frames into an interleaved
+             IO ring buffer.
+*/
+
+#ifndef SimpleAudioRingWriter_h
+#define SimpleAudioRingWriter_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Writes frames into an interleaved ring buffer of any sample type and channel
+// count. Each write splits the block into at most two contiguous spans at the
+// wrap point, so the only modulo is the one that finds the starting frame, and
+// the copy loops run over plain arrays the compiler can vectorize.
+template <typename SampleType>
+class SimpleAudioRingWriter
+{
+public:
+	SimpleAudioRingWriter(SampleType* in_buffer, size_t in_buffer_frame_count, uint32_t in_channels_per_frame)
+	:	m_buffer(in_buffer),
+		m_buffer_frame_count(in_buffer_frame_count),
+		m_channels_per_frame(in_channels_per_frame)
+	{
+	}
+
+	// Write a block of mono samples to every channel of the frames starting at
+	// the given absolute frame position.
+	void WriteMonoFrames(uint64_t in_frame_position, const SampleType* in_samples, size_t in_frame_count) const
+	{
+		ForEachSpan(in_frame_position, in_frame_count, [this, in_samples](size_t in_ring_frame, size_t in_source_frame, size_t in_span_frame_count)
+		{
+			SampleType* destination = m_buffer + in_ring_frame * m_channels_per_frame;
+			const SampleType* source = in_samples + in_source_frame;
+			switch (m_channels_per_frame)
+			{
+				case 1:
+					memcpy(destination, source, in_span_frame_count * sizeof(SampleType));
+					break;
+
+				case 2:
+					CopyMonoToFrames<2>(destination, source, in_span_frame_count);
+					break;
+
+				case 4:
+					CopyMonoToFrames<4>(destination, source, in_span_frame_count);
+					break;
+
+				case 8:
+					CopyMonoToFrames<8>(destination, source, in_span_frame_count);
+					break;
+
+				case 16:
+					CopyMonoToFrames<16>(destination, source, in_span_frame_count);
+					break;
+
+				case 32:
+					CopyMonoToFrames<32>(destination, source, in_span_frame_count);
+					break;
+
+				default:
+					for (size_t i = 0; i < in_span_frame_count; i++)
+					{
+						for (uint32_t channel_index = 0; channel_index < m_channels_per_frame; channel_index++)
+						{
+							destination[i * m_channels_per_frame + channel_index] = source[i];
+						}
+					}
+					break;
+			}
+		});
+	}
+
+	// Write a block of frames that are already interleaved with the ring
+	// buffer's channel count.
+	void WriteInterleavedFrames(uint64_t in_frame_position, const SampleType* in_samples, size_t in_frame_count) const
+	{
+		ForEachSpan(in_frame_position, in_frame_count, [this, in_samples](size_t in_ring_frame, size_t in_source_frame, size_t in_span_frame_count)
+		{
+			memcpy(m_buffer + in_ring_frame * m_channels_per_frame,
+				   in_samples + in_source_frame * m_channels_per_frame,
+				   in_span_frame_count * m_channels_per_frame * sizeof(SampleType));
+		});
+	}
+
+private:
+	// Copy each mono sample to every channel of its frame. With the channel count
+	// fixed at compile time the inner loop becomes a vector broadcast and store,
+	// which a loop to m_channels_per_frame doesn't get, so the common channel
+	// counts each get their own copy of this.
+	template <uint32_t k_channels_per_frame>
+	static void CopyMonoToFrames(SampleType* out_frames, const SampleType* in_samples, size_t in_frame_count)
+	{
+		for (size_t i = 0; i < in_frame_count; i++)
+		{
+			SampleType sample = in_samples[i];
+			for (uint32_t channel_index = 0; channel_index < k_channels_per_frame; channel_index++)
+			{
+				out_frames[i * k_channels_per_frame + channel_index] = sample;
+			}
+		}
+	}
+
+	// Call the operation once per contiguous span of the ring buffer that the
+	// block covers. A block no longer than the ring buffer produces at most two
+	// spans.
+	template <typename Operation>
+	void ForEachSpan(uint64_t in_frame_position, size_t in_frame_count, Operation in_operation) const
+	{
+		if (m_buffer == nullptr || m_buffer_frame_count == 0 || m_channels_per_frame == 0)
+		{
+			return;
+		}
+
+		size_t ring_frame = static_cast<size_t>(in_frame_position % m_buffer_frame_count);
+		size_t source_frame = 0;
+		while (source_frame < in_frame_count)
+		{
+			size_t frames_until_wrap = m_buffer_frame_count - ring_frame;
+			size_t frames_remaining = in_frame_count - source_frame;
+			size_t span_frame_count = frames_remaining < frames_until_wrap ? frames_remaining : frames_until_wrap;
+
+			in_operation(ring_frame, source_frame, span_frame_count);
+
+			source_frame += span_frame_count;
+			ring_frame = 0;
+		}
+	}
+
+	SampleType*	m_buffer;
+	size_t		m_buffer_frame_count;
+	uint32_t	m_channels_per_frame;
+};
+
+#endif /* SimpleAudioRingWriter_h */
@@ -0,0 +1,114 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A sample clock that maps sample times to host times with
+             an exact rational rate.
+*/
+
+#ifndef SimpleAudioSampleClock_h
+#define SimpleAudioSampleClock_h
+
+#include <stdint.h>
+
+// Tracks a running sample time and converts sample times to host times. The
+// host time for a sample time is the anchor plus the sample time multiplied by
+// the exact ratio of host ticks per frame, so converting a far-off sample time
+// doesn't accumulate the rounding error that adding a truncated tick count per
+// buffer does. This has no DriverKit dependencies; the caller supplies the
+// host ticks, which makes it usable with a virtual clock. A clock that's all
+// zeros is valid and reports every sample time at host time zero.
+//
+// The anchor is a sample time and host time pair. Start anchors sample time
+// zero; ChangeRate re-anchors at the current sample time so the clock can
+// switch rates while running without moving any host time it already handed
+// out for an earlier sample time. The frames between the previous anchor and
+// the new one keep converting at the rate they played at, so a sample time
+// from the last advance before the change, such as a zero timestamp the
+// caller hasn't published yet, still gets the host time it would have had.
+class SimpleAudioSampleClock
+{
+public:
+	// Set the rate as in_host_ticks_numerator / in_host_ticks_denominator host
+	// ticks per frame.
+	void SetRate(uint64_t in_host_ticks_numerator, uint64_t in_host_ticks_denominator)
+	{
+		m_host_ticks_numerator = in_host_ticks_numerator;
+		m_host_ticks_denominator = in_host_ticks_denominator;
+	}
+
+	void Start(uint64_t in_anchor_host_time)
+	{
+		m_anchor_host_time = in_anchor_host_time;
+		m_anchor_sample_time = 0;
+		m_sample_time = 0;
+		m_has_previous_segment = false;
+	}
+
+	// Switch to a new rate from the current sample time on. Switching again
+	// before the clock advances only replaces the new rate.
+	void ChangeRate(uint64_t in_host_ticks_numerator, uint64_t in_host_ticks_denominator)
+	{
+		if (m_sample_time != m_anchor_sample_time)
+		{
+			m_previous_anchor_host_time = m_anchor_host_time;
+			m_previous_anchor_sample_time = m_anchor_sample_time;
+			m_previous_host_ticks_numerator = m_host_ticks_numerator;
+			m_previous_host_ticks_denominator = m_host_ticks_denominator;
+			m_has_previous_segment = true;
+			m_anchor_host_time = HostTimeForSampleTime(m_sample_time);
+			m_anchor_sample_time = m_sample_time;
+		}
+		SetRate(in_host_ticks_numerator, in_host_ticks_denominator);
+	}
+
+	uint64_t GetSampleTime() const
+	{
+		return m_sample_time;
+	}
+
+	void Advance(uint64_t in_frame_count)
+	{
+		m_sample_time += in_frame_count;
+	}
+
+	uint64_t HostTimeForSampleTime(uint64_t in_sample_time) const
+	{
+		if (in_sample_time < m_anchor_sample_time && m_has_previous_segment && in_sample_time >= m_previous_anchor_sample_time)
+		{
+			return ConvertSampleTime(in_sample_time, m_previous_anchor_sample_time, m_previous_anchor_host_time, m_previous_host_ticks_numerator, m_previous_host_ticks_denominator);
+		}
+		return ConvertSampleTime(in_sample_time, m_anchor_sample_time, m_anchor_host_time, m_host_ticks_numerator, m_host_ticks_denominator);
+	}
+
+private:
+	static uint64_t ConvertSampleTime(uint64_t in_sample_time, uint64_t in_anchor_sample_time, uint64_t in_anchor_host_time, uint64_t in_host_ticks_numerator, uint64_t in_host_ticks_denominator)
+	{
+		if (in_host_ticks_denominator == 0)
+		{
+			return in_anchor_host_time;
+		}
+		if (in_sample_time < in_anchor_sample_time)
+		{
+			auto ticks = (static_cast<unsigned __int128>(in_anchor_sample_time - in_sample_time) * in_host_ticks_numerator) / in_host_ticks_denominator;
+			return in_anchor_host_time - static_cast<uint64_t>(ticks);
+		}
+		auto ticks = (static_cast<unsigned __int128>(in_sample_time - in_anchor_sample_time) * in_host_ticks_numerator) / in_host_ticks_denominator;
+		return in_anchor_host_time + static_cast<uint64_t>(ticks);
+	}
+
+	uint64_t	m_anchor_host_time;
+	uint64_t	m_anchor_sample_time;
+	uint64_t	m_sample_time;
+	uint64_t	m_host_ticks_numerator;
+	uint64_t	m_host_ticks_denominator;
+
+	// The anchor and rate before the last rate change.
+	bool		m_has_previous_segment;
+	uint64_t	m_previous_anchor_host_time;
+	uint64_t	m_previous_anchor_sample_time;
+	uint64_t	m_previous_host_ticks_numerator;
+	uint64_t	m_previous_host_ticks_denominator;
+};
+
+#endif /* SimpleAudioSampleClock_h */
@@ -0,0 +1,162 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A converter that turns blocks of float samples into
+             dithered integer samples.
+*/
+
+#ifndef SimpleAudioSampleConverter_h
+#define SimpleAudioSampleConverter_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+enum class SimpleAudioDitherMode : uint32_t
+{
+	None = 0,			// Round to the nearest integer sample.
+	TPDF = 1,			// Add triangular dither of plus or minus one LSB before rounding.
+	NoiseShaped = 2		// TPDF dither with first-order error feedback that pushes the noise up in frequency.
+};
+
+// Converts blocks of float samples in [-1, 1] to integer samples, clamping
+// values that are out of range. Every width scales by 2^(n-1), the convention
+// NullAudio and Core Audio use, so -1 maps to the most negative integer, zero
+// stays zero, and +1 clips to the largest integer one step short of it. Each
+// instance keeps the dither state for one
+// channel of one stream, so give each stream its own converter. A converter
+// that's all zeros is valid and doesn't dither, which lets it live in ivars
+// allocated with IONewZero.
+//
+// Without noise shaping the conversion loops have no loop-carried state. The
+// dither comes from hashing a running sample counter, not from a sequential
+// generator, so the compiler can vectorize them, with the clamping done by
+// vector min and max instructions.
+class SimpleAudioSampleConverter
+{
+public:
+	void SetDitherMode(SimpleAudioDitherMode in_dither_mode)
+	{
+		m_dither_mode = in_dither_mode;
+		m_error = 0.0f;
+	}
+
+	SimpleAudioDitherMode GetDitherMode() const
+	{
+		return m_dither_mode;
+	}
+
+	void ConvertToInt16(const float* in_samples, int16_t* out_samples, size_t in_sample_count)
+	{
+		Convert(in_samples, out_samples, in_sample_count, 32768.0f, -32768.0f, 32767.0f, [](int16_t* out_destination, size_t in_index, int32_t in_value)
+		{
+			out_destination[in_index] = static_cast<int16_t>(in_value);
+		});
+	}
+
+	// Writes packed, native-endian 24-bit samples, three bytes per sample.
+	void ConvertToInt24(const float* in_samples, uint8_t* out_samples, size_t in_sample_count)
+	{
+		Convert(in_samples, out_samples, in_sample_count, 8388608.0f, -8388608.0f, 8388607.0f, [](uint8_t* out_destination, size_t in_index, int32_t in_value)
+		{
+			uint8_t* sample = out_destination + 3 * in_index;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			sample[0] = static_cast<uint8_t>(in_value);
+			sample[1] = static_cast<uint8_t>(in_value >> 8);
+			sample[2] = static_cast<uint8_t>(in_value >> 16);
+#else
+			sample[0] = static_cast<uint8_t>(in_value >> 16);
+			sample[1] = static_cast<uint8_t>(in_value >> 8);
+			sample[2] = static_cast<uint8_t>(in_value);
+#endif
+		});
+	}
+
+	// Float samples only carry 24 bits of precision, so there's nothing for
+	// dither to do at 32 bits and this conversion never dithers.
+	void ConvertToInt32(const float* in_samples, int32_t* out_samples, size_t in_sample_count)
+	{
+		for (size_t i = 0; i < in_sample_count; i++)
+		{
+			// 2147483520 is the largest float below 2^31.
+			float value = in_samples[i] * 2147483648.0f;
+			value = fminf(fmaxf(value, -2147483648.0f), 2147483520.0f);
+			out_samples[i] = static_cast<int32_t>(rintf(value));
+		}
+	}
+
+	// Returns a value in [0, 1) from an integer hash of in_value. Consecutive
+	// inputs give uncorrelated outputs, so hashing a counter makes noise
+	// without a sequential generator.
+	static inline float UniformFromHash(uint32_t in_value)
+	{
+		in_value ^= in_value >> 16;
+		in_value *= 0x7feb352d;
+		in_value ^= in_value >> 15;
+		in_value *= 0x846ca68b;
+		in_value ^= in_value >> 16;
+		return static_cast<float>(in_value >> 8) * (1.0f / 16777216.0f);
+	}
+
+private:
+	template <typename DestinationType, typename Store>
+	void Convert(const float* in_samples, DestinationType* out_samples, size_t in_sample_count, float in_scale, float in_minimum, float in_maximum, Store in_store)
+	{
+		switch (m_dither_mode)
+		{
+			case SimpleAudioDitherMode::None:
+				for (size_t i = 0; i < in_sample_count; i++)
+				{
+					float value = fminf(fmaxf(in_samples[i] * in_scale, in_minimum), in_maximum);
+					in_store(out_samples, i, static_cast<int32_t>(rintf(value)));
+				}
+				break;
+
+			case SimpleAudioDitherMode::TPDF:
+			{
+				uint32_t counter = m_dither_counter;
+				for (size_t i = 0; i < in_sample_count; i++)
+				{
+					float value = in_samples[i] * in_scale + TPDFDither(counter + static_cast<uint32_t>(i));
+					value = fminf(fmaxf(value, in_minimum), in_maximum);
+					in_store(out_samples, i, static_cast<int32_t>(rintf(value)));
+				}
+				m_dither_counter = counter + static_cast<uint32_t>(in_sample_count);
+			}
+				break;
+
+			case SimpleAudioDitherMode::NoiseShaped:
+			{
+				// Subtract the previous sample's quantization error so the
+				// error's spectrum is shaped by (1 - z^-1). The error is limited
+				// so a clipped sample doesn't disturb the samples after it.
+				uint32_t counter = m_dither_counter;
+				float error = m_error;
+				for (size_t i = 0; i < in_sample_count; i++)
+				{
+					float value = in_samples[i] * in_scale - error;
+					float quantized = rintf(fminf(fmaxf(value + TPDFDither(counter + static_cast<uint32_t>(i)), in_minimum), in_maximum));
+					error = fminf(fmaxf(quantized - value, -2.0f), 2.0f);
+					in_store(out_samples, i, static_cast<int32_t>(quantized));
+				}
+				m_dither_counter = counter + static_cast<uint32_t>(in_sample_count);
+				m_error = error;
+			}
+				break;
+		}
+	}
+
+	// Returns triangular noise in (-1, 1) LSB made from the difference of two
+	// uniform values, each taken from a hash of the sample counter.
+	static inline float TPDFDither(uint32_t in_counter)
+	{
+		return UniformFromHash(2 * in_counter) - UniformFromHash(2 * in_counter + 1);
+	}
+
+	SimpleAudioDitherMode	m_dither_mode;
+	uint32_t				m_dither_counter;
+	float					m_error;
+};
+
+#endif /* SimpleAudioSampleConverter_h */
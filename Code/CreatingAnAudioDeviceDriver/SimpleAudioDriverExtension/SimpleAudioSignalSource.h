@@ -0,0 +1,248 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Signal sources that render blocks of float samples for the
+             device's data sources.
+*/
+
+#ifndef SimpleAudioSignalSource_h
+#define SimpleAudioSignalSource_h
+
+#include "SimpleAudioSampleConverter.h"
+#include "SimpleAudioToneGenerator.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// The values a source needs for one block.
+struct SimpleAudioSignalContext
+{
+	double	m_sample_rate;
+	double	m_frequency;	// Only used by sources that play a single tone.
+};
+
+// The interface every signal source implements. Render fills in_frame_count
+// frames of mono float samples in [-1, 1] and carries its state into the next
+// call, so consecutive blocks join without a discontinuity. Reset returns the
+// source to its starting state when IO starts.
+class SimpleAudioSignalSource
+{
+public:
+	virtual ~SimpleAudioSignalSource() = default;
+
+	virtual void Reset() = 0;
+
+	virtual void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) = 0;
+};
+
+// A sine at the context's frequency.
+class SimpleAudioSineSource : public SimpleAudioSignalSource
+{
+public:
+	void Reset() override
+	{
+		m_generator.Reset();
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) override
+	{
+		m_generator.Render(out_samples, in_frame_count, in_context.m_frequency, in_context.m_sample_rate, 1.0f);
+	}
+
+private:
+	SimpleAudioToneGenerator	m_generator = {};
+};
+
+// Uniform white noise. Each sample hashes a running counter, so the loop has
+// no loop-carried state and vectorizes.
+class SimpleAudioWhiteNoiseSource : public SimpleAudioSignalSource
+{
+public:
+	void Reset() override
+	{
+		m_counter = 0;
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) override
+	{
+		uint32_t counter = m_counter;
+		for (size_t i = 0; i < in_frame_count; i++)
+		{
+			out_samples[i] = 2.0f * SimpleAudioSampleConverter::UniformFromHash(counter + static_cast<uint32_t>(i)) - 1.0f;
+		}
+		m_counter = counter + static_cast<uint32_t>(in_frame_count);
+	}
+
+private:
+	uint32_t	m_counter = 0;
+};
+
+// Pink noise from white noise through Paul Kellet's three-pole filter, which
+// is within about 0.5 dB of -3 dB per octave across the audio band. The
+// filter is recursive, so only the white noise part of the loop vectorizes.
+class SimpleAudioPinkNoiseSource : public SimpleAudioSignalSource
+{
+public:
+	void Reset() override
+	{
+		m_white.Reset();
+		m_state[0] = m_state[1] = m_state[2] = 0.0f;
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) override
+	{
+		m_white.Render(out_samples, in_frame_count, in_context);
+
+		float state_0 = m_state[0];
+		float state_1 = m_state[1];
+		float state_2 = m_state[2];
+		for (size_t i = 0; i < in_frame_count; i++)
+		{
+			float white = out_samples[i];
+			state_0 = 0.99765f * state_0 + white * 0.0990460f;
+			state_1 = 0.96300f * state_1 + white * 0.2965164f;
+			state_2 = 0.57000f * state_2 + white * 1.0526913f;
+			// The filter has a lot of low-frequency gain; scale it so peaks
+			// stay below full scale.
+			out_samples[i] = 0.11f * (state_0 + state_1 + state_2 + white * 0.1848f);
+		}
+		m_state[0] = state_0;
+		m_state[1] = state_1;
+		m_state[2] = state_2;
+	}
+
+private:
+	SimpleAudioWhiteNoiseSource	m_white;
+	float						m_state[3] = {};
+};
+
+// A logarithmic sweep from 20 Hz to 20 kHz, or to just below Nyquist, that
+// repeats every ten seconds. Within a block the frequency moves linearly, so
+// each frame's phase has a closed form and the loop vectorizes.
+class SimpleAudioSweepSource : public SimpleAudioSignalSource
+{
+public:
+	void Reset() override
+	{
+		m_phase = 0.0;
+		m_frame_index = 0;
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) override
+	{
+		double sample_rate = in_context.m_sample_rate;
+		double end_frequency = fmin(20000.0, 0.45 * sample_rate);
+		uint64_t sweep_frame_count = static_cast<uint64_t>(10.0 * sample_rate);
+		if (sweep_frame_count == 0)
+		{
+			memset(out_samples, 0, in_frame_count * sizeof(float));
+			return;
+		}
+
+		double start_position = static_cast<double>(m_frame_index % sweep_frame_count) / static_cast<double>(sweep_frame_count);
+		double end_position = start_position + static_cast<double>(in_frame_count) / static_cast<double>(sweep_frame_count);
+		double start_increment = FrequencyAt(start_position, end_frequency) / sample_rate;
+		double increment_slope = (FrequencyAt(end_position, end_frequency) / sample_rate - start_increment) / static_cast<double>(in_frame_count);
+
+		// As in SimpleAudioToneGenerator, the phase is computed and wrapped in
+		// double precision and only rounded to float once it's in [0, 1).
+		double start_phase = m_phase;
+		double half_slope = 0.5 * increment_slope;
+		for (size_t i = 0; i < in_frame_count; i++)
+		{
+			double frame = static_cast<double>(i);
+			double phase = start_phase + frame * (start_increment + frame * half_slope);
+			phase -= static_cast<double>(static_cast<int32_t>(phase));
+			out_samples[i] = SimpleAudioToneGenerator::SineOfPhase(static_cast<float>(phase));
+		}
+
+		double frame_count = static_cast<double>(in_frame_count);
+		m_phase += frame_count * (start_increment + 0.5 * increment_slope * frame_count);
+		m_phase -= floor(m_phase);
+		m_frame_index += in_frame_count;
+	}
+
+private:
+	static double FrequencyAt(double in_position, double in_end_frequency)
+	{
+		return 20.0 * pow(in_end_frequency / 20.0, in_position);
+	}
+
+	double		m_phase = 0.0;
+	uint64_t	m_frame_index = 0;
+};
+
+// Eight equal-level tones spaced an octave apart from 80 Hz, summed.
+class SimpleAudioMultitoneSource : public SimpleAudioSignalSource
+{
+public:
+	void Reset() override
+	{
+		for (auto& generator : m_generators)
+		{
+			generator.Reset();
+		}
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) override
+	{
+		memset(out_samples, 0, in_frame_count * sizeof(float));
+
+		float tone[kBlockFrameCount];
+		double frequency = 80.0;
+		for (auto& generator : m_generators)
+		{
+			for (size_t frame_offset = 0; frame_offset < in_frame_count; frame_offset += kBlockFrameCount)
+			{
+				size_t frame_count = in_frame_count - frame_offset < kBlockFrameCount ? in_frame_count - frame_offset : kBlockFrameCount;
+				generator.Render(tone, frame_count, frequency, in_context.m_sample_rate, 1.0f / kToneCount);
+				for (size_t i = 0; i < frame_count; i++)
+				{
+					out_samples[frame_offset + i] += tone[i];
+				}
+			}
+			frequency *= 2.0;
+		}
+	}
+
+private:
+	static constexpr size_t kToneCount = 8;
+	static constexpr size_t kBlockFrameCount = 256;
+
+	SimpleAudioToneGenerator	m_generators[kToneCount] = {};
+};
+
+// A full-scale impulse ten times a second, for checking latency and alignment.
+class SimpleAudioImpulseTrainSource : public SimpleAudioSignalSource
+{
+public:
+	void Reset() override
+	{
+		m_frame_index = 0;
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, const SimpleAudioSignalContext& in_context) override
+	{
+		memset(out_samples, 0, in_frame_count * sizeof(float));
+
+		uint64_t period = static_cast<uint64_t>(in_context.m_sample_rate / 10.0);
+		if (period != 0)
+		{
+			// Find the first impulse at or after the start of the block.
+			uint64_t offset = (period - m_frame_index % period) % period;
+			for (uint64_t i = offset; i < in_frame_count; i += period)
+			{
+				out_samples[i] = 1.0f;
+			}
+		}
+		m_frame_index += in_frame_count;
+	}
+
+private:
+	uint64_t	m_frame_index = 0;
+};
+
+#endif /* SimpleAudioSignalSource_h */
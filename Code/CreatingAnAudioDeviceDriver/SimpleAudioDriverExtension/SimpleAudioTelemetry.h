@@ -0,0 +1,100 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Layout of the telemetry ring that the driver shares with
+             user clients, and the writer the driver uses to fill it.
+*/
+
+#ifndef SimpleAudioTelemetry_h
+#define SimpleAudioTelemetry_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define kSimpleAudioTelemetryVersion 1
+#define kSimpleAudioTelemetryCapacity 1024	// Must be a power of two.
+
+enum SimpleAudioTelemetryEventType : uint32_t
+{
+	SimpleAudioTelemetryEventType_TimerFired = 1,		// m_value_0 is lateness in host ticks, m_value_1 is fill duration in host ticks.
+	SimpleAudioTelemetryEventType_ZeroTimestamp = 2,	// The sample time and host time pair published to the HAL.
+	SimpleAudioTelemetryEventType_ConfigChange = 3,		// m_value_0 is the change action, m_value_1 is the resulting sample rate.
+	SimpleAudioTelemetryEventType_SourceRender = 4		// m_value_0 is the generator type, m_value_1 is the fill's render time in host ticks.
+};
+
+// Each event carries the sequence number it was written with, which is its
+// ring index plus one. A reader copies the event and then checks that the
+// sequence number didn't change and matches the index it expected; if not,
+// the producer lapped the reader and the event is lost.
+struct SimpleAudioTelemetryEvent
+{
+	uint64_t	m_sequence;
+	uint32_t	m_type;
+	uint32_t	m_reserved;
+	uint64_t	m_sample_time;
+	uint64_t	m_host_time;
+	uint64_t	m_value_0;
+	uint64_t	m_value_1;
+};
+
+// The shared memory starts with this header, padded to a cache line, followed
+// by kSimpleAudioTelemetryCapacity events. m_write_index is the total number
+// of events ever written; the next event goes to m_write_index modulo the
+// capacity.
+struct SimpleAudioTelemetryRing
+{
+	uint32_t					m_version;
+	uint32_t					m_capacity;
+	uint64_t					m_write_index;
+	uint64_t					m_reserved[6];
+	SimpleAudioTelemetryEvent	m_events[kSimpleAudioTelemetryCapacity];
+};
+
+// The single producer for a telemetry ring. Writing never blocks or fails; a
+// slow reader just misses events. All writes must come from one thread or one
+// serial queue. A writer that's all zeros has no ring and drops every event.
+class SimpleAudioTelemetryWriter
+{
+public:
+	void Attach(SimpleAudioTelemetryRing* in_ring)
+	{
+		m_ring = in_ring;
+		if (m_ring != nullptr)
+		{
+			m_ring->m_version = kSimpleAudioTelemetryVersion;
+			m_ring->m_capacity = kSimpleAudioTelemetryCapacity;
+			__atomic_store_n(&m_ring->m_write_index, 0, __ATOMIC_RELEASE);
+		}
+	}
+
+	void Write(SimpleAudioTelemetryEventType in_type, uint64_t in_sample_time, uint64_t in_host_time, uint64_t in_value_0, uint64_t in_value_1)
+	{
+		if (m_ring == nullptr)
+		{
+			return;
+		}
+
+		uint64_t index = __atomic_load_n(&m_ring->m_write_index, __ATOMIC_RELAXED);
+		SimpleAudioTelemetryEvent& event = m_ring->m_events[index & (kSimpleAudioTelemetryCapacity - 1)];
+
+		// Invalidate the slot before touching the payload so a reader in the
+		// middle of copying it sees the change.
+		__atomic_store_n(&event.m_sequence, 0, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		event.m_type = in_type;
+		event.m_sample_time = in_sample_time;
+		event.m_host_time = in_host_time;
+		event.m_value_0 = in_value_0;
+		event.m_value_1 = in_value_1;
+
+		__atomic_store_n(&event.m_sequence, index + 1, __ATOMIC_RELEASE);
+		__atomic_store_n(&m_ring->m_write_index, index + 1, __ATOMIC_RELEASE);
+	}
+
+private:
+	SimpleAudioTelemetryRing*	m_ring;
+};
+
+#endif /* SimpleAudioTelemetry_h */
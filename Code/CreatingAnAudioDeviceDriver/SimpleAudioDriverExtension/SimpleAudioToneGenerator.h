@@ -0,0 +1,78 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A phase-continuous sine tone generator that renders blocks
+             of float samples.
+*/
+
+#ifndef SimpleAudioToneGenerator_h
+#define SimpleAudioToneGenerator_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+// Renders a sine tone a block at a time. The phase carries over from one block
+// to the next, and the frequency only sets the per-frame phase increment, so
+// the waveform stays continuous when the frequency changes. This has no
+// DriverKit dependencies, so it builds and runs outside the driver as well. A
+// generator that's all zeros is valid and starts at phase zero.
+class SimpleAudioToneGenerator
+{
+public:
+	void Reset()
+	{
+		m_phase = 0.0;
+	}
+
+	void Render(float* out_samples, size_t in_frame_count, double in_frequency, double in_sample_rate, float in_gain)
+	{
+		double phase_increment = in_frequency / in_sample_rate;
+
+		// Each frame's phase comes from the block's starting phase rather than a
+		// running sum, so there is no rounding drift and no loop-carried
+		// dependency, which lets the compiler vectorize the loop. The phase is
+		// computed and wrapped in double precision. In float, the unwrapped phase
+		// reaches hundreds of cycles by the end of a long block and keeps only a
+		// few bits below the cycle, which put spurs within about 87 dB of a tone
+		// rendered in 65536-frame blocks. Only the wrapped phase, in [0, 1), is
+		// rounded to float.
+		double start_phase = m_phase;
+		for (size_t i = 0; i < in_frame_count; i++)
+		{
+			double phase = start_phase + static_cast<double>(i) * phase_increment;
+			phase -= static_cast<double>(static_cast<int32_t>(phase));
+			out_samples[i] = in_gain * SineOfPhase(static_cast<float>(phase));
+		}
+
+		// Carry the phase between blocks in double precision.
+		m_phase += static_cast<double>(in_frame_count) * phase_increment;
+		m_phase -= floor(m_phase);
+	}
+
+	// Compute sin(2 * pi * in_phase) for a phase in [0, 1) without branches so
+	// that loops calling this vectorize. Fold the phase into the first quarter
+	// cycle, then evaluate an odd polynomial. The result is within about 2.1e-7
+	// of sin over the whole cycle, about -134 dB and far below the 16-bit noise
+	// floor. Stopping at the x^11 term accounts for about 6e-8 of that; the rest
+	// is rounding in the float arithmetic.
+	static inline float SineOfPhase(float in_phase)
+	{
+		float quarter_cycles = in_phase * 4.0f;
+		float half_cycle = static_cast<float>(static_cast<int32_t>(quarter_cycles * 0.5f));
+		float sign = 1.0f - 2.0f * half_cycle;
+		float folded = 1.0f - fabsf(1.0f - (quarter_cycles - 2.0f * half_cycle));
+
+		float x = folded * static_cast<float>(M_PI_2);
+		float x2 = x * x;
+		float polynomial = 1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f)))));
+		return sign * x * polynomial;
+	}
+
+private:
+	// The phase in cycles, kept in [0, 1).
+	double	m_phase;
+};
+
+#endif /* SimpleAudioToneGenerator_h */
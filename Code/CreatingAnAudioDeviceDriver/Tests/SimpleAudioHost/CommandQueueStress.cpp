@@ -0,0 +1,249 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Pushes commands into SimpleAudioCommandQueue from several
+             threads at once and checks that none are lost, duplicated,
+             or torn, and that Push fails exactly when the queue is full.
+*/
+
+#include "SimpleAudioCommandQueue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+
+// The queue has the driver's capacity. Three checks:
+//
+// - One thread pushes and pops at random against a model queue, so Push must
+//   fail exactly when the model holds Capacity commands and Pop exactly when
+//   it's empty.
+// - With the consumer stopped, producers race to fill the empty queue. Exactly
+//   Capacity pushes may succeed between them, every later one must fail, and
+//   draining must give back exactly the commands that were pushed.
+// - Producers push a numbered stream each while the consumer pops. The
+//   consumer must see every producer's commands exactly once and in order.
+//   Each command carries a check value, so a command read while it was being
+//   written shows up too. A queue that loses commands would leave the consumer
+//   waiting forever, so everyone gives up if nothing arrives for a while.
+
+constexpr size_t	k_capacity = 64;
+constexpr uint32_t	k_number_producers = 4;
+constexpr uint32_t	k_number_commands_per_producer = 200000;
+constexpr uint32_t	k_number_fill_rounds = 2000;
+constexpr double	k_stall_seconds = 10.0;
+
+struct Command
+{
+	uint32_t	m_producer;
+	uint32_t	m_index;
+	uint64_t	m_check;
+};
+
+using Queue = SimpleAudioCommandQueue<Command, k_capacity>;
+
+static uint64_t g_number_failures = 0;
+
+static void Check(bool in_condition, const char* in_what)
+{
+	if (!in_condition)
+	{
+		if (g_number_failures < 10)
+		{
+			fprintf(stderr, "CommandQueueStress: %s\n", in_what);
+		}
+		g_number_failures += 1;
+	}
+}
+
+static uint64_t CheckValue(uint32_t in_producer, uint32_t in_index)
+{
+	return (static_cast<uint64_t>(in_producer) << 32 | in_index) * 0x9e3779b97f4a7c15ULL;
+}
+
+static Command MakeCommand(uint32_t in_producer, uint32_t in_index)
+{
+	return Command { in_producer, in_index, CheckValue(in_producer, in_index) };
+}
+
+static void CheckAgainstModel(std::mt19937_64& io_random)
+{
+	static Queue queue;
+	queue.Initialize();
+	std::deque<Command> model;
+	uint32_t next_index = 0;
+	for (uint32_t step = 0; step < 1000000; step++)
+	{
+		// Lean towards whichever side keeps the queue moving between empty and full.
+		bool push = io_random() % 64 < (step / 4096 % 2 == 0 ? 40 : 24);
+		if (push)
+		{
+			Command command = MakeCommand(0, next_index++);
+			bool pushed = queue.Push(command);
+			Check(pushed == (model.size() < k_capacity), "Push didn't fail exactly when the queue was full");
+			if (pushed)
+			{
+				model.push_back(command);
+			}
+		}
+		else
+		{
+			Command command = {};
+			bool popped = queue.Pop(command);
+			Check(popped == !model.empty(), "Pop didn't fail exactly when the queue was empty");
+			if (popped && !model.empty())
+			{
+				Check(command.m_index == model.front().m_index, "Pop returned commands out of order");
+				model.pop_front();
+			}
+		}
+	}
+}
+
+static void CheckConcurrentFill()
+{
+	static Queue queue;
+	queue.Initialize();
+	uint32_t number_overfilled_rounds = 0;
+	for (uint32_t round = 0; round < k_number_fill_rounds; round++)
+	{
+		std::atomic<uint32_t> number_pushed(0);
+		std::vector<std::thread> producers;
+		for (uint32_t producer = 0; producer < k_number_producers; producer++)
+		{
+			producers.emplace_back([&, producer]()
+			{
+				// Each producer tries for the whole capacity, so together they ask
+				// for several times what fits.
+				for (uint32_t index = 0; index < k_capacity; index++)
+				{
+					if (queue.Push(MakeCommand(producer, index)))
+					{
+						number_pushed.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			});
+		}
+		for (std::thread& producer : producers)
+		{
+			producer.join();
+		}
+		Check(number_pushed.load() == k_capacity, "the producers didn't fill the queue exactly");
+		Check(!queue.Push(MakeCommand(0, 0)), "Push succeeded on a full queue");
+
+		// Drain, checking every command is one that a producer pushed.
+		std::vector<uint32_t> next_index(k_number_producers, 0);
+		uint32_t number_popped = 0;
+		Command command = {};
+		while (queue.Pop(command))
+		{
+			bool valid = command.m_producer < k_number_producers && command.m_check == CheckValue(command.m_producer, command.m_index);
+			Check(valid, "a command came back torn");
+			if (valid)
+			{
+				Check(command.m_index == next_index[command.m_producer], "a producer's commands came back out of order");
+				next_index[command.m_producer] = command.m_index + 1;
+			}
+			number_popped += 1;
+		}
+		number_overfilled_rounds += number_popped != k_capacity;
+	}
+	Check(number_overfilled_rounds == 0, "draining a full queue didn't give back exactly its capacity");
+}
+
+static void CheckConcurrentStreams()
+{
+	static Queue queue;
+	queue.Initialize();
+	std::vector<uint64_t> number_full(k_number_producers, 0);
+	std::atomic<bool> give_up(false);
+	std::vector<std::thread> producers;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t producer = 0; producer < k_number_producers; producer++)
+	{
+		producers.emplace_back([&, producer]()
+		{
+			for (uint32_t index = 0; index < k_number_commands_per_producer; index++)
+			{
+				while (!queue.Push(MakeCommand(producer, index)))
+				{
+					if (give_up.load(std::memory_order_relaxed))
+					{
+						return;
+					}
+					number_full[producer] += 1;
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	std::vector<uint32_t> next_index(k_number_producers, 0);
+	uint64_t number_popped = 0;
+	uint64_t number_torn = 0;
+	uint64_t number_out_of_order = 0;
+	auto last_arrival = std::chrono::steady_clock::now();
+	while (number_popped < static_cast<uint64_t>(k_number_producers) * k_number_commands_per_producer)
+	{
+		Command command = {};
+		if (!queue.Pop(command))
+		{
+			if (std::chrono::duration<double>(std::chrono::steady_clock::now() - last_arrival).count() > k_stall_seconds)
+			{
+				give_up.store(true, std::memory_order_relaxed);
+				Check(false, "the consumer stopped getting commands");
+				break;
+			}
+			std::this_thread::yield();
+			continue;
+		}
+		last_arrival = std::chrono::steady_clock::now();
+		number_popped += 1;
+		if (command.m_producer >= k_number_producers || command.m_check != CheckValue(command.m_producer, command.m_index))
+		{
+			number_torn += 1;
+			continue;
+		}
+		number_out_of_order += command.m_index != next_index[command.m_producer];
+		next_index[command.m_producer] = command.m_index + 1;
+	}
+	for (std::thread& producer : producers)
+	{
+		producer.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Command command = {};
+	Check(!queue.Pop(command), "the queue has commands left over");
+	Check(number_torn == 0, "commands came back torn");
+	Check(number_out_of_order == 0, "commands were lost, duplicated, or reordered");
+	for (uint32_t producer = 0; producer < k_number_producers; producer++)
+	{
+		Check(next_index[producer] == k_number_commands_per_producer, "a producer's last command never arrived");
+	}
+
+	uint64_t total_full = 0;
+	for (uint64_t full : number_full)
+	{
+		total_full += full;
+	}
+	printf("%u producers, %llu commands through a %zu-command queue: %.1f million per second, %llu pushes found it full\n", k_number_producers, static_cast<unsigned long long>(number_popped), k_capacity, number_popped / seconds / 1.0e6, static_cast<unsigned long long>(total_full));
+}
+
+int main(int argc, const char* argv[])
+{
+	uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0) : 1;
+	std::mt19937_64 random(seed);
+
+	CheckAgainstModel(random);
+	CheckConcurrentFill();
+	CheckConcurrentStreams();
+
+	printf("CommandQueueStress: seed %llu, %llu failures\n", static_cast<unsigned long long>(seed), static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Runs the SimpleAudio device's timer on a virtual clock while
+             configuration changes and parameter updates land in the
+             middle of IO, checking the timestamps as it goes.
+*/
+
+#include "SimpleAudioHost.h"
+
+#include "SimpleAudioDevice.h"
+#include "SimpleAudioDriver.h"
+#include "SimpleAudioDriverKeys.h"
+#include "SimpleAudioTelemetry.h"
+
+#include <stdlib.h>
+#include <random>
+
+// Each step moves the clock forward by a random amount, so the timer fires
+// anywhere from zero to several times per step, and then does one random
+// thing to the device from outside its work queue the way the HAL or a user
+// client would. Timers fire late by a random amount. The clock runs on a
+// 125/3 timebase so host ticks aren't nanoseconds.
+
+constexpr uint32_t	k_number_steps = 20000;
+constexpr uint32_t	k_timebase_numerator = 125;
+constexpr uint32_t	k_timebase_denominator = 3;
+constexpr uint32_t	k_zero_timestamp_period = 32768;
+
+// The biggest fill is 8192 frames at the base rate of the 44.1 kHz family.
+constexpr double	k_max_fill_seconds = 8192.0 / 44100.0;
+
+static const double k_sample_rates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0, 352800.0, 384000.0 };
+constexpr size_t	k_number_sample_rates = sizeof(k_sample_rates) / sizeof(k_sample_rates[0]);
+
+static const uint32_t k_data_sources[] =
+{
+	SimpleAudioDriverDataSource_Sine440, SimpleAudioDriverDataSource_Sine660, SimpleAudioDriverDataSource_WhiteNoise,
+	SimpleAudioDriverDataSource_PinkNoise, SimpleAudioDriverDataSource_Sweep, SimpleAudioDriverDataSource_Multitone,
+	SimpleAudioDriverDataSource_ImpulseTrain
+};
+
+static uint64_t HostTicksForSeconds(double in_seconds)
+{
+	return static_cast<uint64_t>(in_seconds * NSEC_PER_SEC * k_timebase_denominator / k_timebase_numerator);
+}
+
+static uint64_t g_number_failures = 0;
+
+static void Check(bool in_condition, const char* in_what, uint32_t in_step)
+{
+	if (!in_condition)
+	{
+		if (g_number_failures < 20)
+		{
+			fprintf(stderr, "DeviceTimerLoop: step %u: %s\n", in_step, in_what);
+		}
+		g_number_failures += 1;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0) : 1;
+	std::mt19937_64 random(seed);
+	uint32_t step = 0;
+
+	SimpleAudioHost::SetTimebase(k_timebase_numerator, k_timebase_denominator);
+	SimpleAudioHost::SetHostTime(HostTicksForSeconds(1.0));
+
+	// Consecutive zero timestamps are one period apart in sample time, and
+	// their host times move forward by a period at some mix of the rates.
+	uint64_t min_zts_host_delta = HostTicksForSeconds(k_zero_timestamp_period / k_sample_rates[k_number_sample_rates - 1]) - 1;
+	uint64_t max_zts_host_delta = HostTicksForSeconds(k_zero_timestamp_period / k_sample_rates[0]) + 1;
+	bool has_zts = false;
+	uint64_t last_zts_sample_time = 0;
+	uint64_t last_zts_host_time = 0;
+	uint64_t number_zts = 0;
+	uint64_t last_deadline = 0;
+	SimpleAudioHost::SetZeroTimestampObserver([&](IOUserAudioDevice* in_device, uint64_t in_sample_time, uint64_t in_host_time) {
+		(void)in_device;
+		if (in_sample_time == 0 && in_host_time == 0)
+		{
+			// IO is starting over.
+			has_zts = false;
+			last_deadline = 0;
+			return;
+		}
+		if (has_zts)
+		{
+			Check(in_sample_time == last_zts_sample_time + k_zero_timestamp_period, "zero timestamp sample times aren't a period apart", step);
+			Check(in_host_time > last_zts_host_time, "zero timestamp host time went backwards", step);
+			auto host_delta = in_host_time - last_zts_host_time;
+			Check(host_delta >= min_zts_host_delta && host_delta <= max_zts_host_delta, "zero timestamp host times are too far apart for any rate", step);
+		}
+		Check(in_host_time <= SimpleAudioHost::GetHostTime(), "zero timestamp is in the future", step);
+		has_zts = true;
+		last_zts_sample_time = in_sample_time;
+		last_zts_host_time = in_host_time;
+		number_zts += 1;
+	});
+
+	// The timer never goes back to an earlier deadline, and never sleeps
+	// longer than the biggest fill.
+	uint64_t max_wake_interval = HostTicksForSeconds(k_max_fill_seconds) + 1;
+	SimpleAudioHost::SetWakeObserver([&](uint64_t in_deadline) {
+		Check(in_deadline >= last_deadline, "timer deadline went backwards", step);
+		Check(in_deadline <= SimpleAudioHost::GetHostTime() + max_wake_interval, "timer deadline is too far out", step);
+		last_deadline = in_deadline;
+	});
+
+	// Mostly on time, sometimes a little late, now and then very late.
+	SimpleAudioHost::SetTimerLateness([&](uint64_t in_deadline) -> uint64_t {
+		(void)in_deadline;
+		auto roll = random() % 100;
+		return roll < 80 ? 0 : (roll < 98 ? random() % HostTicksForSeconds(0.002) : random() % HostTicksForSeconds(0.050));
+	});
+
+	auto driver = SimpleAudioHost::OpenDriver();
+	auto device = SimpleAudioHost::GetDevice(driver);
+	auto client = OSTypeAlloc(IOUserClient);
+	auto completion = OSAction::Create(nullptr);
+	OSSharedPtr<IOMemoryMap> telemetry_map;
+	auto telemetry = SimpleAudioHost::MapTelemetry(driver, telemetry_map);
+
+	if (driver->StartDevice(device->GetObjectID(), IOUserAudioStartStopFlags::None) != kIOReturnSuccess)
+	{
+		fprintf(stderr, "DeviceTimerLoop: StartDevice failed\n");
+		return 1;
+	}
+
+	uint64_t number_commands = 0;
+	uint64_t number_config_changes = 0;
+	uint64_t number_restarts = 0;
+	uint64_t last_timer_sample_time = 0;
+	uint64_t last_timer_host_time = 0;
+	bool has_timer_event = false;
+	uint64_t telemetry_read_index = 0;
+
+	// Every configuration change records itself as the newest telemetry event.
+	auto perform_config_change = [&](uint64_t in_change_action, OSObject* in_change_info) {
+		device->PerformDeviceConfigurationChange(in_change_action, in_change_info);
+		auto write_index = __atomic_load_n(&telemetry->m_write_index, __ATOMIC_ACQUIRE);
+		const auto& event = telemetry->m_events[(write_index - 1) & (kSimpleAudioTelemetryCapacity - 1)];
+		Check(event.m_type == SimpleAudioTelemetryEventType_ConfigChange && event.m_value_0 == in_change_action && event.m_value_1 == static_cast<uint64_t>(device->GetSampleRate()), "configuration change wasn't recorded", step);
+		number_config_changes += 1;
+	};
+
+	for (step = 0; step < k_number_steps; step++)
+	{
+		SimpleAudioHost::RunUntil(SimpleAudioHost::GetHostTime() + random() % HostTicksForSeconds(0.050));
+
+		// Each timer wakeup fills on from where the last one left off.
+		auto write_index = __atomic_load_n(&telemetry->m_write_index, __ATOMIC_ACQUIRE);
+		if (write_index - telemetry_read_index > kSimpleAudioTelemetryCapacity)
+		{
+			telemetry_read_index = write_index - kSimpleAudioTelemetryCapacity;
+			has_timer_event = false;
+		}
+		for (; telemetry_read_index < write_index; telemetry_read_index++)
+		{
+			const auto& event = telemetry->m_events[telemetry_read_index & (kSimpleAudioTelemetryCapacity - 1)];
+			if (event.m_type == SimpleAudioTelemetryEventType_TimerFired)
+			{
+				if (has_timer_event)
+				{
+					Check(event.m_sample_time > last_timer_sample_time, "timer fill sample time didn't move forward", step);
+					Check(event.m_host_time > last_timer_host_time, "timer fill host time didn't move forward", step);
+				}
+				has_timer_event = true;
+				last_timer_sample_time = event.m_sample_time;
+				last_timer_host_time = event.m_host_time;
+			}
+		}
+
+		auto roll = random() % 64;
+		if (roll < 4)
+		{
+			// The HAL switches to a specific rate.
+			auto rate = OSSharedPtr(OSNumber::withNumber(static_cast<uint64_t>(k_sample_rates[random() % k_number_sample_rates]), 64), OSNoRetain);
+			perform_config_change(k_sample_rate_config_change_action, rate.get());
+		}
+		else if (roll < 8)
+		{
+			// A user client asks to step to the next rate.
+			Check(driver->HandleTestConfigChange() == kIOReturnSuccess, "HandleTestConfigChange failed", step);
+			auto change_info = OSSharedPtr(OSString::withCString("Toggle Sample Rate"), OSNoRetain);
+			perform_config_change(k_custom_config_change_action, change_info.get());
+			SimpleAudioHost::PerformConfigurationChanges();
+		}
+		else if (roll < 24)
+		{
+			// A user client sends a valid batch of updates.
+			SimpleAudioDriverParameterUpdate updates[4];
+			auto number_updates = 1 + random() % 4;
+			for (size_t update_index = 0; update_index < number_updates; update_index++)
+			{
+				auto& update = updates[update_index];
+				update.m_parameter = static_cast<uint32_t>(random() % 6);
+				update.m_reserved = 0;
+				switch (update.m_parameter)
+				{
+					case SimpleAudioDriverParameter_InputVolume: update.m_value = (random() % 1001) / 1000.0; break;
+					case SimpleAudioDriverParameter_DataSource: update.m_value = k_data_sources[random() % 7]; break;
+					case SimpleAudioDriverParameter_ToneFrequency: update.m_value = 20.0 + random() % 20000; break;
+					case SimpleAudioDriverParameter_SampleRate: update.m_value = k_sample_rates[random() % k_number_sample_rates]; break;
+					case SimpleAudioDriverParameter_GeneratorType: update.m_value = static_cast<double>(random() % kSimpleAudioDriverNumGeneratorTypes); break;
+					default: update.m_value = 32 + random() % (8192 - 32 + 1); break;
+				}
+			}
+			auto data = OSSharedPtr(OSData::withBytes(updates, number_updates * sizeof(updates[0])), OSNoRetain);
+			auto ret = driver->HandleUpdateParameters(data.get(), client, completion);
+			Check(ret == kIOReturnSuccess || ret == kIOReturnNoSpace, "a valid parameter update was rejected", step);
+			number_commands += ret == kIOReturnSuccess ? 1 : 0;
+		}
+		else if (roll < 28)
+		{
+			// An invalid batch is turned away before it's queued. A generator type
+			// between two types would otherwise be truncated to the lower one.
+			static const SimpleAudioDriverParameterUpdate k_invalid_updates[] =
+			{
+				{ SimpleAudioDriverParameter_InputVolume, 0, 2.0 },
+				{ SimpleAudioDriverParameter_GeneratorType, 0, 1.5 },
+				{ SimpleAudioDriverParameter_GeneratorType, 0, -1.0 },
+				{ SimpleAudioDriverParameter_GeneratorType, 0, static_cast<double>(kSimpleAudioDriverNumGeneratorTypes) },
+				{ SimpleAudioDriverParameter_FillFrameSize, 0, 512.5 }
+			};
+			auto update = k_invalid_updates[random() % (sizeof(k_invalid_updates) / sizeof(k_invalid_updates[0]))];
+			auto data = OSSharedPtr(OSData::withBytes(&update, sizeof(update)), OSNoRetain);
+			Check(driver->HandleUpdateParameters(data.get(), client, completion) == kIOReturnBadArgument, "an invalid parameter update was accepted", step);
+		}
+		else if (roll < 36)
+		{
+			auto ret = driver->HandleToggleDataSource(client, completion);
+			Check(ret == kIOReturnSuccess || ret == kIOReturnNoSpace, "toggling the data source failed", step);
+			number_commands += ret == kIOReturnSuccess ? 1 : 0;
+		}
+		else if (roll < 44)
+		{
+			// The HAL gets to the rate changes that parameter updates asked for.
+			number_config_changes += SimpleAudioHost::PerformConfigurationChanges();
+		}
+		else if (roll == 44)
+		{
+			// IO stops and starts again, which starts the clock over.
+			Check(driver->StopDevice(device->GetObjectID(), IOUserAudioStartStopFlags::None) == kIOReturnSuccess, "StopDevice failed", step);
+			SimpleAudioHost::RunUntil(SimpleAudioHost::GetHostTime() + random() % HostTicksForSeconds(0.050));
+			Check(driver->StartDevice(device->GetObjectID(), IOUserAudioStartStopFlags::None) == kIOReturnSuccess, "StartDevice failed", step);
+			telemetry_read_index = __atomic_load_n(&telemetry->m_write_index, __ATOMIC_ACQUIRE);
+			has_timer_event = false;
+			number_restarts += 1;
+		}
+	}
+
+	// Play a full-scale sine for longer than the ring buffer holds at any rate.
+	SimpleAudioDriverParameterUpdate sine_updates[] =
+	{
+		{ SimpleAudioDriverParameter_InputVolume, 0, 1.0 },
+		{ SimpleAudioDriverParameter_DataSource, 0, SimpleAudioDriverDataSource_Sine440 }
+	};
+	auto sine_data = OSSharedPtr(OSData::withBytes(sine_updates, sizeof(sine_updates)), OSNoRetain);
+	Check(driver->HandleUpdateParameters(sine_data.get(), client, completion) == kIOReturnSuccess, "the final parameter update was rejected", step);
+	number_commands += 1;
+	SimpleAudioHost::RunUntil(SimpleAudioHost::GetHostTime() + HostTicksForSeconds(1.0));
+
+	// Stopping IO drains the commands the timer didn't get to.
+	Check(driver->StopDevice(device->GetObjectID(), IOUserAudioStartStopFlags::None) == kIOReturnSuccess, "StopDevice failed", step);
+	SimpleAudioHost::RunUntil(SimpleAudioHost::GetHostTime());
+	number_config_changes += SimpleAudioHost::PerformConfigurationChanges();
+	Check(client->GetNumberCompletions() == number_commands, "a queued command never completed", step);
+	Check(client->GetNumberFailedCompletions() == 0, "a queued command failed", step);
+	Check(number_zts > 1000, "the timer stopped publishing zero timestamps", step);
+
+	// The fills reached the ring buffer.
+	OSSharedPtr<IOMemoryMap> input_map;
+	size_t input_frame_count = 0;
+	auto input = SimpleAudioHost::MapInputBuffer(device, input_map, &input_frame_count);
+	size_t number_nonzero_frames = 0;
+	for (size_t frame = 0; frame < input_frame_count; frame++)
+	{
+		number_nonzero_frames += input[frame] != 0 ? 1 : 0;
+	}
+	Check(number_nonzero_frames > input_frame_count * 9 / 10, "the input ring buffer is mostly silent", step);
+
+	// Tearing everything down frees every object.
+	sine_data.reset();
+	input_map.reset();
+	telemetry_map.reset();
+	client->release();
+	completion->release();
+	SimpleAudioHost::CloseDriver(driver);
+	Check(SimpleAudioHost::GetNumberLiveObjects() == 0, "objects were leaked", step);
+
+	printf("DeviceTimerLoop: seed %llu, %u steps, %llu zero timestamps, %llu configuration changes, %llu commands, %llu restarts, %llu failures\n",
+		   static_cast<unsigned long long>(seed), k_number_steps, static_cast<unsigned long long>(number_zts), static_cast<unsigned long long>(number_config_changes),
+		   static_cast<unsigned long long>(number_commands), static_cast<unsigned long long>(number_restarts), static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
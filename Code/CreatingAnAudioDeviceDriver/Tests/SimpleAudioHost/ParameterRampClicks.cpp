@@ -0,0 +1,117 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Moves the target of SimpleAudioParameterRamp every block and
+             checks that the gain it applies never jumps.
+*/
+
+#include "SimpleAudioParameterRamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// The ramp is applied to a constant signal of 1, so the output is the gain
+// itself and any jump in it is a click. The ramp covers the largest change,
+// from 0 to 1, in the driver's 10 ms, so no two frames in a row may differ by
+// more than one ramp step of that change, however often the target moves and
+// wherever the blocks fall. The target moves every block, to a random level or
+// sometimes back to the one it left, with random block sizes, some shorter and
+// some longer than the ramp. A target that's held for a whole ramp has to be
+// reached exactly. For contrast, the same targets set with no ramp show how
+// big the jumps would be.
+
+constexpr double	k_ramp_duration = 0.01;
+constexpr uint32_t	k_number_blocks = 200000;
+constexpr uint32_t	k_max_block_frame_count = 4096;
+
+static const double k_sample_rates[] = { 44100.0, 48000.0, 192000.0 };
+
+static uint64_t g_number_failures = 0;
+
+static void Check(bool in_condition, const char* in_what)
+{
+	if (!in_condition)
+	{
+		fprintf(stderr, "ParameterRampClicks: %s\n", in_what);
+		g_number_failures += 1;
+	}
+}
+
+// Returns the largest change between consecutive frames over the whole run.
+static double Run(uint32_t in_ramp_frame_count, std::mt19937_64& io_random, uint64_t* out_number_missed_targets)
+{
+	SimpleAudioParameterRamp ramp = {};
+	ramp.Reset(0.0f);
+	std::vector<float> block(k_max_block_frame_count);
+	std::uniform_real_distribution<float> level(0.0f, 1.0f);
+
+	float previous_target = 0.0f;
+	float target = 0.0f;
+	float last_sample = 0.0f;
+	uint32_t frames_since_target = 0;
+	double max_delta = 0.0;
+	*out_number_missed_targets = 0;
+	for (uint32_t block_index = 0; block_index < k_number_blocks; block_index++)
+	{
+		// Mostly short blocks, with a long one now and then so ramps finish.
+		uint32_t frame_count = io_random() % 8 == 0 ? 1 + io_random() % k_max_block_frame_count : 1 + io_random() % 256;
+		float new_target = io_random() % 4 == 0 ? previous_target : (io_random() % 8 == 0 ? static_cast<float>(io_random() % 2) : level(io_random));
+		if (new_target != target)
+		{
+			previous_target = target;
+			target = new_target;
+			frames_since_target = 0;
+		}
+		ramp.SetTarget(new_target, in_ramp_frame_count);
+
+		std::fill(block.begin(), block.begin() + frame_count, 1.0f);
+		ramp.Apply(block.data(), frame_count);
+		for (uint32_t i = 0; i < frame_count; i++)
+		{
+			max_delta = fmax(max_delta, fabs(static_cast<double>(block[i]) - last_sample));
+			last_sample = block[i];
+		}
+
+		frames_since_target += frame_count;
+		if (frames_since_target >= in_ramp_frame_count && last_sample != target)
+		{
+			*out_number_missed_targets += 1;
+		}
+	}
+	return max_delta;
+}
+
+int main(int argc, const char* argv[])
+{
+	uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0) : 1;
+	std::mt19937_64 random(seed);
+
+	printf("ParameterRampClicks: largest change in gain between frames, target moved every block\n");
+	printf("%8s %12s %12s %12s %12s\n", "rate", "ramp frames", "ramped", "limit", "no ramp");
+	for (double sample_rate : k_sample_rates)
+	{
+		uint32_t ramp_frame_count = static_cast<uint32_t>(k_ramp_duration * sample_rate);
+		uint64_t number_missed_targets = 0;
+		double ramped_delta = Run(ramp_frame_count, random, &number_missed_targets);
+		uint64_t unused = 0;
+		double stepped_delta = Run(0, random, &unused);
+
+		// One ramp step of a full-scale change, with room for float rounding.
+		double limit = 1.0 / ramp_frame_count * (1.0 + 1.0e-4) + 1.0e-6;
+		printf("%8.0f %12u %12.3e %12.3e %12.3e\n", sample_rate, ramp_frame_count, ramped_delta, limit, stepped_delta);
+
+		char what[128];
+		snprintf(what, sizeof(what), "at %.0f Hz the gain jumped by %.3e in one frame", sample_rate, ramped_delta);
+		Check(ramped_delta <= limit, what);
+		snprintf(what, sizeof(what), "at %.0f Hz the ramp missed a held target %llu times", sample_rate, static_cast<unsigned long long>(number_missed_targets));
+		Check(number_missed_targets == 0, what);
+	}
+
+	printf("ParameterRampClicks: seed %llu, %llu failures\n", static_cast<unsigned long long>(seed), static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Checks SimpleAudioRingWriter against writing the ring buffer one
+             sample at a time, and measures how much faster it is.
+*/
+
+#include "SimpleAudioRingWriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// The reference writes each sample at its own modulo index, which is what
+// the driver did before it had the ring writer. Every write goes to two
+// buffers, one each way, that must end up identical. The writes start at
+// random positions, most of them close to the wrap point, and some are longer
+// than the ring buffer so that they wrap more than once.
+
+constexpr uint32_t	k_number_writes = 2000;
+constexpr size_t	k_max_block_frame_count = 4096;
+
+// Every channel count the writer has its own loop for, and one it doesn't.
+static const uint32_t k_channel_counts[] = { 1, 2, 3, 4, 8, 16, 32 };
+static const uint32_t k_measured_channel_counts[] = { 1, 2, 8, 32 };
+static const size_t k_buffer_frame_counts[] = { 1, 7, 1000, 4096 };
+
+static uint64_t g_number_failures = 0;
+
+template <typename SampleType>
+static void WriteMonoFramesBySample(SampleType* io_buffer, size_t in_buffer_frame_count, uint32_t in_channels_per_frame, uint64_t in_frame_position, const SampleType* in_samples, size_t in_frame_count)
+{
+	for (size_t i = 0; i < in_frame_count; i++)
+	{
+		size_t ring_frame = static_cast<size_t>((in_frame_position + i) % in_buffer_frame_count);
+		for (uint32_t channel_index = 0; channel_index < in_channels_per_frame; channel_index++)
+		{
+			io_buffer[ring_frame * in_channels_per_frame + channel_index] = in_samples[i];
+		}
+	}
+}
+
+template <typename SampleType>
+static void WriteInterleavedFramesBySample(SampleType* io_buffer, size_t in_buffer_frame_count, uint32_t in_channels_per_frame, uint64_t in_frame_position, const SampleType* in_samples, size_t in_frame_count)
+{
+	for (size_t i = 0; i < in_frame_count; i++)
+	{
+		size_t ring_frame = static_cast<size_t>((in_frame_position + i) % in_buffer_frame_count);
+		for (uint32_t channel_index = 0; channel_index < in_channels_per_frame; channel_index++)
+		{
+			io_buffer[ring_frame * in_channels_per_frame + channel_index] = in_samples[i * in_channels_per_frame + channel_index];
+		}
+	}
+}
+
+template <typename SampleType>
+static void CheckEquivalence(const char* in_type_name, std::mt19937_64& io_random)
+{
+	for (uint32_t channels_per_frame : k_channel_counts)
+	{
+		for (size_t buffer_frame_count : k_buffer_frame_counts)
+		{
+			std::vector<SampleType> buffer(buffer_frame_count * channels_per_frame);
+			std::vector<SampleType> reference_buffer(buffer.size());
+			std::vector<SampleType> samples(k_max_block_frame_count * channels_per_frame);
+			SimpleAudioRingWriter<SampleType> writer(buffer.data(), buffer_frame_count, channels_per_frame);
+
+			uint64_t number_mismatches = 0;
+			for (uint32_t write_index = 0; write_index < k_number_writes; write_index++)
+			{
+				// Start within a few frames of a wrap point most of the time, at
+				// a position far past the first pass through the ring.
+				uint64_t pass = io_random() % 1000000;
+				uint64_t frame_position = pass * buffer_frame_count;
+				if (io_random() % 4 != 0)
+				{
+					frame_position += buffer_frame_count - 1 - io_random() % (buffer_frame_count < 8 ? buffer_frame_count : 8);
+				}
+				else
+				{
+					frame_position += io_random() % buffer_frame_count;
+				}
+				size_t frame_count = io_random() % 8 == 0 ? io_random() % (k_max_block_frame_count + 1) : io_random() % (2 * buffer_frame_count + 1);
+				if (frame_count > k_max_block_frame_count)
+				{
+					frame_count = k_max_block_frame_count;
+				}
+				// Each write's samples differ from the last write's, so a frame
+				// that's missed still holds something different.
+				int16_t first_sample = static_cast<int16_t>(io_random());
+				for (size_t i = 0; i < frame_count * channels_per_frame; i++)
+				{
+					samples[i] = static_cast<SampleType>(static_cast<int16_t>(first_sample + i));
+				}
+
+				if (io_random() % 2 == 0)
+				{
+					writer.WriteMonoFrames(frame_position, samples.data(), frame_count);
+					WriteMonoFramesBySample(reference_buffer.data(), buffer_frame_count, channels_per_frame, frame_position, samples.data(), frame_count);
+				}
+				else
+				{
+					writer.WriteInterleavedFrames(frame_position, samples.data(), frame_count);
+					WriteInterleavedFramesBySample(reference_buffer.data(), buffer_frame_count, channels_per_frame, frame_position, samples.data(), frame_count);
+				}
+				if (buffer != reference_buffer)
+				{
+					number_mismatches += 1;
+					buffer = reference_buffer;
+				}
+			}
+
+			if (number_mismatches != 0)
+			{
+				fprintf(stderr, "RingWriter: %s, %u channels, %zu-frame ring: %llu of %u writes differ from writing by sample\n", in_type_name, channels_per_frame, buffer_frame_count, static_cast<unsigned long long>(number_mismatches), k_number_writes);
+				g_number_failures += 1;
+			}
+		}
+	}
+}
+
+// Writes a second of 512-frame blocks at 48 kHz into an 8192-frame ring, the
+// way the driver fills its input buffer, and reports nanoseconds per frame.
+static void Measure(uint32_t in_channels_per_frame)
+{
+	constexpr size_t k_buffer_frame_count = 8192;
+	constexpr size_t k_block_frame_count = 512;
+	constexpr uint32_t k_number_blocks = 94;
+	constexpr uint32_t k_number_repeats = 50;
+
+	std::vector<int16_t> buffer(k_buffer_frame_count * in_channels_per_frame);
+	std::vector<int16_t> samples(k_block_frame_count);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		samples[i] = static_cast<int16_t>(i * 37);
+	}
+	SimpleAudioRingWriter<int16_t> writer(buffer.data(), k_buffer_frame_count, in_channels_per_frame);
+
+	auto time = [&](auto in_write)
+	{
+		double best = 1.0e300;
+		for (uint32_t repeat = 0; repeat < k_number_repeats; repeat++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t block = 0; block < k_number_blocks; block++)
+			{
+				// Offset the blocks so that some of them straddle the wrap.
+				in_write(static_cast<uint64_t>(block) * k_block_frame_count + 100);
+			}
+			auto end = std::chrono::steady_clock::now();
+			best = fmin(best, std::chrono::duration<double, std::nano>(end - start).count());
+		}
+		return best / (k_number_blocks * k_block_frame_count);
+	};
+
+	double writer_time = time([&](uint64_t in_position) { writer.WriteMonoFrames(in_position, samples.data(), k_block_frame_count); });
+	double reference_time = time([&](uint64_t in_position) { WriteMonoFramesBySample(buffer.data(), k_buffer_frame_count, in_channels_per_frame, in_position, samples.data(), k_block_frame_count); });
+
+	printf("%8u %14.2f %14.2f %8.1fx\n", in_channels_per_frame, writer_time, reference_time, reference_time / writer_time);
+}
+
+int main(int argc, const char* argv[])
+{
+	uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0) : 1;
+	std::mt19937_64 random(seed);
+
+	CheckEquivalence<int16_t>("int16_t", random);
+	CheckEquivalence<float>("float", random);
+
+	printf("RingWriter: mono writes into an 8192-frame int16_t ring, nanoseconds per frame\n");
+	printf("%8s %14s %14s %9s\n", "channels", "ring writer", "by sample", "speedup");
+	for (uint32_t channels_per_frame : k_measured_channel_counts)
+	{
+		Measure(channels_per_frame);
+	}
+
+	printf("RingWriter: seed %llu, %llu failures\n", static_cast<unsigned long long>(seed), static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Switches SimpleAudioSampleClock between sample rates at random
+             while it runs and checks that the host times it hands out
+             stay continuous.
+*/
+
+#include "SimpleAudioSampleClock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+// The clock is driven the way the device timer drives it: each fill first
+// publishes the zero timestamps the clock has reached, then advances by the
+// fill size, then wakes at the host time of the new sample time. Between fills
+// the rate changes at random, sometimes more than once before the next fill.
+// A reference keeps every segment the clock has run at and converts a sample
+// time with the segment it played in. The clock must agree with it for every
+// timestamp and wake time, including the zero timestamps that fall before the
+// latest anchor, which only the clock's previous segment covers.
+
+constexpr uint32_t	k_number_fills = 200000;
+constexpr uint64_t	k_zts_period = 4096;
+constexpr uint32_t	k_max_fill_frame_size = k_zts_period / 2;
+
+static const uint64_t k_sample_rates[] = { 8000, 11025, 44100, 48000, 88200, 96000, 176400, 192000 };
+
+struct Timebase
+{
+	uint32_t	numer;
+	uint32_t	denom;
+};
+static const Timebase k_timebases[] = { { 1, 1 }, { 125, 3 } };
+
+static uint64_t g_number_failures = 0;
+
+static void Check(bool in_condition, const char* in_what, uint32_t in_fill)
+{
+	if (!in_condition)
+	{
+		// Only the first few, since one bug tends to fail every fill after it.
+		if (g_number_failures < 10)
+		{
+			fprintf(stderr, "SampleClockRateChange: fill %u: %s\n", in_fill, in_what);
+		}
+		g_number_failures += 1;
+	}
+}
+
+class ReferenceClock
+{
+public:
+	void Start(uint64_t in_host_time, uint64_t in_numerator, uint64_t in_denominator)
+	{
+		m_segments.assign(1, Segment { 0, in_host_time, in_numerator, in_denominator });
+	}
+
+	void ChangeRate(uint64_t in_sample_time, uint64_t in_numerator, uint64_t in_denominator)
+	{
+		if (m_segments.back().m_sample_time == in_sample_time)
+		{
+			m_segments.back().m_numerator = in_numerator;
+			m_segments.back().m_denominator = in_denominator;
+		}
+		else
+		{
+			m_segments.push_back(Segment { in_sample_time, HostTimeForSampleTime(in_sample_time), in_numerator, in_denominator });
+		}
+	}
+
+	uint64_t HostTimeForSampleTime(uint64_t in_sample_time) const
+	{
+		auto segment = m_segments.rbegin();
+		while (segment->m_sample_time > in_sample_time)
+		{
+			++segment;
+		}
+		auto ticks = (static_cast<unsigned __int128>(in_sample_time - segment->m_sample_time) * segment->m_numerator) / segment->m_denominator;
+		return segment->m_host_time + static_cast<uint64_t>(ticks);
+	}
+
+private:
+	struct Segment
+	{
+		uint64_t	m_sample_time;
+		uint64_t	m_host_time;
+		uint64_t	m_numerator;
+		uint64_t	m_denominator;
+	};
+	std::vector<Segment> m_segments;
+};
+
+static void Run(const Timebase& in_timebase, std::mt19937_64& io_random)
+{
+	auto pick_rate = [&](uint64_t& out_numerator, uint64_t& out_denominator)
+	{
+		uint64_t sample_rate = k_sample_rates[io_random() % (sizeof(k_sample_rates) / sizeof(k_sample_rates[0]))];
+		out_numerator = 1000000000ULL * in_timebase.denom;
+		out_denominator = sample_rate * in_timebase.numer;
+	};
+
+	uint64_t numerator;
+	uint64_t denominator;
+	pick_rate(numerator, denominator);
+	uint64_t start_host_time = io_random() >> 8;
+
+	SimpleAudioSampleClock clock = {};
+	clock.SetRate(numerator, denominator);
+	clock.Start(start_host_time);
+	ReferenceClock reference;
+	reference.Start(start_host_time, numerator, denominator);
+
+	uint64_t next_zts_sample_time = 0;
+	uint64_t last_zts_host_time = 0;
+	uint64_t wake_host_time = clock.HostTimeForSampleTime(0);
+	uint32_t number_rate_changes = 0;
+	uint32_t number_early_zts = 0;
+	for (uint32_t fill = 0; fill < k_number_fills; fill++)
+	{
+		// Publish the zero timestamps the clock has reached.
+		while (next_zts_sample_time <= clock.GetSampleTime())
+		{
+			uint64_t zts_host_time = clock.HostTimeForSampleTime(next_zts_sample_time);
+			Check(zts_host_time == reference.HostTimeForSampleTime(next_zts_sample_time), "a zero timestamp's host time differs from the reference", fill);
+			Check(zts_host_time >= last_zts_host_time, "a zero timestamp's host time went backwards", fill);
+			Check(zts_host_time <= wake_host_time, "a zero timestamp is later than the fill that published it", fill);
+			last_zts_host_time = zts_host_time;
+			next_zts_sample_time += k_zts_period;
+		}
+
+		// The fill is scheduled where the last one said to wake.
+		uint64_t scheduled_host_time = clock.HostTimeForSampleTime(clock.GetSampleTime());
+		Check(scheduled_host_time == wake_host_time, "the fill's host time moved from the wake time", fill);
+
+		clock.Advance(1 + io_random() % k_max_fill_frame_size);
+		uint64_t next_wake_host_time = clock.HostTimeForSampleTime(clock.GetSampleTime());
+		Check(next_wake_host_time == reference.HostTimeForSampleTime(clock.GetSampleTime()), "the wake time differs from the reference", fill);
+		Check(next_wake_host_time >= wake_host_time, "the wake time went backwards", fill);
+		wake_host_time = next_wake_host_time;
+
+		// Change the rate now and then, and sometimes again right away.
+		while (io_random() % 32 == 0)
+		{
+			uint64_t pending_zts_host_time = clock.HostTimeForSampleTime(next_zts_sample_time);
+			if (next_zts_sample_time <= clock.GetSampleTime())
+			{
+				number_early_zts += 1;
+			}
+
+			pick_rate(numerator, denominator);
+			clock.ChangeRate(numerator, denominator);
+			reference.ChangeRate(clock.GetSampleTime(), numerator, denominator);
+			number_rate_changes += 1;
+
+			Check(clock.HostTimeForSampleTime(clock.GetSampleTime()) == wake_host_time, "changing the rate moved the pending wake time", fill);
+			if (next_zts_sample_time <= clock.GetSampleTime())
+			{
+				Check(clock.HostTimeForSampleTime(next_zts_sample_time) == pending_zts_host_time, "changing the rate moved an unpublished zero timestamp", fill);
+			}
+		}
+	}
+
+	printf("%u/%u timebase: %u fills, %u rate changes, %u with a zero timestamp before the new anchor\n", in_timebase.numer, in_timebase.denom, k_number_fills, number_rate_changes, number_early_zts);
+	Check(number_early_zts != 0, "no rate change had a zero timestamp before its anchor", k_number_fills);
+}
+
+int main(int argc, const char* argv[])
+{
+	uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0) : 1;
+	std::mt19937_64 random(seed);
+
+	for (const Timebase& timebase : k_timebases)
+	{
+		Run(timebase, random);
+	}
+
+	printf("SampleClockRateChange: seed %llu, %llu failures\n", static_cast<unsigned long long>(seed), static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Checks the scaling, clipping, and silence of
+             SimpleAudioSampleConverter at each width, and measures its
+             throughput.
+*/
+
+#include "SimpleAudioSampleConverter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Every width must scale by 2^(n-1), the same as NullAudio: each integer
+// sample, divided by 2^(n-1), has to come back as itself, -1 has to give the
+// most negative integer, and +1 and anything beyond it has to clip to the
+// largest. Silence has to stay exactly zero without dither and within one LSB
+// with it, and dither must never push a full-scale sample out of range.
+
+constexpr size_t	k_block_sample_count = 4096;
+constexpr uint32_t	k_number_measured_blocks = 256;
+constexpr uint32_t	k_number_repeats = 20;
+
+static const float k_clipped_values[] = { 1.0f, 1.0000001f, 1.5f, 100.0f, INFINITY };
+
+static uint64_t g_number_failures = 0;
+
+static void Check(bool in_condition, const char* in_what)
+{
+	if (!in_condition)
+	{
+		fprintf(stderr, "SampleConversion: %s\n", in_what);
+		g_number_failures += 1;
+	}
+}
+
+// Each width behind the same interface, reading back the 24-bit samples as
+// signed integers.
+struct Int16Width
+{
+	static constexpr const char* k_name = "int16";
+	static constexpr int64_t k_maximum = 32767;
+	static constexpr int64_t k_minimum = -32768;
+	static constexpr double k_scale = 32768.0;
+	static constexpr int64_t k_step = 1;
+
+	std::vector<int16_t> m_samples;
+	explicit Int16Width(size_t in_sample_count) : m_samples(in_sample_count) {}
+	void Convert(SimpleAudioSampleConverter& io_converter, const float* in_samples, size_t in_sample_count) { io_converter.ConvertToInt16(in_samples, m_samples.data(), in_sample_count); }
+	int64_t Get(size_t in_index) const { return m_samples[in_index]; }
+};
+
+struct Int24Width
+{
+	static constexpr const char* k_name = "int24";
+	static constexpr int64_t k_maximum = 8388607;
+	static constexpr int64_t k_minimum = -8388608;
+	static constexpr double k_scale = 8388608.0;
+	static constexpr int64_t k_step = 1;
+
+	std::vector<uint8_t> m_samples;
+	explicit Int24Width(size_t in_sample_count) : m_samples(3 * in_sample_count) {}
+	void Convert(SimpleAudioSampleConverter& io_converter, const float* in_samples, size_t in_sample_count) { io_converter.ConvertToInt24(in_samples, m_samples.data(), in_sample_count); }
+	int64_t Get(size_t in_index) const
+	{
+		const uint8_t* sample = m_samples.data() + 3 * in_index;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		int32_t value = sample[0] | (sample[1] << 8) | (sample[2] << 16);
+#else
+		int32_t value = sample[2] | (sample[1] << 8) | (sample[0] << 16);
+#endif
+		return value >= 0x800000 ? value - 0x1000000 : value;
+	}
+};
+
+// A float only has 24 bits, so at 32 bits only every 256th integer near full
+// scale is reachable, and the largest is 2147483520.
+struct Int32Width
+{
+	static constexpr const char* k_name = "int32";
+	static constexpr int64_t k_maximum = 2147483520;
+	static constexpr int64_t k_minimum = -2147483648LL;
+	static constexpr double k_scale = 2147483648.0;
+	static constexpr int64_t k_step = 256;
+
+	std::vector<int32_t> m_samples;
+	explicit Int32Width(size_t in_sample_count) : m_samples(in_sample_count) {}
+	void Convert(SimpleAudioSampleConverter& io_converter, const float* in_samples, size_t in_sample_count) { io_converter.ConvertToInt32(in_samples, m_samples.data(), in_sample_count); }
+	int64_t Get(size_t in_index) const { return m_samples[in_index]; }
+};
+
+template <typename Width>
+static void CheckAccuracy()
+{
+	SimpleAudioSampleConverter converter = {};
+	char what[128];
+
+	// Every integer sample, or every 256th at 32 bits, in blocks.
+	std::vector<float> samples(k_block_sample_count);
+	Width width(k_block_sample_count);
+	uint64_t number_mismatches = 0;
+	for (int64_t first = Width::k_minimum; first <= Width::k_maximum; first += Width::k_step * k_block_sample_count)
+	{
+		size_t count = 0;
+		for (; count < k_block_sample_count && first + static_cast<int64_t>(count) * Width::k_step <= Width::k_maximum; count++)
+		{
+			samples[count] = static_cast<float>((first + static_cast<int64_t>(count) * Width::k_step) / Width::k_scale);
+		}
+		width.Convert(converter, samples.data(), count);
+		for (size_t i = 0; i < count; i++)
+		{
+			number_mismatches += width.Get(i) != first + static_cast<int64_t>(i) * Width::k_step;
+		}
+	}
+	snprintf(what, sizeof(what), "%s: %llu integer samples don't come back from sample / 2^(n-1)", Width::k_name, static_cast<unsigned long long>(number_mismatches));
+	Check(number_mismatches == 0, what);
+
+	// Full scale, clipping, and silence.
+	std::vector<float> edges = { -1.0f, 0.0f, -0.0f, 0.5f, -0.5f };
+	for (float value : k_clipped_values)
+	{
+		edges.push_back(value);
+		edges.push_back(-value);
+	}
+	width.Convert(converter, edges.data(), edges.size());
+	snprintf(what, sizeof(what), "%s: -1 doesn't give the most negative sample", Width::k_name);
+	Check(width.Get(0) == Width::k_minimum, what);
+	snprintf(what, sizeof(what), "%s: silence isn't zero", Width::k_name);
+	Check(width.Get(1) == 0 && width.Get(2) == 0, what);
+	snprintf(what, sizeof(what), "%s: half scale isn't 2^(n-2)", Width::k_name);
+	Check(width.Get(3) == -Width::k_minimum / 2 && width.Get(4) == Width::k_minimum / 2, what);
+	for (size_t i = 5; i < edges.size(); i += 2)
+	{
+		snprintf(what, sizeof(what), "%s: %g doesn't clip", Width::k_name, edges[i]);
+		Check(width.Get(i) == Width::k_maximum && width.Get(i + 1) == Width::k_minimum, what);
+	}
+}
+
+// Dither only applies below 32 bits.
+template <typename Width>
+static void CheckDither(SimpleAudioDitherMode in_dither_mode, const char* in_mode_name)
+{
+	SimpleAudioSampleConverter converter = {};
+	converter.SetDitherMode(in_dither_mode);
+	char what[128];
+
+	std::vector<float> samples(k_block_sample_count, 0.0f);
+	Width width(k_block_sample_count);
+	int64_t largest = 0;
+	for (uint32_t block = 0; block < 64; block++)
+	{
+		width.Convert(converter, samples.data(), samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			largest = std::max(largest, std::abs(width.Get(i)));
+		}
+	}
+	// Noise shaping feeds back up to 2 LSB of error, so it can reach 3.
+	int64_t limit = in_dither_mode == SimpleAudioDitherMode::NoiseShaped ? 3 : 1;
+	snprintf(what, sizeof(what), "%s, %s dither: silence reaches %lld LSB", Width::k_name, in_mode_name, static_cast<long long>(largest));
+	Check(largest <= limit, what);
+
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		samples[i] = (i & 1) ? -1.0f : 1.0f;
+	}
+	bool in_range = true;
+	for (uint32_t block = 0; block < 64; block++)
+	{
+		width.Convert(converter, samples.data(), samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			in_range = in_range && width.Get(i) >= Width::k_minimum && width.Get(i) <= Width::k_maximum;
+			in_range = in_range && ((i & 1) ? width.Get(i) <= Width::k_minimum + limit : width.Get(i) >= Width::k_maximum - limit);
+		}
+	}
+	snprintf(what, sizeof(what), "%s, %s dither: a full-scale sample leaves the range or strays from full scale", Width::k_name, in_mode_name);
+	Check(in_range, what);
+}
+
+// Converts a ramp from a little past -1 to a little past +1 in 4096-sample
+// blocks and reports millions of samples per second.
+template <typename Width>
+static void Measure(SimpleAudioDitherMode in_dither_mode, const char* in_mode_name)
+{
+	SimpleAudioSampleConverter converter = {};
+	converter.SetDitherMode(in_dither_mode);
+	std::vector<float> samples(k_block_sample_count);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		samples[i] = static_cast<float>(i) / k_block_sample_count * 2.2f - 1.1f;
+	}
+	Width width(k_block_sample_count);
+
+	double best = 1.0e300;
+	for (uint32_t repeat = 0; repeat < k_number_repeats; repeat++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t block = 0; block < k_number_measured_blocks; block++)
+		{
+			width.Convert(converter, samples.data(), samples.size());
+		}
+		auto end = std::chrono::steady_clock::now();
+		best = fmin(best, std::chrono::duration<double>(end - start).count());
+	}
+	printf("%-6s %-13s %10.1f\n", Width::k_name, in_mode_name, k_number_measured_blocks * k_block_sample_count / best / 1.0e6);
+}
+
+int main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	CheckAccuracy<Int16Width>();
+	CheckAccuracy<Int24Width>();
+	CheckAccuracy<Int32Width>();
+	CheckDither<Int16Width>(SimpleAudioDitherMode::TPDF, "TPDF");
+	CheckDither<Int16Width>(SimpleAudioDitherMode::NoiseShaped, "noise-shaped");
+	CheckDither<Int24Width>(SimpleAudioDitherMode::TPDF, "TPDF");
+	CheckDither<Int24Width>(SimpleAudioDitherMode::NoiseShaped, "noise-shaped");
+
+	printf("SampleConversion: %zu-sample blocks, millions of samples per second\n", k_block_sample_count);
+	printf("%-6s %-13s %10s\n", "width", "dither", "Msamples/s");
+	Measure<Int16Width>(SimpleAudioDitherMode::None, "none");
+	Measure<Int16Width>(SimpleAudioDitherMode::TPDF, "TPDF");
+	Measure<Int16Width>(SimpleAudioDitherMode::NoiseShaped, "noise-shaped");
+	Measure<Int24Width>(SimpleAudioDitherMode::None, "none");
+	Measure<Int24Width>(SimpleAudioDitherMode::TPDF, "TPDF");
+	Measure<Int24Width>(SimpleAudioDitherMode::NoiseShaped, "noise-shaped");
+	Measure<Int32Width>(SimpleAudioDitherMode::None, "none");
+
+	printf("SampleConversion: %llu failures\n", static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,444 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The AudioDriverKit objects and the HAL's side of them, for
+             building the SimpleAudio driver outside of macOS.
+*/
+
+#include <AudioDriverKit/AudioDriverKit.h>
+
+#include "SimpleAudioHost.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+	struct PendingConfigurationChange
+	{
+		OSSharedPtr<IOUserAudioDevice>	m_device;
+		uint64_t						m_change_action;
+		OSSharedPtr<OSObject>			m_change_info;
+	};
+
+	IOUserAudioObjectID	g_next_object_id = 2;
+	std::vector<PendingConfigurationChange>	g_pending_configuration_changes;
+	std::function<void(IOUserAudioDevice*, uint64_t, uint64_t)>	g_zero_timestamp_observer;
+}
+
+//
+// Objects
+//
+
+bool IOUserAudioObject::InitObject(IOUserAudioDriver* in_driver)
+{
+	if (in_driver == nullptr || !OSObject::init())
+	{
+		return false;
+	}
+	m_owning_driver = in_driver;
+	m_object_id = g_next_object_id++;
+	return true;
+}
+
+kern_return_t IOUserAudioObject::SetName(OSString* in_name)
+{
+	m_name = OSSharedPtr<OSString>(in_name, OSRetain);
+	return kIOReturnSuccess;
+}
+
+OSSharedPtr<IODispatchQueue> IOUserAudioObject::GetWorkQueue() const
+{
+	return m_owning_driver->GetWorkQueue();
+}
+
+//
+// Streams
+//
+
+OSSharedPtr<IOUserAudioStream> IOUserAudioStream::Create(IOUserAudioDriver* in_driver, IOUserAudioStreamDirection in_direction, IOMemoryDescriptor* in_io_memory_descriptor)
+{
+	auto stream = OSSharedPtr<IOUserAudioStream>(new IOUserAudioStream(), OSNoRetain);
+	if (!stream->InitObject(in_driver))
+	{
+		return nullptr;
+	}
+	stream->m_direction = in_direction;
+	stream->m_io_memory_descriptor = OSSharedPtr<IOMemoryDescriptor>(in_io_memory_descriptor, OSRetain);
+	return stream;
+}
+
+kern_return_t IOUserAudioStream::SetAvailableStreamFormats(const IOUserAudioStreamBasicDescription* in_formats, size_t in_number_formats)
+{
+	m_available_formats.assign(in_formats, in_formats + in_number_formats);
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioStream::SetCurrentStreamFormat(const IOUserAudioStreamBasicDescription* in_format)
+{
+	for (const auto& format : m_available_formats)
+	{
+		if (memcmp(&format, in_format, sizeof(format)) == 0)
+		{
+			m_current_format = format;
+			return kIOReturnSuccess;
+		}
+	}
+	return kIOReturnBadArgument;
+}
+
+kern_return_t IOUserAudioStream::DeviceSampleRateChanged(double in_sample_rate)
+{
+	for (const auto& format : m_available_formats)
+	{
+		if (format.mSampleRate == in_sample_rate &&
+			format.mFormatID == m_current_format.mFormatID &&
+			format.mFormatFlags == m_current_format.mFormatFlags &&
+			format.mBytesPerFrame == m_current_format.mBytesPerFrame &&
+			format.mChannelsPerFrame == m_current_format.mChannelsPerFrame &&
+			format.mBitsPerChannel == m_current_format.mBitsPerChannel)
+		{
+			m_current_format = format;
+			return kIOReturnSuccess;
+		}
+	}
+	return kIOReturnUnsupported;
+}
+
+//
+// Controls
+//
+
+bool IOUserAudioControl::InitControl(IOUserAudioDriver* in_driver, bool in_is_settable, IOUserAudioObjectPropertyElement in_element, IOUserAudioObjectPropertyScope in_scope, IOUserAudioClassID in_class_id)
+{
+	if (!InitObject(in_driver))
+	{
+		return false;
+	}
+	m_is_settable = in_is_settable;
+	m_element = in_element;
+	m_scope = in_scope;
+	m_class_id = in_class_id;
+	return true;
+}
+
+OSSharedPtr<IOUserAudioLevelControl> IOUserAudioLevelControl::Create(IOUserAudioDriver* in_driver, bool in_is_settable, double in_initial_level_db, IOUserAudioLevelControlRange in_level_range, IOUserAudioObjectPropertyElement in_element, IOUserAudioObjectPropertyScope in_scope, IOUserAudioClassID in_class_id)
+{
+	auto control = OSSharedPtr<IOUserAudioLevelControl>(new IOUserAudioLevelControl(), OSNoRetain);
+	if (!control->InitControl(in_driver, in_is_settable, in_element, in_scope, in_class_id) || !(in_level_range.m_minimum < in_level_range.m_maximum))
+	{
+		return nullptr;
+	}
+	control->m_range = in_level_range;
+	control->m_scalar_value = static_cast<float>((in_initial_level_db - in_level_range.m_minimum) / (in_level_range.m_maximum - in_level_range.m_minimum));
+	return control;
+}
+
+kern_return_t IOUserAudioLevelControl::SetScalarValue(float in_value)
+{
+	if (!(in_value >= 0.0f && in_value <= 1.0f))
+	{
+		return kIOReturnBadArgument;
+	}
+	m_scalar_value = in_value;
+	return kIOReturnSuccess;
+}
+
+OSSharedPtr<IOUserAudioSelectorControl> IOUserAudioSelectorControl::Create(IOUserAudioDriver* in_driver, bool in_is_settable, IOUserAudioObjectPropertyElement in_element, IOUserAudioObjectPropertyScope in_scope, IOUserAudioClassID in_class_id)
+{
+	auto control = OSSharedPtr<IOUserAudioSelectorControl>(new IOUserAudioSelectorControl(), OSNoRetain);
+	if (!control->InitControl(in_driver, in_is_settable, in_element, in_scope, in_class_id))
+	{
+		return nullptr;
+	}
+	return control;
+}
+
+kern_return_t IOUserAudioSelectorControl::AddControlValueDescriptions(const IOUserAudioSelectorValueDescription* in_descriptions, size_t in_number_descriptions)
+{
+	for (size_t index = 0; index < in_number_descriptions; index++)
+	{
+		m_values.push_back(in_descriptions[index].m_value);
+	}
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioSelectorControl::SetCurrentSelectedValues(const IOUserAudioSelectorValue* in_values, size_t in_number_values)
+{
+	for (size_t index = 0; index < in_number_values; index++)
+	{
+		if (std::find(m_values.begin(), m_values.end(), in_values[index]) == m_values.end())
+		{
+			return kIOReturnBadArgument;
+		}
+	}
+	m_selected_values.assign(in_values, in_values + in_number_values);
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioSelectorControl::GetCurrentSelectedValues(IOUserAudioSelectorValue* out_values, size_t in_number_values) const
+{
+	for (size_t index = 0; index < in_number_values; index++)
+	{
+		out_values[index] = index < m_selected_values.size() ? m_selected_values[index] : 0;
+	}
+	return kIOReturnSuccess;
+}
+
+OSSharedPtr<IOUserAudioCustomProperty> IOUserAudioCustomProperty::Create(IOUserAudioDriver* in_driver, IOUserAudioObjectPropertyAddress in_address, bool in_is_settable, IOUserAudioCustomPropertyDataType in_qualifier_type, IOUserAudioCustomPropertyDataType in_data_type)
+{
+	(void)in_is_settable;
+	(void)in_qualifier_type;
+	(void)in_data_type;
+	auto property = OSSharedPtr<IOUserAudioCustomProperty>(new IOUserAudioCustomProperty(), OSNoRetain);
+	if (!property->InitObject(in_driver))
+	{
+		return nullptr;
+	}
+	property->m_address = in_address;
+	return property;
+}
+
+kern_return_t IOUserAudioCustomProperty::SetQualifierAndDataValue(OSObject* in_qualifier, OSObject* in_data)
+{
+	m_values.push_back(OSSharedPtr<OSObject>(in_qualifier, OSRetain));
+	m_values.push_back(OSSharedPtr<OSObject>(in_data, OSRetain));
+	return kIOReturnSuccess;
+}
+
+//
+// Devices
+//
+
+bool IOUserAudioDevice::init(IOUserAudioDriver* in_driver, bool in_supports_prewarming, OSString* in_device_uid, OSString* in_model_uid, OSString* in_manufacturer_uid, uint32_t in_zero_timestamp_period)
+{
+	(void)in_supports_prewarming;
+	(void)in_device_uid;
+	(void)in_model_uid;
+	(void)in_manufacturer_uid;
+	if (!InitObject(in_driver) || in_zero_timestamp_period == 0)
+	{
+		return false;
+	}
+	m_zero_timestamp_period = in_zero_timestamp_period;
+	return true;
+}
+
+void IOUserAudioDevice::free()
+{
+	m_streams.clear();
+	m_owned_objects.clear();
+	m_name.reset();
+	OSObject::free();
+}
+
+kern_return_t IOUserAudioDevice::StartIO(IOUserAudioStartStopFlags in_flags)
+{
+	(void)in_flags;
+	m_io_running_count += 1;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::StopIO(IOUserAudioStartStopFlags in_flags)
+{
+	(void)in_flags;
+	if (m_io_running_count == 0)
+	{
+		return kIOReturnInvalid;
+	}
+	m_io_running_count -= 1;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::PerformDeviceConfigurationChange(uint64_t in_change_action, OSObject* in_change_info)
+{
+	(void)in_change_action;
+	(void)in_change_info;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::AbortDeviceConfigurationChange(uint64_t in_change_action, OSObject* in_change_info)
+{
+	(void)in_change_action;
+	(void)in_change_info;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::HandleChangeSampleRate(double in_sample_rate)
+{
+	return SetSampleRate(in_sample_rate);
+}
+
+kern_return_t IOUserAudioDevice::RequestDeviceConfigurationChange(uint64_t in_change_action, OSObject* in_change_info)
+{
+	g_pending_configuration_changes.push_back({ OSSharedPtr<IOUserAudioDevice>(this, OSRetain), in_change_action, OSSharedPtr<OSObject>(in_change_info, OSRetain) });
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::SetAvailableSampleRates(const double* in_sample_rates, size_t in_number_sample_rates)
+{
+	m_available_sample_rates.assign(in_sample_rates, in_sample_rates + in_number_sample_rates);
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::SetSampleRate(double in_sample_rate)
+{
+	if (std::find(m_available_sample_rates.begin(), m_available_sample_rates.end(), in_sample_rate) == m_available_sample_rates.end())
+	{
+		return kIOReturnBadArgument;
+	}
+	m_sample_rate = in_sample_rate;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::AddStream(IOUserAudioStream* in_stream)
+{
+	m_streams.push_back(OSSharedPtr<IOUserAudioStream>(in_stream, OSRetain));
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::AddControl(IOUserAudioControl* in_control)
+{
+	m_owned_objects.push_back(OSSharedPtr<IOUserAudioObject>(in_control, OSRetain));
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::AddCustomProperty(IOUserAudioCustomProperty* in_custom_property)
+{
+	m_owned_objects.push_back(OSSharedPtr<IOUserAudioObject>(in_custom_property, OSRetain));
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOUserAudioDevice::SetPreferredInputChannelLayout(const IOUserAudioChannelLabel* in_layout, size_t in_number_channels)
+{
+	(void)in_layout;
+	return in_number_channels > 0 ? kIOReturnSuccess : kIOReturnBadArgument;
+}
+
+kern_return_t IOUserAudioDevice::UpdateCurrentZeroTimestamp(uint64_t in_sample_time, uint64_t in_host_time)
+{
+	m_zts_sample_time = in_sample_time;
+	m_zts_host_time = in_host_time;
+	if (g_zero_timestamp_observer)
+	{
+		g_zero_timestamp_observer(this, in_sample_time, in_host_time);
+	}
+	return kIOReturnSuccess;
+}
+
+void IOUserAudioDevice::GetCurrentZeroTimestamp(uint64_t* out_sample_time, uint64_t* out_host_time) const
+{
+	*out_sample_time = m_zts_sample_time;
+	*out_host_time = m_zts_host_time;
+}
+
+//
+// Drivers
+//
+
+bool IOUserAudioDriver::init()
+{
+	return IOService::init();
+}
+
+void IOUserAudioDriver::free()
+{
+	m_objects.clear();
+	m_work_queue.reset();
+	IOService::free();
+}
+
+kern_return_t IOUserAudioDriver::Start_Impl(IOService* in_provider)
+{
+	auto error = IOService::Start_Impl(in_provider);
+	if (error == kIOReturnSuccess)
+	{
+		error = IODispatchQueue::Create("Default", 0, 0, m_work_queue.attach());
+	}
+	return error;
+}
+
+kern_return_t IOUserAudioDriver::Stop_Impl(IOService* in_provider)
+{
+	// The objects hold references back to the driver, so let go of them here
+	// rather than waiting for free().
+	m_objects.clear();
+	return IOService::Stop_Impl(in_provider);
+}
+
+kern_return_t IOUserAudioDriver::NewUserClient_Impl(uint32_t in_type, IOUserClient** out_user_client)
+{
+	// There's no HAL to connect the driver's user client to.
+	(void)in_type;
+	*out_user_client = nullptr;
+	return kIOReturnUnsupported;
+}
+
+kern_return_t IOUserAudioDriver::StartDevice(IOUserAudioObjectID in_object_id, IOUserAudioStartStopFlags in_flags)
+{
+	for (const auto& object : m_objects)
+	{
+		auto device = OSDynamicCast(IOUserAudioDevice, object.get());
+		if (device != nullptr && device->GetObjectID() == in_object_id)
+		{
+			return device->StartIO(in_flags);
+		}
+	}
+	return kIOReturnBadArgument;
+}
+
+kern_return_t IOUserAudioDriver::StopDevice(IOUserAudioObjectID in_object_id, IOUserAudioStartStopFlags in_flags)
+{
+	for (const auto& object : m_objects)
+	{
+		auto device = OSDynamicCast(IOUserAudioDevice, object.get());
+		if (device != nullptr && device->GetObjectID() == in_object_id)
+		{
+			return device->StopIO(in_flags);
+		}
+	}
+	return kIOReturnBadArgument;
+}
+
+kern_return_t IOUserAudioDriver::AddObject(IOUserAudioObject* in_object)
+{
+	if (in_object == nullptr)
+	{
+		return kIOReturnBadArgument;
+	}
+	m_objects.push_back(OSSharedPtr<IOUserAudioObject>(in_object, OSRetain));
+	return kIOReturnSuccess;
+}
+
+//
+// Harness controls
+//
+
+namespace SimpleAudioHost
+{
+
+void SetZeroTimestampObserver(std::function<void(IOUserAudioDevice* in_device, uint64_t in_sample_time, uint64_t in_host_time)> in_observer)
+{
+	g_zero_timestamp_observer = in_observer;
+}
+
+size_t GetNumberPendingConfigurationChanges()
+{
+	return g_pending_configuration_changes.size();
+}
+
+size_t PerformConfigurationChanges()
+{
+	// Performing a change can request another one, which waits for the next call.
+	std::vector<PendingConfigurationChange> changes;
+	changes.swap(g_pending_configuration_changes);
+	for (auto& change : changes)
+	{
+		change.m_device->PerformDeviceConfigurationChange(change.m_change_action, change.m_change_info.get());
+	}
+	return changes.size();
+}
+
+}
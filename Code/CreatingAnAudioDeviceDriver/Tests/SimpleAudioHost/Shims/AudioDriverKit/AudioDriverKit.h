@@ -0,0 +1,306 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The subset of AudioDriverKit that the SimpleAudio driver uses,
+             for building it outside of macOS.
+*/
+
+#ifndef AudioDriverKit_h
+#define AudioDriverKit_h
+
+#include <DriverKit/DriverKit.h>
+
+#define FailIf(in_condition, in_action, in_label, in_message, ...) do { if (in_condition) { DebugMsg(in_message, ##__VA_ARGS__); { in_action; } goto in_label; } } while (0)
+#define FailIfError(in_error, in_action, in_label, in_message, ...) FailIf((in_error) != 0, in_action, in_label, in_message, ##__VA_ARGS__)
+#define FailIfNULL(in_pointer, in_action, in_label, in_message, ...) FailIf((in_pointer) == nullptr, in_action, in_label, in_message, ##__VA_ARGS__)
+
+namespace AudioDriverKit
+{
+
+typedef uint32_t IOUserAudioObjectID;
+typedef uint32_t IOUserAudioSelectorValue;
+typedef uint32_t IOUserAudioObjectPropertySelector;
+typedef uint32_t IOUserAudioObjectPropertyElement;
+
+constexpr IOUserAudioObjectPropertyElement IOUserAudioObjectPropertyElementMain = 0;
+constexpr uint32_t kIOUserAudioDriverUserClientType = 'hal!';
+
+enum class IOUserAudioObjectPropertyScope : uint32_t
+{
+	Global = 'glob',
+	Input = 'inpt',
+	Output = 'outp'
+};
+
+enum class IOUserAudioClassID : uint32_t
+{
+	VolumeControl = 'vlme',
+	DataSourceControl = 'dsrc'
+};
+
+enum class IOUserAudioStreamDirection : uint32_t
+{
+	Output = 0,
+	Input = 1
+};
+
+enum class IOUserAudioTransportType : uint32_t
+{
+	BuiltIn = 'bltn'
+};
+
+enum class IOUserAudioChannelLabel : uint32_t
+{
+	Mono = 42
+};
+
+enum class IOUserAudioCustomPropertyDataType : uint32_t
+{
+	None = 0,
+	CFString = 'cfst',
+	String = CFString
+};
+
+enum class IOUserAudioStartStopFlags : uint32_t
+{
+	None = 0
+};
+
+enum class IOUserAudioFormatID : uint32_t
+{
+	LinearPCM = 'lpcm'
+};
+
+enum class IOUserAudioFormatFlags : uint32_t
+{
+	FormatFlagIsFloat = (1U << 0),
+	FormatFlagIsBigEndian = (1U << 1),
+	FormatFlagIsSignedInteger = (1U << 2),
+	FormatFlagIsPacked = (1U << 3),
+	FormatFlagsNativeEndian = 0
+};
+
+constexpr uint32_t operator|(IOUserAudioFormatFlags in_flags_1, IOUserAudioFormatFlags in_flags_2)
+{
+	return static_cast<uint32_t>(in_flags_1) | static_cast<uint32_t>(in_flags_2);
+}
+
+struct IOUserAudioObjectPropertyAddress
+{
+	IOUserAudioObjectPropertySelector	mSelector;
+	IOUserAudioObjectPropertyScope		mScope;
+	IOUserAudioObjectPropertyElement	mElement;
+};
+
+struct IOUserAudioStreamBasicDescription
+{
+	double					mSampleRate;
+	IOUserAudioFormatID		mFormatID;
+	IOUserAudioFormatFlags	mFormatFlags;
+	uint32_t				mBytesPerPacket;
+	uint32_t				mFramesPerPacket;
+	uint32_t				mBytesPerFrame;
+	uint32_t				mChannelsPerFrame;
+	uint32_t				mBitsPerChannel;
+	uint32_t				mReserved;
+};
+
+struct IOUserAudioSelectorValueDescription
+{
+	IOUserAudioSelectorValue	m_value;
+	OSSharedPtr<OSString>		m_name;
+};
+
+struct IOUserAudioLevelControlRange
+{
+	double	m_minimum;
+	double	m_maximum;
+};
+
+}
+
+// The classes are global, as they are in AudioDriverKit; only the types are in the namespace.
+using namespace AudioDriverKit;
+
+class IOUserAudioDriver;
+
+// Every audio object belongs to a driver and runs on the driver's work queue.
+// Objects don't retain their driver.
+class IOUserAudioObject : public OSObject
+{
+public:
+	IOUserAudioObjectID				GetObjectID() const { return m_object_id; }
+	kern_return_t					SetName(OSString* in_name);
+	OSSharedPtr<IODispatchQueue>	GetWorkQueue() const;
+
+protected:
+	bool							InitObject(IOUserAudioDriver* in_driver);
+
+	IOUserAudioDriver*				m_owning_driver = nullptr;
+	IOUserAudioObjectID				m_object_id = 0;
+	OSSharedPtr<OSString>			m_name;
+};
+
+class IOUserAudioStream : public IOUserAudioObject
+{
+public:
+	static OSSharedPtr<IOUserAudioStream>	Create(IOUserAudioDriver* in_driver, IOUserAudioStreamDirection in_direction, IOMemoryDescriptor* in_io_memory_descriptor);
+
+	kern_return_t						SetAvailableStreamFormats(const IOUserAudioStreamBasicDescription* in_formats, size_t in_number_formats);
+	kern_return_t						SetCurrentStreamFormat(const IOUserAudioStreamBasicDescription* in_format);
+	IOUserAudioStreamBasicDescription	GetCurrentStreamFormat() const { return m_current_format; }
+
+	// Switches to the available format at the new rate that's otherwise the same as the current one.
+	kern_return_t						DeviceSampleRateChanged(double in_sample_rate);
+
+	OSSharedPtr<IOMemoryDescriptor>		GetIOMemoryDescriptor() const { return m_io_memory_descriptor; }
+
+private:
+	IOUserAudioStreamDirection						m_direction = IOUserAudioStreamDirection::Input;
+	OSSharedPtr<IOMemoryDescriptor>					m_io_memory_descriptor;
+	std::vector<IOUserAudioStreamBasicDescription>	m_available_formats;
+	IOUserAudioStreamBasicDescription				m_current_format = {};
+};
+
+class IOUserAudioControl : public IOUserAudioObject
+{
+protected:
+	bool							InitControl(IOUserAudioDriver* in_driver, bool in_is_settable, IOUserAudioObjectPropertyElement in_element, IOUserAudioObjectPropertyScope in_scope, IOUserAudioClassID in_class_id);
+
+	bool							m_is_settable = false;
+	IOUserAudioObjectPropertyElement	m_element = IOUserAudioObjectPropertyElementMain;
+	IOUserAudioObjectPropertyScope	m_scope = IOUserAudioObjectPropertyScope::Global;
+	IOUserAudioClassID				m_class_id = IOUserAudioClassID::VolumeControl;
+};
+
+// The scalar value maps linearly onto the decibel range.
+class IOUserAudioLevelControl : public IOUserAudioControl
+{
+public:
+	static OSSharedPtr<IOUserAudioLevelControl>	Create(IOUserAudioDriver* in_driver, bool in_is_settable, double in_initial_level_db, IOUserAudioLevelControlRange in_level_range, IOUserAudioObjectPropertyElement in_element, IOUserAudioObjectPropertyScope in_scope, IOUserAudioClassID in_class_id);
+
+	float							GetScalarValue() const { return m_scalar_value; }
+	kern_return_t					SetScalarValue(float in_value);
+
+private:
+	IOUserAudioLevelControlRange	m_range = {};
+	float							m_scalar_value = 0.0f;
+};
+
+class IOUserAudioSelectorControl : public IOUserAudioControl
+{
+public:
+	static OSSharedPtr<IOUserAudioSelectorControl>	Create(IOUserAudioDriver* in_driver, bool in_is_settable, IOUserAudioObjectPropertyElement in_element, IOUserAudioObjectPropertyScope in_scope, IOUserAudioClassID in_class_id);
+
+	kern_return_t					AddControlValueDescriptions(const IOUserAudioSelectorValueDescription* in_descriptions, size_t in_number_descriptions);
+
+	// A value that isn't one of the descriptions is rejected.
+	kern_return_t					SetCurrentSelectedValues(const IOUserAudioSelectorValue* in_values, size_t in_number_values);
+	kern_return_t					GetCurrentSelectedValues(IOUserAudioSelectorValue* out_values, size_t in_number_values) const;
+
+private:
+	std::vector<IOUserAudioSelectorValue>	m_values;
+	std::vector<IOUserAudioSelectorValue>	m_selected_values;
+};
+
+class IOUserAudioCustomProperty : public IOUserAudioObject
+{
+public:
+	static OSSharedPtr<IOUserAudioCustomProperty>	Create(IOUserAudioDriver* in_driver, IOUserAudioObjectPropertyAddress in_address, bool in_is_settable, IOUserAudioCustomPropertyDataType in_qualifier_type, IOUserAudioCustomPropertyDataType in_data_type);
+
+	kern_return_t					SetQualifierAndDataValue(OSObject* in_qualifier, OSObject* in_data);
+
+private:
+	IOUserAudioObjectPropertyAddress	m_address = {};
+	std::vector<OSSharedPtr<OSObject>>	m_values;
+};
+
+// The HAL side of a device. Configuration change requests wait until the
+// harness performs them, the way the HAL performs them later on its own thread.
+class IOUserAudioDevice : public IOUserAudioObject
+{
+public:
+	virtual bool				init(IOUserAudioDriver* in_driver, bool in_supports_prewarming, OSString* in_device_uid, OSString* in_model_uid, OSString* in_manufacturer_uid, uint32_t in_zero_timestamp_period);
+	void						free() override;
+
+	virtual kern_return_t		StartIO(IOUserAudioStartStopFlags in_flags);
+	virtual kern_return_t		StopIO(IOUserAudioStartStopFlags in_flags);
+	virtual kern_return_t		PerformDeviceConfigurationChange(uint64_t in_change_action, OSObject* in_change_info);
+	virtual kern_return_t		AbortDeviceConfigurationChange(uint64_t in_change_action, OSObject* in_change_info);
+	virtual kern_return_t		HandleChangeSampleRate(double in_sample_rate);
+
+	kern_return_t				RequestDeviceConfigurationChange(uint64_t in_change_action, OSObject* in_change_info);
+
+	kern_return_t				SetAvailableSampleRates(const double* in_sample_rates, size_t in_number_sample_rates);
+	kern_return_t				SetSampleRate(double in_sample_rate);
+	double						GetSampleRate() const { return m_sample_rate; }
+
+	kern_return_t				AddStream(IOUserAudioStream* in_stream);
+	kern_return_t				AddControl(IOUserAudioControl* in_control);
+	kern_return_t				AddCustomProperty(IOUserAudioCustomProperty* in_custom_property);
+
+	kern_return_t				SetPreferredInputChannelLayout(const IOUserAudioChannelLabel* in_layout, size_t in_number_channels);
+	kern_return_t				SetInputLatency(uint32_t in_latency) { m_input_latency = in_latency; return kIOReturnSuccess; }
+	kern_return_t				SetInputSafetyOffset(uint32_t in_safety_offset) { m_input_safety_offset = in_safety_offset; return kIOReturnSuccess; }
+	kern_return_t				SetTransportType(IOUserAudioTransportType in_transport_type) { m_transport_type = in_transport_type; return kIOReturnSuccess; }
+
+	uint32_t					GetZeroTimestampPeriod() const { return m_zero_timestamp_period; }
+	kern_return_t				UpdateCurrentZeroTimestamp(uint64_t in_sample_time, uint64_t in_host_time);
+
+	// For the harness.
+	uint32_t					GetInputLatency() const { return m_input_latency; }
+	uint32_t					GetInputSafetyOffset() const { return m_input_safety_offset; }
+	bool						IsRunning() const { return m_io_running_count > 0; }
+	IOUserAudioStream*			GetStream(size_t in_index) const { return in_index < m_streams.size() ? m_streams[in_index].get() : nullptr; }
+	void						GetCurrentZeroTimestamp(uint64_t* out_sample_time, uint64_t* out_host_time) const;
+
+private:
+	uint32_t					m_zero_timestamp_period = 0;
+	double						m_sample_rate = 0.0;
+	std::vector<double>			m_available_sample_rates;
+	std::vector<OSSharedPtr<IOUserAudioStream>>	m_streams;
+	std::vector<OSSharedPtr<IOUserAudioObject>>	m_owned_objects;
+	uint32_t					m_input_latency = 0;
+	uint32_t					m_input_safety_offset = 0;
+	IOUserAudioTransportType	m_transport_type = IOUserAudioTransportType::BuiltIn;
+	uint32_t					m_io_running_count = 0;
+	uint64_t					m_zts_sample_time = 0;
+	uint64_t					m_zts_host_time = 0;
+};
+
+class IOUserAudioDriver : public IOService
+{
+public:
+	bool						init() override;
+	void						free() override;
+
+	kern_return_t				Start(IOService* in_provider) { return Start_Impl(in_provider); }
+	kern_return_t				Start(IOService* in_provider, OSSuperDispatchTag) { return IOUserAudioDriver::Start_Impl(in_provider); }
+	kern_return_t				Stop(IOService* in_provider) { return Stop_Impl(in_provider); }
+	kern_return_t				Stop(IOService* in_provider, OSSuperDispatchTag) { return IOUserAudioDriver::Stop_Impl(in_provider); }
+	kern_return_t				NewUserClient(uint32_t in_type, IOUserClient** out_user_client) { return NewUserClient_Impl(in_type, out_user_client); }
+	kern_return_t				NewUserClient(uint32_t in_type, IOUserClient** out_user_client, OSSuperDispatchTag) { return IOUserAudioDriver::NewUserClient_Impl(in_type, out_user_client); }
+
+	// These call the device's StartIO and StopIO.
+	virtual kern_return_t		StartDevice(IOUserAudioObjectID in_object_id, IOUserAudioStartStopFlags in_flags);
+	virtual kern_return_t		StopDevice(IOUserAudioObjectID in_object_id, IOUserAudioStartStopFlags in_flags);
+
+	kern_return_t				AddObject(IOUserAudioObject* in_object);
+	OSSharedPtr<IODispatchQueue>	GetWorkQueue() const { return m_work_queue; }
+
+	// For the harness.
+	size_t						GetNumberObjects() const { return m_objects.size(); }
+	IOUserAudioObject*			GetObject(size_t in_index) const { return m_objects[in_index].get(); }
+
+protected:
+	kern_return_t				Start_Impl(IOService* in_provider) override;
+	kern_return_t				Stop_Impl(IOService* in_provider) override;
+	kern_return_t				NewUserClient_Impl(uint32_t in_type, IOUserClient** out_user_client) override;
+
+private:
+	OSSharedPtr<IODispatchQueue>	m_work_queue;
+	std::vector<OSSharedPtr<IOUserAudioObject>>	m_objects;
+};
+
+#endif /* AudioDriverKit_h */
@@ -0,0 +1,388 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The DriverKit runtime for building the SimpleAudio driver
+             outside of macOS, running on a virtual clock.
+*/
+
+#include <DriverKit/DriverKit.h>
+
+#include "SimpleAudioHost.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+bool g_simple_audio_host_debug_messages = false;
+
+namespace
+{
+	uint32_t	g_timebase_numerator = 1;
+	uint32_t	g_timebase_denominator = 1;
+	uint64_t	g_host_time = 0;
+	uint64_t	g_number_live_objects = 0;
+
+	std::vector<IODispatchQueue*>			g_queues;
+	std::vector<IOTimerDispatchSource*>		g_timers;
+	std::function<uint64_t(uint64_t)>		g_timer_lateness;
+	std::function<void(uint64_t)>			g_wake_observer;
+}
+
+//
+// Clock
+//
+
+uint64_t mach_absolute_time()
+{
+	return g_host_time;
+}
+
+int mach_timebase_info(mach_timebase_info_t out_info)
+{
+	out_info->numer = g_timebase_numerator;
+	out_info->denom = g_timebase_denominator;
+	return 0;
+}
+
+//
+// Objects
+//
+
+OSObject::OSObject() : m_retain_count(1)
+{
+	g_number_live_objects += 1;
+}
+
+OSObject::~OSObject()
+{
+	g_number_live_objects -= 1;
+}
+
+void OSObject::retain() const
+{
+	m_retain_count += 1;
+}
+
+void OSObject::release() const
+{
+	if (m_retain_count == 0)
+	{
+		fprintf(stderr, "OSObject::release: over-released object\n");
+		abort();
+	}
+	m_retain_count -= 1;
+	if (m_retain_count == 0)
+	{
+		auto object = const_cast<OSObject*>(this);
+		object->free();
+		delete object;
+	}
+}
+
+uint32_t OSObject::getRetainCount() const
+{
+	return m_retain_count;
+}
+
+OSString* OSString::withCString(const char* in_string)
+{
+	auto string = new OSString();
+	string->m_string = in_string;
+	return string;
+}
+
+OSNumber* OSNumber::withNumber(uint64_t in_value, size_t in_number_of_bits)
+{
+	auto number = new OSNumber();
+	number->m_value = in_number_of_bits < 64 ? in_value & ((1ULL << in_number_of_bits) - 1) : in_value;
+	return number;
+}
+
+OSData* OSData::withBytes(const void* in_bytes, size_t in_length)
+{
+	auto data = new OSData();
+	auto bytes = static_cast<const uint8_t*>(in_bytes);
+	data->m_bytes.assign(bytes, bytes + in_length);
+	return data;
+}
+
+OSAction* OSAction::Create(Handler in_handler)
+{
+	auto action = new OSAction();
+	action->m_handler = in_handler;
+	return action;
+}
+
+//
+// Dispatch
+//
+
+kern_return_t IODispatchQueue::Create(const char* in_name, uint64_t in_options, uint64_t in_priority, IODispatchQueue** out_queue)
+{
+	(void)in_name;
+	(void)in_options;
+	(void)in_priority;
+	*out_queue = new IODispatchQueue();
+	g_queues.push_back(*out_queue);
+	return kIOReturnSuccess;
+}
+
+IODispatchQueue::~IODispatchQueue()
+{
+	g_queues.erase(std::remove(g_queues.begin(), g_queues.end(), this), g_queues.end());
+}
+
+void IODispatchQueue::DispatchSync(Block in_block)
+{
+	m_running_depth += 1;
+	in_block();
+	m_running_depth -= 1;
+}
+
+void IODispatchQueue::DispatchAsync(Block in_block)
+{
+	m_blocks.push_back(in_block);
+}
+
+bool IODispatchQueue::RunNextBlock()
+{
+	if (m_blocks.empty())
+	{
+		return false;
+	}
+	auto block = m_blocks.front();
+	m_blocks.pop_front();
+	DispatchSync(block);
+	return true;
+}
+
+kern_return_t IOTimerDispatchSource::Create(IODispatchQueue* in_queue, IOTimerDispatchSource** out_source)
+{
+	if (in_queue == nullptr)
+	{
+		return kIOReturnBadArgument;
+	}
+	auto source = new IOTimerDispatchSource();
+	source->m_queue = in_queue;
+	source->m_queue->retain();
+	g_timers.push_back(source);
+	*out_source = source;
+	return kIOReturnSuccess;
+}
+
+IOTimerDispatchSource::~IOTimerDispatchSource()
+{
+	g_timers.erase(std::remove(g_timers.begin(), g_timers.end(), this), g_timers.end());
+	OSSafeReleaseNULL(m_handler);
+	OSSafeReleaseNULL(m_queue);
+}
+
+kern_return_t IOTimerDispatchSource::SetHandler(OSAction* in_action)
+{
+	if (in_action != nullptr)
+	{
+		in_action->retain();
+	}
+	OSSafeReleaseNULL(m_handler);
+	m_handler = in_action;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOTimerDispatchSource::WakeAtTime(uint64_t in_options, uint64_t in_deadline, uint64_t in_leeway)
+{
+	(void)in_options;
+	(void)in_leeway;
+	if (g_wake_observer)
+	{
+		g_wake_observer(in_deadline);
+	}
+	m_armed = true;
+	m_fire_time = in_deadline + (g_timer_lateness ? g_timer_lateness(in_deadline) : 0);
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOTimerDispatchSource::SetEnable(bool in_enable)
+{
+	m_enabled = in_enable;
+	return kIOReturnSuccess;
+}
+
+void IOTimerDispatchSource::Fire(uint64_t in_time)
+{
+	// The timer stays retained while its handler runs, in case the handler
+	// releases the last reference to the object that owns it.
+	m_armed = false;
+	retain();
+	auto handler = m_handler;
+	handler->retain();
+	m_queue->DispatchSync([handler, in_time]() { handler->Invoke(in_time); });
+	handler->release();
+	release();
+}
+
+//
+// Memory
+//
+
+kern_return_t IOMemoryDescriptor::CreateMapping(uint64_t in_options, uint64_t in_address, uint64_t in_offset, uint64_t in_length, uint64_t in_alignment, IOMemoryMap** out_map)
+{
+	(void)in_options;
+	(void)in_address;
+	(void)in_alignment;
+	if (in_offset > m_bytes.size() || (in_length != 0 && in_offset + in_length > m_bytes.size()))
+	{
+		return kIOReturnBadArgument;
+	}
+	auto map = new IOMemoryMap();
+	map->m_descriptor = OSSharedPtr<OSObject>(this, OSRetain);
+	map->m_address = reinterpret_cast<uint64_t>(m_bytes.data() + in_offset);
+	map->m_length = in_length != 0 ? in_length : m_bytes.size() - in_offset;
+	*out_map = map;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOBufferMemoryDescriptor::Create(uint64_t in_options, uint64_t in_capacity, uint64_t in_alignment, IOBufferMemoryDescriptor** out_descriptor)
+{
+	(void)in_options;
+	(void)in_alignment;
+	auto descriptor = new IOBufferMemoryDescriptor();
+	descriptor->m_bytes.assign(in_capacity, 0);
+	*out_descriptor = descriptor;
+	return kIOReturnSuccess;
+}
+
+//
+// Services
+//
+
+kern_return_t IOService::Create(IOService* in_provider, const char* in_properties_key, IOService** out_result)
+{
+	(void)in_provider;
+	(void)in_properties_key;
+	*out_result = nullptr;
+	return kIOReturnUnsupported;
+}
+
+kern_return_t IOService::Start_Impl(IOService* in_provider)
+{
+	(void)in_provider;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOService::Stop_Impl(IOService* in_provider)
+{
+	(void)in_provider;
+	return kIOReturnSuccess;
+}
+
+kern_return_t IOService::NewUserClient_Impl(uint32_t in_type, IOUserClient** out_user_client)
+{
+	(void)in_type;
+	*out_user_client = nullptr;
+	return kIOReturnUnsupported;
+}
+
+void IOUserClient::AsyncCompletion(OSAction* in_action, IOReturn in_status, const IOUserClientAsyncArgumentsArray in_arguments, uint32_t in_number_arguments)
+{
+	(void)in_action;
+	m_number_completions += 1;
+	if (in_status != kIOReturnSuccess)
+	{
+		m_number_failed_completions += 1;
+	}
+	if (in_number_arguments > 0)
+	{
+		m_last_completion_argument = in_arguments[0];
+	}
+}
+
+//
+// Harness controls
+//
+
+namespace SimpleAudioHost
+{
+
+void SetTimebase(uint32_t in_numerator, uint32_t in_denominator)
+{
+	g_timebase_numerator = in_numerator;
+	g_timebase_denominator = in_denominator;
+}
+
+void SetHostTime(uint64_t in_host_time)
+{
+	g_host_time = in_host_time;
+}
+
+uint64_t GetHostTime()
+{
+	return g_host_time;
+}
+
+static bool RunQueuedBlocks()
+{
+	bool ran_block = false;
+	for (bool ran_this_pass = true; ran_this_pass; )
+	{
+		ran_this_pass = false;
+		// A block can create or free queues, so index rather than iterate.
+		for (size_t queue_index = 0; queue_index < g_queues.size(); queue_index++)
+		{
+			if (g_queues[queue_index]->RunNextBlock())
+			{
+				ran_this_pass = true;
+				ran_block = true;
+			}
+		}
+	}
+	return ran_block;
+}
+
+void RunUntil(uint64_t in_host_time)
+{
+	for (;;)
+	{
+		RunQueuedBlocks();
+
+		IOTimerDispatchSource* next_timer = nullptr;
+		for (auto timer : g_timers)
+		{
+			if (timer->IsArmed() && timer->GetFireTime() <= in_host_time && (next_timer == nullptr || timer->GetFireTime() < next_timer->GetFireTime()))
+			{
+				next_timer = timer;
+			}
+		}
+		if (next_timer == nullptr)
+		{
+			break;
+		}
+
+		// A timer armed with a deadline that's already passed fires now.
+		g_host_time = std::max(g_host_time, next_timer->GetFireTime());
+		next_timer->Fire(g_host_time);
+	}
+	g_host_time = std::max(g_host_time, in_host_time);
+}
+
+void SetTimerLateness(std::function<uint64_t(uint64_t in_deadline)> in_lateness)
+{
+	g_timer_lateness = in_lateness;
+}
+
+void SetWakeObserver(std::function<void(uint64_t in_deadline)> in_observer)
+{
+	g_wake_observer = in_observer;
+}
+
+uint64_t GetNumberLiveObjects()
+{
+	return g_number_live_objects;
+}
+
+void SetDebugMessages(bool in_debug_messages)
+{
+	g_simple_audio_host_debug_messages = in_debug_messages;
+}
+
+}
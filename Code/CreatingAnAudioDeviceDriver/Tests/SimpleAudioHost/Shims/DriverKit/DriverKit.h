@@ -0,0 +1,328 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The subset of DriverKit that the SimpleAudio driver uses, for
+             building it outside of macOS.
+*/
+
+#ifndef DriverKit_h
+#define DriverKit_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// The driver's blocks are rewritten as lambdas that capture by reference when
+// the sources are copied into the build directory, so __block has nothing to do.
+#define __block
+
+typedef int kern_return_t;
+typedef int IOReturn;
+
+#define kIOReturnSuccess		0
+#define kIOReturnError			((IOReturn)0xe00002bc)
+#define kIOReturnNoMemory		((IOReturn)0xe00002bd)
+#define kIOReturnNoResources	((IOReturn)0xe00002be)
+#define kIOReturnBadArgument	((IOReturn)0xe00002c2)
+#define kIOReturnUnsupported	((IOReturn)0xe00002c7)
+#define kIOReturnInvalid		((IOReturn)0xe00002d1)
+#define kIOReturnNoSpace		((IOReturn)0xe00002d5)
+
+#define NSEC_PER_SEC 1000000000ULL
+
+// The host clock. It only moves when the harness moves it; see SimpleAudioHost.h.
+struct mach_timebase_info
+{
+	uint32_t	numer;
+	uint32_t	denom;
+};
+typedef struct mach_timebase_info* mach_timebase_info_t;
+
+uint64_t	mach_absolute_time();
+int			mach_timebase_info(mach_timebase_info_t out_info);
+
+// Messages are dropped unless the harness turns them on.
+extern bool g_simple_audio_host_debug_messages;
+#define DebugMsg(in_format, ...) do { if (g_simple_audio_host_debug_messages) { fprintf(stderr, in_format "\n", ##__VA_ARGS__); } } while (0)
+
+//
+// Objects
+//
+
+// Reference counted like DriverKit's: an object starts with one reference and
+// free() runs when the last one goes away. The harness counts live objects so
+// it can check that tearing the driver down frees everything.
+class OSObject
+{
+public:
+	OSObject();
+	virtual			~OSObject();
+
+	virtual bool	init() { return true; }
+	virtual void	free() {}
+
+	void			retain() const;
+	void			release() const;
+	uint32_t		getRetainCount() const;
+
+private:
+	mutable uint32_t	m_retain_count;
+};
+
+#define OSTypeAlloc(in_type) (new in_type())
+#define OSDynamicCast(in_type, in_object) (dynamic_cast<in_type*>(in_object))
+#define OSSafeReleaseNULL(io_object) do { if ((io_object) != nullptr) { (io_object)->release(); (io_object) = nullptr; } } while (0)
+
+// Instance variables are allocated one at a time with IONewZero or new, so
+// both are freed the same way.
+#define IONewZero(in_type, in_count) ((in_count) == 1 ? new in_type() : new in_type[in_count]())
+#define IOSafeDeleteNULL(io_pointer, in_type, in_count) do { if ((in_count) == 1) { delete (io_pointer); } else { delete[] (io_pointer); } (io_pointer) = nullptr; } while (0)
+
+struct OSNoRetainTag {};
+struct OSRetainTag {};
+constexpr OSNoRetainTag OSNoRetain;
+constexpr OSRetainTag OSRetain;
+
+template <typename T>
+class OSSharedPtr
+{
+public:
+	OSSharedPtr() : m_object(nullptr) {}
+	OSSharedPtr(decltype(nullptr)) : m_object(nullptr) {}
+	OSSharedPtr(T* in_object, OSNoRetainTag) : m_object(in_object) {}
+	OSSharedPtr(T* in_object, OSRetainTag) : m_object(in_object) { if (m_object != nullptr) { m_object->retain(); } }
+	OSSharedPtr(const OSSharedPtr& in_other) : OSSharedPtr(in_other.m_object, OSRetain) {}
+	OSSharedPtr(OSSharedPtr&& in_other) : m_object(in_other.m_object) { in_other.m_object = nullptr; }
+	template <typename U>
+	OSSharedPtr(const OSSharedPtr<U>& in_other) : OSSharedPtr(in_other.get(), OSRetain) {}
+	~OSSharedPtr() { reset(); }
+
+	OSSharedPtr& operator=(OSSharedPtr in_other)
+	{
+		T* object = m_object;
+		m_object = in_other.m_object;
+		in_other.m_object = object;
+		return *this;
+	}
+
+	T* get() const { return m_object; }
+	T* operator->() const { return m_object; }
+	T& operator*() const { return *m_object; }
+	explicit operator bool() const { return m_object != nullptr; }
+
+	void reset()
+	{
+		T* object = m_object;
+		m_object = nullptr;
+		if (object != nullptr)
+		{
+			object->release();
+		}
+	}
+
+	// Releases the current object and returns the pointer for an out parameter
+	// to fill, taking ownership of whatever reference it gets.
+	T** attach()
+	{
+		reset();
+		return &m_object;
+	}
+
+private:
+	T*	m_object;
+};
+
+class OSString : public OSObject
+{
+public:
+	static OSString*	withCString(const char* in_string);
+	const char*			getCStringNoCopy() const { return m_string.c_str(); }
+
+private:
+	std::string			m_string;
+};
+
+class OSNumber : public OSObject
+{
+public:
+	static OSNumber*	withNumber(uint64_t in_value, size_t in_number_of_bits);
+	uint64_t			unsigned64BitValue() const { return m_value; }
+
+private:
+	uint64_t			m_value = 0;
+};
+
+class OSData : public OSObject
+{
+public:
+	static OSData*		withBytes(const void* in_bytes, size_t in_length);
+	size_t				getLength() const { return m_bytes.size(); }
+	const void*			getBytesNoCopy() const { return m_bytes.data(); }
+
+private:
+	std::vector<uint8_t>	m_bytes;
+};
+
+// An action calls back into the object that made it. It doesn't retain the
+// object, so an object can hold its own actions without a cycle.
+class OSAction : public OSObject
+{
+public:
+	typedef std::function<void(OSAction* in_action, uint64_t in_time)> Handler;
+
+	static OSAction*	Create(Handler in_handler);
+	void				Invoke(uint64_t in_time) { if (m_handler) { m_handler(this, in_time); } }
+
+private:
+	Handler				m_handler;
+};
+
+//
+// Dispatch
+//
+
+// Queues don't have threads. DispatchSync runs the block right away, which is
+// what DriverKit does when the caller is already on the queue and otherwise
+// only differs in which thread runs it. DispatchAsync holds the block until the
+// harness's run loop gets to it.
+class IODispatchQueue : public OSObject
+{
+public:
+	typedef std::function<void()> Block;
+
+	static kern_return_t	Create(const char* in_name, uint64_t in_options, uint64_t in_priority, IODispatchQueue** out_queue);
+	~IODispatchQueue() override;
+
+	void					DispatchSync(Block in_block);
+	void					DispatchAsync(Block in_block);
+
+	// For the run loop. Returns whether there was a block to run.
+	bool					RunNextBlock();
+	bool					IsRunningBlock() const { return m_running_depth > 0; }
+
+private:
+	std::deque<Block>		m_blocks;
+	uint32_t				m_running_depth = 0;
+};
+
+#define kIOTimerClockMachAbsoluteTime 1
+
+// A one-shot timer on the virtual clock. WakeAtTime arms it; it fires at most
+// once per call, on its queue, from the harness's run loop.
+class IOTimerDispatchSource : public OSObject
+{
+public:
+	static kern_return_t	Create(IODispatchQueue* in_queue, IOTimerDispatchSource** out_source);
+	~IOTimerDispatchSource() override;
+
+	kern_return_t			SetHandler(OSAction* in_action);
+	kern_return_t			WakeAtTime(uint64_t in_options, uint64_t in_deadline, uint64_t in_leeway);
+	kern_return_t			SetEnable(bool in_enable);
+
+	// For the run loop.
+	bool					IsArmed() const { return m_enabled && m_armed && m_handler != nullptr; }
+	uint64_t				GetFireTime() const { return m_fire_time; }
+	void					Fire(uint64_t in_time);
+
+private:
+	IODispatchQueue*		m_queue = nullptr;
+	OSAction*				m_handler = nullptr;
+	bool					m_enabled = false;
+	bool					m_armed = false;
+	uint64_t				m_fire_time = 0;
+};
+
+//
+// Memory
+//
+
+#define kIOMemoryDirectionIn	1
+#define kIOMemoryDirectionOut	2
+#define kIOMemoryDirectionInOut	3
+
+class IOMemoryMap : public OSObject
+{
+public:
+	uint64_t			GetAddress() const { return m_address; }
+	uint64_t			GetOffset() const { return 0; }
+	uint64_t			GetLength() const { return m_length; }
+
+private:
+	friend class IOMemoryDescriptor;
+	OSSharedPtr<OSObject>	m_descriptor;
+	uint64_t			m_address = 0;
+	uint64_t			m_length = 0;
+};
+
+class IOMemoryDescriptor : public OSObject
+{
+public:
+	kern_return_t		CreateMapping(uint64_t in_options, uint64_t in_address, uint64_t in_offset, uint64_t in_length, uint64_t in_alignment, IOMemoryMap** out_map);
+
+protected:
+	std::vector<uint8_t>	m_bytes;
+};
+
+// The memory is zero filled and lives as long as the descriptor.
+class IOBufferMemoryDescriptor : public IOMemoryDescriptor
+{
+public:
+	static kern_return_t	Create(uint64_t in_options, uint64_t in_capacity, uint64_t in_alignment, IOBufferMemoryDescriptor** out_descriptor);
+};
+
+//
+// Services
+//
+
+// Generated headers pass SUPERDISPATCH to call the superclass's implementation
+// of a method that has an _Impl.
+struct OSSuperDispatchTag {};
+#define SUPERDISPATCH OSSuperDispatchTag()
+
+class IOUserClient;
+
+class IOService : public OSObject
+{
+public:
+	kern_return_t			Start(IOService* in_provider) { return Start_Impl(in_provider); }
+	kern_return_t			Start(IOService* in_provider, OSSuperDispatchTag) { return IOService::Start_Impl(in_provider); }
+	kern_return_t			Stop(IOService* in_provider) { return Stop_Impl(in_provider); }
+	kern_return_t			Stop(IOService* in_provider, OSSuperDispatchTag) { return IOService::Stop_Impl(in_provider); }
+	kern_return_t			NewUserClient(uint32_t in_type, IOUserClient** out_user_client) { return NewUserClient_Impl(in_type, out_user_client); }
+	kern_return_t			NewUserClient(uint32_t in_type, IOUserClient** out_user_client, OSSuperDispatchTag) { return IOService::NewUserClient_Impl(in_type, out_user_client); }
+
+	kern_return_t			RegisterService() { return kIOReturnSuccess; }
+
+	// There's no IOKit personality to match, so creating a service always fails.
+	kern_return_t			Create(IOService* in_provider, const char* in_properties_key, IOService** out_result);
+
+protected:
+	virtual kern_return_t	Start_Impl(IOService* in_provider);
+	virtual kern_return_t	Stop_Impl(IOService* in_provider);
+	virtual kern_return_t	NewUserClient_Impl(uint32_t in_type, IOUserClient** out_user_client);
+};
+
+typedef uint64_t IOUserClientAsyncArgumentsArray[16];
+
+// A client records completions so the harness can check that each one arrived.
+class IOUserClient : public IOService
+{
+public:
+	void					AsyncCompletion(OSAction* in_action, IOReturn in_status, const IOUserClientAsyncArgumentsArray in_arguments, uint32_t in_number_arguments);
+
+	uint64_t				GetNumberCompletions() const { return m_number_completions; }
+	uint64_t				GetNumberFailedCompletions() const { return m_number_failed_completions; }
+	uint64_t				GetLastCompletionArgument() const { return m_last_completion_argument; }
+
+private:
+	uint64_t				m_number_completions = 0;
+	uint64_t				m_number_failed_completions = 0;
+	uint64_t				m_last_completion_argument = 0;
+};
+
+#endif /* DriverKit_h */
@@ -0,0 +1,8 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Everything the mock provides is in DriverKit.h.
+*/
+
+#include <DriverKit/DriverKit.h>
@@ -0,0 +1,95 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+What iig generates from SimpleAudioDevice.iig, written by hand
+             for building the driver against the mock.
+*/
+
+#ifndef SimpleAudioDevice_h
+#define SimpleAudioDevice_h
+
+#include <AudioDriverKit/AudioDriverKit.h>
+
+constexpr uint64_t k_custom_config_change_action = 1234;
+constexpr uint64_t k_sample_rate_config_change_action = 1235;
+
+struct SimpleAudioDevice_IVars;
+
+class SimpleAudioDevice: public IOUserAudioDevice
+{
+	typedef IOUserAudioDevice super;
+
+public:
+	bool						init(IOUserAudioDriver* in_driver,
+									 bool in_supports_prewarming,
+									 OSString* in_device_uid,
+									 OSString* in_model_uid,
+									 OSString* in_manufacturer_uid,
+									 uint32_t in_zero_timestamp_period) override;
+	
+	void						free() override;
+	
+public:
+	kern_return_t				StartIO(IOUserAudioStartStopFlags in_flags) final;
+	
+	kern_return_t				StopIO(IOUserAudioStartStopFlags in_flags) final;
+	
+	kern_return_t				PerformDeviceConfigurationChange(uint64_t change_action,
+																 OSObject* in_change_info) final;
+	
+	kern_return_t				AbortDeviceConfigurationChange(uint64_t change_action,
+															   OSObject* in_change_info) final;
+	
+	kern_return_t				HandleChangeSampleRate(double in_sample_rate) final;
+	
+	kern_return_t				ToggleDataSource(IOUserClient* in_client,
+												 OSAction* in_completion);
+	
+	kern_return_t				UpdateParameters(OSData* in_updates,
+												 IOUserClient* in_client,
+												 OSAction* in_completion);
+	
+	kern_return_t				CopyTelemetryMemory(IOMemoryDescriptor** out_memory);
+
+private:
+	kern_return_t				StartTimers();
+	
+	void						StopTimers();
+	
+	void						UpdateTimers();
+	
+	void						DeviceTimerOccurred_Impl(OSAction* action,
+														 uint64_t time);
+	
+	// iig makes one of these for each method typed as a callback.
+	kern_return_t				CreateActionDeviceTimerOccurred(size_t in_reference_size,
+																OSAction** out_action)
+	{
+		(void)in_reference_size;
+		*out_action = OSAction::Create([this](OSAction* action, uint64_t time) { DeviceTimerOccurred_Impl(action, time); });
+		return *out_action != nullptr ? kIOReturnSuccess : kIOReturnNoMemory;
+	}
+	
+	void						CaptureToneParameters();
+	
+	void						GenerateToneForInput(size_t in_frame_size);
+	
+	kern_return_t				EnqueueCommand(uint32_t in_command,
+											   uint64_t in_argument,
+											   OSObject* in_object,
+											   IOUserClient* in_client,
+											   OSAction* in_completion);
+	
+	void						DrainCommands();
+	
+	kern_return_t				PerformToggleDataSource(uint64_t* out_selected_value);
+	
+	kern_return_t				ValidateParameterUpdates(OSData* in_updates);
+	
+	kern_return_t				PerformUpdateParameters(OSData* in_updates);
+
+	SimpleAudioDevice_IVars*	ivars = nullptr;
+};
+
+#endif /* SimpleAudioDevice_h */
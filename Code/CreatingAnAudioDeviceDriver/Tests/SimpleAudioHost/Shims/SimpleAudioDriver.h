@@ -0,0 +1,62 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+What iig generates from SimpleAudioDriver.iig, written by hand
+             for building the driver against the mock.
+*/
+
+#ifndef SimpleAudioDriver_h
+#define SimpleAudioDriver_h
+
+#include <AudioDriverKit/AudioDriverKit.h>
+
+struct SimpleAudioDriver_IVars;
+
+class SimpleAudioDriver: public IOUserAudioDriver
+{
+	typedef IOUserAudioDriver super;
+
+public:
+	bool init() override;
+	
+	void free() override;
+	
+	kern_return_t Start(IOService* provider) { return Start_Impl(provider); }
+	kern_return_t Start(IOService* provider, OSSuperDispatchTag) { return super::Start_Impl(provider); }
+	kern_return_t Stop(IOService* provider) { return Stop_Impl(provider); }
+	kern_return_t Stop(IOService* provider, OSSuperDispatchTag) { return super::Stop_Impl(provider); }
+	kern_return_t NewUserClient(uint32_t in_type, IOUserClient** out_user_client) { return NewUserClient_Impl(in_type, out_user_client); }
+	
+public:
+	kern_return_t StartDevice(IOUserAudioObjectID in_object_id,
+							  IOUserAudioStartStopFlags in_flags) override;
+	
+	kern_return_t StopDevice(IOUserAudioObjectID in_object_id,
+							 IOUserAudioStartStopFlags in_flags) override;
+	
+public:
+	kern_return_t HandleToggleDataSource(IOUserClient* in_client,
+										 OSAction* in_completion);
+
+	kern_return_t HandleTestConfigChange();
+	
+	kern_return_t HandleUpdateParameters(OSData* in_updates,
+										 IOUserClient* in_client,
+										 OSAction* in_completion);
+	
+	kern_return_t HandleCopyTelemetryMemory(IOMemoryDescriptor** out_memory);
+
+protected:
+	kern_return_t Start_Impl(IOService* provider) override;
+	
+	kern_return_t Stop_Impl(IOService* provider) override;
+	
+	kern_return_t NewUserClient_Impl(uint32_t in_type,
+									 IOUserClient** out_user_client) override;
+
+private:
+	SimpleAudioDriver_IVars* ivars = nullptr;
+};
+
+#endif /* SimpleAudioDriver_h */
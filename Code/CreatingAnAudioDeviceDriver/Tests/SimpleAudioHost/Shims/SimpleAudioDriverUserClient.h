@@ -0,0 +1,17 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+What iig generates from SimpleAudioDriverUserClient.iig. The
+             harness doesn't build the user client, so the class is
+             only declared.
+*/
+
+#ifndef SimpleAudioDriverUserClient_h
+#define SimpleAudioDriverUserClient_h
+
+#include <DriverKit/DriverKit.h>
+
+class SimpleAudioDriverUserClient;
+
+#endif /* SimpleAudioDriverUserClient_h */
@@ -0,0 +1,175 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Checks that the SimpleAudio tone and sweep sources stay clean
+             over long blocks, against a double-precision reference and
+             in the spectrum.
+*/
+
+#include "SimpleAudioSignalSource.h"
+
+#include <stdio.h>
+#include <complex>
+#include <vector>
+
+// The tone is checked two ways. Its samples are compared with sin() of the
+// exact phase, and its spectrum is taken with a tone that lands exactly on a
+// bin, so a rectangular window has no leakage and every other bin is
+// distortion or noise. Long blocks are the hard case, since the phase within a
+// block grows with the block. The sweep has no simple closed form across
+// blocks, so it's compared with the same per-block formula evaluated in long
+// double with sinl().
+
+constexpr size_t	k_fft_size = 65536;
+constexpr double	k_sample_rate = 48000.0;
+constexpr size_t	k_tone_bin = 1361;
+constexpr double	k_max_sample_error = 1.0e-6;
+constexpr double	k_min_spurious_free_range_db = 120.0;
+
+static const size_t k_block_frame_counts[] = { 256, 4096, 65536 };
+
+static uint64_t g_number_failures = 0;
+
+static void Check(bool in_condition, const char* in_what)
+{
+	if (!in_condition)
+	{
+		fprintf(stderr, "SignalPurity: %s\n", in_what);
+		g_number_failures += 1;
+	}
+}
+
+static void FFT(std::vector<std::complex<double>>& io_data)
+{
+	size_t size = io_data.size();
+	for (size_t i = 1, j = 0; i < size; i++)
+	{
+		size_t bit = size >> 1;
+		for (; j & bit; bit >>= 1)
+		{
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j)
+		{
+			std::swap(io_data[i], io_data[j]);
+		}
+	}
+	for (size_t length = 2; length <= size; length <<= 1)
+	{
+		std::complex<double> step = std::polar(1.0, -2.0 * M_PI / static_cast<double>(length));
+		for (size_t start = 0; start < size; start += length)
+		{
+			std::complex<double> twiddle = 1.0;
+			for (size_t k = 0; k < length / 2; k++)
+			{
+				std::complex<double> even = io_data[start + k];
+				std::complex<double> odd = io_data[start + k + length / 2] * twiddle;
+				io_data[start + k] = even + odd;
+				io_data[start + k + length / 2] = even - odd;
+				twiddle *= step;
+			}
+		}
+	}
+}
+
+// The largest bin other than the tone's, in dB below the tone.
+static double SpuriousFreeRange(const std::vector<float>& in_samples, size_t in_tone_bin)
+{
+	std::vector<std::complex<double>> spectrum(in_samples.begin(), in_samples.end());
+	FFT(spectrum);
+	double tone = std::abs(spectrum[in_tone_bin]);
+	double largest_spur = 0.0;
+	for (size_t bin = 0; bin <= spectrum.size() / 2; bin++)
+	{
+		if (bin != in_tone_bin)
+		{
+			largest_spur = fmax(largest_spur, std::abs(spectrum[bin]));
+		}
+	}
+	return 20.0 * log10(tone / fmax(largest_spur, 1.0e-300));
+}
+
+static void CheckTone()
+{
+	double frequency = k_tone_bin * k_sample_rate / k_fft_size;
+	long double phase_increment = static_cast<long double>(frequency) / k_sample_rate;
+	for (size_t block_frame_count : k_block_frame_counts)
+	{
+		SimpleAudioToneGenerator generator = {};
+		std::vector<float> samples(k_fft_size);
+		for (size_t frame = 0; frame < k_fft_size; frame += block_frame_count)
+		{
+			generator.Render(samples.data() + frame, block_frame_count, frequency, k_sample_rate, 1.0f);
+		}
+
+		double max_error = 0.0;
+		for (size_t frame = 0; frame < k_fft_size; frame++)
+		{
+			long double phase = frame * phase_increment;
+			phase -= floorl(phase);
+			max_error = fmax(max_error, fabs(samples[frame] - static_cast<double>(sinl(2.0L * static_cast<long double>(M_PI) * phase))));
+		}
+		double range = SpuriousFreeRange(samples, k_tone_bin);
+
+		printf("tone   %6zu-frame blocks: max error %.2e, spurious-free range %.1f dB\n", block_frame_count, max_error, range);
+		Check(max_error < k_max_sample_error, "a tone sample is too far from the exact sine");
+		Check(range > k_min_spurious_free_range_db, "the tone has a spur too close to its level");
+	}
+}
+
+// Compares the sweep with its own per-block phase formula evaluated in long
+// double, across the wrap from the end of the sweep back to 20 Hz.
+static void CheckSweep(double in_sample_rate, size_t in_block_frame_count)
+{
+	SimpleAudioSweepSource source;
+	source.Reset();
+	SimpleAudioSignalContext context = { in_sample_rate, 0.0 };
+
+	double end_frequency = fmin(20000.0, 0.45 * in_sample_rate);
+	uint64_t sweep_frame_count = static_cast<uint64_t>(10.0 * in_sample_rate);
+	auto frequency_at = [&](long double in_position) { return 20.0L * powl(end_frequency / 20.0L, in_position); };
+
+	// Twelve seconds, to go through the end of the sweep and back to the start.
+	uint64_t frame_count = static_cast<uint64_t>(12.0 * in_sample_rate);
+	std::vector<float> block(in_block_frame_count);
+	long double phase = 0.0L;
+	double max_error = 0.0;
+	for (uint64_t frame = 0; frame < frame_count; frame += in_block_frame_count)
+	{
+		source.Render(block.data(), in_block_frame_count, context);
+
+		long double start_position = static_cast<long double>(frame % sweep_frame_count) / sweep_frame_count;
+		long double end_position = start_position + static_cast<long double>(in_block_frame_count) / sweep_frame_count;
+		long double start_increment = frequency_at(start_position) / in_sample_rate;
+		long double slope = (frequency_at(end_position) / in_sample_rate - start_increment) / in_block_frame_count;
+		for (size_t i = 0; i < in_block_frame_count; i++)
+		{
+			long double frame_phase = phase + i * (start_increment + i * 0.5L * slope);
+			frame_phase -= floorl(frame_phase);
+			max_error = fmax(max_error, fabs(block[i] - static_cast<double>(sinl(2.0L * static_cast<long double>(M_PI) * frame_phase))));
+		}
+		phase += in_block_frame_count * (start_increment + 0.5L * slope * in_block_frame_count);
+		phase -= floorl(phase);
+	}
+
+	printf("sweep  %6zu-frame blocks at %.0f Hz: max error %.2e\n", in_block_frame_count, in_sample_rate, max_error);
+	Check(max_error < k_max_sample_error, "a sweep sample is too far from the reference");
+}
+
+int main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	CheckTone();
+	for (size_t block_frame_count : k_block_frame_counts)
+	{
+		CheckSweep(48000.0, block_frame_count);
+		CheckSweep(192000.0, block_frame_count);
+	}
+
+	printf("SignalPurity: %llu failures\n", static_cast<unsigned long long>(g_number_failures));
+	return g_number_failures == 0 ? 0 : 1;
+}
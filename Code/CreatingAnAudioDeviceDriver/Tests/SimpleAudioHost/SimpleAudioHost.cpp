@@ -0,0 +1,82 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A stand-in for the DriverKit runtime and the HAL that loads the
+             SimpleAudio driver and drives it on a virtual clock.
+*/
+
+#include "SimpleAudioHost.h"
+
+#include "SimpleAudioDevice.h"
+#include "SimpleAudioDriver.h"
+#include "SimpleAudioTelemetry.h"
+
+#include <stdlib.h>
+
+namespace SimpleAudioHost
+{
+
+SimpleAudioDriver* OpenDriver()
+{
+	auto driver = OSTypeAlloc(SimpleAudioDriver);
+	if (!driver->init())
+	{
+		fprintf(stderr, "SimpleAudioHost::OpenDriver: init failed\n");
+		exit(1);
+	}
+	if (driver->Start(nullptr) != kIOReturnSuccess)
+	{
+		fprintf(stderr, "SimpleAudioHost::OpenDriver: Start failed\n");
+		exit(1);
+	}
+	return driver;
+}
+
+void CloseDriver(SimpleAudioDriver* in_driver)
+{
+	RunUntil(GetHostTime());
+	in_driver->Stop(nullptr);
+	in_driver->release();
+}
+
+SimpleAudioDevice* GetDevice(SimpleAudioDriver* in_driver)
+{
+	for (size_t object_index = 0; object_index < in_driver->GetNumberObjects(); object_index++)
+	{
+		auto device = OSDynamicCast(SimpleAudioDevice, in_driver->GetObject(object_index));
+		if (device != nullptr)
+		{
+			return device;
+		}
+	}
+	fprintf(stderr, "SimpleAudioHost::GetDevice: the driver has no device\n");
+	exit(1);
+}
+
+SimpleAudioTelemetryRing* MapTelemetry(SimpleAudioDriver* in_driver, OSSharedPtr<IOMemoryMap>& out_map)
+{
+	OSSharedPtr<IOMemoryDescriptor> memory;
+	if (in_driver->HandleCopyTelemetryMemory(memory.attach()) != kIOReturnSuccess ||
+		memory->CreateMapping(0, 0, 0, 0, 0, out_map.attach()) != kIOReturnSuccess)
+	{
+		fprintf(stderr, "SimpleAudioHost::MapTelemetry: couldn't map the telemetry\n");
+		exit(1);
+	}
+	return reinterpret_cast<SimpleAudioTelemetryRing*>(out_map->GetAddress() + out_map->GetOffset());
+}
+
+int16_t* MapInputBuffer(SimpleAudioDevice* in_device, OSSharedPtr<IOMemoryMap>& out_map, size_t* out_frame_count)
+{
+	auto stream = in_device->GetStream(0);
+	auto memory = stream != nullptr ? stream->GetIOMemoryDescriptor() : nullptr;
+	if (!memory || memory->CreateMapping(0, 0, 0, 0, 0, out_map.attach()) != kIOReturnSuccess)
+	{
+		fprintf(stderr, "SimpleAudioHost::MapInputBuffer: couldn't map the input stream\n");
+		exit(1);
+	}
+	*out_frame_count = out_map->GetLength() / stream->GetCurrentStreamFormat().mBytesPerFrame;
+	return reinterpret_cast<int16_t*>(out_map->GetAddress() + out_map->GetOffset());
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A stand-in for the DriverKit runtime and the HAL that loads the
+             SimpleAudio driver and drives it on a virtual clock.
+*/
+
+#ifndef SimpleAudioHost_h
+#define SimpleAudioHost_h
+
+#include <AudioDriverKit/AudioDriverKit.h>
+
+#include <functional>
+
+class SimpleAudioDriver;
+class SimpleAudioDevice;
+struct SimpleAudioTelemetryRing;
+
+namespace SimpleAudioHost
+{
+
+//
+// Clock and run loop
+//
+
+// The host clock only moves when the harness moves it, and nothing runs
+// concurrently: DispatchAsync blocks and timers run from RunUntil, one at a
+// time, in the order the real queue would run them.
+void		SetTimebase(uint32_t in_numerator, uint32_t in_denominator);
+void		SetHostTime(uint64_t in_host_time);
+uint64_t	GetHostTime();
+
+// Runs every queued block, then fires each armed timer whose time has come, in
+// time order, moving the clock to each timer's fire time. The clock ends at
+// in_host_time or at the last fire time, whichever is later.
+void		RunUntil(uint64_t in_host_time);
+
+// Called each time a timer is armed, to add how late it fires past its
+// deadline. Timers fire on time when there's no lateness function.
+void		SetTimerLateness(std::function<uint64_t(uint64_t in_deadline)> in_lateness);
+
+// Called with each deadline a timer is armed with.
+void		SetWakeObserver(std::function<void(uint64_t in_deadline)> in_observer);
+
+//
+// HAL
+//
+
+// Called with each zero timestamp a device publishes, including the zeros a
+// device publishes to clear its timestamps when IO starts.
+void		SetZeroTimestampObserver(std::function<void(IOUserAudioDevice* in_device, uint64_t in_sample_time, uint64_t in_host_time)> in_observer);
+
+// Configuration changes a device requested and the HAL hasn't performed yet.
+size_t		GetNumberPendingConfigurationChanges();
+
+// Performs every pending configuration change on the calling thread, the way
+// the HAL does, without stopping IO first. Returns how many it performed.
+size_t		PerformConfigurationChanges();
+
+// Objects that have been allocated and not yet freed.
+uint64_t	GetNumberLiveObjects();
+
+void		SetDebugMessages(bool in_debug_messages);
+
+//
+// Driver
+//
+
+// Allocates, initializes, and starts the driver the way DriverKit does.
+SimpleAudioDriver*	OpenDriver();
+
+// Stops and releases the driver once the run loop has nothing left to do.
+void				CloseDriver(SimpleAudioDriver* in_driver);
+
+SimpleAudioDevice*	GetDevice(SimpleAudioDriver* in_driver);
+
+// Maps the device's telemetry ring. The map stays valid until it's released.
+SimpleAudioTelemetryRing*	MapTelemetry(SimpleAudioDriver* in_driver, OSSharedPtr<IOMemoryMap>& out_map);
+
+// Maps the device's input stream ring buffer.
+int16_t*	MapInputBuffer(SimpleAudioDevice* in_device, OSSharedPtr<IOMemoryMap>& out_map, size_t* out_frame_count);
+
+}
+
+#endif /* SimpleAudioHost_h */
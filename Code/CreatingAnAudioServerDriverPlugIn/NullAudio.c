@@ -17,10 +17,20 @@ A minimal user-space driver.
 #include <CoreAudio/AudioServerPlugIn.h>
 #include <dispatch/dispatch.h>
 #include <mach/mach_time.h>
+#include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/syslog.h>
 
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+	#include <arm_neon.h>
+#endif
+
 //==================================================================================================
 #pragma mark -
 #pragma mark Macros
@@ -79,34 +89,42 @@ A minimal user-space driver.
 //	illustrate the minimal set of things a driver has to do. The sample driver has the following
 //	qualities:
 //	- a plug-in
-//		- custom property with the selector kPlugIn_CustomPropertyID = 'PCst'
+//		- custom property with the selector kPlugIn_CustomPropertyID = 'PCst' that reports
+//		  timing statistics about each device's IO
 //	- a box
-//	- a device
-//		- supports 44100 and 48000 sample rates
+//	- up to kPlugIn_MaxNumberDevices devices, each of which has the following
+//		- created at initialization time or via NullAudio_CreateDevice()
+//		- supports the standard sample rates from 8000 to 384000
 //		- provides a rate scalar of 1.0 via hard coding
-//	- a single input stream
-//		- supports 2 channels of 32 bit float LPCM samples
-//		- always produces zeros 
-//	- a single output stream
-//		- supports 2 channels of 32 bit float LPCM samples
-//		- data written to it is ignored
-//	- controls
-//		- master input volume
-//		- master output volume
-//		- master input mute
-//		- master output mute
-//		- master input data source
-//		- master output data source
-//		- master play-through data destination
-//		- all are for illustration purposes only and do not actually manipulate data
-
-
-//	Declare the internal object ID numbers for all the objects this driver implements. Note that
-//	this driver has a fixed set of objects that never grows or shrinks. If this were not the case,
-//	the driver would need to have a means to dynamically allocate these IDs. It's important to
-//	realize that a lot of the structure of this driver is vastly simpler when the IDs are all
-//	known a priori. Comments in the code will try to identify some of these simplifications and
-//	point out what a more complicated driver will need to do.
+//		- a single input stream
+//			- supports 1 to 32 channels of 16 bit, packed 24 bit and 32 bit integer or 32 bit float
+//			  LPCM samples, the virtual format is always 32 bit float
+//			- produces whatever was written to the output stream
+//		- a single output stream
+//			- always has the same format as the input stream
+//			- data written to it is looped back to the input stream
+//		- controls
+//			- master input volume
+//			- master output volume
+//			- master input mute
+//			- master output mute
+//			- master input data source
+//			- master output data source
+//			- master play-through data destination
+//			- the volume and mute controls are applied to the data, the others are for
+//			  illustration purposes only
+//		- play-through of the input to the output with a latency set through the custom property
+//		  kDevice_PlayThruLatencyPropertyID = 'PTlt'
+
+
+//	Declare the internal object ID numbers for all the objects this driver implements. The plug-in
+//	and the box are singletons with fixed IDs. Devices, on the other hand, are created and destroyed
+//	on demand, so their IDs have to be allocated dynamically. To keep that simple, each device slot
+//	owns a block of kDevice_NumberObjectIDs consecutive IDs that covers the device and all of its
+//	sub-objects, always laid out in the same order. The enum below gives the IDs of the objects in
+//	the first slot's block. The object in the same position for slot N has that ID plus
+//	N * kDevice_NumberObjectIDs. This means that any object ID can be mapped back to its device and
+//	to the kind of object it is with a little arithmetic rather than a search.
 enum
 {
 	kObjectID_PlugIn					= kAudioObjectPlugInObject,
@@ -123,48 +141,215 @@ enum
 	kObjectID_DataDestination_PlayThru_Master	= 12
 };
 
-//	Declare the stuff that tracks the state of the plug-in, the device and its sub-objects.
-//	Note that we use global variables here because this driver only ever has a single device. If
-//	multiple devices were supported, this state would need to be encapsulated in one or more structs
-//	so that each object's state can be tracked individually.
-//	Note also that we share a single mutex across all objects to be thread safe for the same reason.
+#define										kDevice_NumberObjectIDs			(kObjectID_DataDestination_PlayThru_Master - kObjectID_Device + 1)
+#define										kPlugIn_MaxNumberDevices		64
+#define										kPlugIn_AnyDeviceSlot			0xFFFFFFFF
+
+//	Declare the stuff that tracks the state of the plug-in, the box and the devices.
+//	The plug-in and box state is global and is protected by gPlugIn_StateMutex. That mutex also
+//	protects the set of devices that exist. Everything else about a device lives in its
+//	NullAudio_Device struct and is protected by that device's own mStateMutex, so that property
+//	traffic and IO on one device never contend with another device. When both are needed,
+//	gPlugIn_StateMutex is always taken first.
+//	The one exception is each device's clock anchor. It is read by the IO thread on every cycle, so
+//	it is published through a sequence lock instead so that the IO thread never has to block.
 #define										kPlugIn_BundleID				"com.apple.audio.NullAudio"
 static pthread_mutex_t						gPlugIn_StateMutex				= PTHREAD_MUTEX_INITIALIZER;
 static UInt32								gPlugIn_RefCount				= 0;
 static AudioServerPlugInHostRef				gPlugIn_Host					= NULL;
 static const AudioObjectPropertySelector	kPlugIn_CustomPropertyID		= 'PCst';
+static const AudioObjectPropertySelector	kDevice_PlayThruLatencyPropertyID	= 'PTlt';
 
 #define										kBox_UID						"NullAudioBox_UID"
 static CFStringRef							gBox_Name						= NULL;
 static Boolean								gBox_Acquired					= true;
 
+//	The pending property change notifications are protected by gNotification_Mutex, which is never
+//	held while taking any other lock or calling the host. The counters can be read at any time.
+//	gNotification_NumberDropped counts the notifications that were lost because the table was full
+//	and there wasn't memory to send them on their own, so it should always be zero.
+typedef struct NullAudio_Notification
+{
+	AudioObjectID				mObjectID;
+	AudioObjectPropertyAddress	mAddress;
+} NullAudio_Notification;
+
+#define										kNotification_MaxNumberPending	256
+static const Float64						kNotification_MinimumInterval	= 20.0 * 1000.0 * 1000.0;
+static pthread_mutex_t						gNotification_Mutex				= PTHREAD_MUTEX_INITIALIZER;
+static dispatch_queue_t						gNotification_Queue				= NULL;
+static NullAudio_Notification				gNotification_Pending[kNotification_MaxNumberPending];
+static UInt32								gNotification_NumberPending		= 0;
+static bool									gNotification_FlushIsScheduled	= false;
+static UInt64								gNotification_LastFlushTime		= 0;
+static _Atomic UInt64						gNotification_NumberEmitted		= 0;
+static _Atomic UInt64						gNotification_NumberSuppressed	= 0;
+static _Atomic UInt64						gNotification_NumberDropped		= 0;
+
+//	The saved settings for the devices are protected by gPlugIn_StateMutex. gSettings_Mutex only
+//	protects whether or not a write is scheduled and is never held while taking another lock.
+#define										kSettings_Key					"settings"
+static const int64_t						kSettings_WriteDelay			= 500LL * 1000LL * 1000LL;
+static pthread_mutex_t						gSettings_Mutex					= PTHREAD_MUTEX_INITIALIZER;
+static dispatch_queue_t						gSettings_Queue					= NULL;
+static bool									gSettings_WriteIsScheduled		= false;
+static CFDictionaryRef						gSettings_Devices				= NULL;
+
 #define										kDevice_UID						"NullAudioDevice_UID"
 #define										kDevice_ModelUID				"NullAudioDevice_ModelUID"
-static pthread_mutex_t						gDevice_IOMutex					= PTHREAD_MUTEX_INITIALIZER;
-static Float64								gDevice_SampleRate				= 44100.0;
-static UInt64								gDevice_IOIsRunning				= 0;
+#define										kDevice_Name					"DeviceName"
+static const Float64						kDevice_DefaultSampleRate		= 44100.0;
 static const UInt32							kDevice_RingBufferSize			= 16384;
-static Float64								gDevice_HostTicksPerFrame		= 0.0;
-static UInt64								gDevice_NumberTimeStamps		= 0;
-static Float64								gDevice_AnchorSampleTime		= 0.0;
-static UInt64								gDevice_AnchorHostTime			= 0;
-
-static bool									gStream_Input_IsActive			= true;
-static bool									gStream_Output_IsActive			= true;
+static const UInt32							kDevice_DefaultChannelsPerFrame	= 2;
+static const UInt32							kDevice_MaxChannelsPerFrame		= 32;
+static const UInt32							kDevice_MaxPlayThruLatency		= 8192;
+static const Float64						kDevice_SampleRates[]			= { 8000.0, 11025.0, 12000.0, 16000.0, 22050.0, 24000.0, 32000.0, 44100.0, 48000.0, 64000.0, 88200.0, 96000.0, 128000.0, 176400.0, 192000.0, 352800.0, 384000.0 };
+#define										kDevice_NumberSampleRates		(sizeof(kDevice_SampleRates) / sizeof(kDevice_SampleRates[0]))
+
+//	The sample formats the streams support. The virtual format is always kSampleFormat_Float32 and
+//	the physical format can be any of these.
+enum
+{
+	kSampleFormat_Float32		= 0,
+	kSampleFormat_SInt16		= 1,
+	kSampleFormat_SInt24		= 2,
+	kSampleFormat_SInt32		= 3,
+	kSampleFormat_NumberFormats	= 4
+};
 
 static const Float32						kVolume_MinDB					= -96.0;
 static const Float32						kVolume_MaxDB					= 6.0;
-static Float32								gVolume_Input_Master_Value		= 0.0;
-static Float32								gVolume_Output_Master_Value		= 0.0;
-
-static bool									gMute_Input_Master_Value		= false;
-static bool									gMute_Output_Master_Value		= false;
 
 static const UInt32							kDataSource_NumberItems			= 4;
 #define										kDataSource_ItemNamePattern		"Data Source Item %d"
-static UInt32								gDataSource_Input_Master_Value	= 0;
-static UInt32								gDataSource_Output_Master_Value	= 0;
-static UInt32								gDataDestination_PlayThru_Master_Value	= 0;
+
+#define										kDevice_MaxNumberClients		64
+
+//	The per-client state a device keeps for each client the HAL has told it about. A slot in the
+//	table is claimed and released with the device's mStateMutex held. The IO thread finds a client
+//	without locking by looking for a slot that is in use with a matching client ID.
+typedef struct NullAudio_Client
+{
+	//	written with mStateMutex held
+	_Atomic bool		mIsInUse;
+	UInt32				mClientID;
+	pid_t				mProcessID;
+	
+	//	only touched by the IO thread
+	UInt64				mMixCycleCounter;
+	UInt64				mNumberFramesMixed;
+} NullAudio_Client;
+
+//	The IO operations that the telemetry keeps timings for.
+enum
+{
+	kTelemetry_Operation_ReadInput		= 0,
+	kTelemetry_Operation_ConvertInput	= 1,
+	kTelemetry_Operation_MixOutput		= 2,
+	kTelemetry_Operation_ConvertMix		= 3,
+	kTelemetry_Operation_WriteMix		= 4,
+	kTelemetry_NumberOperations			= 5
+};
+
+#define										kTelemetry_NumberBuckets		40
+
+//	A histogram of durations in host ticks with a bucket per power of two. It is only written by the
+//	IO thread and can be read at any time without locking.
+typedef struct NullAudio_Histogram
+{
+	_Atomic UInt64		mBuckets[kTelemetry_NumberBuckets];
+	_Atomic UInt64		mNumberValues;
+	_Atomic UInt64		mTotal;
+	_Atomic UInt64		mMaximum;
+} NullAudio_Histogram;
+
+typedef struct NullAudio_Telemetry
+{
+	//	written by the IO thread and read lock-free by the property code
+	NullAudio_Histogram	mCycleDuration;
+	NullAudio_Histogram	mCycleJitter;
+	NullAudio_Histogram	mOperationDuration[kTelemetry_NumberOperations];
+	_Atomic UInt64		mNumberOverloads;
+	
+	//	only touched by the IO thread
+	UInt64				mCycleStartTime;
+	UInt64				mLastCycleStartTime;
+	UInt64				mOperationStartTime[kTelemetry_NumberOperations];
+} NullAudio_Telemetry;
+
+typedef struct NullAudio_Device
+{
+	//	whether or not the slot holds a device, written with gPlugIn_StateMutex held
+	_Atomic bool		mIsAlive;
+	
+	//	fixed for the lifetime of the slot
+	UInt32				mSlot;
+	AudioObjectID		mObjectID;
+	CFStringRef			mUID;
+	CFStringRef			mName;
+	
+	//	protected by mStateMutex
+	pthread_mutex_t		mStateMutex;
+	Float64				mSampleRate;
+	UInt32				mSampleFormat;
+	UInt32				mChannelsPerFrame;
+	UInt64				mIOIsRunning;
+	bool				mStream_Input_IsActive;
+	bool				mStream_Output_IsActive;
+	Float32				mVolume_Input_Master_Value;
+	Float32				mVolume_Output_Master_Value;
+	bool				mMute_Input_Master_Value;
+	bool				mMute_Output_Master_Value;
+	UInt32				mDataSource_Input_Master_Value;
+	UInt32				mDataSource_Output_Master_Value;
+	UInt32				mDataDestination_PlayThru_Master_Value;
+	
+	//	the clock anchor, written with mStateMutex held and read lock-free by the IO thread
+	_Atomic UInt32		mClockAnchorSequence;
+	_Atomic UInt64		mClockAnchorGeneration;
+	_Atomic UInt64		mAnchorHostTime;
+	_Atomic Float64		mAnchorSampleTime;
+	_Atomic UInt64		mHostTicksPerRingBufferWhole;
+	_Atomic UInt64		mHostTicksPerRingBufferRemainder;
+	_Atomic UInt64		mHostTicksPerRingBufferDenominator;
+	
+	//	only touched by the IO thread
+	UInt64				mNumberTimeStamps;
+	UInt64				mNumberTimeStampsGeneration;
+	UInt64				mZeroTimeStampHostOffset;
+	UInt64				mZeroTimeStampHostOffsetRemainder;
+	
+	//	the loopback ring, only touched by the IO thread once IO is running
+	Byte*				mLoopbackRingBuffer;
+	UInt32				mLoopbackRingBufferByteSize;
+	
+	//	the play-through latency in frames, 0 when play-through is off, written with mStateMutex held
+	//	and read lock-free by the IO thread, and the play-through ring, only touched by the IO thread
+	//	once IO is running
+	_Atomic UInt32		mPlayThruLatency;
+	Float32*			mPlayThruRingBuffer;
+	UInt32				mPlayThruRingBufferByteSize;
+	
+	//	the linear gains that go with the volume and mute controls, written with mStateMutex held
+	//	and read lock-free by the IO thread
+	_Atomic Float32		mGain_Input_Master;
+	_Atomic Float32		mGain_Output_Master;
+	
+	//	the gains that were in effect at the end of the last buffer, only touched by the IO thread
+	Float32				mAppliedGain_Input_Master;
+	Float32				mAppliedGain_Output_Master;
+	
+	//	the clients of the device and the IO cycle that the mix was last started in, the latter is
+	//	only touched by the IO thread once IO is running
+	NullAudio_Client	mClients[kDevice_MaxNumberClients];
+	UInt64				mMixCycleCounter;
+	bool				mMixHasData;
+	
+	//	the timing statistics for the IO path
+	NullAudio_Telemetry	mTelemetry;
+} NullAudio_Device;
+
+static NullAudio_Device						gDevices[kPlugIn_MaxNumberDevices];
 
 //==================================================================================================
 #pragma mark -
@@ -173,6 +358,119 @@ static UInt32								gDataDestination_PlayThru_Master_Value	= 0;
 
 #pragma mark Prototypes
 
+//	Host clock helpers
+typedef struct NullAudio_ClockPeriod
+{
+	//	the period is exactly mWhole + (mRemainder / mDenominator) host ticks
+	UInt64	mWhole;
+	UInt64	mRemainder;
+	UInt64	mDenominator;
+} NullAudio_ClockPeriod;
+
+typedef struct NullAudio_ClockAnchor
+{
+	UInt64					mGeneration;
+	UInt64					mHostTime;
+	Float64					mSampleTime;
+	NullAudio_ClockPeriod	mHostTicksPerRingBuffer;
+} NullAudio_ClockAnchor;
+
+static UInt64					NullAudio_GetCurrentHostTime(void);
+static Float64					NullAudio_GetNanosecondsPerHostTick(void);
+static NullAudio_ClockPeriod	NullAudio_GetHostTicksPerRingBuffer(Float64 inSampleRate);
+static UInt64					NullAudio_GetHostTicksPerIOCycle(const NullAudio_ClockPeriod* inHostTicksPerRingBuffer, UInt32 inIOBufferFrameSize);
+static void						NullAudio_AdvanceHostOffset(const NullAudio_ClockPeriod* inPeriod, UInt64* ioHostOffset, UInt64* ioHostOffsetRemainder);
+static void						NullAudio_PublishClockAnchor(NullAudio_Device* inDevice, UInt64 inHostTime, Float64 inSampleTime, NullAudio_ClockPeriod inHostTicksPerRingBuffer);
+static void						NullAudio_CopyClockAnchor(NullAudio_Device* inDevice, NullAudio_ClockAnchor* outAnchor);
+
+//	Notification helpers
+typedef struct NullAudio_OverflowNotification
+{
+	AudioObjectID				mObjectID;
+	UInt32						mNumberAddresses;
+	AudioObjectPropertyAddress	mAddresses[];
+} NullAudio_OverflowNotification;
+
+static void		NullAudio_QueuePropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress* inAddresses);
+static void		NullAudio_FlushPropertiesChanged(void* inContext);
+static void		NullAudio_SendOverflowPropertiesChanged(void* inContext);
+static void		NullAudio_SendIdentifyPropertyChanged(void* inContext);
+
+//	Settings helpers
+static void				NullAudio_SettingsChanged(void);
+static void				NullAudio_WriteScheduledSettings(void* inContext);
+static CFDictionaryRef	NullAudio_CopyDeviceSettings(NullAudio_Device* inDevice);
+static void				NullAudio_WriteSettings(void);
+static bool				NullAudio_GetSettingsNumber(CFDictionaryRef inSettings, CFStringRef inKey, CFNumberType inNumberType, void* outValue);
+static void				NullAudio_RestoreDeviceSettings(NullAudio_Device* inDevice);
+
+//	Device helpers
+static AudioObjectID		NullAudio_GetObjectKind(AudioObjectID inObjectID);
+static AudioObjectID		NullAudio_GetDeviceObjectID(const NullAudio_Device* inDevice, AudioObjectID inObjectKind);
+static NullAudio_Device*	NullAudio_FindDevice(AudioObjectID inObjectID);
+static UInt32				NullAudio_CopyDeviceList(AudioObjectID* outDeviceList, UInt32 inMaxNumberDevices);
+static NullAudio_Device*	NullAudio_AllocateDevice(UInt32 inSlot);
+static void					NullAudio_FreeDevice(NullAudio_Device* inDevice);
+static void					NullAudio_DeviceListChanged(void);
+
+//	Configuration change helpers
+typedef struct NullAudio_ConfigurationChangeRequest
+{
+	AudioObjectID	mDeviceObjectID;
+	UInt64			mChangeAction;
+	void*			mChangeInfo;
+} NullAudio_ConfigurationChangeRequest;
+
+static OSStatus	NullAudio_ScheduleConfigurationChangeRequest(AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo);
+static void		NullAudio_SendConfigurationChangeRequest(void* inContext);
+
+//	Format helpers
+typedef struct NullAudio_FormatChange
+{
+	Float64	mSampleRate;
+	UInt32	mSampleFormat;
+	UInt32	mChannelsPerFrame;
+} NullAudio_FormatChange;
+
+static UInt32		NullAudio_GetBytesPerSample(UInt32 inSampleFormat);
+static void			NullAudio_FillOutFormat(AudioStreamBasicDescription* outFormat, Float64 inSampleRate, UInt32 inSampleFormat, UInt32 inChannelsPerFrame);
+static UInt32		NullAudio_GetSampleFormat(const AudioStreamBasicDescription* inFormat);
+static bool			NullAudio_IsSupportedSampleRate(Float64 inSampleRate);
+static OSStatus		NullAudio_ReserveLoopbackRingBuffer(NullAudio_Device* inDevice, UInt32 inBytesPerFrame);
+
+//	Loopback helpers
+static UInt32		NullAudio_GetLoopbackRingOffset(Float64 inSampleTime);
+static void			NullAudio_WriteToLoopbackRingBuffer(NullAudio_Device* inDevice, Float64 inSampleTime, UInt32 inFrameCount, const void* inBuffer);
+static void			NullAudio_ReadFromLoopbackRingBuffer(NullAudio_Device* inDevice, Float64 inSampleTime, UInt32 inFrameCount, void* outBuffer);
+
+//	Play-through helpers
+static OSStatus		NullAudio_ReservePlayThruRingBuffer(NullAudio_Device* inDevice, UInt32 inChannelsPerFrame);
+static void			NullAudio_WriteToPlayThruRingBuffer(NullAudio_Device* inDevice, Float64 inSampleTime, UInt32 inFrameCount, const Float32* inBuffer);
+static void			NullAudio_MixFromPlayThruRingBuffer(NullAudio_Device* inDevice, Float64 inInputSampleTime, Float64 inOutputSampleTime, UInt32 inFrameCount, Float32* ioMix);
+
+//	Gain helpers
+static Float32		NullAudio_GetLinearGain(Float32 inVolumeScalar, bool inIsMuted);
+static void			NullAudio_UpdateGains(NullAudio_Device* inDevice);
+static void			NullAudio_ApplyGain(Float32* ioSamples, UInt32 inFrameCount, UInt32 inChannelsPerFrame, Float32 inStartGain, Float32 inEndGain);
+static void			NullAudio_ApplyGainRamp(Float32* ioSamples, UInt32 inFrameCount, UInt32 inChannelsPerFrame, Float32 inStartGain, Float32 inStep);
+
+//	Mixing helpers
+static NullAudio_Client*	NullAudio_FindClient(NullAudio_Device* inDevice, UInt32 inClientID);
+static void					NullAudio_AccumulateSamples(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples);
+
+//	Telemetry helpers
+static UInt32			NullAudio_GetTelemetryOperation(UInt32 inOperationID);
+static void				NullAudio_RecordHistogramValue(NullAudio_Histogram* inHistogram, UInt64 inValue);
+static void				NullAudio_ResetHistogram(NullAudio_Histogram* inHistogram);
+static void				NullAudio_ResetTelemetry(NullAudio_Telemetry* inTelemetry);
+static void				NullAudio_SetDictionaryNumber(CFMutableDictionaryRef inDictionary, CFStringRef inKey, CFNumberType inNumberType, const void* inValue);
+static CFDictionaryRef	NullAudio_CopyHistogramDictionary(const NullAudio_Histogram* inHistogram, Float64 inNanosecondsPerHostTick);
+static CFDictionaryRef	NullAudio_CopyTelemetryDictionary(CFStringRef inDeviceUID);
+
+//	Sample conversion helpers
+static void			NullAudio_ConvertToFloat(const void* inSource, UInt32 inSampleFormat, Float32* outDestination, UInt32 inNumberSamples);
+static void			NullAudio_ConvertFromFloat(const Float32* inSource, UInt32 inSampleFormat, void* outDestination, UInt32 inNumberSamples);
+
 //	Entry points for the COM methods
 void*				NullAudio_Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID);
 static HRESULT		NullAudio_QueryInterface(void* inDriver, REFIID inUUID, LPVOID* outInterface);
@@ -229,6 +527,126 @@ static OSStatus		NullAudio_GetControlPropertyDataSize(AudioServerPlugInDriverRef
 static OSStatus		NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
 static OSStatus		NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
 
+#pragma mark Property Dispatch
+
+//	Every property call from the HAL first has to figure out what kind of object it is addressed to.
+//	Rather than repeating a switch on the object ID in each of the property entry points, the
+//	per-class implementations are gathered into a table of handlers, and the kind of the object
+//	indexes directly into a table of those. Because the kinds are small and dense, finding the
+//	handlers is a little arithmetic and an array load.
+
+typedef struct NullAudio_PropertyHandlers
+{
+	Boolean		(*mHasProperty)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
+	OSStatus	(*mIsPropertySettable)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
+	OSStatus	(*mGetPropertyDataSize)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
+	OSStatus	(*mGetPropertyData)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
+	OSStatus	(*mSetPropertyData)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
+} NullAudio_PropertyHandlers;
+
+static const NullAudio_PropertyHandlers	kPropertyHandlers_PlugIn	= { NullAudio_HasPlugInProperty, NullAudio_IsPlugInPropertySettable, NullAudio_GetPlugInPropertyDataSize, NullAudio_GetPlugInPropertyData, NullAudio_SetPlugInPropertyData };
+static const NullAudio_PropertyHandlers	kPropertyHandlers_Box		= { NullAudio_HasBoxProperty, NullAudio_IsBoxPropertySettable, NullAudio_GetBoxPropertyDataSize, NullAudio_GetBoxPropertyData, NullAudio_SetBoxPropertyData };
+static const NullAudio_PropertyHandlers	kPropertyHandlers_Device	= { NullAudio_HasDeviceProperty, NullAudio_IsDevicePropertySettable, NullAudio_GetDevicePropertyDataSize, NullAudio_GetDevicePropertyData, NullAudio_SetDevicePropertyData };
+static const NullAudio_PropertyHandlers	kPropertyHandlers_Stream	= { NullAudio_HasStreamProperty, NullAudio_IsStreamPropertySettable, NullAudio_GetStreamPropertyDataSize, NullAudio_GetStreamPropertyData, NullAudio_SetStreamPropertyData };
+static const NullAudio_PropertyHandlers	kPropertyHandlers_Control	= { NullAudio_HasControlProperty, NullAudio_IsControlPropertySettable, NullAudio_GetControlPropertyDataSize, NullAudio_GetControlPropertyData, NullAudio_SetControlPropertyData };
+
+static const NullAudio_PropertyHandlers* const	kPropertyHandlersByObjectID[] =
+{
+	[kObjectID_PlugIn]							= &kPropertyHandlers_PlugIn,
+	[kObjectID_Box]								= &kPropertyHandlers_Box,
+	[kObjectID_Device]							= &kPropertyHandlers_Device,
+	[kObjectID_Stream_Input]					= &kPropertyHandlers_Stream,
+	[kObjectID_Volume_Input_Master]				= &kPropertyHandlers_Control,
+	[kObjectID_Mute_Input_Master]				= &kPropertyHandlers_Control,
+	[kObjectID_DataSource_Input_Master]			= &kPropertyHandlers_Control,
+	[kObjectID_Stream_Output]					= &kPropertyHandlers_Stream,
+	[kObjectID_Volume_Output_Master]			= &kPropertyHandlers_Control,
+	[kObjectID_Mute_Output_Master]				= &kPropertyHandlers_Control,
+	[kObjectID_DataSource_Output_Master]		= &kPropertyHandlers_Control,
+	[kObjectID_DataDestination_PlayThru_Master]	= &kPropertyHandlers_Control
+};
+
+static inline const NullAudio_PropertyHandlers*	NullAudio_GetPropertyHandlers(AudioObjectID inObjectID)
+{
+	//	Objects that belong to a device are looked up by their kind, which is the ID of the object in
+	//	the same position in the first device's block, but only if the device they belong to exists.
+	//	Note that kAudioObjectUnknown (0) has no entry in the table, so it maps to NULL too.
+	const NullAudio_PropertyHandlers* theAnswer = NULL;
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
+	if((theObjectKind < kObjectID_Device) || (NullAudio_FindDevice(inObjectID) != NULL))
+	{
+		theAnswer = kPropertyHandlersByObjectID[theObjectKind];
+	}
+	return theAnswer;
+}
+
+#pragma mark Property Tables
+
+//	Within a class, which properties an object has, whether each one can be set, and how big its
+//	data is all come from one table with an entry per property. The class's Has, IsSettable, and
+//	GetPropertyDataSize routines look the address up in that table, so the three can't disagree
+//	about what an object implements. An entry only matches addresses in the scopes it allows and
+//	with elements no higher than its mMaxElement. Most entries give the size of the data outright.
+//	The few whose size depends on the address or on the state of the driver name a routine that
+//	works it out instead. Getting and setting the data is still done property by property in each
+//	class's routines, since that's where the variable length lists and the qualifiers need code.
+
+enum
+{
+	kPropertyScope_Any				= kAudioObjectPropertyScopeWildcard,
+	kPropertyScope_InputOrOutput	= 'inou',
+	kPropertyElement_Any			= kAudioObjectPropertyElementWildcard
+};
+
+typedef OSStatus	(*NullAudio_PropertyDataSizeGetter)(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
+
+typedef struct NullAudio_PropertyInfo
+{
+	AudioObjectPropertySelector			mSelector;
+	AudioObjectPropertyScope			mScope;
+	AudioObjectPropertyElement			mMaxElement;
+	UInt32								mDataSize;
+	Boolean								mIsSettable;
+	NullAudio_PropertyDataSizeGetter	mGetDataSize;
+} NullAudio_PropertyInfo;
+
+#define	NullAudio_NumberProperties(inTable)	((UInt32)(sizeof(inTable) / sizeof((inTable)[0])))
+
+static inline const NullAudio_PropertyInfo*	NullAudio_FindPropertyInfo(const NullAudio_PropertyInfo* inTable, UInt32 inNumberProperties, const AudioObjectPropertyAddress* inAddress)
+{
+	//	The tables are a few dozen entries at most, so they are searched in order. A property is
+	//	only listed once per table, so the search stops at the first entry with the selector.
+	const NullAudio_PropertyInfo* theAnswer = NULL;
+	for(UInt32 theIndex = 0; theIndex < inNumberProperties; ++theIndex)
+	{
+		if(inTable[theIndex].mSelector == inAddress->mSelector)
+		{
+			const NullAudio_PropertyInfo* theInfo = &inTable[theIndex];
+			Boolean theScopeMatches = (theInfo->mScope == kPropertyScope_Any) || (theInfo->mScope == inAddress->mScope) || ((theInfo->mScope == kPropertyScope_InputOrOutput) && ((inAddress->mScope == kAudioObjectPropertyScopeInput) || (inAddress->mScope == kAudioObjectPropertyScopeOutput)));
+			if(theScopeMatches && (inAddress->mElement <= theInfo->mMaxElement))
+			{
+				theAnswer = theInfo;
+			}
+			break;
+		}
+	}
+	return theAnswer;
+}
+
+static inline OSStatus	NullAudio_GetPropertyInfoDataSize(const NullAudio_PropertyInfo* inInfo, AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	OSStatus theAnswer = 0;
+	if(inInfo->mGetDataSize != NULL)
+	{
+		theAnswer = inInfo->mGetDataSize(inObjectID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		*outDataSize = inInfo->mDataSize;
+	}
+	return theAnswer;
+}
+
 #pragma mark The Interface
 
 static AudioServerPlugInDriverInterface	gAudioServerPlugInDriverInterface =
@@ -260,240 +678,1820 @@ static AudioServerPlugInDriverInterface	gAudioServerPlugInDriverInterface =
 static AudioServerPlugInDriverInterface*	gAudioServerPlugInDriverInterfacePtr	= &gAudioServerPlugInDriverInterface;
 static AudioServerPlugInDriverRef			gAudioServerPlugInDriverRef				= &gAudioServerPlugInDriverInterfacePtr;
 
-#pragma mark Factory
+#pragma mark Host Clock
 
-void*	NullAudio_Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID)
+//	All of the driver's notion of time flows through these functions. Keeping the calls to
+//	mach_absolute_time() and mach_timebase_info() in one place means that the IO path can be driven
+//	by a different clock (for example, a simulated one when exercising the driver outside of
+//	coreaudiod) by changing only this section.
+//
+//	The length of the zero time stamp period in host ticks is generally not a whole number, so it is
+//	kept as an exact fraction rather than a Float64. The host time of each zero time stamp is then
+//	the anchor plus a whole number of ticks, with the fractional part carried forward in an integer
+//	remainder. This keeps the time stamps exact no matter how long IO has been running, where adding
+//	up a Float64 period would lose precision as the count of time stamps grows.
+
+static UInt64	NullAudio_GetCurrentHostTime(void)
 {
-	//	This is the CFPlugIn factory function. Its job is to create the implementation for the given
-	//	type provided that the type is supported. Because this driver is simple and all its
-	//	initialization is handled via static iniitalization when the bundle is loaded, all that
-	//	needs to be done is to return the AudioServerPlugInDriverRef that points to the driver's
-	//	interface. A more complicated driver would create any base line objects it needs to satisfy
-	//	the IUnknown methods that are used to discover that actual interface to talk to the driver.
-	//	The majority of the driver's initilization should be handled in the Initialize() method of
-	//	the driver's AudioServerPlugInDriverInterface.
-	
-	#pragma unused(inAllocator)
-    void* theAnswer = NULL;
-    if(CFEqual(inRequestedTypeUUID, kAudioServerPlugInTypeUUID))
-    {
-		theAnswer = gAudioServerPlugInDriverRef;
-    }
-    return theAnswer;
+	return mach_absolute_time();
 }
 
-#pragma mark Inheritence
-
-static HRESULT	NullAudio_QueryInterface(void* inDriver, REFIID inUUID, LPVOID* outInterface)
+static Float64	NullAudio_GetNanosecondsPerHostTick(void)
 {
-	//	This function is called by the HAL to get the interface to talk to the plug-in through.
-	//	AudioServerPlugIns are required to support the IUnknown interface and the
-	//	AudioServerPlugInDriverInterface. As it happens, all interfaces must also provide the
-	//	IUnknown interface, so we can always just return the single interface we made with
-	//	gAudioServerPlugInDriverInterfacePtr regardless of which one is asked for.
+	struct mach_timebase_info theTimeBaseInfo;
+	mach_timebase_info(&theTimeBaseInfo);
+	return ((Float64)theTimeBaseInfo.numer) / ((Float64)theTimeBaseInfo.denom);
+}
 
-	//	declare the local variables
-	HRESULT theAnswer = 0;
-	CFUUIDRef theRequestedUUID = NULL;
+static NullAudio_ClockPeriod	NullAudio_GetHostTicksPerRingBuffer(Float64 inSampleRate)
+{
+	//	The host clock runs at 10^9 * denom / numer ticks per second, so one ring buffer's worth of
+	//	frames takes (kDevice_RingBufferSize * 10^9 * denom) / (numer * sample rate) ticks. All the
+	//	supported sample rates are whole numbers, so both sides of the fraction are integers. They are
+	//	reduced by their greatest common divisor to keep the remainder arithmetic small.
+	struct mach_timebase_info theTimeBaseInfo;
+	mach_timebase_info(&theTimeBaseInfo);
+	UInt64 theNumerator = ((UInt64)kDevice_RingBufferSize) * 1000000000ULL * theTimeBaseInfo.denom;
+	UInt64 theDenominator = ((UInt64)theTimeBaseInfo.numer) * ((UInt64)inSampleRate);
 	
-	//	validate the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_QueryInterface: bad driver reference");
-	FailWithAction(outInterface == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_QueryInterface: no place to store the returned interface");
-
-	//	make a CFUUIDRef from inUUID
-	theRequestedUUID = CFUUIDCreateFromUUIDBytes(NULL, inUUID);
-	FailWithAction(theRequestedUUID == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_QueryInterface: failed to create the CFUUIDRef");
-
-	//	AudioServerPlugIns only support two interfaces, IUnknown (which has to be supported by all
-	//	CFPlugIns and AudioServerPlugInDriverInterface (which is the actual interface the HAL will
-	//	use).
-	if(CFEqual(theRequestedUUID, IUnknownUUID) || CFEqual(theRequestedUUID, kAudioServerPlugInDriverInterfaceUUID))
-	{
-		pthread_mutex_lock(&gPlugIn_StateMutex);
-		++gPlugIn_RefCount;
-		pthread_mutex_unlock(&gPlugIn_StateMutex);
-		*outInterface = gAudioServerPlugInDriverRef;
-	}
-	else
+	UInt64 theA = theNumerator;
+	UInt64 theB = theDenominator;
+	while(theB != 0)
 	{
-		theAnswer = E_NOINTERFACE;
+		UInt64 theRemainder = theA % theB;
+		theA = theB;
+		theB = theRemainder;
 	}
+	theNumerator /= theA;
+	theDenominator /= theA;
 	
-	//	make sure to release the UUID we created
-	CFRelease(theRequestedUUID);
-		
-Done:
+	NullAudio_ClockPeriod theAnswer = { theNumerator / theDenominator, theNumerator % theDenominator, theDenominator };
 	return theAnswer;
 }
 
-static ULONG	NullAudio_AddRef(void* inDriver)
+static UInt64	NullAudio_GetHostTicksPerIOCycle(const NullAudio_ClockPeriod* inHostTicksPerRingBuffer, UInt32 inIOBufferFrameSize)
 {
-	//	This call returns the resulting reference count after the increment.
-	
-	//	declare the local variables
-	ULONG theAnswer = 0;
-	
-	//	check the arguments
-	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_AddRef: bad driver reference");
+	//	This is only used for the telemetry, so it doesn't need to be exact.
+	Float64 theHostTicksPerRingBuffer = (Float64)inHostTicksPerRingBuffer->mWhole + ((Float64)inHostTicksPerRingBuffer->mRemainder / (Float64)inHostTicksPerRingBuffer->mDenominator);
+	return (UInt64)((theHostTicksPerRingBuffer * inIOBufferFrameSize) / kDevice_RingBufferSize);
+}
 
-	//	decrement the refcount
-	pthread_mutex_lock(&gPlugIn_StateMutex);
-	if(gPlugIn_RefCount < UINT32_MAX)
+static void	NullAudio_AdvanceHostOffset(const NullAudio_ClockPeriod* inPeriod, UInt64* ioHostOffset, UInt64* ioHostOffsetRemainder)
+{
+	//	This moves a host tick offset forward by one period. The offset is always the whole part of
+	//	the exact value and the remainder, which is always less than the denominator, is the rest.
+	*ioHostOffset += inPeriod->mWhole;
+	*ioHostOffsetRemainder += inPeriod->mRemainder;
+	if(*ioHostOffsetRemainder >= inPeriod->mDenominator)
 	{
-		++gPlugIn_RefCount;
+		*ioHostOffsetRemainder -= inPeriod->mDenominator;
+		*ioHostOffset += 1;
 	}
-	theAnswer = gPlugIn_RefCount;
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
-
-Done:
-	return theAnswer;
 }
 
-static ULONG	NullAudio_Release(void* inDriver)
+static void	NullAudio_PublishClockAnchor(NullAudio_Device* inDevice, UInt64 inHostTime, Float64 inSampleTime, NullAudio_ClockPeriod inHostTicksPerRingBuffer)
 {
-	//	This call returns the resulting reference count after the decrement.
-
-	//	declare the local variables
-	ULONG theAnswer = 0;
-	
-	//	check the arguments
-	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_Release: bad driver reference");
+	//	This is the writer side of the sequence lock that protects the clock anchor. The sequence
+	//	number is odd while the fields are being updated. Writers must be serialized by the caller,
+	//	which for this driver means holding the device's mStateMutex. Each publication also bumps the
+	//	generation so that the IO thread knows to restart its count of zero time stamps.
+	UInt32 theSequence = atomic_load_explicit(&inDevice->mClockAnchorSequence, memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mClockAnchorSequence, theSequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	
+	atomic_fetch_add_explicit(&inDevice->mClockAnchorGeneration, 1, memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mAnchorHostTime, inHostTime, memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mAnchorSampleTime, inSampleTime, memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mHostTicksPerRingBufferWhole, inHostTicksPerRingBuffer.mWhole, memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mHostTicksPerRingBufferRemainder, inHostTicksPerRingBuffer.mRemainder, memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mHostTicksPerRingBufferDenominator, inHostTicksPerRingBuffer.mDenominator, memory_order_relaxed);
+	
+	atomic_store_explicit(&inDevice->mClockAnchorSequence, theSequence + 2, memory_order_release);
+}
 
-	//	increment the refcount
-	pthread_mutex_lock(&gPlugIn_StateMutex);
-	if(gPlugIn_RefCount > 0)
+static void	NullAudio_CopyClockAnchor(NullAudio_Device* inDevice, NullAudio_ClockAnchor* outAnchor)
+{
+	//	This is the reader side of the sequence lock. It never blocks. It just retries in the rare
+	//	case that it raced with a writer, which can only happen when IO is being started or the
+	//	sample rate is changing.
+	UInt32 theSequenceBefore;
+	UInt32 theSequenceAfter;
+	do
 	{
-		--gPlugIn_RefCount;
-		//	Note that we don't do anything special if the refcount goes to zero as the HAL
-		//	will never fully release a plug-in it opens. We keep managing the refcount so that
-		//	the API semantics are correct though.
+		theSequenceBefore = atomic_load_explicit(&inDevice->mClockAnchorSequence, memory_order_acquire);
+		outAnchor->mGeneration = atomic_load_explicit(&inDevice->mClockAnchorGeneration, memory_order_relaxed);
+		outAnchor->mHostTime = atomic_load_explicit(&inDevice->mAnchorHostTime, memory_order_relaxed);
+		outAnchor->mSampleTime = atomic_load_explicit(&inDevice->mAnchorSampleTime, memory_order_relaxed);
+		outAnchor->mHostTicksPerRingBuffer.mWhole = atomic_load_explicit(&inDevice->mHostTicksPerRingBufferWhole, memory_order_relaxed);
+		outAnchor->mHostTicksPerRingBuffer.mRemainder = atomic_load_explicit(&inDevice->mHostTicksPerRingBufferRemainder, memory_order_relaxed);
+		outAnchor->mHostTicksPerRingBuffer.mDenominator = atomic_load_explicit(&inDevice->mHostTicksPerRingBufferDenominator, memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		theSequenceAfter = atomic_load_explicit(&inDevice->mClockAnchorSequence, memory_order_relaxed);
 	}
-	theAnswer = gPlugIn_RefCount;
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
-
-Done:
-	return theAnswer;
+	while(((theSequenceBefore & 1) != 0) || (theSequenceBefore != theSequenceAfter));
 }
 
-#pragma mark Basic Operations
+#pragma mark Notifications
 
-static OSStatus	NullAudio_Initialize(AudioServerPlugInDriverRef inDriver, AudioServerPlugInHostRef inHost)
-{
-	//	The job of this method is, as the name implies, to get the driver initialized. One specific
-	//	thing that needs to be done is to store the AudioServerPlugInHostRef so that it can be used
-	//	later. Note that when this call returns, the HAL will scan the various lists the driver
-	//	maintains (such as the device list) to get the inital set of objects the driver is
-	//	publishing. So, there is no need to notifiy the HAL about any objects created as part of the
-	//	execution of this method.
+//	Property change notifications don't go straight to the host. Instead, they are added to a table
+//	of pending notifications and sent later from gNotification_Queue. An address that is already
+//	pending for the same object isn't added again, so something like a volume ramp that sets the
+//	same control hundreds of times a second only produces one notification per flush. Flushes are
+//	at least kNotification_MinimumInterval apart. This also means that the host is never called with
+//	any of the driver's locks held, so it is safe to queue notifications from anywhere.
 
-	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_Initialize: bad driver reference");
-	
-	//	store the AudioServerPlugInHostRef
-	gPlugIn_Host = inHost;
+static void	NullAudio_QueuePropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress* inAddresses)
+{
+	NullAudio_OverflowNotification* theOverflow = NULL;
+	UInt64 theDelay = 0;
 	
-	//	initialize the box acquired property from the settings
-	CFPropertyListRef theSettingsData = NULL;
-	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR("box acquired"), &theSettingsData);
-	if(theSettingsData != NULL)
+	pthread_mutex_lock(&gNotification_Mutex);
+	for(UInt32 theAddressIndex = 0; theAddressIndex < inNumberAddresses; ++theAddressIndex)
 	{
-		if(CFGetTypeID(theSettingsData) == CFBooleanGetTypeID())
+		//	see if the address is already pending
+		bool isPending = false;
+		for(UInt32 thePendingIndex = 0; !isPending && (thePendingIndex < gNotification_NumberPending); ++thePendingIndex)
 		{
-			gBox_Acquired = CFBooleanGetValue((CFBooleanRef)theSettingsData);
+			const NullAudio_Notification* thePending = &gNotification_Pending[thePendingIndex];
+			isPending = (thePending->mObjectID == inObjectID) && (thePending->mAddress.mSelector == inAddresses[theAddressIndex].mSelector) && (thePending->mAddress.mScope == inAddresses[theAddressIndex].mScope) && (thePending->mAddress.mElement == inAddresses[theAddressIndex].mElement);
 		}
-		else if(CFGetTypeID(theSettingsData) == CFNumberGetTypeID())
+		
+		if(isPending)
 		{
-			SInt32 theValue = 0;
-			CFNumberGetValue((CFNumberRef)theSettingsData, kCFNumberSInt32Type, &theValue);
-			gBox_Acquired = theValue ? 1 : 0;
+			atomic_fetch_add_explicit(&gNotification_NumberSuppressed, 1, memory_order_relaxed);
 		}
-		CFRelease(theSettingsData);
-	}
-	
-	//	initialize the box name from the settings
-	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR("box acquired"), &theSettingsData);
-	if(theSettingsData != NULL)
-	{
-		if(CFGetTypeID(theSettingsData) == CFStringGetTypeID())
+		else if(gNotification_NumberPending < kNotification_MaxNumberPending)
 		{
-			gBox_Name = (CFStringRef)theSettingsData;
-			CFRetain(gBox_Name);
+			gNotification_Pending[gNotification_NumberPending].mObjectID = inObjectID;
+			gNotification_Pending[gNotification_NumberPending].mAddress = inAddresses[theAddressIndex];
+			++gNotification_NumberPending;
+		}
+		else
+		{
+			//	keep just the addresses that didn't fit so they can be sent on their own below
+			if(theOverflow == NULL)
+			{
+				theOverflow = (NullAudio_OverflowNotification*)malloc(sizeof(NullAudio_OverflowNotification) + (inNumberAddresses * sizeof(AudioObjectPropertyAddress)));
+				if(theOverflow != NULL)
+				{
+					theOverflow->mObjectID = inObjectID;
+					theOverflow->mNumberAddresses = 0;
+				}
+			}
+			if(theOverflow != NULL)
+			{
+				theOverflow->mAddresses[theOverflow->mNumberAddresses] = inAddresses[theAddressIndex];
+				++theOverflow->mNumberAddresses;
+			}
+			else
+			{
+				atomic_fetch_add_explicit(&gNotification_NumberDropped, 1, memory_order_relaxed);
+			}
 		}
-		CFRelease(theSettingsData);
 	}
 	
-	//	set the box name directly as a last resort
-	if(gBox_Name == NULL)
+	//	schedule a flush if there isn't one already, but not before the minimum interval has passed
+	//	since the last one
+	if(!gNotification_FlushIsScheduled)
 	{
-		gBox_Name = CFSTR("Null Box");
+		UInt64 theCurrentTime = NullAudio_GetCurrentHostTime();
+		UInt64 theNextFlushTime = gNotification_LastFlushTime + (UInt64)(kNotification_MinimumInterval / NullAudio_GetNanosecondsPerHostTick());
+		theDelay = (theNextFlushTime > theCurrentTime) ? (UInt64)((theNextFlushTime - theCurrentTime) * NullAudio_GetNanosecondsPerHostTick()) : 0;
+		gNotification_FlushIsScheduled = true;
+		dispatch_after_f(dispatch_time(DISPATCH_TIME_NOW, (int64_t)theDelay), gNotification_Queue, NULL, NullAudio_FlushPropertiesChanged);
 	}
+	pthread_mutex_unlock(&gNotification_Mutex);
 	
-	//	calculate the host ticks per frame
-	struct mach_timebase_info theTimeBaseInfo;
-	mach_timebase_info(&theTimeBaseInfo);
-	Float64 theHostClockFrequency = (Float64)theTimeBaseInfo.denom / (Float64)theTimeBaseInfo.numer;
-	theHostClockFrequency *= 1000000000.0;
-	gDevice_HostTicksPerFrame = theHostClockFrequency / gDevice_SampleRate;
-	
-Done:
-	return theAnswer;
+	//	The table only fills up if something is wrong, but a notification must never be lost, so
+	//	anything that didn't fit is sent on its own. The addresses that were queued or suppressed
+	//	above aren't sent again here. If even that couldn't be allocated, the addresses were counted
+	//	in gNotification_NumberDropped above so that the loss shows up in the telemetry.
+	if(theOverflow != NULL)
+	{
+		DebugMsg("NullAudio_QueuePropertiesChanged: the notification table is full");
+		dispatch_async_f(gNotification_Queue, theOverflow, NullAudio_SendOverflowPropertiesChanged);
+	}
 }
 
-static OSStatus	NullAudio_CreateDevice(AudioServerPlugInDriverRef inDriver, CFDictionaryRef inDescription, const AudioServerPlugInClientInfo* inClientInfo, AudioObjectID* outDeviceObjectID)
+static void	NullAudio_FlushPropertiesChanged(void* inContext)
 {
-	//	This method is used to tell a driver that implements the Transport Manager semantics to
-	//	create an AudioEndpointDevice from a set of AudioEndpoints. Since this driver is not a
-	//	Transport Manager, we just check the arguments and return
-	//	kAudioHardwareUnsupportedOperationError.
+	//	This runs on gNotification_Queue. It takes everything that is pending and sends it to the host
+	//	with one call per object.
 	
-	#pragma unused(inDescription, inClientInfo, outDeviceObjectID)
+	#pragma unused(inContext)
 	
-	//	declare the local variables
-	OSStatus theAnswer = kAudioHardwareUnsupportedOperationError;
+	NullAudio_Notification thePending[kNotification_MaxNumberPending];
+	AudioObjectPropertyAddress theAddresses[kNotification_MaxNumberPending];
+	UInt32 theNumberPending = 0;
 	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_CreateDevice: bad driver reference");
+	pthread_mutex_lock(&gNotification_Mutex);
+	theNumberPending = gNotification_NumberPending;
+	memcpy(thePending, gNotification_Pending, theNumberPending * sizeof(NullAudio_Notification));
+	gNotification_NumberPending = 0;
+	gNotification_FlushIsScheduled = false;
+	gNotification_LastFlushTime = NullAudio_GetCurrentHostTime();
+	pthread_mutex_unlock(&gNotification_Mutex);
+	
+	for(UInt32 theFirstIndex = 0; theFirstIndex < theNumberPending; ++theFirstIndex)
+	{
+		//	gather up the addresses for this object, skipping the ones that were already sent
+		AudioObjectID theObjectID = thePending[theFirstIndex].mObjectID;
+		UInt32 theNumberAddresses = 0;
+		if(theObjectID != kAudioObjectUnknown)
+		{
+			for(UInt32 theIndex = theFirstIndex; theIndex < theNumberPending; ++theIndex)
+			{
+				if(thePending[theIndex].mObjectID == theObjectID)
+				{
+					theAddresses[theNumberAddresses] = thePending[theIndex].mAddress;
+					++theNumberAddresses;
+					thePending[theIndex].mObjectID = kAudioObjectUnknown;
+				}
+			}
+			gPlugIn_Host->PropertiesChanged(gPlugIn_Host, theObjectID, theNumberAddresses, theAddresses);
+			atomic_fetch_add_explicit(&gNotification_NumberEmitted, theNumberAddresses, memory_order_relaxed);
+		}
+	}
+}
 
-Done:
-	return theAnswer;
+static void	NullAudio_SendOverflowPropertiesChanged(void* inContext)
+{
+	//	This runs on gNotification_Queue and sends the addresses that didn't fit in the table. The
+	//	context is the heap block NullAudio_QueuePropertiesChanged() filled out.
+	NullAudio_OverflowNotification* theOverflow = (NullAudio_OverflowNotification*)inContext;
+	gPlugIn_Host->PropertiesChanged(gPlugIn_Host, theOverflow->mObjectID, theOverflow->mNumberAddresses, theOverflow->mAddresses);
+	atomic_fetch_add_explicit(&gNotification_NumberEmitted, theOverflow->mNumberAddresses, memory_order_relaxed);
+	free(theOverflow);
 }
 
-static OSStatus	NullAudio_DestroyDevice(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID)
+static void	NullAudio_SendIdentifyPropertyChanged(void* inContext)
 {
-	//	This method is used to tell a driver that implements the Transport Manager semantics to
-	//	destroy an AudioEndpointDevice. Since this driver is not a Transport Manager, we just check
-	//	the arguments and return kAudioHardwareUnsupportedOperationError.
+	//	This runs on gNotification_Queue a while after the identify property is set on the box.
 	
-	#pragma unused(inDeviceObjectID)
-	
-	//	declare the local variables
-	OSStatus theAnswer = kAudioHardwareUnsupportedOperationError;
+	#pragma unused(inContext)
 	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DestroyDevice: bad driver reference");
-
-Done:
-	return theAnswer;
+	AudioObjectPropertyAddress theAddress = { kAudioObjectPropertyIdentify, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	NullAudio_QueuePropertiesChanged(kObjectID_Box, 1, &theAddress);
 }
 
-static OSStatus	NullAudio_AddDeviceClient(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
+#pragma mark Settings
+
+//	All of the settings that are saved between runs of the driver are kept in a single dictionary
+//	under kSettings_Key, so that restoring them at initialization only takes one trip to storage.
+//	The dictionary holds the box's settings, the slots of the devices that exist and a dictionary of
+//	settings for each device keyed by the device's UID.
+//
+//	Saving is done behind the setters' backs. A setter just calls NullAudio_SettingsChanged(), which
+//	schedules a write on gSettings_Queue kSettings_WriteDelay in the future if one isn't already
+//	scheduled. The write takes a snapshot of the current state and hands it to the host, so however
+//	many changes happen in that time only cost a single write and no setter ever waits on storage.
+
+static void	NullAudio_SettingsChanged(void)
 {
-	//	This method is used to inform the driver about a new client that is using the given device.
-	//	This allows the device to act differently depending on who the client is. This driver does
-	//	not need to track the clients using the device, so we just check the arguments and return
-	//	successfully.
+	pthread_mutex_lock(&gSettings_Mutex);
+	if(!gSettings_WriteIsScheduled && (gSettings_Queue != NULL))
+	{
+		gSettings_WriteIsScheduled = true;
+		dispatch_after_f(dispatch_time(DISPATCH_TIME_NOW, kSettings_WriteDelay), gSettings_Queue, NULL, NullAudio_WriteScheduledSettings);
+	}
+	pthread_mutex_unlock(&gSettings_Mutex);
+}
+
+static void	NullAudio_WriteScheduledSettings(void* inContext)
+{
+	//	This runs on gSettings_Queue. Changes made from here on need another write, so the flag is
+	//	cleared before the snapshot is taken.
+	
+	#pragma unused(inContext)
+	
+	pthread_mutex_lock(&gSettings_Mutex);
+	gSettings_WriteIsScheduled = false;
+	pthread_mutex_unlock(&gSettings_Mutex);
+	NullAudio_WriteSettings();
+}
+
+static CFDictionaryRef	NullAudio_CopyDeviceSettings(NullAudio_Device* inDevice)
+{
+	//	The caller must hold gPlugIn_StateMutex.
+	CFMutableDictionaryRef theAnswer = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	if(theAnswer != NULL)
+	{
+		pthread_mutex_lock(&inDevice->mStateMutex);
+		Float64 theSampleRate = inDevice->mSampleRate;
+		Float32 theInputVolume = inDevice->mVolume_Input_Master_Value;
+		Float32 theOutputVolume = inDevice->mVolume_Output_Master_Value;
+		bool theInputMute = inDevice->mMute_Input_Master_Value;
+		bool theOutputMute = inDevice->mMute_Output_Master_Value;
+		SInt32 theInputDataSource = (SInt32)inDevice->mDataSource_Input_Master_Value;
+		SInt32 theOutputDataSource = (SInt32)inDevice->mDataSource_Output_Master_Value;
+		SInt32 thePlayThruDestination = (SInt32)inDevice->mDataDestination_PlayThru_Master_Value;
+		SInt32 thePlayThruLatency = (SInt32)atomic_load_explicit(&inDevice->mPlayThruLatency, memory_order_relaxed);
+		pthread_mutex_unlock(&inDevice->mStateMutex);
+		
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("sample rate"), kCFNumberFloat64Type, &theSampleRate);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("input volume"), kCFNumberFloat32Type, &theInputVolume);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("output volume"), kCFNumberFloat32Type, &theOutputVolume);
+		CFDictionarySetValue(theAnswer, CFSTR("input mute"), theInputMute ? kCFBooleanTrue : kCFBooleanFalse);
+		CFDictionarySetValue(theAnswer, CFSTR("output mute"), theOutputMute ? kCFBooleanTrue : kCFBooleanFalse);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("input data source"), kCFNumberSInt32Type, &theInputDataSource);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("output data source"), kCFNumberSInt32Type, &theOutputDataSource);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("play-thru destination"), kCFNumberSInt32Type, &thePlayThruDestination);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("play-thru latency"), kCFNumberSInt32Type, &thePlayThruLatency);
+	}
+	return theAnswer;
+}
+
+static void	NullAudio_WriteSettings(void)
+{
+	//	This runs on gSettings_Queue. The device settings are merged into the ones that were loaded so
+	//	that the settings for a device that doesn't exist right now aren't lost.
+	CFMutableDictionaryRef theSettings = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	CFMutableDictionaryRef theDeviceSettings = NULL;
+	if(theSettings != NULL)
+	{
+		pthread_mutex_lock(&gPlugIn_StateMutex);
+		theDeviceSettings = (gSettings_Devices != NULL) ? CFDictionaryCreateMutableCopy(NULL, 0, gSettings_Devices) : CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		if(theDeviceSettings != NULL)
+		{
+			for(UInt32 theSlot = 0; theSlot < kPlugIn_MaxNumberDevices; ++theSlot)
+			{
+				if(atomic_load_explicit(&gDevices[theSlot].mIsAlive, memory_order_relaxed))
+				{
+					CFDictionaryRef theSettingsForDevice = NullAudio_CopyDeviceSettings(&gDevices[theSlot]);
+					if(theSettingsForDevice != NULL)
+					{
+						CFDictionarySetValue(theDeviceSettings, gDevices[theSlot].mUID, theSettingsForDevice);
+						CFRelease(theSettingsForDevice);
+					}
+				}
+			}
+			
+			//	the merged settings become the ones that later writes start from
+			if(gSettings_Devices != NULL)
+			{
+				CFRelease(gSettings_Devices);
+			}
+			gSettings_Devices = CFDictionaryCreateCopy(NULL, theDeviceSettings);
+			CFDictionarySetValue(theSettings, CFSTR("devices"), theDeviceSettings);
+			CFRelease(theDeviceSettings);
+		}
+		
+		//	save which slots are in use rather than how many, since a slot determines the device's UID
+		CFMutableArrayRef theDeviceSlots = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+		if(theDeviceSlots != NULL)
+		{
+			for(UInt32 theSlot = 0; theSlot < kPlugIn_MaxNumberDevices; ++theSlot)
+			{
+				if(atomic_load_explicit(&gDevices[theSlot].mIsAlive, memory_order_relaxed))
+				{
+					SInt32 theSlotValue = (SInt32)theSlot;
+					CFNumberRef theSlotNumber = CFNumberCreate(NULL, kCFNumberSInt32Type, &theSlotValue);
+					if(theSlotNumber != NULL)
+					{
+						CFArrayAppendValue(theDeviceSlots, theSlotNumber);
+						CFRelease(theSlotNumber);
+					}
+				}
+			}
+			CFDictionarySetValue(theSettings, CFSTR("device slots"), theDeviceSlots);
+			CFRelease(theDeviceSlots);
+		}
+		CFDictionarySetValue(theSettings, CFSTR("box acquired"), gBox_Acquired ? kCFBooleanTrue : kCFBooleanFalse);
+		if(gBox_Name != NULL)
+		{
+			CFDictionarySetValue(theSettings, CFSTR("box name"), gBox_Name);
+		}
+		pthread_mutex_unlock(&gPlugIn_StateMutex);
+		
+		gPlugIn_Host->WriteToStorage(gPlugIn_Host, CFSTR(kSettings_Key), theSettings);
+		CFRelease(theSettings);
+	}
+}
+
+static bool	NullAudio_GetSettingsNumber(CFDictionaryRef inSettings, CFStringRef inKey, CFNumberType inNumberType, void* outValue)
+{
+	//	This returns false if inSettings doesn't have a number or a boolean for the key.
+	bool theAnswer = false;
+	CFTypeRef theValue = (inSettings != NULL) ? CFDictionaryGetValue(inSettings, inKey) : NULL;
+	if(theValue != NULL)
+	{
+		if(CFGetTypeID(theValue) == CFNumberGetTypeID())
+		{
+			theAnswer = CFNumberGetValue((CFNumberRef)theValue, inNumberType, outValue);
+		}
+		else if((CFGetTypeID(theValue) == CFBooleanGetTypeID()) && (inNumberType == kCFNumberSInt32Type))
+		{
+			*((SInt32*)outValue) = CFBooleanGetValue((CFBooleanRef)theValue) ? 1 : 0;
+			theAnswer = true;
+		}
+	}
+	return theAnswer;
+}
+
+static void	NullAudio_RestoreDeviceSettings(NullAudio_Device* inDevice)
+{
+	//	This applies the saved settings for the device, if there are any, ignoring anything that is
+	//	out of range. The caller must hold gPlugIn_StateMutex and the device's mStateMutex.
+	CFDictionaryRef theSettings = NULL;
+	if(gSettings_Devices != NULL)
+	{
+		theSettings = (CFDictionaryRef)CFDictionaryGetValue(gSettings_Devices, inDevice->mUID);
+	}
+	if((theSettings != NULL) && (CFGetTypeID(theSettings) == CFDictionaryGetTypeID()))
+	{
+		Float64 theSampleRate = 0.0;
+		Float32 theVolume = 0.0;
+		SInt32 theValue = 0;
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("sample rate"), kCFNumberFloat64Type, &theSampleRate) && NullAudio_IsSupportedSampleRate(theSampleRate))
+		{
+			inDevice->mSampleRate = theSampleRate;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("input volume"), kCFNumberFloat32Type, &theVolume) && (theVolume >= 0.0f) && (theVolume <= 1.0f))
+		{
+			inDevice->mVolume_Input_Master_Value = theVolume;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("output volume"), kCFNumberFloat32Type, &theVolume) && (theVolume >= 0.0f) && (theVolume <= 1.0f))
+		{
+			inDevice->mVolume_Output_Master_Value = theVolume;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("input mute"), kCFNumberSInt32Type, &theValue))
+		{
+			inDevice->mMute_Input_Master_Value = theValue != 0;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("output mute"), kCFNumberSInt32Type, &theValue))
+		{
+			inDevice->mMute_Output_Master_Value = theValue != 0;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("input data source"), kCFNumberSInt32Type, &theValue) && (theValue >= 0) && ((UInt32)theValue < kDataSource_NumberItems))
+		{
+			inDevice->mDataSource_Input_Master_Value = (UInt32)theValue;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("output data source"), kCFNumberSInt32Type, &theValue) && (theValue >= 0) && ((UInt32)theValue < kDataSource_NumberItems))
+		{
+			inDevice->mDataSource_Output_Master_Value = (UInt32)theValue;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("play-thru destination"), kCFNumberSInt32Type, &theValue) && (theValue >= 0) && ((UInt32)theValue < kDataSource_NumberItems))
+		{
+			inDevice->mDataDestination_PlayThru_Master_Value = (UInt32)theValue;
+		}
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("play-thru latency"), kCFNumberSInt32Type, &theValue) && (theValue >= 0) && ((UInt32)theValue <= kDevice_MaxPlayThruLatency))
+		{
+			atomic_store_explicit(&inDevice->mPlayThruLatency, (UInt32)theValue, memory_order_relaxed);
+		}
+	}
+}
+
+#pragma mark Device Management
+
+//	The device slots are statically allocated and are never freed, only marked as not alive. This
+//	means that a pointer to a slot is always safe to dereference, which in turn means that looking up
+//	a device doesn't require any locks. The IO path depends on this.
+
+static AudioObjectID	NullAudio_GetObjectKind(AudioObjectID inObjectID)
+{
+	//	This maps an object ID to the ID of the object in the same position in the first device's
+	//	block, which is what the rest of the driver switches on. The plug-in and the box map to
+	//	themselves and IDs that are out of range map to kAudioObjectUnknown.
+	AudioObjectID theAnswer = kAudioObjectUnknown;
+	if(inObjectID < kObjectID_Device)
+	{
+		theAnswer = inObjectID;
+	}
+	else if(inObjectID < (kObjectID_Device + (kPlugIn_MaxNumberDevices * kDevice_NumberObjectIDs)))
+	{
+		theAnswer = kObjectID_Device + ((inObjectID - kObjectID_Device) % kDevice_NumberObjectIDs);
+	}
+	return theAnswer;
+}
+
+static AudioObjectID	NullAudio_GetDeviceObjectID(const NullAudio_Device* inDevice, AudioObjectID inObjectKind)
+{
+	//	This is the inverse of NullAudio_GetObjectKind() for the objects in the given device's block.
+	return inDevice->mObjectID + (inObjectKind - kObjectID_Device);
+}
+
+static NullAudio_Device*	NullAudio_FindDevice(AudioObjectID inObjectID)
+{
+	//	This returns the device that either is or owns the given object, or NULL if the object doesn't
+	//	belong to a device that currently exists.
+	NullAudio_Device* theAnswer = NULL;
+	if((inObjectID >= kObjectID_Device) && (inObjectID < (kObjectID_Device + (kPlugIn_MaxNumberDevices * kDevice_NumberObjectIDs))))
+	{
+		NullAudio_Device* theDevice = &gDevices[(inObjectID - kObjectID_Device) / kDevice_NumberObjectIDs];
+		if(atomic_load_explicit(&theDevice->mIsAlive, memory_order_acquire))
+		{
+			theAnswer = theDevice;
+		}
+	}
+	return theAnswer;
+}
+
+static UInt32	NullAudio_CopyDeviceList(AudioObjectID* outDeviceList, UInt32 inMaxNumberDevices)
+{
+	//	This fills out up to inMaxNumberDevices device object IDs and returns the total number of
+	//	devices, so passing 0 just counts them. The caller must hold gPlugIn_StateMutex so that the
+	//	list stays consistent with any other state it reports alongside it.
+	UInt32 theNumberDevices = 0;
+	for(UInt32 theSlot = 0; theSlot < kPlugIn_MaxNumberDevices; ++theSlot)
+	{
+		if(atomic_load_explicit(&gDevices[theSlot].mIsAlive, memory_order_relaxed))
+		{
+			if(theNumberDevices < inMaxNumberDevices)
+			{
+				outDeviceList[theNumberDevices] = gDevices[theSlot].mObjectID;
+			}
+			++theNumberDevices;
+		}
+	}
+	return theNumberDevices;
+}
+
+static NullAudio_Device*	NullAudio_AllocateDevice(UInt32 inSlot)
+{
+	//	This takes the given slot, or the first free slot if inSlot is kPlugIn_AnyDeviceSlot, resets it
+	//	to the default state and marks it alive. It returns NULL if the slot is already in use, all the
+	//	slots are in use or the slot's resources can't be allocated. The caller must hold
+	//	gPlugIn_StateMutex.
+	//
+	//	Note that a slot always hands out the same object IDs and UID. So, destroying a device and then
+	//	creating another one will bring back the same device as far as the HAL is concerned, which is
+	//	what we want for things like the HAL's persisted settings for the device.
+	NullAudio_Device* theAnswer = NULL;
+	for(UInt32 theSlot = 0; (theAnswer == NULL) && (theSlot < kPlugIn_MaxNumberDevices); ++theSlot)
+	{
+		if(((inSlot == kPlugIn_AnyDeviceSlot) || (inSlot == theSlot)) && !atomic_load_explicit(&gDevices[theSlot].mIsAlive, memory_order_relaxed))
+		{
+			theAnswer = &gDevices[theSlot];
+		}
+	}
+	
+	//	the rings are allocated the first time the slot is used and then kept along with the slot
+	if((theAnswer != NULL) && ((NullAudio_ReserveLoopbackRingBuffer(theAnswer, kDevice_DefaultChannelsPerFrame * NullAudio_GetBytesPerSample(kSampleFormat_Float32)) != 0) || (NullAudio_ReservePlayThruRingBuffer(theAnswer, kDevice_DefaultChannelsPerFrame) != 0)))
+	{
+		DebugMsg("NullAudio_AllocateDevice: failed to allocate the ring buffers");
+		theAnswer = NULL;
+	}
+	
+	if(theAnswer != NULL)
+	{
+		pthread_mutex_lock(&theAnswer->mStateMutex);
+		
+		//	the first device keeps the names this driver has always used
+		if(theAnswer->mUID == NULL)
+		{
+			if(theAnswer->mSlot == 0)
+			{
+				theAnswer->mUID = CFSTR(kDevice_UID);
+				theAnswer->mName = CFSTR(kDevice_Name);
+			}
+			else
+			{
+				theAnswer->mUID = CFStringCreateWithFormat(NULL, NULL, CFSTR(kDevice_UID "_%u"), (unsigned int)theAnswer->mSlot);
+				theAnswer->mName = CFStringCreateWithFormat(NULL, NULL, CFSTR(kDevice_Name " %u"), (unsigned int)(theAnswer->mSlot + 1));
+			}
+		}
+		
+		theAnswer->mSampleRate = kDevice_DefaultSampleRate;
+		theAnswer->mSampleFormat = kSampleFormat_Float32;
+		theAnswer->mChannelsPerFrame = kDevice_DefaultChannelsPerFrame;
+		theAnswer->mIOIsRunning = 0;
+		theAnswer->mStream_Input_IsActive = true;
+		theAnswer->mStream_Output_IsActive = true;
+		//	the volumes start out at the scalar value that maps to 0 dB so the loopback is unity gain
+		theAnswer->mVolume_Input_Master_Value = sqrtf(-kVolume_MinDB / (kVolume_MaxDB - kVolume_MinDB));
+		theAnswer->mVolume_Output_Master_Value = theAnswer->mVolume_Input_Master_Value;
+		theAnswer->mMute_Input_Master_Value = false;
+		theAnswer->mMute_Output_Master_Value = false;
+		theAnswer->mDataSource_Input_Master_Value = 0;
+		theAnswer->mDataSource_Output_Master_Value = 0;
+		theAnswer->mDataDestination_PlayThru_Master_Value = 0;
+		atomic_store_explicit(&theAnswer->mPlayThruLatency, 0, memory_order_relaxed);
+		NullAudio_RestoreDeviceSettings(theAnswer);
+		NullAudio_UpdateGains(theAnswer);
+		for(UInt32 theClientIndex = 0; theClientIndex < kDevice_MaxNumberClients; ++theClientIndex)
+		{
+			atomic_store_explicit(&theAnswer->mClients[theClientIndex].mIsInUse, false, memory_order_relaxed);
+		}
+		theAnswer->mAppliedGain_Input_Master = atomic_load_explicit(&theAnswer->mGain_Input_Master, memory_order_relaxed);
+		theAnswer->mAppliedGain_Output_Master = atomic_load_explicit(&theAnswer->mGain_Output_Master, memory_order_relaxed);
+		NullAudio_ResetTelemetry(&theAnswer->mTelemetry);
+		NullAudio_PublishClockAnchor(theAnswer, 0, 0.0, NullAudio_GetHostTicksPerRingBuffer(theAnswer->mSampleRate));
+		
+		pthread_mutex_unlock(&theAnswer->mStateMutex);
+		
+		atomic_store_explicit(&theAnswer->mIsAlive, true, memory_order_release);
+	}
+	return theAnswer;
+}
+
+static void	NullAudio_FreeDevice(NullAudio_Device* inDevice)
+{
+	//	This just marks the slot as free. The caller must hold gPlugIn_StateMutex and the device's
+	//	mStateMutex, and IO must be stopped on the device.
+	atomic_store_explicit(&inDevice->mIsAlive, false, memory_order_release);
+}
+
+static void	NullAudio_DeviceListChanged(void)
+{
+	//	This tells the HAL that the set of devices changed. Both the plug-in and the box have a device
+	//	list, and the devices are also among the plug-in's owned objects.
+	AudioObjectPropertyAddress thePlugInAddresses[2] = { { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain }, { kAudioObjectPropertyOwnedObjects, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain } };
+	NullAudio_QueuePropertiesChanged(kObjectID_PlugIn, 2, thePlugInAddresses);
+	AudioObjectPropertyAddress theBoxAddress = { kAudioBoxPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	NullAudio_QueuePropertiesChanged(kObjectID_Box, 1, &theBoxAddress);
+}
+
+#pragma mark Configuration Changes
+
+//	Changes to the sample rate and format have to go through the host's configuration change
+//	machinery, which must not be called from inside a property setter. The request is packaged up
+//	and sent from the global queue instead. It carries the device's object ID rather than a pointer
+//	to the device so that a device destroyed in the meantime just gets a bad object error.
+
+static OSStatus	NullAudio_ScheduleConfigurationChangeRequest(AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
+{
+	OSStatus theAnswer = 0;
+	NullAudio_ConfigurationChangeRequest* theRequest = (NullAudio_ConfigurationChangeRequest*)malloc(sizeof(NullAudio_ConfigurationChangeRequest));
+	FailWithAction(theRequest == NULL, theAnswer = kAudioHardwareUnspecifiedError, Done, "NullAudio_ScheduleConfigurationChangeRequest: failed to allocate the request");
+	theRequest->mDeviceObjectID = inDeviceObjectID;
+	theRequest->mChangeAction = inChangeAction;
+	theRequest->mChangeInfo = inChangeInfo;
+	dispatch_async_f(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), theRequest, NullAudio_SendConfigurationChangeRequest);
+
+Done:
+	return theAnswer;
+}
+
+static void	NullAudio_SendConfigurationChangeRequest(void* inContext)
+{
+	NullAudio_ConfigurationChangeRequest* theRequest = (NullAudio_ConfigurationChangeRequest*)inContext;
+	gPlugIn_Host->RequestDeviceConfigurationChange(gPlugIn_Host, theRequest->mDeviceObjectID, theRequest->mChangeAction, theRequest->mChangeInfo);
+	free(theRequest);
+}
+
+#pragma mark Formats
+
+//	The input and output streams of a device always share the same format so that the loopback ring
+//	can hold the data exactly as the output stream wrote it. The physical format is described by the
+//	sample rate, the sample format and the number of channels. The virtual format has the same
+//	sample rate and number of channels but is always 32 bit float. The format only changes in
+//	NullAudio_PerformDeviceConfigurationChange(), which the HAL only calls while IO is stopped, so
+//	the IO thread can read it without taking the state lock.
+
+static UInt32	NullAudio_GetBytesPerSample(UInt32 inSampleFormat)
+{
+	UInt32 theAnswer = 0;
+	switch(inSampleFormat)
+	{
+		case kSampleFormat_Float32:
+			theAnswer = sizeof(Float32);
+			break;
+			
+		case kSampleFormat_SInt16:
+			theAnswer = sizeof(SInt16);
+			break;
+			
+		case kSampleFormat_SInt24:
+			theAnswer = 3;
+			break;
+			
+		case kSampleFormat_SInt32:
+			theAnswer = sizeof(SInt32);
+			break;
+	};
+	return theAnswer;
+}
+
+static void	NullAudio_FillOutFormat(AudioStreamBasicDescription* outFormat, Float64 inSampleRate, UInt32 inSampleFormat, UInt32 inChannelsPerFrame)
+{
+	outFormat->mSampleRate = inSampleRate;
+	outFormat->mFormatID = kAudioFormatLinearPCM;
+	outFormat->mFormatFlags = ((inSampleFormat == kSampleFormat_Float32) ? kAudioFormatFlagIsFloat : kAudioFormatFlagIsSignedInteger) | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
+	outFormat->mBytesPerPacket = NullAudio_GetBytesPerSample(inSampleFormat) * inChannelsPerFrame;
+	outFormat->mFramesPerPacket = 1;
+	outFormat->mBytesPerFrame = NullAudio_GetBytesPerSample(inSampleFormat) * inChannelsPerFrame;
+	outFormat->mChannelsPerFrame = inChannelsPerFrame;
+	outFormat->mBitsPerChannel = 8 * NullAudio_GetBytesPerSample(inSampleFormat);
+	outFormat->mReserved = 0;
+}
+
+static UInt32	NullAudio_GetSampleFormat(const AudioStreamBasicDescription* inFormat)
+{
+	//	This returns the sample format that the given ASBD describes, ignoring the sample rate. It
+	//	returns kSampleFormat_NumberFormats if the ASBD isn't one of the formats we support.
+	UInt32 theAnswer = kSampleFormat_NumberFormats;
+	if((inFormat->mChannelsPerFrame >= 1) && (inFormat->mChannelsPerFrame <= kDevice_MaxChannelsPerFrame))
+	{
+		for(UInt32 theSampleFormat = 0; (theAnswer == kSampleFormat_NumberFormats) && (theSampleFormat < kSampleFormat_NumberFormats); ++theSampleFormat)
+		{
+			AudioStreamBasicDescription theFormat;
+			NullAudio_FillOutFormat(&theFormat, inFormat->mSampleRate, theSampleFormat, inFormat->mChannelsPerFrame);
+			if((inFormat->mFormatID == theFormat.mFormatID) && (inFormat->mFormatFlags == theFormat.mFormatFlags) && (inFormat->mBytesPerPacket == theFormat.mBytesPerPacket) && (inFormat->mFramesPerPacket == theFormat.mFramesPerPacket) && (inFormat->mBytesPerFrame == theFormat.mBytesPerFrame) && (inFormat->mBitsPerChannel == theFormat.mBitsPerChannel))
+			{
+				theAnswer = theSampleFormat;
+			}
+		}
+	}
+	return theAnswer;
+}
+
+static bool	NullAudio_IsSupportedSampleRate(Float64 inSampleRate)
+{
+	bool theAnswer = false;
+	for(UInt32 theIndex = 0; !theAnswer && (theIndex < kDevice_NumberSampleRates); ++theIndex)
+	{
+		theAnswer = inSampleRate == kDevice_SampleRates[theIndex];
+	}
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_ReserveLoopbackRingBuffer(NullAudio_Device* inDevice, UInt32 inBytesPerFrame)
+{
+	//	This makes sure the loopback ring can hold kDevice_RingBufferSize frames of the given size.
+	//	The ring only ever grows. It must not be called while IO is running.
+	OSStatus theAnswer = 0;
+	UInt32 theByteSize = kDevice_RingBufferSize * inBytesPerFrame;
+	if(theByteSize > inDevice->mLoopbackRingBufferByteSize)
+	{
+		Byte* theRingBuffer = (Byte*)realloc(inDevice->mLoopbackRingBuffer, theByteSize);
+		if(theRingBuffer != NULL)
+		{
+			inDevice->mLoopbackRingBuffer = theRingBuffer;
+			inDevice->mLoopbackRingBufferByteSize = theByteSize;
+		}
+		else
+		{
+			theAnswer = kAudioHardwareUnspecifiedError;
+		}
+	}
+	if(theAnswer == 0)
+	{
+		memset(inDevice->mLoopbackRingBuffer, 0, inDevice->mLoopbackRingBufferByteSize);
+	}
+	return theAnswer;
+}
+
+#pragma mark Loopback
+
+//	Each device loops the data written to its output stream back to its input stream. The output
+//	data is written into a ring buffer of kDevice_RingBufferSize frames at the position given by its
+//	sample time modulo the size of the ring, and ReadInput reads it back out from the position given
+//	by the input sample time. Since the HAL always places the input time behind the output time, the
+//	data written for a given sample time is read back once the input catches up to it. Because the
+//	ring is the same size as the zero time stamp period, a given sample time always lands in the same
+//	place in the ring. The ring holds the data in the physical format, so a span of frames is just
+//	bytes to copy. It crosses the end of the ring at most once, so every transfer is at most two
+//	memcpy() calls, which are already vectorized.
+
+static UInt32	NullAudio_GetLoopbackRingOffset(Float64 inSampleTime)
+{
+	//	The input time can be slightly negative right after IO starts. Going through SInt64 keeps the
+	//	conversion well defined, and since the size of the ring is a power of two, the unsigned
+	//	remainder is still the right position in the ring.
+	return (UInt32)(((UInt64)((SInt64)inSampleTime)) % kDevice_RingBufferSize);
+}
+
+static void	NullAudio_WriteToLoopbackRingBuffer(NullAudio_Device* inDevice, Float64 inSampleTime, UInt32 inFrameCount, const void* inBuffer)
+{
+	UInt32 theBytesPerFrame = inDevice->mChannelsPerFrame * NullAudio_GetBytesPerSample(inDevice->mSampleFormat);
+	UInt32 theRingOffset = NullAudio_GetLoopbackRingOffset(inSampleTime);
+	UInt32 theFirstSpanFrameCount = ((theRingOffset + inFrameCount) > kDevice_RingBufferSize) ? (kDevice_RingBufferSize - theRingOffset) : inFrameCount;
+	memcpy(inDevice->mLoopbackRingBuffer + (theRingOffset * theBytesPerFrame), inBuffer, theFirstSpanFrameCount * theBytesPerFrame);
+	if(theFirstSpanFrameCount < inFrameCount)
+	{
+		memcpy(inDevice->mLoopbackRingBuffer, ((const Byte*)inBuffer) + (theFirstSpanFrameCount * theBytesPerFrame), (inFrameCount - theFirstSpanFrameCount) * theBytesPerFrame);
+	}
+}
+
+static void	NullAudio_ReadFromLoopbackRingBuffer(NullAudio_Device* inDevice, Float64 inSampleTime, UInt32 inFrameCount, void* outBuffer)
+{
+	//	Once the data has been read, it is cleared from the ring so that if nothing is writing to the
+	//	output, the input goes silent rather than repeating the last ring's worth of audio forever.
+	//	The HAL only does ReadInput once per IO cycle, so no other reader can need the data. Note that
+	//	zero is silence in all the supported sample formats.
+	UInt32 theBytesPerFrame = inDevice->mChannelsPerFrame * NullAudio_GetBytesPerSample(inDevice->mSampleFormat);
+	UInt32 theRingOffset = NullAudio_GetLoopbackRingOffset(inSampleTime);
+	UInt32 theFirstSpanFrameCount = ((theRingOffset + inFrameCount) > kDevice_RingBufferSize) ? (kDevice_RingBufferSize - theRingOffset) : inFrameCount;
+	memcpy(outBuffer, inDevice->mLoopbackRingBuffer + (theRingOffset * theBytesPerFrame), theFirstSpanFrameCount * theBytesPerFrame);
+	memset(inDevice->mLoopbackRingBuffer + (theRingOffset * theBytesPerFrame), 0, theFirstSpanFrameCount * theBytesPerFrame);
+	if(theFirstSpanFrameCount < inFrameCount)
+	{
+		memcpy(((Byte*)outBuffer) + (theFirstSpanFrameCount * theBytesPerFrame), inDevice->mLoopbackRingBuffer, (inFrameCount - theFirstSpanFrameCount) * theBytesPerFrame);
+		memset(inDevice->mLoopbackRingBuffer, 0, (inFrameCount - theFirstSpanFrameCount) * theBytesPerFrame);
+	}
+}
+
+#pragma mark Play-Through
+
+//	When play-through is on, the device routes its own input into its output with a fixed latency,
+//	so that the input can be monitored without going through an app. ConvertInput copies each
+//	buffer of float input, after the input volume and mute have been applied, into the play-through
+//	ring at its input sample time. ConvertMix then adds the frames from the output sample time minus
+//	the latency into the mix before the output volume and mute are applied. Like the loopback ring,
+//	frames are cleared from the play-through ring as they are read so that it goes silent when
+//	there is no input. Play-through is off when the latency is 0.
+//
+//	The input for a given sample time has to have been captured before it can be played, so the
+//	latency can't be less than the distance between the output and input times of a cycle. A
+//	shorter latency is treated as that distance. Note that since the input of this device is the
+//	loopback of its output, turning play-through on feeds the output back on itself. The input
+//	volume controls how fast that dies away.
+
+static OSStatus	NullAudio_ReservePlayThruRingBuffer(NullAudio_Device* inDevice, UInt32 inChannelsPerFrame)
+{
+	//	This makes sure the play-through ring can hold kDevice_RingBufferSize frames of float samples.
+	//	The ring only ever grows. It must not be called while IO is running.
+	OSStatus theAnswer = 0;
+	UInt32 theByteSize = kDevice_RingBufferSize * inChannelsPerFrame * (UInt32)sizeof(Float32);
+	if(theByteSize > inDevice->mPlayThruRingBufferByteSize)
+	{
+		Float32* theRingBuffer = (Float32*)realloc(inDevice->mPlayThruRingBuffer, theByteSize);
+		if(theRingBuffer != NULL)
+		{
+			inDevice->mPlayThruRingBuffer = theRingBuffer;
+			inDevice->mPlayThruRingBufferByteSize = theByteSize;
+		}
+		else
+		{
+			theAnswer = kAudioHardwareUnspecifiedError;
+		}
+	}
+	if(theAnswer == 0)
+	{
+		memset(inDevice->mPlayThruRingBuffer, 0, inDevice->mPlayThruRingBufferByteSize);
+	}
+	return theAnswer;
+}
+
+static void	NullAudio_WriteToPlayThruRingBuffer(NullAudio_Device* inDevice, Float64 inSampleTime, UInt32 inFrameCount, const Float32* inBuffer)
+{
+	UInt32 theChannelsPerFrame = inDevice->mChannelsPerFrame;
+	UInt32 theRingOffset = NullAudio_GetLoopbackRingOffset(inSampleTime);
+	UInt32 theFirstSpanFrameCount = ((theRingOffset + inFrameCount) > kDevice_RingBufferSize) ? (kDevice_RingBufferSize - theRingOffset) : inFrameCount;
+	memcpy(inDevice->mPlayThruRingBuffer + (theRingOffset * theChannelsPerFrame), inBuffer, theFirstSpanFrameCount * theChannelsPerFrame * sizeof(Float32));
+	if(theFirstSpanFrameCount < inFrameCount)
+	{
+		memcpy(inDevice->mPlayThruRingBuffer, inBuffer + (theFirstSpanFrameCount * theChannelsPerFrame), (inFrameCount - theFirstSpanFrameCount) * theChannelsPerFrame * sizeof(Float32));
+	}
+}
+
+static void	NullAudio_MixFromPlayThruRingBuffer(NullAudio_Device* inDevice, Float64 inInputSampleTime, Float64 inOutputSampleTime, UInt32 inFrameCount, Float32* ioMix)
+{
+	//	This adds the play-through frames for the given output time into the mix and clears them from
+	//	the ring. The read position is never later than the input time of this cycle, which is the
+	//	newest input there is. The output time is never behind the input time and the latency is at
+	//	most kDevice_MaxPlayThruLatency, which is half the ring, so the read position is never earlier
+	//	than the input time minus kDevice_MaxPlayThruLatency. The frames being read are therefore
+	//	within the last half ring of input and can't have been overwritten by newer input.
+	UInt32 theLatency = atomic_load_explicit(&inDevice->mPlayThruLatency, memory_order_relaxed);
+	if(theLatency > 0)
+	{
+		Float64 theSampleTime = inOutputSampleTime - theLatency;
+		if(theSampleTime > inInputSampleTime)
+		{
+			theSampleTime = inInputSampleTime;
+		}
+		UInt32 theChannelsPerFrame = inDevice->mChannelsPerFrame;
+		UInt32 theRingOffset = NullAudio_GetLoopbackRingOffset(theSampleTime);
+		UInt32 theFirstSpanFrameCount = ((theRingOffset + inFrameCount) > kDevice_RingBufferSize) ? (kDevice_RingBufferSize - theRingOffset) : inFrameCount;
+		Float32* theFirstSpan = inDevice->mPlayThruRingBuffer + (theRingOffset * theChannelsPerFrame);
+		NullAudio_AccumulateSamples(theFirstSpan, ioMix, theFirstSpanFrameCount * theChannelsPerFrame);
+		memset(theFirstSpan, 0, theFirstSpanFrameCount * theChannelsPerFrame * sizeof(Float32));
+		if(theFirstSpanFrameCount < inFrameCount)
+		{
+			NullAudio_AccumulateSamples(inDevice->mPlayThruRingBuffer, ioMix + (theFirstSpanFrameCount * theChannelsPerFrame), (inFrameCount - theFirstSpanFrameCount) * theChannelsPerFrame);
+			memset(inDevice->mPlayThruRingBuffer, 0, (inFrameCount - theFirstSpanFrameCount) * theChannelsPerFrame * sizeof(Float32));
+		}
+	}
+}
+
+#pragma mark Vector Helpers
+
+//	The gain and sample conversion loops are written in terms of these few operations on a vector of
+//	four Float32s or four SInt32s so that the same loop works with SSE2 on x86_64 and NEON on arm64.
+//	When neither is available, NullAudio_HasVectorUnit is 0 and the loops fall back to scalar code.
+
+#if defined(__SSE2__)
+
+	#define NullAudio_HasVectorUnit	1
+	
+	typedef __m128	NullAudio_FloatVector;
+	typedef __m128i	NullAudio_IntVector;
+	
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Load(const Float32* inSource)						{ return _mm_loadu_ps(inSource); }
+	static inline void					NullAudio_FloatVector_Store(Float32* outDestination, NullAudio_FloatVector inVector)	{ _mm_storeu_ps(outDestination, inVector); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Splat(Float32 inValue)								{ return _mm_set1_ps(inValue); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Make(Float32 in0, Float32 in1, Float32 in2, Float32 in3)	{ return _mm_setr_ps(in0, in1, in2, in3); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Add(NullAudio_FloatVector inA, NullAudio_FloatVector inB)	{ return _mm_add_ps(inA, inB); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Multiply(NullAudio_FloatVector inA, NullAudio_FloatVector inB)	{ return _mm_mul_ps(inA, inB); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Clamp(NullAudio_FloatVector inVector, Float32 inMinimum, Float32 inMaximum)	{ return _mm_min_ps(_mm_max_ps(inVector, _mm_set1_ps(inMinimum)), _mm_set1_ps(inMaximum)); }
+	static inline NullAudio_IntVector	NullAudio_FloatVector_Round(NullAudio_FloatVector inVector)					{ return _mm_cvtps_epi32(inVector); }
+	static inline NullAudio_FloatVector	NullAudio_IntVector_ToFloat(NullAudio_IntVector inVector)					{ return _mm_cvtepi32_ps(inVector); }
+	static inline NullAudio_IntVector	NullAudio_IntVector_Load(const SInt32* inSource)							{ return _mm_loadu_si128((const __m128i*)inSource); }
+	static inline void					NullAudio_IntVector_Store(SInt32* outDestination, NullAudio_IntVector inVector)	{ _mm_storeu_si128((__m128i*)outDestination, inVector); }
+	static inline NullAudio_IntVector	NullAudio_IntVector_LoadSInt16(const SInt16* inSource)						{ __m128i theVector = _mm_loadl_epi64((const __m128i*)inSource); return _mm_srai_epi32(_mm_unpacklo_epi16(theVector, theVector), 16); }
+	static inline void					NullAudio_IntVector_StoreSInt16(SInt16* outDestination, NullAudio_IntVector inVector)	{ _mm_storel_epi64((__m128i*)outDestination, _mm_packs_epi32(inVector, inVector)); }
+
+#elif defined(__ARM_NEON)
+
+	#define NullAudio_HasVectorUnit	1
+	
+	typedef float32x4_t	NullAudio_FloatVector;
+	typedef int32x4_t	NullAudio_IntVector;
+	
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Load(const Float32* inSource)						{ return vld1q_f32(inSource); }
+	static inline void					NullAudio_FloatVector_Store(Float32* outDestination, NullAudio_FloatVector inVector)	{ vst1q_f32(outDestination, inVector); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Splat(Float32 inValue)								{ return vdupq_n_f32(inValue); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Make(Float32 in0, Float32 in1, Float32 in2, Float32 in3)	{ NullAudio_FloatVector theAnswer = { in0, in1, in2, in3 }; return theAnswer; }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Add(NullAudio_FloatVector inA, NullAudio_FloatVector inB)	{ return vaddq_f32(inA, inB); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Multiply(NullAudio_FloatVector inA, NullAudio_FloatVector inB)	{ return vmulq_f32(inA, inB); }
+	static inline NullAudio_FloatVector	NullAudio_FloatVector_Clamp(NullAudio_FloatVector inVector, Float32 inMinimum, Float32 inMaximum)	{ return vminq_f32(vmaxq_f32(inVector, vdupq_n_f32(inMinimum)), vdupq_n_f32(inMaximum)); }
+	static inline NullAudio_IntVector	NullAudio_FloatVector_Round(NullAudio_FloatVector inVector)					{ return vcvtnq_s32_f32(inVector); }
+	static inline NullAudio_FloatVector	NullAudio_IntVector_ToFloat(NullAudio_IntVector inVector)					{ return vcvtq_f32_s32(inVector); }
+	static inline NullAudio_IntVector	NullAudio_IntVector_Load(const SInt32* inSource)							{ return vld1q_s32(inSource); }
+	static inline void					NullAudio_IntVector_Store(SInt32* outDestination, NullAudio_IntVector inVector)	{ vst1q_s32(outDestination, inVector); }
+	static inline NullAudio_IntVector	NullAudio_IntVector_LoadSInt16(const SInt16* inSource)						{ return vmovl_s16(vld1_s16(inSource)); }
+	static inline void					NullAudio_IntVector_StoreSInt16(SInt16* outDestination, NullAudio_IntVector inVector)	{ vst1_s16(outDestination, vqmovn_s32(inVector)); }
+
+#else
+
+	#define NullAudio_HasVectorUnit	0
+
+#endif
+
+#pragma mark Gain
+
+//	The volume and mute controls are applied to the audio as it passes through the loopback. The
+//	output controls are applied to the float mix before it is converted to the physical format and
+//	the input controls are applied to the data after it has been converted back to float. The
+//	linear gain for each pair of controls is worked out when one of them changes and cached in the
+//	device, so the IO thread only has to multiply. When the gain changes, the IO thread ramps from
+//	the old gain to the new one over the course of one buffer so that the change doesn't produce
+//	zipper noise.
+
+static Float32	NullAudio_GetLinearGain(Float32 inVolumeScalar, bool inIsMuted)
+{
+	//	This uses the same taper as the dB value of the volume control. The scalar value is squared
+	//	before converting to dB and then the dB value is converted to a linear gain.
+	Float32 theAnswer = 0.0;
+	if(!inIsMuted)
+	{
+		Float32 theDecibels = kVolume_MinDB + ((inVolumeScalar * inVolumeScalar) * (kVolume_MaxDB - kVolume_MinDB));
+		theAnswer = powf(10.0f, theDecibels / 20.0f);
+	}
+	return theAnswer;
+}
+
+static void	NullAudio_UpdateGains(NullAudio_Device* inDevice)
+{
+	//	The caller must hold the device's state lock.
+	atomic_store_explicit(&inDevice->mGain_Input_Master, NullAudio_GetLinearGain(inDevice->mVolume_Input_Master_Value, inDevice->mMute_Input_Master_Value), memory_order_relaxed);
+	atomic_store_explicit(&inDevice->mGain_Output_Master, NullAudio_GetLinearGain(inDevice->mVolume_Output_Master_Value, inDevice->mMute_Output_Master_Value), memory_order_relaxed);
+}
+
+static void	NullAudio_ApplyGain(Float32* ioSamples, UInt32 inFrameCount, UInt32 inChannelsPerFrame, Float32 inStartGain, Float32 inEndGain)
+{
+	//	This scales an interleaved buffer in place. The gain for frame i of the buffer is
+	//	inStartGain + ((i + 1) * theStep), so the last frame is at inEndGain. When the gain isn't
+	//	changing, the whole buffer is just multiplied by a constant.
+	UInt32 theNumberSamples = inFrameCount * inChannelsPerFrame;
+	if(inStartGain == inEndGain)
+	{
+		if(inEndGain == 0.0f)
+		{
+			//	muted, so there's no need to multiply
+			memset(ioSamples, 0, theNumberSamples * sizeof(Float32));
+		}
+		else if(inEndGain != 1.0f)
+		{
+			//	a constant gain doesn't care about frame boundaries, so treat it as mono
+			NullAudio_ApplyGainRamp(ioSamples, theNumberSamples, 1, inStartGain, 0.0f);
+		}
+	}
+	else if(inFrameCount > 0)
+	{
+		NullAudio_ApplyGainRamp(ioSamples, inFrameCount, inChannelsPerFrame, inStartGain, (inEndGain - inStartGain) / (Float32)inFrameCount);
+	}
+}
+
+static void	NullAudio_ApplyGainRamp(Float32* ioSamples, UInt32 inFrameCount, UInt32 inChannelsPerFrame, Float32 inStartGain, Float32 inStep)
+{
+	UInt32 theFrameIndex = 0;
+	
+#if NullAudio_HasVectorUnit
+	if((inChannelsPerFrame == 1) || (inChannelsPerFrame == 2) || (inChannelsPerFrame == 4))
+	{
+		//	Each vector holds 4 / inChannelsPerFrame whole frames, so the gain vector holds the gain
+		//	of the frame each lane belongs to, for example { g0, g0, g1, g1 } for stereo.
+		UInt32 theFramesPerVector = 4 / inChannelsPerFrame;
+		NullAudio_FloatVector theGain = NullAudio_FloatVector_Make(inStartGain + ((Float32)(1 + (0 / inChannelsPerFrame)) * inStep), inStartGain + ((Float32)(1 + (1 / inChannelsPerFrame)) * inStep), inStartGain + ((Float32)(1 + (2 / inChannelsPerFrame)) * inStep), inStartGain + ((Float32)(1 + (3 / inChannelsPerFrame)) * inStep));
+		NullAudio_FloatVector theGainIncrement = NullAudio_FloatVector_Splat((Float32)theFramesPerVector * inStep);
+		for(; (theFrameIndex + theFramesPerVector) <= inFrameCount; theFrameIndex += theFramesPerVector)
+		{
+			Float32* theSamples = ioSamples + (theFrameIndex * inChannelsPerFrame);
+			NullAudio_FloatVector_Store(theSamples, NullAudio_FloatVector_Multiply(NullAudio_FloatVector_Load(theSamples), theGain));
+			theGain = NullAudio_FloatVector_Add(theGain, theGainIncrement);
+		}
+	}
+	else if((inChannelsPerFrame % 4) == 0)
+	{
+		//	each frame is a whole number of vectors that all get the same gain
+		for(; theFrameIndex < inFrameCount; ++theFrameIndex)
+		{
+			Float32* theSamples = ioSamples + (theFrameIndex * inChannelsPerFrame);
+			NullAudio_FloatVector theGain = NullAudio_FloatVector_Splat(inStartGain + ((Float32)(theFrameIndex + 1) * inStep));
+			for(UInt32 theChannelIndex = 0; theChannelIndex < inChannelsPerFrame; theChannelIndex += 4)
+			{
+				NullAudio_FloatVector_Store(theSamples + theChannelIndex, NullAudio_FloatVector_Multiply(NullAudio_FloatVector_Load(theSamples + theChannelIndex), theGain));
+			}
+		}
+	}
+#endif
+	
+	//	whatever is left over, which is everything for the other channel counts or if there is no
+	//	vector unit
+	for(; theFrameIndex < inFrameCount; ++theFrameIndex)
+	{
+		Float32* theSamples = ioSamples + (theFrameIndex * inChannelsPerFrame);
+		Float32 theFrameGain = inStartGain + ((Float32)(theFrameIndex + 1) * inStep);
+		for(UInt32 theChannelIndex = 0; theChannelIndex < inChannelsPerFrame; ++theChannelIndex)
+		{
+			theSamples[theChannelIndex] *= theFrameGain;
+		}
+	}
+}
+
+#pragma mark Mixing
+
+//	The driver does the MixOutput operation itself rather than letting the HAL do it. The HAL calls
+//	it once for each client doing output in an IO cycle with the client's data in the main buffer
+//	and the device's mix buffer as the secondary buffer. The first client to mix in a cycle copies
+//	its data into the mix and the rest add theirs to it, so the mix never depends on what was left
+//	in the buffer from the last cycle. If no client mixes in a cycle, ConvertMix clears the mix
+//	instead. The HAL already gives every client its own copy of the input data after ReadInput, so
+//	the input side doesn't need any per-client work.
+
+static NullAudio_Client*	NullAudio_FindClient(NullAudio_Device* inDevice, UInt32 inClientID)
+{
+	//	This is called on the IO thread, so it doesn't take any locks. It returns NULL if the client
+	//	isn't in the table.
+	NullAudio_Client* theAnswer = NULL;
+	for(UInt32 theClientIndex = 0; (theAnswer == NULL) && (theClientIndex < kDevice_MaxNumberClients); ++theClientIndex)
+	{
+		if(atomic_load_explicit(&inDevice->mClients[theClientIndex].mIsInUse, memory_order_acquire) && (inDevice->mClients[theClientIndex].mClientID == inClientID))
+		{
+			theAnswer = &inDevice->mClients[theClientIndex];
+		}
+	}
+	return theAnswer;
+}
+
+static void	NullAudio_AccumulateSamples(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples)
+{
+	UInt32 theSampleIndex = 0;
+#if NullAudio_HasVectorUnit
+	for(; (theSampleIndex + 4) <= inNumberSamples; theSampleIndex += 4)
+	{
+		NullAudio_FloatVector_Store(ioDestination + theSampleIndex, NullAudio_FloatVector_Add(NullAudio_FloatVector_Load(ioDestination + theSampleIndex), NullAudio_FloatVector_Load(inSource + theSampleIndex)));
+	}
+#endif
+	for(; theSampleIndex < inNumberSamples; ++theSampleIndex)
+	{
+		ioDestination[theSampleIndex] += inSource[theSampleIndex];
+	}
+}
+
+#pragma mark Telemetry
+
+//	Each device keeps timing statistics about its IO so that a monitoring tool can check on the
+//	health of the IO path through kPlugIn_CustomPropertyID. The IO thread records how long each IO
+//	cycle takes, how far the start of each cycle is from where the nominal buffer size says it
+//	should be, how many cycles took longer than a buffer's worth of time and how long each IO
+//	operation takes. Each statistic goes into a histogram with a bucket per power of two host ticks.
+//	The IO thread is the only writer, so recording is just a few relaxed atomic operations, with no
+//	locks or allocation. The property code reads the histograms lock-free too, which means that a
+//	snapshot taken while IO is running may be off by a cycle or so, which is fine for monitoring.
+
+static UInt32	NullAudio_GetTelemetryOperation(UInt32 inOperationID)
+{
+	UInt32 theAnswer = kTelemetry_NumberOperations;
+	switch(inOperationID)
+	{
+		case kAudioServerPlugInIOOperationReadInput:
+			theAnswer = kTelemetry_Operation_ReadInput;
+			break;
+			
+		case kAudioServerPlugInIOOperationConvertInput:
+			theAnswer = kTelemetry_Operation_ConvertInput;
+			break;
+			
+		case kAudioServerPlugInIOOperationMixOutput:
+			theAnswer = kTelemetry_Operation_MixOutput;
+			break;
+			
+		case kAudioServerPlugInIOOperationConvertMix:
+			theAnswer = kTelemetry_Operation_ConvertMix;
+			break;
+			
+		case kAudioServerPlugInIOOperationWriteMix:
+			theAnswer = kTelemetry_Operation_WriteMix;
+			break;
+	};
+	return theAnswer;
+}
+
+static void	NullAudio_RecordHistogramValue(NullAudio_Histogram* inHistogram, UInt64 inValue)
+{
+	//	Bucket 0 holds zero and bucket i holds values in [2^(i - 1), 2^i). The last bucket also holds
+	//	everything bigger than that.
+	UInt32 theBucket = (inValue == 0) ? 0 : (UInt32)(64 - __builtin_clzll(inValue));
+	if(theBucket >= kTelemetry_NumberBuckets)
+	{
+		theBucket = kTelemetry_NumberBuckets - 1;
+	}
+	atomic_fetch_add_explicit(&inHistogram->mBuckets[theBucket], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&inHistogram->mNumberValues, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&inHistogram->mTotal, inValue, memory_order_relaxed);
+	if(inValue > atomic_load_explicit(&inHistogram->mMaximum, memory_order_relaxed))
+	{
+		atomic_store_explicit(&inHistogram->mMaximum, inValue, memory_order_relaxed);
+	}
+}
+
+static void	NullAudio_ResetHistogram(NullAudio_Histogram* inHistogram)
+{
+	for(UInt32 theBucket = 0; theBucket < kTelemetry_NumberBuckets; ++theBucket)
+	{
+		atomic_store_explicit(&inHistogram->mBuckets[theBucket], 0, memory_order_relaxed);
+	}
+	atomic_store_explicit(&inHistogram->mNumberValues, 0, memory_order_relaxed);
+	atomic_store_explicit(&inHistogram->mTotal, 0, memory_order_relaxed);
+	atomic_store_explicit(&inHistogram->mMaximum, 0, memory_order_relaxed);
+}
+
+static void	NullAudio_ResetTelemetry(NullAudio_Telemetry* inTelemetry)
+{
+	//	This must not be called while IO is running.
+	NullAudio_ResetHistogram(&inTelemetry->mCycleDuration);
+	NullAudio_ResetHistogram(&inTelemetry->mCycleJitter);
+	for(UInt32 theOperation = 0; theOperation < kTelemetry_NumberOperations; ++theOperation)
+	{
+		NullAudio_ResetHistogram(&inTelemetry->mOperationDuration[theOperation]);
+		inTelemetry->mOperationStartTime[theOperation] = 0;
+	}
+	atomic_store_explicit(&inTelemetry->mNumberOverloads, 0, memory_order_relaxed);
+	inTelemetry->mCycleStartTime = 0;
+	inTelemetry->mLastCycleStartTime = 0;
+}
+
+static void	NullAudio_SetDictionaryNumber(CFMutableDictionaryRef inDictionary, CFStringRef inKey, CFNumberType inNumberType, const void* inValue)
+{
+	CFNumberRef theNumber = CFNumberCreate(NULL, inNumberType, inValue);
+	if(theNumber != NULL)
+	{
+		CFDictionarySetValue(inDictionary, inKey, theNumber);
+		CFRelease(theNumber);
+	}
+}
+
+static CFDictionaryRef	NullAudio_CopyHistogramDictionary(const NullAudio_Histogram* inHistogram, Float64 inNanosecondsPerHostTick)
+{
+	//	The histogram is reported in nanoseconds. The buckets are an array of counts along with an
+	//	array of the upper bound of each bucket.
+	CFMutableDictionaryRef theAnswer = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	if(theAnswer != NULL)
+	{
+		SInt64 theNumberValues = (SInt64)atomic_load_explicit(&inHistogram->mNumberValues, memory_order_relaxed);
+		Float64 theMean = (theNumberValues > 0) ? (((Float64)atomic_load_explicit(&inHistogram->mTotal, memory_order_relaxed) / (Float64)theNumberValues) * inNanosecondsPerHostTick) : 0.0;
+		Float64 theMaximum = (Float64)atomic_load_explicit(&inHistogram->mMaximum, memory_order_relaxed) * inNanosecondsPerHostTick;
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("count"), kCFNumberSInt64Type, &theNumberValues);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("mean ns"), kCFNumberFloat64Type, &theMean);
+		NullAudio_SetDictionaryNumber(theAnswer, CFSTR("max ns"), kCFNumberFloat64Type, &theMaximum);
+		
+		CFMutableArrayRef theBuckets = CFArrayCreateMutable(NULL, kTelemetry_NumberBuckets, &kCFTypeArrayCallBacks);
+		CFMutableArrayRef theBucketLimits = CFArrayCreateMutable(NULL, kTelemetry_NumberBuckets, &kCFTypeArrayCallBacks);
+		if((theBuckets != NULL) && (theBucketLimits != NULL))
+		{
+			for(UInt32 theBucket = 0; theBucket < kTelemetry_NumberBuckets; ++theBucket)
+			{
+				SInt64 theCount = (SInt64)atomic_load_explicit(&inHistogram->mBuckets[theBucket], memory_order_relaxed);
+				Float64 theLimit = (Float64)(1ULL << theBucket) * inNanosecondsPerHostTick;
+				CFNumberRef theCountNumber = CFNumberCreate(NULL, kCFNumberSInt64Type, &theCount);
+				CFNumberRef theLimitNumber = CFNumberCreate(NULL, kCFNumberFloat64Type, &theLimit);
+				if((theCountNumber != NULL) && (theLimitNumber != NULL))
+				{
+					CFArrayAppendValue(theBuckets, theCountNumber);
+					CFArrayAppendValue(theBucketLimits, theLimitNumber);
+				}
+				if(theCountNumber != NULL)
+				{
+					CFRelease(theCountNumber);
+				}
+				if(theLimitNumber != NULL)
+				{
+					CFRelease(theLimitNumber);
+				}
+			}
+			CFDictionarySetValue(theAnswer, CFSTR("buckets"), theBuckets);
+			CFDictionarySetValue(theAnswer, CFSTR("bucket limits ns"), theBucketLimits);
+		}
+		if(theBuckets != NULL)
+		{
+			CFRelease(theBuckets);
+		}
+		if(theBucketLimits != NULL)
+		{
+			CFRelease(theBucketLimits);
+		}
+	}
+	return theAnswer;
+}
+
+static CFDictionaryRef	NullAudio_CopyTelemetryDictionary(CFStringRef inDeviceUID)
+{
+	//	This returns a dictionary with an entry for each device keyed by the device's UID along with
+	//	the notification counters. If inDeviceUID isn't NULL, only that device is included.
+	const CFStringRef theOperationNames[kTelemetry_NumberOperations] = { CFSTR("ReadInput"), CFSTR("ConvertInput"), CFSTR("MixOutput"), CFSTR("ConvertMix"), CFSTR("WriteMix") };
+	
+	Float64 theNanosecondsPerHostTick = NullAudio_GetNanosecondsPerHostTick();
+	CFMutableDictionaryRef theAnswer = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	if(theAnswer != NULL)
+	{
+		pthread_mutex_lock(&gPlugIn_StateMutex);
+		for(UInt32 theSlot = 0; theSlot < kPlugIn_MaxNumberDevices; ++theSlot)
+		{
+			NullAudio_Device* theDevice = &gDevices[theSlot];
+			if(atomic_load_explicit(&theDevice->mIsAlive, memory_order_acquire) && ((inDeviceUID == NULL) || CFEqual(inDeviceUID, theDevice->mUID)))
+			{
+				CFMutableDictionaryRef theDeviceTelemetry = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+				CFMutableDictionaryRef theOperations = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+				if((theDeviceTelemetry != NULL) && (theOperations != NULL))
+				{
+					SInt64 theNumberOverloads = (SInt64)atomic_load_explicit(&theDevice->mTelemetry.mNumberOverloads, memory_order_relaxed);
+					NullAudio_SetDictionaryNumber(theDeviceTelemetry, CFSTR("overloads"), kCFNumberSInt64Type, &theNumberOverloads);
+					
+					CFDictionaryRef theHistogram = NullAudio_CopyHistogramDictionary(&theDevice->mTelemetry.mCycleDuration, theNanosecondsPerHostTick);
+					if(theHistogram != NULL)
+					{
+						CFDictionarySetValue(theDeviceTelemetry, CFSTR("cycle duration"), theHistogram);
+						CFRelease(theHistogram);
+					}
+					theHistogram = NullAudio_CopyHistogramDictionary(&theDevice->mTelemetry.mCycleJitter, theNanosecondsPerHostTick);
+					if(theHistogram != NULL)
+					{
+						CFDictionarySetValue(theDeviceTelemetry, CFSTR("cycle jitter"), theHistogram);
+						CFRelease(theHistogram);
+					}
+					for(UInt32 theOperation = 0; theOperation < kTelemetry_NumberOperations; ++theOperation)
+					{
+						theHistogram = NullAudio_CopyHistogramDictionary(&theDevice->mTelemetry.mOperationDuration[theOperation], theNanosecondsPerHostTick);
+						if(theHistogram != NULL)
+						{
+							CFDictionarySetValue(theOperations, theOperationNames[theOperation], theHistogram);
+							CFRelease(theHistogram);
+						}
+					}
+					CFDictionarySetValue(theDeviceTelemetry, CFSTR("operations"), theOperations);
+					CFDictionarySetValue(theAnswer, theDevice->mUID, theDeviceTelemetry);
+				}
+				if(theDeviceTelemetry != NULL)
+				{
+					CFRelease(theDeviceTelemetry);
+				}
+				if(theOperations != NULL)
+				{
+					CFRelease(theOperations);
+				}
+			}
+		}
+		pthread_mutex_unlock(&gPlugIn_StateMutex);
+		
+		if(inDeviceUID == NULL)
+		{
+			CFMutableDictionaryRef theNotifications = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+			if(theNotifications != NULL)
+			{
+				SInt64 theNumberEmitted = (SInt64)atomic_load_explicit(&gNotification_NumberEmitted, memory_order_relaxed);
+				SInt64 theNumberSuppressed = (SInt64)atomic_load_explicit(&gNotification_NumberSuppressed, memory_order_relaxed);
+				SInt64 theNumberDropped = (SInt64)atomic_load_explicit(&gNotification_NumberDropped, memory_order_relaxed);
+				NullAudio_SetDictionaryNumber(theNotifications, CFSTR("emitted"), kCFNumberSInt64Type, &theNumberEmitted);
+				NullAudio_SetDictionaryNumber(theNotifications, CFSTR("suppressed"), kCFNumberSInt64Type, &theNumberSuppressed);
+				NullAudio_SetDictionaryNumber(theNotifications, CFSTR("dropped"), kCFNumberSInt64Type, &theNumberDropped);
+				CFDictionarySetValue(theAnswer, CFSTR("notifications"), theNotifications);
+				CFRelease(theNotifications);
+			}
+		}
+	}
+	return theAnswer;
+}
+
+#pragma mark Sample Conversion
+
+//	The HAL mixes in 32 bit float, so when the physical format is an integer format, the driver
+//	converts between the two in the ConvertInput and ConvertMix operations. Both conversions are
+//	done in place in the IO buffer. Going from float to a narrower format, each sample is written at
+//	or before where it was read from, so ConvertFromFloat() works from the front to the back. Going
+//	the other way, each sample is written at or after where it was read from, so ConvertToFloat()
+//	works from the back to the front. In both cases, a whole vector is read before any of it is
+//	written, which is what keeps the vector loops safe.
+//
+//	Integer samples are scaled by 2^(bits - 1) so that -1.0 maps to the most negative integer. Float
+//	samples are clamped to the integer range after scaling and rounded to the nearest integer. Packed
+//	24 bit samples are three native endian bytes. There's no vector load or store for those, so the
+//	vector loops go through a small SInt32 array and the bytes are moved with scalar code.
+
+static const Float32	kSampleConversion_SInt16Scale		= 32768.0f;
+static const Float32	kSampleConversion_SInt16Maximum		= 32767.0f;
+static const Float32	kSampleConversion_SInt24Scale		= 8388608.0f;
+static const Float32	kSampleConversion_SInt24Maximum		= 8388607.0f;
+static const Float32	kSampleConversion_SInt32Scale		= 2147483648.0f;
+static const Float32	kSampleConversion_SInt32Maximum		= 2147483520.0f;	//	the largest float below 2^31
+
+static inline SInt32	NullAudio_ReadSInt24(const Byte* inSource)
+{
+	//	assemble the bytes into the top of an SInt32 and shift back down to sign extend
+	return ((SInt32)(((UInt32)inSource[0] << 8) | ((UInt32)inSource[1] << 16) | ((UInt32)inSource[2] << 24))) >> 8;
+}
+
+static inline void	NullAudio_WriteSInt24(Byte* outDestination, SInt32 inValue)
+{
+	outDestination[0] = (Byte)(inValue & 0xFF);
+	outDestination[1] = (Byte)((inValue >> 8) & 0xFF);
+	outDestination[2] = (Byte)((inValue >> 16) & 0xFF);
+}
+
+static inline SInt32	NullAudio_FloatToSInt(Float32 inValue, Float32 inScale, Float32 inMaximum)
+{
+	Float32 theValue = inValue * inScale;
+	theValue = (theValue < -inScale) ? -inScale : ((theValue > inMaximum) ? inMaximum : theValue);
+	return (SInt32)lrintf(theValue);
+}
+
+static void	NullAudio_ConvertToFloat(const void* inSource, UInt32 inSampleFormat, Float32* outDestination, UInt32 inNumberSamples)
+{
+	//	This works from the back of the buffer to the front so that it can be done in place. The
+	//	samples that don't fill a whole vector at the end are done first.
+	UInt32 theNumberVectorSamples = NullAudio_HasVectorUnit ? (inNumberSamples & ~3U) : 0;
+	UInt32 theSampleIndex = inNumberSamples;
+	switch(inSampleFormat)
+	{
+		case kSampleFormat_Float32:
+			if((const void*)outDestination != inSource)
+			{
+				memmove(outDestination, inSource, inNumberSamples * sizeof(Float32));
+			}
+			break;
+			
+		case kSampleFormat_SInt16:
+			for(; theSampleIndex > theNumberVectorSamples; --theSampleIndex)
+			{
+				outDestination[theSampleIndex - 1] = (Float32)((const SInt16*)inSource)[theSampleIndex - 1] / kSampleConversion_SInt16Scale;
+			}
+			#if NullAudio_HasVectorUnit
+				for(; theSampleIndex > 0; theSampleIndex -= 4)
+				{
+					NullAudio_IntVector theSamples = NullAudio_IntVector_LoadSInt16(((const SInt16*)inSource) + theSampleIndex - 4);
+					NullAudio_FloatVector_Store(outDestination + theSampleIndex - 4, NullAudio_FloatVector_Multiply(NullAudio_IntVector_ToFloat(theSamples), NullAudio_FloatVector_Splat(1.0f / kSampleConversion_SInt16Scale)));
+				}
+			#endif
+			break;
+			
+		case kSampleFormat_SInt24:
+			for(; theSampleIndex > theNumberVectorSamples; --theSampleIndex)
+			{
+				outDestination[theSampleIndex - 1] = (Float32)NullAudio_ReadSInt24(((const Byte*)inSource) + ((theSampleIndex - 1) * 3)) / kSampleConversion_SInt24Scale;
+			}
+			#if NullAudio_HasVectorUnit
+				for(; theSampleIndex > 0; theSampleIndex -= 4)
+				{
+					SInt32 theSamples[4];
+					for(UInt32 theLane = 0; theLane < 4; ++theLane)
+					{
+						theSamples[theLane] = NullAudio_ReadSInt24(((const Byte*)inSource) + ((theSampleIndex - 4 + theLane) * 3));
+					}
+					NullAudio_FloatVector_Store(outDestination + theSampleIndex - 4, NullAudio_FloatVector_Multiply(NullAudio_IntVector_ToFloat(NullAudio_IntVector_Load(theSamples)), NullAudio_FloatVector_Splat(1.0f / kSampleConversion_SInt24Scale)));
+				}
+			#endif
+			break;
+			
+		case kSampleFormat_SInt32:
+			for(; theSampleIndex > theNumberVectorSamples; --theSampleIndex)
+			{
+				outDestination[theSampleIndex - 1] = (Float32)((const SInt32*)inSource)[theSampleIndex - 1] / kSampleConversion_SInt32Scale;
+			}
+			#if NullAudio_HasVectorUnit
+				for(; theSampleIndex > 0; theSampleIndex -= 4)
+				{
+					NullAudio_IntVector theSamples = NullAudio_IntVector_Load(((const SInt32*)inSource) + theSampleIndex - 4);
+					NullAudio_FloatVector_Store(outDestination + theSampleIndex - 4, NullAudio_FloatVector_Multiply(NullAudio_IntVector_ToFloat(theSamples), NullAudio_FloatVector_Splat(1.0f / kSampleConversion_SInt32Scale)));
+				}
+			#endif
+			break;
+	};
+}
+
+static void	NullAudio_ConvertFromFloat(const Float32* inSource, UInt32 inSampleFormat, void* outDestination, UInt32 inNumberSamples)
+{
+	//	This works from the front of the buffer to the back so that it can be done in place. The
+	//	samples that don't fill a whole vector at the end are done last.
+	UInt32 theNumberVectorSamples = NullAudio_HasVectorUnit ? (inNumberSamples & ~3U) : 0;
+	UInt32 theSampleIndex = 0;
+	switch(inSampleFormat)
+	{
+		case kSampleFormat_Float32:
+			if(outDestination != (const void*)inSource)
+			{
+				memmove(outDestination, inSource, inNumberSamples * sizeof(Float32));
+			}
+			break;
+			
+		case kSampleFormat_SInt16:
+			#if NullAudio_HasVectorUnit
+				for(; theSampleIndex < theNumberVectorSamples; theSampleIndex += 4)
+				{
+					NullAudio_FloatVector theSamples = NullAudio_FloatVector_Multiply(NullAudio_FloatVector_Load(inSource + theSampleIndex), NullAudio_FloatVector_Splat(kSampleConversion_SInt16Scale));
+					NullAudio_IntVector_StoreSInt16(((SInt16*)outDestination) + theSampleIndex, NullAudio_FloatVector_Round(NullAudio_FloatVector_Clamp(theSamples, -kSampleConversion_SInt16Scale, kSampleConversion_SInt16Maximum)));
+				}
+			#endif
+			for(; theSampleIndex < inNumberSamples; ++theSampleIndex)
+			{
+				((SInt16*)outDestination)[theSampleIndex] = (SInt16)NullAudio_FloatToSInt(inSource[theSampleIndex], kSampleConversion_SInt16Scale, kSampleConversion_SInt16Maximum);
+			}
+			break;
+			
+		case kSampleFormat_SInt24:
+			#if NullAudio_HasVectorUnit
+				for(; theSampleIndex < theNumberVectorSamples; theSampleIndex += 4)
+				{
+					SInt32 theSamples[4];
+					NullAudio_FloatVector theFloatSamples = NullAudio_FloatVector_Multiply(NullAudio_FloatVector_Load(inSource + theSampleIndex), NullAudio_FloatVector_Splat(kSampleConversion_SInt24Scale));
+					NullAudio_IntVector_Store(theSamples, NullAudio_FloatVector_Round(NullAudio_FloatVector_Clamp(theFloatSamples, -kSampleConversion_SInt24Scale, kSampleConversion_SInt24Maximum)));
+					for(UInt32 theLane = 0; theLane < 4; ++theLane)
+					{
+						NullAudio_WriteSInt24(((Byte*)outDestination) + ((theSampleIndex + theLane) * 3), theSamples[theLane]);
+					}
+				}
+			#endif
+			for(; theSampleIndex < inNumberSamples; ++theSampleIndex)
+			{
+				NullAudio_WriteSInt24(((Byte*)outDestination) + (theSampleIndex * 3), NullAudio_FloatToSInt(inSource[theSampleIndex], kSampleConversion_SInt24Scale, kSampleConversion_SInt24Maximum));
+			}
+			break;
+			
+		case kSampleFormat_SInt32:
+			#if NullAudio_HasVectorUnit
+				for(; theSampleIndex < theNumberVectorSamples; theSampleIndex += 4)
+				{
+					NullAudio_FloatVector theSamples = NullAudio_FloatVector_Multiply(NullAudio_FloatVector_Load(inSource + theSampleIndex), NullAudio_FloatVector_Splat(kSampleConversion_SInt32Scale));
+					NullAudio_IntVector_Store(((SInt32*)outDestination) + theSampleIndex, NullAudio_FloatVector_Round(NullAudio_FloatVector_Clamp(theSamples, -kSampleConversion_SInt32Scale, kSampleConversion_SInt32Maximum)));
+				}
+			#endif
+			for(; theSampleIndex < inNumberSamples; ++theSampleIndex)
+			{
+				((SInt32*)outDestination)[theSampleIndex] = NullAudio_FloatToSInt(inSource[theSampleIndex], kSampleConversion_SInt32Scale, kSampleConversion_SInt32Maximum);
+			}
+			break;
+	};
+}
+
+#pragma mark Factory
+
+void*	NullAudio_Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID)
+{
+	//	This is the CFPlugIn factory function. Its job is to create the implementation for the given
+	//	type provided that the type is supported. Because this driver is simple and all its
+	//	initialization is handled via static iniitalization when the bundle is loaded, all that
+	//	needs to be done is to return the AudioServerPlugInDriverRef that points to the driver's
+	//	interface. A more complicated driver would create any base line objects it needs to satisfy
+	//	the IUnknown methods that are used to discover that actual interface to talk to the driver.
+	//	The majority of the driver's initilization should be handled in the Initialize() method of
+	//	the driver's AudioServerPlugInDriverInterface.
+	
+	#pragma unused(inAllocator)
+    void* theAnswer = NULL;
+    if(CFEqual(inRequestedTypeUUID, kAudioServerPlugInTypeUUID))
+    {
+		theAnswer = gAudioServerPlugInDriverRef;
+    }
+    return theAnswer;
+}
+
+#pragma mark Inheritence
+
+static HRESULT	NullAudio_QueryInterface(void* inDriver, REFIID inUUID, LPVOID* outInterface)
+{
+	//	This function is called by the HAL to get the interface to talk to the plug-in through.
+	//	AudioServerPlugIns are required to support the IUnknown interface and the
+	//	AudioServerPlugInDriverInterface. As it happens, all interfaces must also provide the
+	//	IUnknown interface, so we can always just return the single interface we made with
+	//	gAudioServerPlugInDriverInterfacePtr regardless of which one is asked for.
+
+	//	declare the local variables
+	HRESULT theAnswer = 0;
+	CFUUIDRef theRequestedUUID = NULL;
+	
+	//	validate the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_QueryInterface: bad driver reference");
+	FailWithAction(outInterface == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_QueryInterface: no place to store the returned interface");
+
+	//	make a CFUUIDRef from inUUID
+	theRequestedUUID = CFUUIDCreateFromUUIDBytes(NULL, inUUID);
+	FailWithAction(theRequestedUUID == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_QueryInterface: failed to create the CFUUIDRef");
+
+	//	AudioServerPlugIns only support two interfaces, IUnknown (which has to be supported by all
+	//	CFPlugIns and AudioServerPlugInDriverInterface (which is the actual interface the HAL will
+	//	use).
+	if(CFEqual(theRequestedUUID, IUnknownUUID) || CFEqual(theRequestedUUID, kAudioServerPlugInDriverInterfaceUUID))
+	{
+		pthread_mutex_lock(&gPlugIn_StateMutex);
+		++gPlugIn_RefCount;
+		pthread_mutex_unlock(&gPlugIn_StateMutex);
+		*outInterface = gAudioServerPlugInDriverRef;
+	}
+	else
+	{
+		theAnswer = E_NOINTERFACE;
+	}
+	
+	//	make sure to release the UUID we created
+	CFRelease(theRequestedUUID);
+		
+Done:
+	return theAnswer;
+}
+
+static ULONG	NullAudio_AddRef(void* inDriver)
+{
+	//	This call returns the resulting reference count after the increment.
+	
+	//	declare the local variables
+	ULONG theAnswer = 0;
+	
+	//	check the arguments
+	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_AddRef: bad driver reference");
+
+	//	decrement the refcount
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	if(gPlugIn_RefCount < UINT32_MAX)
+	{
+		++gPlugIn_RefCount;
+	}
+	theAnswer = gPlugIn_RefCount;
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+
+Done:
+	return theAnswer;
+}
+
+static ULONG	NullAudio_Release(void* inDriver)
+{
+	//	This call returns the resulting reference count after the decrement.
+
+	//	declare the local variables
+	ULONG theAnswer = 0;
+	
+	//	check the arguments
+	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_Release: bad driver reference");
+
+	//	increment the refcount
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	if(gPlugIn_RefCount > 0)
+	{
+		--gPlugIn_RefCount;
+		//	Note that we don't do anything special if the refcount goes to zero as the HAL
+		//	will never fully release a plug-in it opens. We keep managing the refcount so that
+		//	the API semantics are correct though.
+	}
+	theAnswer = gPlugIn_RefCount;
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+
+Done:
+	return theAnswer;
+}
+
+#pragma mark Basic Operations
+
+static OSStatus	NullAudio_Initialize(AudioServerPlugInDriverRef inDriver, AudioServerPlugInHostRef inHost)
+{
+	//	The job of this method is, as the name implies, to get the driver initialized. One specific
+	//	thing that needs to be done is to store the AudioServerPlugInHostRef so that it can be used
+	//	later. Note that when this call returns, the HAL will scan the various lists the driver
+	//	maintains (such as the device list) to get the inital set of objects the driver is
+	//	publishing. So, there is no need to notifiy the HAL about any objects created as part of the
+	//	execution of this method.
+
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_Initialize: bad driver reference");
+	
+	//	store the AudioServerPlugInHostRef
+	gPlugIn_Host = inHost;
+	
+	//	make the queues that property change notifications and settings are written from
+	gNotification_Queue = dispatch_queue_create("com.apple.audio.NullAudio.notifications", DISPATCH_QUEUE_SERIAL);
+	gSettings_Queue = dispatch_queue_create("com.apple.audio.NullAudio.settings", DISPATCH_QUEUE_SERIAL);
+	
+	//	read all the settings at once
+	CFPropertyListRef theSettingsData = NULL;
+	CFDictionaryRef theSettings = NULL;
+	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR(kSettings_Key), &theSettingsData);
+	if((theSettingsData != NULL) && (CFGetTypeID(theSettingsData) == CFDictionaryGetTypeID()))
+	{
+		theSettings = (CFDictionaryRef)theSettingsData;
+	}
+	
+	//	initialize the box acquired property from the settings
+	SInt32 theValue = 0;
+	if(NullAudio_GetSettingsNumber(theSettings, CFSTR("box acquired"), kCFNumberSInt32Type, &theValue))
+	{
+		gBox_Acquired = theValue ? 1 : 0;
+	}
+	
+	//	initialize the box name from the settings
+	CFTypeRef theBoxName = (theSettings != NULL) ? CFDictionaryGetValue(theSettings, CFSTR("box name")) : NULL;
+	if((theBoxName != NULL) && (CFGetTypeID(theBoxName) == CFStringGetTypeID()))
+	{
+		gBox_Name = (CFStringRef)theBoxName;
+		CFRetain(gBox_Name);
+	}
+	
+	//	set the box name directly as a last resort
+	if(gBox_Name == NULL)
+	{
+		gBox_Name = CFSTR("Null Box");
+	}
+	
+	//	hang on to the device settings so that each device can restore its own when it is allocated
+	CFTypeRef theDeviceSettings = (theSettings != NULL) ? CFDictionaryGetValue(theSettings, CFSTR("devices")) : NULL;
+	if((theDeviceSettings != NULL) && (CFGetTypeID(theDeviceSettings) == CFDictionaryGetTypeID()))
+	{
+		gSettings_Devices = (CFDictionaryRef)theDeviceSettings;
+		CFRetain(gSettings_Devices);
+	}
+	
+	//	set up the device slots
+	for(UInt32 theSlot = 0; theSlot < kPlugIn_MaxNumberDevices; ++theSlot)
+	{
+		pthread_mutex_init(&gDevices[theSlot].mStateMutex, NULL);
+		gDevices[theSlot].mSlot = theSlot;
+		gDevices[theSlot].mObjectID = kObjectID_Device + (theSlot * kDevice_NumberObjectIDs);
+	}
+	
+	//	create the devices in the slots that were in use when the settings were saved, so that each
+	//	one comes back with its own UID and settings. Settings from before the slots were saved only
+	//	have a count, which always meant the first slots. With no settings, there is just the one
+	//	device.
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	CFTypeRef theDeviceSlots = (theSettings != NULL) ? CFDictionaryGetValue(theSettings, CFSTR("device slots")) : NULL;
+	if((theDeviceSlots != NULL) && (CFGetTypeID(theDeviceSlots) == CFArrayGetTypeID()))
+	{
+		CFIndex theNumberSlots = CFArrayGetCount((CFArrayRef)theDeviceSlots);
+		for(CFIndex theSlotIndex = 0; theSlotIndex < theNumberSlots; ++theSlotIndex)
+		{
+			CFTypeRef theSlotNumber = CFArrayGetValueAtIndex((CFArrayRef)theDeviceSlots, theSlotIndex);
+			if((theSlotNumber != NULL) && (CFGetTypeID(theSlotNumber) == CFNumberGetTypeID()) && CFNumberGetValue((CFNumberRef)theSlotNumber, kCFNumberSInt32Type, &theValue) && (theValue >= 0) && (theValue < kPlugIn_MaxNumberDevices))
+			{
+				NullAudio_AllocateDevice((UInt32)theValue);
+			}
+		}
+	}
+	else
+	{
+		UInt32 theNumberDevices = 1;
+		if(NullAudio_GetSettingsNumber(theSettings, CFSTR("device count"), kCFNumberSInt32Type, &theValue))
+		{
+			theNumberDevices = (theValue < 0) ? 0 : ((theValue > kPlugIn_MaxNumberDevices) ? kPlugIn_MaxNumberDevices : (UInt32)theValue);
+		}
+		for(UInt32 theDeviceIndex = 0; theDeviceIndex < theNumberDevices; ++theDeviceIndex)
+		{
+			NullAudio_AllocateDevice(theDeviceIndex);
+		}
+	}
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	if(theSettingsData != NULL)
+	{
+		CFRelease(theSettingsData);
+	}
+	
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_CreateDevice(AudioServerPlugInDriverRef inDriver, CFDictionaryRef inDescription, const AudioServerPlugInClientInfo* inClientInfo, AudioObjectID* outDeviceObjectID)
+{
+	//	This method is used to tell a driver that implements the Transport Manager semantics to
+	//	create an AudioEndpointDevice from a set of AudioEndpoints. This driver is not a Transport
+	//	Manager, so it ignores the description. But it does use this method to publish another
+	//	instance of its device, up to kPlugIn_MaxNumberDevices of them in total. The new device gets
+	//	the object IDs that belong to the first free slot.
+	
+	#pragma unused(inDescription, inClientInfo)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NULL;
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_CreateDevice: bad driver reference");
+	FailWithAction(outDeviceObjectID == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_CreateDevice: no place to put the new device's object ID");
+	
+	//	allocate the device
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	theDevice = NullAudio_AllocateDevice(kPlugIn_AnyDeviceSlot);
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	FailWithAction(theDevice == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_CreateDevice: all the device slots are in use");
+	*outDeviceObjectID = theDevice->mObjectID;
+	
+	//	save the new set of devices and tell the HAL about the new device
+	NullAudio_SettingsChanged();
+	NullAudio_DeviceListChanged();
+
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_DestroyDevice(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID)
+{
+	//	This method is used to tell a driver that implements the Transport Manager semantics to
+	//	destroy an AudioEndpointDevice. For this driver, it is the counterpart to
+	//	NullAudio_CreateDevice() and it just frees the device's slot. A device that is still doing IO
+	//	can't be destroyed, since the slot could then be handed to a new device while an IO thread is
+	//	still using it.
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DestroyDevice: bad driver reference");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DestroyDevice: bad device ID");
+	
+	//	free the device, checking that IO is stopped under the device's lock so IO can't start in between
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	pthread_mutex_lock(&theDevice->mStateMutex);
+	if(theDevice->mIOIsRunning != 0)
+	{
+		theAnswer = kAudioHardwareIllegalOperationError;
+	}
+	else
+	{
+		NullAudio_FreeDevice(theDevice);
+	}
+	pthread_mutex_unlock(&theDevice->mStateMutex);
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	FailIf(theAnswer != 0, Done, "NullAudio_DestroyDevice: IO is running on the device");
 	
-	#pragma unused(inClientInfo)
+	//	save the new set of devices and tell the HAL that the device is gone
+	NullAudio_SettingsChanged();
+	NullAudio_DeviceListChanged();
+
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_AddDeviceClient(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
+{
+	//	This method is used to inform the driver about a new client that is using the given device.
+	//	This allows the device to act differently depending on who the client is. This driver keeps
+	//	some per-client state for the mixing it does, so the client is added to the device's table.
+	//	Note that a client that doesn't fit in the table still works. Its output still gets mixed,
+	//	it just doesn't have any per-client state.
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	NullAudio_Client* theClient = NULL;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_AddDeviceClient: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_AddDeviceClient: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_AddDeviceClient: bad device ID");
+	FailWithAction(inClientInfo == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_AddDeviceClient: no client info");
+	
+	//	find a free slot in the table
+	pthread_mutex_lock(&theDevice->mStateMutex);
+	for(UInt32 theClientIndex = 0; (theClient == NULL) && (theClientIndex < kDevice_MaxNumberClients); ++theClientIndex)
+	{
+		if(!atomic_load_explicit(&theDevice->mClients[theClientIndex].mIsInUse, memory_order_relaxed))
+		{
+			theClient = &theDevice->mClients[theClientIndex];
+		}
+	}
+	if(theClient != NULL)
+	{
+		//	fill out the slot and then publish it to the IO thread
+		theClient->mClientID = inClientInfo->mClientID;
+		theClient->mProcessID = inClientInfo->mProcessID;
+		theClient->mMixCycleCounter = 0;
+		theClient->mNumberFramesMixed = 0;
+		atomic_store_explicit(&theClient->mIsInUse, true, memory_order_release);
+	}
+	pthread_mutex_unlock(&theDevice->mStateMutex);
+	if(theClient == NULL)
+	{
+		DebugMsg("NullAudio_AddDeviceClient: the client table is full");
+	}
 
 Done:
 	return theAnswer;
@@ -502,17 +2500,28 @@ Done:
 static OSStatus	NullAudio_RemoveDeviceClient(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
 {
 	//	This method is used to inform the driver about a client that is no longer using the given
-	//	device. This driver does not track clients, so we just check the arguments and return
-	//	successfully.
-	
-	#pragma unused(inClientInfo)
+	//	device. This just frees up the client's slot in the table. The HAL has stopped IO for the
+	//	client by this point, so the IO thread isn't using the slot.
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_RemoveDeviceClient: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_RemoveDeviceClient: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_RemoveDeviceClient: bad device ID");
+	FailWithAction(inClientInfo == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_RemoveDeviceClient: no client info");
+	
+	//	free the client's slot
+	pthread_mutex_lock(&theDevice->mStateMutex);
+	for(UInt32 theClientIndex = 0; theClientIndex < kDevice_MaxNumberClients; ++theClientIndex)
+	{
+		if(atomic_load_explicit(&theDevice->mClients[theClientIndex].mIsInUse, memory_order_relaxed) && (theDevice->mClients[theClientIndex].mClientID == inClientInfo->mClientID))
+		{
+			atomic_store_explicit(&theDevice->mClients[theClientIndex].mIsInUse, false, memory_order_release);
+		}
+	}
+	pthread_mutex_unlock(&theDevice->mStateMutex);
 
 Done:
 	return theAnswer;
@@ -530,37 +2539,63 @@ static OSStatus	NullAudio_PerformDeviceConfigurationChange(AudioServerPlugInDriv
 	//	means that the only notifications that would need to be sent here would be for either
 	//	custom properties the HAL doesn't know about or for controls.
 	//
-	//	For the device implemented by this driver, only sample rate changes go through this process
-	//	as it is the only state that can be changed for the device that isn't a control. For this
-	//	change, the new sample rate is passed in the inChangeAction argument.
-	
-	#pragma unused(inChangeInfo)
+	//	For the device implemented by this driver, only sample rate and stream format changes go
+	//	through this process as they are the only state that can be changed for the device that isn't
+	//	a control. For a sample rate change, the new sample rate is passed in the inChangeAction
+	//	argument and inChangeInfo is NULL. For a format change, inChangeInfo points to a
+	//	NullAudio_FormatChange that has to be freed here.
 
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	NullAudio_FormatChange theNewFormat;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad device ID");
-	FailWithAction((inChangeAction != 44100) && (inChangeAction != 48000), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad sample rate");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad device ID");
+	FailWithAction((inChangeInfo == NULL) && !NullAudio_IsSupportedSampleRate((Float64)inChangeAction), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad sample rate");
 	
 	//	lock the state mutex
-	pthread_mutex_lock(&gPlugIn_StateMutex);
+	pthread_mutex_lock(&theDevice->mStateMutex);
 	
-	//	change the sample rate
-	gDevice_SampleRate = inChangeAction;
+	//	figure out the new format
+	theNewFormat.mSampleRate = (Float64)inChangeAction;
+	theNewFormat.mSampleFormat = theDevice->mSampleFormat;
+	theNewFormat.mChannelsPerFrame = theDevice->mChannelsPerFrame;
+	if(inChangeInfo != NULL)
+	{
+		theNewFormat = *((const NullAudio_FormatChange*)inChangeInfo);
+	}
 	
-	//	recalculate the state that depends on the sample rate
-	struct mach_timebase_info theTimeBaseInfo;
-	mach_timebase_info(&theTimeBaseInfo);
-	Float64 theHostClockFrequency = (Float64)theTimeBaseInfo.denom / (Float64)theTimeBaseInfo.numer;
-	theHostClockFrequency *= 1000000000.0;
-	gDevice_HostTicksPerFrame = theHostClockFrequency / gDevice_SampleRate;
+	//	make sure the rings are big enough for the new format
+	theAnswer = NullAudio_ReserveLoopbackRingBuffer(theDevice, theNewFormat.mChannelsPerFrame * NullAudio_GetBytesPerSample(theNewFormat.mSampleFormat));
+	if(theAnswer == 0)
+	{
+		theAnswer = NullAudio_ReservePlayThruRingBuffer(theDevice, theNewFormat.mChannelsPerFrame);
+	}
+	if(theAnswer == 0)
+	{
+		//	change the format
+		theDevice->mSampleRate = theNewFormat.mSampleRate;
+		theDevice->mSampleFormat = theNewFormat.mSampleFormat;
+		theDevice->mChannelsPerFrame = theNewFormat.mChannelsPerFrame;
+		
+		//	recalculate the state that depends on the sample rate
+		NullAudio_PublishClockAnchor(theDevice, atomic_load_explicit(&theDevice->mAnchorHostTime, memory_order_relaxed), 0.0, NullAudio_GetHostTicksPerRingBuffer(theDevice->mSampleRate));
+		
+		//	the sample rate is one of the saved settings
+		NullAudio_SettingsChanged();
+	}
+	else
+	{
+		DebugMsg("NullAudio_PerformDeviceConfigurationChange: failed to allocate the ring buffers");
+	}
 
 	//	unlock the state mutex
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	pthread_mutex_unlock(&theDevice->mStateMutex);
 	
 Done:
+	free(inChangeInfo);
 	return theAnswer;
 }
 
@@ -568,19 +2603,21 @@ static OSStatus	NullAudio_AbortDeviceConfigurationChange(AudioServerPlugInDriver
 {
 	//	This method is called to tell the driver that a request for a config change has been denied.
 	//	This provides the driver an opportunity to clean up any state associated with the request.
-	//	For this driver, an aborted config change requires no action. So we just check the arguments
-	//	and return
+	//	For this driver, the only thing to clean up is the NullAudio_FormatChange that goes with a
+	//	format change.
 
-	#pragma unused(inChangeAction, inChangeInfo)
+	#pragma unused(inChangeAction)
 
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_PerformDeviceConfigurationChange: bad device ID");
 
 Done:
+	free(inChangeInfo);
 	return theAnswer;
 }
 
@@ -592,6 +2629,7 @@ static Boolean	NullAudio_HasProperty(AudioServerPlugInDriverRef inDriver, AudioO
 	
 	//	declare the local variables
 	Boolean theAnswer = false;
+	const NullAudio_PropertyHandlers* theHandlers = NullAudio_GetPropertyHandlers(inObjectID);
 	
 	//	check the arguments
 	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasProperty: bad driver reference");
@@ -600,35 +2638,10 @@ static Boolean	NullAudio_HasProperty(AudioServerPlugInDriverRef inDriver, AudioO
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required. There is more detailed commentary about each
 	//	property in the NullAudio_GetPropertyData() method.
-	switch(inObjectID)
+	if(theHandlers != NULL)
 	{
-		case kObjectID_PlugIn:
-			theAnswer = NullAudio_HasPlugInProperty(inDriver, inObjectID, inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Box:
-			theAnswer = NullAudio_HasBoxProperty(inDriver, inObjectID, inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Device:
-			theAnswer = NullAudio_HasDeviceProperty(inDriver, inObjectID, inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			theAnswer = NullAudio_HasStreamProperty(inDriver, inObjectID, inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			theAnswer = NullAudio_HasControlProperty(inDriver, inObjectID, inClientProcessID, inAddress);
-			break;
-	};
+		theAnswer = theHandlers->mHasProperty(inDriver, inObjectID, inClientProcessID, inAddress);
+	}
 
 Done:
 	return theAnswer;
@@ -638,51 +2651,27 @@ static OSStatus	NullAudio_IsPropertySettable(AudioServerPlugInDriverRef inDriver
 {
 	//	This method returns whether or not the given property on the object can have its value
 	//	changed.
-	
-	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsPropertySettable: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPropertySettable: no address");
-	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPropertySettable: no place to put the return value");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetPropertyData() method.
-	switch(inObjectID)
-	{
-		case kObjectID_PlugIn:
-			theAnswer = NullAudio_IsPlugInPropertySettable(inDriver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Box:
-			theAnswer = NullAudio_IsBoxPropertySettable(inDriver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Device:
-			theAnswer = NullAudio_IsDevicePropertySettable(inDriver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			theAnswer = NullAudio_IsStreamPropertySettable(inDriver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			theAnswer = NullAudio_IsControlPropertySettable(inDriver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-				
-		default:
-			theAnswer = kAudioHardwareBadObjectError;
-			break;
-	};
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyHandlers* theHandlers = NullAudio_GetPropertyHandlers(inObjectID);
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsPropertySettable: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPropertySettable: no address");
+	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPropertySettable: no place to put the return value");
+	
+	//	Note that for each object, this driver implements all the required properties plus a few
+	//	extras that are useful but not required. There is more detailed commentary about each
+	//	property in the NullAudio_GetPropertyData() method.
+	if(theHandlers != NULL)
+	{
+		theAnswer = theHandlers->mIsPropertySettable(inDriver, inObjectID, inClientProcessID, inAddress, outIsSettable);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareBadObjectError;
+	}
 
 Done:
 	return theAnswer;
@@ -694,6 +2683,7 @@ static OSStatus	NullAudio_GetPropertyDataSize(AudioServerPlugInDriverRef inDrive
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	const NullAudio_PropertyHandlers* theHandlers = NullAudio_GetPropertyHandlers(inObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPropertyDataSize: bad driver reference");
@@ -703,39 +2693,14 @@ static OSStatus	NullAudio_GetPropertyDataSize(AudioServerPlugInDriverRef inDrive
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required. There is more detailed commentary about each
 	//	property in the NullAudio_GetPropertyData() method.
-	switch(inObjectID)
+	if(theHandlers != NULL)
 	{
-		case kObjectID_PlugIn:
-			theAnswer = NullAudio_GetPlugInPropertyDataSize(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Box:
-			theAnswer = NullAudio_GetBoxPropertyDataSize(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Device:
-			theAnswer = NullAudio_GetDevicePropertyDataSize(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			theAnswer = NullAudio_GetStreamPropertyDataSize(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			theAnswer = NullAudio_GetControlPropertyDataSize(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-				
-		default:
-			theAnswer = kAudioHardwareBadObjectError;
-			break;
-	};
+		theAnswer = theHandlers->mGetPropertyDataSize(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareBadObjectError;
+	}
 
 Done:
 	return theAnswer;
@@ -745,6 +2710,7 @@ static OSStatus	NullAudio_GetPropertyData(AudioServerPlugInDriverRef inDriver, A
 {
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	const NullAudio_PropertyHandlers* theHandlers = NullAudio_GetPropertyHandlers(inObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPropertyData: bad driver reference");
@@ -757,39 +2723,14 @@ static OSStatus	NullAudio_GetPropertyData(AudioServerPlugInDriverRef inDriver, A
 	//
 	//	Also, since most of the data that will get returned is static, there are few instances where
 	//	it is necessary to lock the state mutex.
-	switch(inObjectID)
+	if(theHandlers != NULL)
 	{
-		case kObjectID_PlugIn:
-			theAnswer = NullAudio_GetPlugInPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Box:
-			theAnswer = NullAudio_GetBoxPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Device:
-			theAnswer = NullAudio_GetDevicePropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			theAnswer = NullAudio_GetStreamPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			theAnswer = NullAudio_GetControlPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-				
-		default:
-			theAnswer = kAudioHardwareBadObjectError;
-			break;
-	};
+		theAnswer = theHandlers->mGetPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareBadObjectError;
+	}
 
 Done:
 	return theAnswer;
@@ -799,6 +2740,7 @@ static OSStatus	NullAudio_SetPropertyData(AudioServerPlugInDriverRef inDriver, A
 {
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	const NullAudio_PropertyHandlers* theHandlers = NullAudio_GetPropertyHandlers(inObjectID);
 	UInt32 theNumberPropertiesChanged = 0;
 	AudioObjectPropertyAddress theChangedAddresses[2];
 	
@@ -809,44 +2751,20 @@ static OSStatus	NullAudio_SetPropertyData(AudioServerPlugInDriverRef inDriver, A
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required. There is more detailed commentary about each
 	//	property in the NullAudio_GetPropertyData() method.
-	switch(inObjectID)
+	if(theHandlers != NULL)
 	{
-		case kObjectID_PlugIn:
-			theAnswer = NullAudio_SetPlugInPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Box:
-			theAnswer = NullAudio_SetBoxPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Device:
-			theAnswer = NullAudio_SetDevicePropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			theAnswer = NullAudio_SetStreamPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			theAnswer = NullAudio_SetControlPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-				
-		default:
-			theAnswer = kAudioHardwareBadObjectError;
-			break;
-	};
+		theAnswer = theHandlers->mSetPropertyData(inDriver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareBadObjectError;
+	}
 
-	//	send any notifications
+	//	queue up any notifications, and since something changed, the settings need to be saved
 	if(theNumberPropertiesChanged > 0)
 	{
-		gPlugIn_Host->PropertiesChanged(gPlugIn_Host, inObjectID, theNumberPropertiesChanged, theChangedAddresses);
+		NullAudio_QueuePropertiesChanged(inObjectID, theNumberPropertiesChanged, theChangedAddresses);
+		NullAudio_SettingsChanged();
 	}
 
 Done:
@@ -855,184 +2773,134 @@ Done:
 
 #pragma mark PlugIn Property Operations
 
-static Boolean	NullAudio_HasPlugInProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+//	The plug-in owns the box, and each of the devices once the box has been acquired.
+static OSStatus	NullAudio_GetPlugInOwnedObjectsDataSize(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
 {
-	//	This method returns whether or not the plug-in object has the given property.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	Boolean theAnswer = false;
-	
-	//	check the arguments
-	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasPlugInProperty: bad driver reference");
-	FailIf(inAddress == NULL, Done, "NullAudio_HasPlugInProperty: no address");
-	FailIf(inObjectID != kObjectID_PlugIn, Done, "NullAudio_HasPlugInProperty: not the plug-in object");
-	
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetPlugInPropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioPlugInPropertyBoxList:
-		case kAudioPlugInPropertyTranslateUIDToBox:
-		case kAudioPlugInPropertyDeviceList:
-		case kAudioPlugInPropertyTranslateUIDToDevice:
-		case kAudioPlugInPropertyResourceBundle:
-		case kAudioObjectPropertyCustomPropertyInfoList:
-		case kPlugIn_CustomPropertyID:
-			theAnswer = true;
-			break;
-	};
+	#pragma unused(inObjectID, inAddress, inQualifierDataSize, inQualifierData)
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	*outDataSize = (1 + (gBox_Acquired ? NullAudio_CopyDeviceList(NULL, 0) : 0)) * sizeof(AudioObjectID);
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	return 0;
+}
 
-Done:
-	return theAnswer;
+//	The plug-in and the box both list the devices, but only while the box is acquired.
+static OSStatus	NullAudio_GetDeviceListDataSize(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	#pragma unused(inObjectID, inAddress, inQualifierDataSize, inQualifierData)
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	*outDataSize = (gBox_Acquired ? NullAudio_CopyDeviceList(NULL, 0) : 0) * sizeof(AudioObjectID);
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	return 0;
 }
 
-static OSStatus	NullAudio_IsPlugInPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+//	The custom property's qualifier is optional, but it has to be a property list if it's there.
+static OSStatus	NullAudio_GetPlugInCustomPropertyDataSize(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
 {
-	//	This method returns whether or not the given property on the plug-in object can have its
-	//	value changed.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
+	#pragma unused(inObjectID, inAddress, inQualifierData)
 	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsPlugInPropertySettable: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPlugInPropertySettable: no address");
-	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPlugInPropertySettable: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_PlugIn, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsPlugInPropertySettable: not the plug-in object");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetPlugInPropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioPlugInPropertyBoxList:
-		case kAudioPlugInPropertyTranslateUIDToBox:
-		case kAudioPlugInPropertyDeviceList:
-		case kAudioPlugInPropertyTranslateUIDToDevice:
-		case kAudioPlugInPropertyResourceBundle:
-		case kAudioObjectPropertyCustomPropertyInfoList:
-			*outIsSettable = false;
-			break;
-		
-		case kPlugIn_CustomPropertyID:
-			*outIsSettable = true;
-			break;
-		
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
-
+	FailWithAction((inQualifierDataSize != 0) && (inQualifierDataSize != sizeof(CFPropertyListRef)), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInCustomPropertyDataSize: the qualifier is the wrong size for kPlugIn_CustomPropertyID");
+	*outDataSize = sizeof(CFPropertyListRef);
 Done:
 	return theAnswer;
 }
 
-static OSStatus	NullAudio_GetPlugInPropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+static const NullAudio_PropertyInfo	kPlugIn_Properties[] =
 {
-	//	This method returns the byte size of the property's data.
-	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus theAnswer = 0;
+	{ kAudioObjectPropertyBaseClass,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),							false,	NULL },
+	{ kAudioObjectPropertyClass,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),							false,	NULL },
+	{ kAudioObjectPropertyOwner,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),							false,	NULL },
+	{ kAudioObjectPropertyManufacturer,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),							false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,				kPropertyScope_Any,	kPropertyElement_Any,	0,												false,	NullAudio_GetPlugInOwnedObjectsDataSize },
+	{ kAudioPlugInPropertyBoxList,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),							false,	NULL },
+	{ kAudioPlugInPropertyTranslateUIDToBox,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),							false,	NULL },
+	{ kAudioPlugInPropertyDeviceList,				kPropertyScope_Any,	kPropertyElement_Any,	0,												false,	NullAudio_GetDeviceListDataSize },
+	{ kAudioPlugInPropertyTranslateUIDToDevice,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),							false,	NULL },
+	{ kAudioPlugInPropertyResourceBundle,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),							false,	NULL },
+	{ kAudioObjectPropertyCustomPropertyInfoList,	kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioServerPlugInCustomPropertyInfo),	false,	NULL },
+	{ kPlugIn_CustomPropertyID,						kPropertyScope_Any,	kPropertyElement_Any,	0,												true,	NullAudio_GetPlugInCustomPropertyDataSize },
+};
+
+static Boolean	NullAudio_HasPlugInProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+{
+	//	This method returns whether or not the plug-in object has the given property.
 	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPlugInPropertyDataSize: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetPlugInPropertyDataSize: no address");
-	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetPlugInPropertyDataSize: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_PlugIn, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPlugInPropertyDataSize: not the plug-in object");
+	#pragma unused(inClientProcessID)
 	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetPlugInPropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-			if(gBox_Acquired)
-			{
-				*outDataSize = 2 * sizeof(AudioClassID);
-			}
-			else
-			{
-				*outDataSize = sizeof(AudioClassID);
-			}
-			break;
-			
-		case kAudioPlugInPropertyBoxList:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioPlugInPropertyTranslateUIDToBox:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioPlugInPropertyDeviceList:
-			if(gBox_Acquired)
-			{
-				*outDataSize = sizeof(AudioClassID);
-			}
-			else
-			{
-				*outDataSize = 0;
-			}
-			break;
-			
-		case kAudioPlugInPropertyTranslateUIDToDevice:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioPlugInPropertyResourceBundle:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyCustomPropertyInfoList:
-			*outDataSize = sizeof(AudioServerPlugInCustomPropertyInfo);
-			break;
-			
-		case kPlugIn_CustomPropertyID:
-			FailWithAction(inQualifierDataSize != sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyDataSize: the qualifier is the wrong size for kPlugIn_CustomPropertyID");
-			FailWithAction(inQualifierData == NULL, theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyDataSize: no qualifier for kPlugIn_CustomPropertyID");
-			DebugMsg("NullAudio_GetPlugInPropertyDataSize: the qualifier passed to us was:");
-			CFShow(*((CFPropertyListRef*)inQualifierData));
-			*outDataSize = sizeof(CFPropertyListRef);
-			break;
-			
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+	//	declare the local variables
+	Boolean theAnswer = false;
+	
+	//	check the arguments
+	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasPlugInProperty: bad driver reference");
+	FailIf(inAddress == NULL, Done, "NullAudio_HasPlugInProperty: no address");
+	FailIf(inObjectID != kObjectID_PlugIn, Done, "NullAudio_HasPlugInProperty: not the plug-in object");
+	
+	//	Note that for each object, this driver implements all the required properties plus a few
+	//	extras that are useful but not required. There is more detailed commentary about each
+	//	property in the NullAudio_GetPlugInPropertyData() method.
+	theAnswer = NullAudio_FindPropertyInfo(kPlugIn_Properties, NullAudio_NumberProperties(kPlugIn_Properties), inAddress) != NULL;
+
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_IsPlugInPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+{
+	//	This method returns whether or not the given property on the plug-in object can have its value
+	//	changed.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsPlugInPropertySettable: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPlugInPropertySettable: no address");
+	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsPlugInPropertySettable: no place to put the return value");
+	FailWithAction(inObjectID != kObjectID_PlugIn, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsPlugInPropertySettable: not the plug-in object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kPlugIn_Properties, NullAudio_NumberProperties(kPlugIn_Properties), inAddress);
+	if(theInfo != NULL)
+	{
+		*outIsSettable = theInfo->mIsSettable;
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
+
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_GetPlugInPropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	//	This method returns the byte size of the property's data.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPlugInPropertyDataSize: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetPlugInPropertyDataSize: no address");
+	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetPlugInPropertyDataSize: no place to put the return value");
+	FailWithAction(inObjectID != kObjectID_PlugIn, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPlugInPropertyDataSize: not the plug-in object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kPlugIn_Properties, NullAudio_NumberProperties(kPlugIn_Properties), inAddress);
+	if(theInfo != NULL)
+	{
+		theAnswer = NullAudio_GetPropertyInfoDataSize(theInfo, inObjectID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -1045,6 +2913,8 @@ static OSStatus	NullAudio_GetPlugInPropertyData(AudioServerPlugInDriverRef inDri
 	//	declare the local variables
 	OSStatus theAnswer = 0;
 	UInt32 theNumberItemsToFetch;
+	UInt32 theNumberDevices;
+	CFStringRef theDeviceUID;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetPlugInPropertyData: bad driver reference");
@@ -1094,21 +2964,18 @@ static OSStatus	NullAudio_GetPlugInPropertyData(AudioServerPlugInDriverRef inDri
 			//	case, only that number of items will be returned
 			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
 			
-			//	Clamp that to the number of boxes this driver implements (which is just 1)
-			if(theNumberItemsToFetch > (gBox_Acquired ? 2 : 1))
-			{
-				theNumberItemsToFetch = (gBox_Acquired ? 2 : 1);
-			}
-			
-			//	Write the devices' object IDs into the return value
-			if(theNumberItemsToFetch > 1)
-			{
-				((AudioObjectID*)outData)[0] = kObjectID_Box;
-				((AudioObjectID*)outData)[0] = kObjectID_Device;
-			}
-			else if(theNumberItemsToFetch > 0)
+			//	The plug-in owns the box and, if the box has been acquired, the devices. Write the
+			//	box's object ID first followed by as many of the devices' as will fit.
+			if(theNumberItemsToFetch > 0)
 			{
 				((AudioObjectID*)outData)[0] = kObjectID_Box;
+				pthread_mutex_lock(&gPlugIn_StateMutex);
+				theNumberDevices = gBox_Acquired ? NullAudio_CopyDeviceList(((AudioObjectID*)outData) + 1, theNumberItemsToFetch - 1) : 0;
+				pthread_mutex_unlock(&gPlugIn_StateMutex);
+				if(theNumberItemsToFetch > (1 + theNumberDevices))
+				{
+					theNumberItemsToFetch = 1 + theNumberDevices;
+				}
 			}
 			
 			//	Return how many bytes we wrote to
@@ -1163,17 +3030,15 @@ static OSStatus	NullAudio_GetPlugInPropertyData(AudioServerPlugInDriverRef inDri
 			//	case, only that number of items will be returned
 			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
 			
-			//	Clamp that to the number of devices this driver implements (which is just 1 if the
-			//	box has been acquired)
-			if(theNumberItemsToFetch > (gBox_Acquired ? 1 : 0))
-			{
-				theNumberItemsToFetch = (gBox_Acquired ? 1 : 0);
-			}
-			
-			//	Write the devices' object IDs into the return value
-			if(theNumberItemsToFetch > 0)
+			//	Write the devices' object IDs into the return value and clamp that to the number
+			//	of devices this driver has published (which is none if the box hasn't been
+			//	acquired)
+			pthread_mutex_lock(&gPlugIn_StateMutex);
+			theNumberDevices = gBox_Acquired ? NullAudio_CopyDeviceList((AudioObjectID*)outData, theNumberItemsToFetch) : 0;
+			pthread_mutex_unlock(&gPlugIn_StateMutex);
+			if(theNumberItemsToFetch > theNumberDevices)
 			{
-				((AudioObjectID*)outData)[0] = kObjectID_Device;
+				theNumberItemsToFetch = theNumberDevices;
 			}
 			
 			//	Return how many bytes we wrote to
@@ -1182,20 +3047,21 @@ static OSStatus	NullAudio_GetPlugInPropertyData(AudioServerPlugInDriverRef inDri
 			
 		case kAudioPlugInPropertyTranslateUIDToDevice:
 			//	This property takes the CFString passed in the qualifier and converts that
-			//	to the object ID of the device it corresponds to. For this driver, there is
-			//	just the one device. Note that it is not an error if the string in the
+			//	to the object ID of the device it corresponds to. For this driver, that means
+			//	checking the UID of each device. Note that it is not an error if the string in the
 			//	qualifier doesn't match any devices. In such case, kAudioObjectUnknown is
 			//	the object ID to return.
 			FailWithAction(inDataSize < sizeof(AudioObjectID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: not enough space for the return value of kAudioPlugInPropertyTranslateUIDToDevice");
 			FailWithAction(inQualifierDataSize != sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: the qualifier is the wrong size for kAudioPlugInPropertyTranslateUIDToDevice");
 			FailWithAction(inQualifierData == NULL, theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: no qualifier for kAudioPlugInPropertyTranslateUIDToDevice");
-			if(CFStringCompare(*((CFStringRef*)inQualifierData), CFSTR(kDevice_UID), 0) == kCFCompareEqualTo)
-			{
-				*((AudioObjectID*)outData) = kObjectID_Device;
-			}
-			else
+			*((AudioObjectID*)outData) = kAudioObjectUnknown;
+			for(UInt32 theSlot = 0; theSlot < kPlugIn_MaxNumberDevices; ++theSlot)
 			{
-				*((AudioObjectID*)outData) = kAudioObjectUnknown;
+				if(atomic_load_explicit(&gDevices[theSlot].mIsAlive, memory_order_acquire) && (CFStringCompare(*((CFStringRef*)inQualifierData), gDevices[theSlot].mUID, 0) == kCFCompareEqualTo))
+				{
+					*((AudioObjectID*)outData) = gDevices[theSlot].mObjectID;
+					break;
+				}
 			}
 			*outDataSize = sizeof(AudioObjectID);
 			break;
@@ -1212,23 +3078,30 @@ static OSStatus	NullAudio_GetPlugInPropertyData(AudioServerPlugInDriverRef inDri
 		case kAudioObjectPropertyCustomPropertyInfoList:
 			//	This property returns an array of AudioServerPlugInCustomPropertyInfo's that
 			//	describe the type of data used by any custom properties. For this example,
-			//	the plug-in supports a single property whose data type is a CFString and
-			//	whose qualifier is a CFString.
+			//	the plug-in supports a single property whose data type is a property list (the
+			//	telemetry dictionary) and whose qualifier is a property list.
 			FailWithAction(inDataSize < sizeof(AudioServerPlugInCustomPropertyInfo), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: not enough space for the return value of kAudioObjectPropertyCustomPropertyInfoList");
 			((AudioServerPlugInCustomPropertyInfo*)outData)->mSelector = kPlugIn_CustomPropertyID;
-			((AudioServerPlugInCustomPropertyInfo*)outData)->mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFString;
+			((AudioServerPlugInCustomPropertyInfo*)outData)->mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFPropertyList;
 			((AudioServerPlugInCustomPropertyInfo*)outData)->mQualifierDataType = kAudioServerPlugInCustomPropertyDataTypeCFPropertyList;
 			*outDataSize = sizeof(AudioServerPlugInCustomPropertyInfo);
 			break;
 			
 		case kPlugIn_CustomPropertyID:
-			FailWithAction(inDataSize < sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: not enough space for the return value of kPlugIn_CustomPropertyID");
-			FailWithAction(inQualifierDataSize != sizeof(CFPropertyListRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: the qualifier is the wrong size for kPlugIn_CustomPropertyID");
-			FailWithAction(inQualifierData == NULL, theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: no qualifier for kPlugIn_CustomPropertyID");
-			DebugMsg("NullAudio_GetPlugInPropertyData: the qualifier passed to us was:");
-			CFShow(*((CFPropertyListRef*)inQualifierData));
-			*((CFStringRef*)outData) = CFSTR("NullAudio PlugIn Custom Property");
-			*outDataSize = sizeof(CFStringRef);
+			//	This property returns the IO telemetry as a dictionary with an entry for each device
+			//	keyed by its UID plus the property change notification counters under
+			//	"notifications". If the qualifier is a device UID, only that device is included.
+			//	Note that the caller is responsible for releasing the returned dictionary.
+			FailWithAction(inDataSize < sizeof(CFPropertyListRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: not enough space for the return value of kPlugIn_CustomPropertyID");
+			FailWithAction((inQualifierDataSize != 0) && (inQualifierDataSize != sizeof(CFPropertyListRef)), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetPlugInPropertyData: the qualifier is the wrong size for kPlugIn_CustomPropertyID");
+			theDeviceUID = NULL;
+			if((inQualifierDataSize == sizeof(CFPropertyListRef)) && (inQualifierData != NULL) && (*((CFPropertyListRef*)inQualifierData) != NULL) && (CFGetTypeID(*((CFPropertyListRef*)inQualifierData)) == CFStringGetTypeID()))
+			{
+				theDeviceUID = *((CFStringRef*)inQualifierData);
+			}
+			*((CFPropertyListRef*)outData) = NullAudio_CopyTelemetryDictionary(theDeviceUID);
+			FailWithAction(*((CFPropertyListRef*)outData) == NULL, theAnswer = kAudioHardwareUnspecifiedError, Done, "NullAudio_GetPlugInPropertyData: couldn't create the telemetry dictionary");
+			*outDataSize = sizeof(CFPropertyListRef);
 			break;
 			
 		default:
@@ -1263,13 +3136,13 @@ static OSStatus	NullAudio_SetPlugInPropertyData(AudioServerPlugInDriverRef inDri
 	switch(inAddress->mSelector)
 	{
 		case kPlugIn_CustomPropertyID:
-			FailWithAction(inDataSize != sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetPlugInPropertyData: not enough space for the return value of kPlugIn_CustomPropertyID");
+			FailWithAction(inDataSize != sizeof(CFPropertyListRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetPlugInPropertyData: not enough space for the return value of kPlugIn_CustomPropertyID");
 			FailWithAction(inQualifierDataSize != sizeof(CFPropertyListRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetPlugInPropertyData: the qualifier is the wrong size for kPlugIn_CustomPropertyID");
 			FailWithAction(inQualifierData == NULL, theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetPlugInPropertyData: no qualifier for kPlugIn_CustomPropertyID");
 			DebugMsg("NullAudio_SetPlugInPropertyData: the qualifier passed to us was:");
 			CFShow(*((CFPropertyListRef*)inQualifierData));
 			DebugMsg("NullAudio_SetPlugInPropertyData: the data passed to us was:");
-			CFShow(*((CFStringRef*)inData));
+			CFShow(*((CFPropertyListRef*)inData));
 			break;
 			
 		default:
@@ -1283,6 +3156,29 @@ Done:
 
 #pragma mark Box Property Operations
 
+static const NullAudio_PropertyInfo	kBox_Properties[] =
+{
+	{ kAudioObjectPropertyBaseClass,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),	false,	NULL },
+	{ kAudioObjectPropertyClass,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),	false,	NULL },
+	{ kAudioObjectPropertyOwner,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),	false,	NULL },
+	{ kAudioObjectPropertyName,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),	true,	NULL },
+	{ kAudioObjectPropertyModelName,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),	false,	NULL },
+	{ kAudioObjectPropertyManufacturer,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),	false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,		kPropertyScope_Any,	kPropertyElement_Any,	0,						false,	NULL },
+	{ kAudioObjectPropertyIdentify,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			true,	NULL },
+	{ kAudioObjectPropertySerialNumber,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),	false,	NULL },
+	{ kAudioObjectPropertyFirmwareVersion,	kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),	false,	NULL },
+	{ kAudioBoxPropertyBoxUID,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),	false,	NULL },
+	{ kAudioBoxPropertyTransportType,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			false,	NULL },
+	{ kAudioBoxPropertyHasAudio,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			false,	NULL },
+	{ kAudioBoxPropertyHasVideo,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			false,	NULL },
+	{ kAudioBoxPropertyHasMIDI,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			false,	NULL },
+	{ kAudioBoxPropertyIsProtected,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			false,	NULL },
+	{ kAudioBoxPropertyAcquired,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			true,	NULL },
+	{ kAudioBoxPropertyAcquisitionFailed,	kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),			false,	NULL },
+	{ kAudioBoxPropertyDeviceList,			kPropertyScope_Any,	kPropertyElement_Any,	0,						false,	NullAudio_GetDeviceListDataSize },
+};
+
 static Boolean	NullAudio_HasBoxProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
 {
 	//	This method returns whether or not the box object has the given property.
@@ -1297,34 +3193,10 @@ static Boolean	NullAudio_HasBoxProperty(AudioServerPlugInDriverRef inDriver, Aud
 	FailIf(inAddress == NULL, Done, "NullAudio_HasBoxProperty: no address");
 	FailIf(inObjectID != kObjectID_Box, Done, "NullAudio_HasBoxProperty: not the box object");
 	
-	
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required. There is more detailed commentary about each
 	//	property in the NullAudio_GetBoxPropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyModelName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioObjectPropertyIdentify:
-		case kAudioObjectPropertySerialNumber:
-		case kAudioObjectPropertyFirmwareVersion:
-		case kAudioBoxPropertyBoxUID:
-		case kAudioBoxPropertyTransportType:
-		case kAudioBoxPropertyHasAudio:
-		case kAudioBoxPropertyHasVideo:
-		case kAudioBoxPropertyHasMIDI:
-		case kAudioBoxPropertyIsProtected:
-		case kAudioBoxPropertyAcquired:
-		case kAudioBoxPropertyAcquisitionFailed:
-		case kAudioBoxPropertyDeviceList:
-			theAnswer = true;
-			break;
-	};
+	theAnswer = NullAudio_FindPropertyInfo(kBox_Properties, NullAudio_NumberProperties(kBox_Properties), inAddress) != NULL;
 
 Done:
 	return theAnswer;
@@ -1332,54 +3204,31 @@ Done:
 
 static OSStatus	NullAudio_IsBoxPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
 {
-	//	This method returns whether or not the given property on the plug-in object can have its
-	//	value changed.
+	//	This method returns whether or not the given property on the box object can have its value
+	//	changed.
 	
 	#pragma unused(inClientProcessID)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsBoxPropertySettable: bad driver reference");
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsBoxPropertySettable: no address");
 	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsBoxPropertySettable: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_Box, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsBoxPropertySettable: not the plug-in object");
+	FailWithAction(inObjectID != kObjectID_Box, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsBoxPropertySettable: not the box object");
 	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetBoxPropertyData() method.
-	switch(inAddress->mSelector)
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kBox_Properties, NullAudio_NumberProperties(kBox_Properties), inAddress);
+	if(theInfo != NULL)
 	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyModelName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioObjectPropertySerialNumber:
-		case kAudioObjectPropertyFirmwareVersion:
-		case kAudioBoxPropertyBoxUID:
-		case kAudioBoxPropertyTransportType:
-		case kAudioBoxPropertyHasAudio:
-		case kAudioBoxPropertyHasVideo:
-		case kAudioBoxPropertyHasMIDI:
-		case kAudioBoxPropertyIsProtected:
-		case kAudioBoxPropertyAcquisitionFailed:
-		case kAudioBoxPropertyDeviceList:
-			*outIsSettable = false;
-			break;
-		
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyIdentify:
-		case kAudioBoxPropertyAcquired:
-			*outIsSettable = true;
-			break;
-		
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+		*outIsSettable = theInfo->mIsSettable;
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -1389,106 +3238,28 @@ static OSStatus	NullAudio_GetBoxPropertyDataSize(AudioServerPlugInDriverRef inDr
 {
 	//	This method returns the byte size of the property's data.
 	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
+	#pragma unused(inClientProcessID)
 	
 	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetBoxPropertyDataSize: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetBoxPropertyDataSize: no address");
-	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetBoxPropertyDataSize: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_Box, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetBoxPropertyDataSize: not the plug-in object");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetBoxPropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyModelName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-			*outDataSize = 0;
-			break;
-			
-		case kAudioObjectPropertyIdentify:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioObjectPropertySerialNumber:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyFirmwareVersion:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioBoxPropertyBoxUID:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioBoxPropertyTransportType:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasAudio:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasVideo:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasMIDI:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyIsProtected:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyAcquired:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyAcquisitionFailed:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyDeviceList:
-			{
-				pthread_mutex_lock(&gPlugIn_StateMutex);
-				*outDataSize = gBox_Acquired ? sizeof(AudioObjectID) : 0;
-				pthread_mutex_unlock(&gPlugIn_StateMutex);
-			}
-			break;
-			
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetBoxPropertyDataSize: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetBoxPropertyDataSize: no address");
+	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetBoxPropertyDataSize: no place to put the return value");
+	FailWithAction(inObjectID != kObjectID_Box, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetBoxPropertyDataSize: not the box object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kBox_Properties, NullAudio_NumberProperties(kBox_Properties), inAddress);
+	if(theInfo != NULL)
+	{
+		theAnswer = NullAudio_GetPropertyInfoDataSize(theInfo, inObjectID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -1649,19 +3420,18 @@ static OSStatus	NullAudio_GetBoxPropertyData(AudioServerPlugInDriverRef inDriver
 			break;
 			
 		case kAudioBoxPropertyDeviceList:
-			//	This is used to indicate which devices came from this box
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			if(gBox_Acquired)
-			{
-				FailWithAction(inDataSize < sizeof(AudioObjectID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetBoxPropertyData: not enough space for the return value of kAudioBoxPropertyDeviceList for the box");
-				*((AudioObjectID*)outData) = kObjectID_Device;
-				*outDataSize = sizeof(AudioObjectID);
-			}
-			else
+			//	This is used to indicate which devices came from this box, which is all of them
 			{
-				*outDataSize = 0;
+				UInt32 theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
+				pthread_mutex_lock(&gPlugIn_StateMutex);
+				UInt32 theNumberDevices = gBox_Acquired ? NullAudio_CopyDeviceList((AudioObjectID*)outData, theNumberItemsToFetch) : 0;
+				pthread_mutex_unlock(&gPlugIn_StateMutex);
+				if(theNumberItemsToFetch > theNumberDevices)
+				{
+					theNumberItemsToFetch = theNumberDevices;
+				}
+				*outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
 			}
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
 			break;
 			
 		default:
@@ -1727,11 +3497,7 @@ static OSStatus	NullAudio_SetBoxPropertyData(AudioServerPlugInDriverRef inDriver
 			{
 				syslog(LOG_NOTICE, "The identify property has been set on the Box implemented by the NullAudio driver.");
 				FailWithAction(inDataSize != sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetBoxPropertyData: wrong size for the data for kAudioObjectPropertyIdentify");
-				dispatch_after(dispatch_time(0, 2ULL * 1000ULL * 1000ULL * 1000ULL), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),	^()
-																																		{
-																																			AudioObjectPropertyAddress theAddress = { kAudioObjectPropertyIdentify, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
-																																			gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_Box, 1, &theAddress);
-																																		});
+				dispatch_after_f(dispatch_time(0, 2ULL * 1000ULL * 1000ULL * 1000ULL), gNotification_Queue, NULL, NullAudio_SendIdentifyPropertyChanged);
 			}
 			break;
 			
@@ -1744,7 +3510,6 @@ static OSStatus	NullAudio_SetBoxPropertyData(AudioServerPlugInDriverRef inDriver
 				{
 					//	the new value is different from the old value, so save it
 					gBox_Acquired = *((UInt32*)inData) != 0;
-					gPlugIn_Host->WriteToStorage(gPlugIn_Host, CFSTR("box acquired"), gBox_Acquired ? kCFBooleanTrue : kCFBooleanFalse);
 					
 					//	and it means that this property and the device list property have changed
 					*outNumberPropertiesChanged = 2;
@@ -1756,11 +3521,8 @@ static OSStatus	NullAudio_SetBoxPropertyData(AudioServerPlugInDriverRef inDriver
 					outChangedAddresses[1].mElement = kAudioObjectPropertyElementMain;
 					
 					//	but it also means that the device list has changed for the plug-in too
-					dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),	^()
-																									{
-																										AudioObjectPropertyAddress theAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
-																										gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_PlugIn, 1, &theAddress);
-																									});
+					AudioObjectPropertyAddress thePlugInAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+					NullAudio_QueuePropertiesChanged(kObjectID_PlugIn, 1, &thePlugInAddress);
 				}
 				pthread_mutex_unlock(&gPlugIn_StateMutex);
 			}
@@ -1777,287 +3539,186 @@ Done:
 
 #pragma mark Device Property Operations
 
-static Boolean	NullAudio_HasDeviceProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
-{
-	//	This method returns whether or not the given object has the given property.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	Boolean theAnswer = false;
-	
-	//	check the arguments
-	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasDeviceProperty: bad driver reference");
-	FailIf(inAddress == NULL, Done, "NullAudio_HasDeviceProperty: no address");
-	FailIf(inObjectID != kObjectID_Device, Done, "NullAudio_HasDeviceProperty: not the device object");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetDevicePropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioDevicePropertyDeviceUID:
-		case kAudioDevicePropertyModelUID:
-		case kAudioDevicePropertyTransportType:
-		case kAudioDevicePropertyRelatedDevices:
-		case kAudioDevicePropertyClockDomain:
-		case kAudioDevicePropertyDeviceIsAlive:
-		case kAudioDevicePropertyDeviceIsRunning:
-		case kAudioObjectPropertyControlList:
-		case kAudioDevicePropertyNominalSampleRate:
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-		case kAudioDevicePropertyIsHidden:
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-		case kAudioDevicePropertyIcon:
-		case kAudioDevicePropertyStreams:
-			theAnswer = true;
-			break;
-			
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-		case kAudioDevicePropertyLatency:
-		case kAudioDevicePropertySafetyOffset:
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-		case kAudioDevicePropertyPreferredChannelLayout:
-			theAnswer = (inAddress->mScope == kAudioObjectPropertyScopeInput) || (inAddress->mScope == kAudioObjectPropertyScopeOutput);
-			break;
-		
-		case kAudioObjectPropertyElementName:
-			theAnswer = inAddress->mElement <= 2;
-			break;
-	};
-
-Done:
-	return theAnswer;
-}
-
-static OSStatus	NullAudio_IsDevicePropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
-{
-	//	This method returns whether or not the given property on the object can have its value
-	//	changed.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsDevicePropertySettable: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsDevicePropertySettable: no address");
-	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsDevicePropertySettable: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsDevicePropertySettable: not the device object");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetDevicePropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyElementName:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioDevicePropertyDeviceUID:
-		case kAudioDevicePropertyModelUID:
-		case kAudioDevicePropertyTransportType:
-		case kAudioDevicePropertyRelatedDevices:
-		case kAudioDevicePropertyClockDomain:
-		case kAudioDevicePropertyDeviceIsAlive:
-		case kAudioDevicePropertyDeviceIsRunning:
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-		case kAudioDevicePropertyLatency:
-		case kAudioDevicePropertyStreams:
-		case kAudioObjectPropertyControlList:
-		case kAudioDevicePropertySafetyOffset:
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-		case kAudioDevicePropertyIsHidden:
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-		case kAudioDevicePropertyPreferredChannelLayout:
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-		case kAudioDevicePropertyIcon:
-			*outIsSettable = false;
-			break;
-		
-		case kAudioDevicePropertyNominalSampleRate:
-			*outIsSettable = true;
-			break;
-		
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
-
-Done:
-	return theAnswer;
-}
-
-static OSStatus	NullAudio_GetDevicePropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+//	The device owns two streams and seven controls, half of each in each direction.
+static OSStatus	NullAudio_GetDeviceOwnedObjectsDataSize(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
 {
-	//	This method returns the byte size of the property's data.
-	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePropertyDataSize: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyDataSize: no address");
-	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyDataSize: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePropertyDataSize: not the device object");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetDevicePropertyData() method.
-	switch(inAddress->mSelector)
+	#pragma unused(inObjectID, inQualifierDataSize, inQualifierData)
+	switch(inAddress->mScope)
 	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyElementName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-			switch(inAddress->mScope)
-			{
-				case kAudioObjectPropertyScopeGlobal:
-					*outDataSize = 8 * sizeof(AudioObjectID);
-					break;
-					
-				case kAudioObjectPropertyScopeInput:
-					*outDataSize = 4 * sizeof(AudioObjectID);
-					break;
-					
-				case kAudioObjectPropertyScopeOutput:
-					*outDataSize = 4 * sizeof(AudioObjectID);
-					break;
-			};
-			break;
-
-		case kAudioDevicePropertyDeviceUID:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-
-		case kAudioDevicePropertyModelUID:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-
-		case kAudioDevicePropertyTransportType:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyRelatedDevices:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-
-		case kAudioDevicePropertyClockDomain:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyDeviceIsAlive:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-
-		case kAudioDevicePropertyDeviceIsRunning:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyLatency:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyStreams:
-			switch(inAddress->mScope)
-			{
-				case kAudioObjectPropertyScopeGlobal:
-					*outDataSize = 2 * sizeof(AudioObjectID);
-					break;
-					
-				case kAudioObjectPropertyScopeInput:
-					*outDataSize = 1 * sizeof(AudioObjectID);
-					break;
-					
-				case kAudioObjectPropertyScopeOutput:
-					*outDataSize = 1 * sizeof(AudioObjectID);
-					break;
-			};
-			break;
-
-		case kAudioObjectPropertyControlList:
-			*outDataSize = 7 * sizeof(AudioObjectID);
-			break;
-
-		case kAudioDevicePropertySafetyOffset:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioDevicePropertyNominalSampleRate:
-			*outDataSize = sizeof(Float64);
+		case kAudioObjectPropertyScopeGlobal:
+			*outDataSize = 8 * sizeof(AudioObjectID);
 			break;
-
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-			*outDataSize = 2 * sizeof(AudioValueRange);
+			
+		case kAudioObjectPropertyScopeInput:
+			*outDataSize = 4 * sizeof(AudioObjectID);
 			break;
-		
-		case kAudioDevicePropertyIsHidden:
-			*outDataSize = sizeof(UInt32);
+			
+		case kAudioObjectPropertyScopeOutput:
+			*outDataSize = 4 * sizeof(AudioObjectID);
 			break;
-
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-			*outDataSize = 2 * sizeof(UInt32);
+			
+		default:
+			*outDataSize = 0;
 			break;
+	};
+	return 0;
+}
 
-		case kAudioDevicePropertyPreferredChannelLayout:
-			*outDataSize = offsetof(AudioChannelLayout, mChannelDescriptions) + (2 * sizeof(AudioChannelDescription));
+static OSStatus	NullAudio_GetDeviceStreamsDataSize(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	#pragma unused(inObjectID, inQualifierDataSize, inQualifierData)
+	switch(inAddress->mScope)
+	{
+		case kAudioObjectPropertyScopeGlobal:
+			*outDataSize = 2 * sizeof(AudioObjectID);
 			break;
-
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-			*outDataSize = sizeof(UInt32);
+			
+		case kAudioObjectPropertyScopeInput:
+			*outDataSize = 1 * sizeof(AudioObjectID);
 			break;
-
-		case kAudioDevicePropertyIcon:
-			*outDataSize = sizeof(CFURLRef);
+			
+		case kAudioObjectPropertyScopeOutput:
+			*outDataSize = 1 * sizeof(AudioObjectID);
 			break;
-
+			
 		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
+			*outDataSize = 0;
 			break;
 	};
+	return 0;
+}
+
+//	The channel layout has a description per channel, and the channel count can change.
+static OSStatus	NullAudio_GetDevicePreferredChannelLayoutDataSize(AudioObjectID inObjectID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	#pragma unused(inAddress, inQualifierDataSize, inQualifierData)
+	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	FailWithAction(theDevice == NULL, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePreferredChannelLayoutDataSize: not a device object");
+	pthread_mutex_lock(&theDevice->mStateMutex);
+	*outDataSize = offsetof(AudioChannelLayout, mChannelDescriptions) + (theDevice->mChannelsPerFrame * sizeof(AudioChannelDescription));
+	pthread_mutex_unlock(&theDevice->mStateMutex);
+Done:
+	return theAnswer;
+}
+
+static const NullAudio_PropertyInfo	kDevice_Properties[] =
+{
+	{ kAudioObjectPropertyBaseClass,						kPropertyScope_Any,				kPropertyElement_Any,	sizeof(AudioClassID),									false,	NULL },
+	{ kAudioObjectPropertyClass,							kPropertyScope_Any,				kPropertyElement_Any,	sizeof(AudioClassID),									false,	NULL },
+	{ kAudioObjectPropertyOwner,							kPropertyScope_Any,				kPropertyElement_Any,	sizeof(AudioObjectID),									false,	NULL },
+	{ kAudioObjectPropertyName,								kPropertyScope_Any,				kPropertyElement_Any,	sizeof(CFStringRef),									false,	NULL },
+	{ kAudioObjectPropertyManufacturer,						kPropertyScope_Any,				kPropertyElement_Any,	sizeof(CFStringRef),									false,	NULL },
+	{ kAudioObjectPropertyElementName,						kPropertyScope_Any,				2,						sizeof(CFStringRef),									false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,						kPropertyScope_Any,				kPropertyElement_Any,	0,														false,	NullAudio_GetDeviceOwnedObjectsDataSize },
+	{ kAudioDevicePropertyDeviceUID,						kPropertyScope_Any,				kPropertyElement_Any,	sizeof(CFStringRef),									false,	NULL },
+	{ kAudioDevicePropertyModelUID,							kPropertyScope_Any,				kPropertyElement_Any,	sizeof(CFStringRef),									false,	NULL },
+	{ kAudioDevicePropertyTransportType,					kPropertyScope_Any,				kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyRelatedDevices,					kPropertyScope_Any,				kPropertyElement_Any,	sizeof(AudioObjectID),									false,	NULL },
+	{ kAudioDevicePropertyClockDomain,						kPropertyScope_Any,				kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyDeviceIsAlive,					kPropertyScope_Any,				kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyDeviceIsRunning,					kPropertyScope_Any,				kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyDeviceCanBeDefaultDevice,			kPropertyScope_InputOrOutput,	kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyDeviceCanBeDefaultSystemDevice,	kPropertyScope_InputOrOutput,	kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyLatency,							kPropertyScope_InputOrOutput,	kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyStreams,							kPropertyScope_Any,				kPropertyElement_Any,	0,														false,	NullAudio_GetDeviceStreamsDataSize },
+	{ kAudioObjectPropertyControlList,						kPropertyScope_Any,				kPropertyElement_Any,	7 * sizeof(AudioObjectID),								false,	NULL },
+	{ kAudioDevicePropertySafetyOffset,						kPropertyScope_InputOrOutput,	kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyNominalSampleRate,				kPropertyScope_Any,				kPropertyElement_Any,	sizeof(Float64),										true,	NULL },
+	{ kAudioDevicePropertyAvailableNominalSampleRates,		kPropertyScope_Any,				kPropertyElement_Any,	kDevice_NumberSampleRates * sizeof(AudioValueRange),	false,	NULL },
+	{ kAudioDevicePropertyIsHidden,							kPropertyScope_Any,				kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyPreferredChannelsForStereo,		kPropertyScope_InputOrOutput,	kPropertyElement_Any,	2 * sizeof(UInt32),										false,	NULL },
+	{ kAudioDevicePropertyPreferredChannelLayout,			kPropertyScope_InputOrOutput,	kPropertyElement_Any,	0,														false,	NullAudio_GetDevicePreferredChannelLayoutDataSize },
+	{ kAudioDevicePropertyZeroTimeStampPeriod,				kPropertyScope_Any,				kPropertyElement_Any,	sizeof(UInt32),											false,	NULL },
+	{ kAudioDevicePropertyIcon,								kPropertyScope_Any,				kPropertyElement_Any,	sizeof(CFURLRef),										false,	NULL },
+	{ kAudioObjectPropertyCustomPropertyInfoList,			kPropertyScope_Any,				kPropertyElement_Any,	sizeof(AudioServerPlugInCustomPropertyInfo),			false,	NULL },
+	{ kDevice_PlayThruLatencyPropertyID,					kPropertyScope_Any,				kPropertyElement_Any,	sizeof(CFPropertyListRef),								true,	NULL },
+};
+
+static Boolean	NullAudio_HasDeviceProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+{
+	//	This method returns whether or not the device object has the given property.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	Boolean theAnswer = false;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	
+	//	check the arguments
+	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasDeviceProperty: bad driver reference");
+	FailIf(inAddress == NULL, Done, "NullAudio_HasDeviceProperty: no address");
+	FailIf((theDevice == NULL) || (theDevice->mObjectID != inObjectID), Done, "NullAudio_HasDeviceProperty: not the device object");
+	
+	//	Note that for each object, this driver implements all the required properties plus a few
+	//	extras that are useful but not required. There is more detailed commentary about each
+	//	property in the NullAudio_GetDevicePropertyData() method.
+	theAnswer = NullAudio_FindPropertyInfo(kDevice_Properties, NullAudio_NumberProperties(kDevice_Properties), inAddress) != NULL;
+
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_IsDevicePropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+{
+	//	This method returns whether or not the given property on the device object can have its value
+	//	changed.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsDevicePropertySettable: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsDevicePropertySettable: no address");
+	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsDevicePropertySettable: no place to put the return value");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsDevicePropertySettable: not the device object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kDevice_Properties, NullAudio_NumberProperties(kDevice_Properties), inAddress);
+	if(theInfo != NULL)
+	{
+		*outIsSettable = theInfo->mIsSettable;
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
+
+Done:
+	return theAnswer;
+}
+
+static OSStatus	NullAudio_GetDevicePropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	//	This method returns the byte size of the property's data.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePropertyDataSize: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyDataSize: no address");
+	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyDataSize: no place to put the return value");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePropertyDataSize: not the device object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kDevice_Properties, NullAudio_NumberProperties(kDevice_Properties), inAddress);
+	if(theInfo != NULL)
+	{
+		theAnswer = NullAudio_GetPropertyInfoDataSize(theInfo, inObjectID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -2069,6 +3730,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
 	UInt32 theNumberItemsToFetch;
 	UInt32 theItemIndex;
 	
@@ -2077,7 +3739,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyData: no address");
 	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyData: no place to put the return value size");
 	FailWithAction(outData == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetDevicePropertyData: no place to put the return value");
-	FailWithAction(inObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePropertyData: not the device object");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetDevicePropertyData: not the device object");
 	
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required.
@@ -2108,9 +3770,9 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			break;
 			
 		case kAudioObjectPropertyName:
-			//	This is the human readable name of the device.
+			//	This is the human readable name of the device. Each device gets its own.
 			FailWithAction(inDataSize < sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioObjectPropertyName for the device");
-			*((CFStringRef*)outData) = CFSTR("DeviceName");
+			*((CFStringRef*)outData) = (CFStringRef)CFRetain(theDevice->mName);
 			*outDataSize = sizeof(CFStringRef);
 			break;
 			
@@ -2166,7 +3828,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 					//	fill out the list with as many objects as requested, which is everything
 					for(theItemIndex = 0; theItemIndex < theNumberItemsToFetch; ++theItemIndex)
 					{
-						((AudioObjectID*)outData)[theItemIndex] = kObjectID_Stream_Input + theItemIndex;
+						((AudioObjectID*)outData)[theItemIndex] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Input) + theItemIndex;
 					}
 					break;
 					
@@ -2180,7 +3842,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 					//	fill out the list with the right objects
 					for(theItemIndex = 0; theItemIndex < theNumberItemsToFetch; ++theItemIndex)
 					{
-						((AudioObjectID*)outData)[theItemIndex] = kObjectID_Stream_Input + theItemIndex;
+						((AudioObjectID*)outData)[theItemIndex] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Input) + theItemIndex;
 					}
 					break;
 					
@@ -2194,7 +3856,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 					//	fill out the list with the right objects
 					for(theItemIndex = 0; theItemIndex < theNumberItemsToFetch; ++theItemIndex)
 					{
-						((AudioObjectID*)outData)[theItemIndex] = kObjectID_Stream_Output + theItemIndex;
+						((AudioObjectID*)outData)[theItemIndex] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Output) + theItemIndex;
 					}
 					break;
 			};
@@ -2208,7 +3870,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			//	audio device across boot sessions. Note that two instances of the same
 			//	device must have different values for this property.
 			FailWithAction(inDataSize < sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioDevicePropertyDeviceUID for the device");
-			*((CFStringRef*)outData) = CFSTR(kDevice_UID);
+			*((CFStringRef*)outData) = (CFStringRef)CFRetain(theDevice->mUID);
 			*outDataSize = sizeof(CFStringRef);
 			break;
 
@@ -2244,7 +3906,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			//	case, only that number of items will be returned
 			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
 			
-			//	we only have the one device...
+			//	each device is only related to itself
 			if(theNumberItemsToFetch > 1)
 			{
 				theNumberItemsToFetch = 1;
@@ -2253,7 +3915,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			//	Write the devices' object IDs into the return value
 			if(theNumberItemsToFetch > 0)
 			{
-				((AudioObjectID*)outData)[0] = kObjectID_Device;
+				((AudioObjectID*)outData)[0] = theDevice->mObjectID;
 			}
 			
 			//	report how much we wrote
@@ -2285,9 +3947,9 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			//	This property returns whether or not IO is running for the device. Note that
 			//	we need to take both the state lock to check this value for thread safety.
 			FailWithAction(inDataSize < sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioDevicePropertyDeviceIsRunning for the device");
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((UInt32*)outData) = ((gDevice_IOIsRunning > 0) > 0) ? 1 : 0;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			*((UInt32*)outData) = ((theDevice->mIOIsRunning > 0) > 0) ? 1 : 0;
+			pthread_mutex_unlock(&theDevice->mStateMutex);
 			*outDataSize = sizeof(UInt32);
 			break;
 
@@ -2338,11 +4000,11 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 					//	fill out the list with as many objects as requested
 					if(theNumberItemsToFetch > 0)
 					{
-						((AudioObjectID*)outData)[0] = kObjectID_Stream_Input;
+						((AudioObjectID*)outData)[0] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Input);
 					}
 					if(theNumberItemsToFetch > 1)
 					{
-						((AudioObjectID*)outData)[1] = kObjectID_Stream_Output;
+						((AudioObjectID*)outData)[1] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Output);
 					}
 					break;
 					
@@ -2356,7 +4018,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 					//	fill out the list with as many objects as requested
 					if(theNumberItemsToFetch > 0)
 					{
-						((AudioObjectID*)outData)[0] = kObjectID_Stream_Input;
+						((AudioObjectID*)outData)[0] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Input);
 					}
 					break;
 					
@@ -2370,7 +4032,7 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 					//	fill out the list with as many objects as requested
 					if(theNumberItemsToFetch > 0)
 					{
-						((AudioObjectID*)outData)[0] = kObjectID_Stream_Output;
+						((AudioObjectID*)outData)[0] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Output);
 					}
 					break;
 			};
@@ -2394,11 +4056,11 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			{
 				if(theItemIndex < 3)
 				{
-					((AudioObjectID*)outData)[theItemIndex] = kObjectID_Volume_Input_Master + theItemIndex;
+					((AudioObjectID*)outData)[theItemIndex] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Volume_Input_Master) + theItemIndex;
 				}
 				else
 				{
-					((AudioObjectID*)outData)[theItemIndex] = kObjectID_Volume_Output_Master + (theItemIndex - 3);
+					((AudioObjectID*)outData)[theItemIndex] = NullAudio_GetDeviceObjectID(theDevice, kObjectID_Volume_Output_Master) + (theItemIndex - 3);
 				}
 			}
 			
@@ -2418,9 +4080,9 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			//	This property returns the nominal sample rate of the device. Note that we
 			//	only need to take the state lock to get this value.
 			FailWithAction(inDataSize < sizeof(Float64), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioDevicePropertyNominalSampleRate for the device");
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((Float64*)outData) = gDevice_SampleRate;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			*((Float64*)outData) = theDevice->mSampleRate;
+			pthread_mutex_unlock(&theDevice->mStateMutex);
 			*outDataSize = sizeof(Float64);
 			break;
 
@@ -2435,21 +4097,16 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			theNumberItemsToFetch = inDataSize / sizeof(AudioValueRange);
 			
 			//	clamp it to the number of items we have
-			if(theNumberItemsToFetch > 2)
+			if(theNumberItemsToFetch > kDevice_NumberSampleRates)
 			{
-				theNumberItemsToFetch = 2;
+				theNumberItemsToFetch = kDevice_NumberSampleRates;
 			}
 			
 			//	fill out the return array
-			if(theNumberItemsToFetch > 0)
+			for(UInt32 theItemIndex = 0; theItemIndex < theNumberItemsToFetch; ++theItemIndex)
 			{
-				((AudioValueRange*)outData)[0].mMinimum = 44100.0;
-				((AudioValueRange*)outData)[0].mMaximum = 44100.0;
-			}
-			if(theNumberItemsToFetch > 1)
-			{
-				((AudioValueRange*)outData)[1].mMinimum = 48000.0;
-				((AudioValueRange*)outData)[1].mMaximum = 48000.0;
+				((AudioValueRange*)outData)[theItemIndex].mMinimum = kDevice_SampleRates[theItemIndex];
+				((AudioValueRange*)outData)[theItemIndex].mMaximum = kDevice_SampleRates[theItemIndex];
 			}
 			
 			//	report how much we wrote
@@ -2466,25 +4123,43 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 		case kAudioDevicePropertyPreferredChannelsForStereo:
 			//	This property returns which two channesl to use as left/right for stereo
 			//	data by default. Note that the channel numbers are 1-based.xz
+			//	For a mono device, both are the one channel.
 			FailWithAction(inDataSize < (2 * sizeof(UInt32)), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioDevicePropertyPreferredChannelsForStereo for the device");
+			pthread_mutex_lock(&theDevice->mStateMutex);
 			((UInt32*)outData)[0] = 1;
-			((UInt32*)outData)[1] = 2;
+			((UInt32*)outData)[1] = (theDevice->mChannelsPerFrame > 1) ? 2 : 1;
+			pthread_mutex_unlock(&theDevice->mStateMutex);
 			*outDataSize = 2 * sizeof(UInt32);
 			break;
 
 		case kAudioDevicePropertyPreferredChannelLayout:
 			//	This property returns the default AudioChannelLayout to use for the device
-			//	by default. For this device, we return a stereo ACL.
+			//	by default. For this device, we return an ACL that labels a single channel as
+			//	mono, the first two channels as left and right and any others as discrete.
 			{
 				//	calcualte how big the
-				UInt32 theACLSize = offsetof(AudioChannelLayout, mChannelDescriptions) + (2 * sizeof(AudioChannelDescription));
+				pthread_mutex_lock(&theDevice->mStateMutex);
+				UInt32 theNumberChannels = theDevice->mChannelsPerFrame;
+				pthread_mutex_unlock(&theDevice->mStateMutex);
+				UInt32 theACLSize = offsetof(AudioChannelLayout, mChannelDescriptions) + (theNumberChannels * sizeof(AudioChannelDescription));
 				FailWithAction(inDataSize < theACLSize, theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioDevicePropertyPreferredChannelLayout for the device");
 				((AudioChannelLayout*)outData)->mChannelLayoutTag = kAudioChannelLayoutTag_UseChannelDescriptions;
 				((AudioChannelLayout*)outData)->mChannelBitmap = 0;
-				((AudioChannelLayout*)outData)->mNumberChannelDescriptions = 2;
-				for(theItemIndex = 0; theItemIndex < 2; ++theItemIndex)
+				((AudioChannelLayout*)outData)->mNumberChannelDescriptions = theNumberChannels;
+				for(theItemIndex = 0; theItemIndex < theNumberChannels; ++theItemIndex)
 				{
-					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelLabel = kAudioChannelLabel_Left + theItemIndex;
+					if(theNumberChannels == 1)
+					{
+						((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelLabel = kAudioChannelLabel_Mono;
+					}
+					else if(theItemIndex < 2)
+					{
+						((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelLabel = kAudioChannelLabel_Left + theItemIndex;
+					}
+					else
+					{
+						((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelLabel = kAudioChannelLabel_Discrete_0 + theItemIndex;
+					}
 					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelFlags = 0;
 					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mCoordinates[0] = 0;
 					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mCoordinates[1] = 0;
@@ -2515,6 +4190,28 @@ static OSStatus	NullAudio_GetDevicePropertyData(AudioServerPlugInDriverRef inDri
 			}
 			break;
 			
+		case kAudioObjectPropertyCustomPropertyInfoList:
+			//	The device has one custom property, the play-through latency, which is a CFNumber
+			//	with no qualifier.
+			FailWithAction(inDataSize < sizeof(AudioServerPlugInCustomPropertyInfo), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kAudioObjectPropertyCustomPropertyInfoList for the device");
+			((AudioServerPlugInCustomPropertyInfo*)outData)->mSelector = kDevice_PlayThruLatencyPropertyID;
+			((AudioServerPlugInCustomPropertyInfo*)outData)->mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFPropertyList;
+			((AudioServerPlugInCustomPropertyInfo*)outData)->mQualifierDataType = kAudioServerPlugInCustomPropertyDataTypeNone;
+			*outDataSize = sizeof(AudioServerPlugInCustomPropertyInfo);
+			break;
+			
+		case kDevice_PlayThruLatencyPropertyID:
+			//	This is the play-through latency in frames as a CFNumber. 0 means that play-through is
+			//	off. Note that the caller is responsible for releasing the returned number.
+			{
+				FailWithAction(inDataSize < sizeof(CFPropertyListRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetDevicePropertyData: not enough space for the return value of kDevice_PlayThruLatencyPropertyID for the device");
+				SInt32 theLatency = (SInt32)atomic_load_explicit(&theDevice->mPlayThruLatency, memory_order_relaxed);
+				*((CFPropertyListRef*)outData) = CFNumberCreate(NULL, kCFNumberSInt32Type, &theLatency);
+				FailWithAction(*((CFPropertyListRef*)outData) == NULL, theAnswer = kAudioHardwareUnspecifiedError, Done, "NullAudio_GetDevicePropertyData: couldn't create the value of kDevice_PlayThruLatencyPropertyID for the device");
+				*outDataSize = sizeof(CFPropertyListRef);
+			}
+			break;
+			
 		default:
 			theAnswer = kAudioHardwareUnknownPropertyError;
 			break;
@@ -2530,6 +4227,7 @@ static OSStatus	NullAudio_SetDevicePropertyData(AudioServerPlugInDriverRef inDri
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
 	Float64 theOldSampleRate;
 	UInt64 theNewSampleRate;
 	
@@ -2538,7 +4236,7 @@ static OSStatus	NullAudio_SetDevicePropertyData(AudioServerPlugInDriverRef inDri
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: no address");
 	FailWithAction(outNumberPropertiesChanged == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: no place to return the number of properties that changed");
 	FailWithAction(outChangedAddresses == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: no place to return the properties that changed");
-	FailWithAction(inObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_SetDevicePropertyData: not the device object");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_SetDevicePropertyData: not the device object");
 	
 	//	initialize the returned number of changed properties
 	*outNumberPropertiesChanged = 0;
@@ -2554,22 +4252,44 @@ static OSStatus	NullAudio_SetDevicePropertyData(AudioServerPlugInDriverRef inDri
 
 			//	check the arguments
 			FailWithAction(inDataSize != sizeof(Float64), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetDevicePropertyData: wrong size for the data for kAudioDevicePropertyNominalSampleRate");
-			FailWithAction((*((const Float64*)inData) != 44100.0) && (*((const Float64*)inData) != 48000.0), theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: unsupported value for kAudioDevicePropertyNominalSampleRate");
+			FailWithAction(!NullAudio_IsSupportedSampleRate(*((const Float64*)inData)), theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: unsupported value for kAudioDevicePropertyNominalSampleRate");
 			
 			//	make sure that the new value is different than the old value
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			theOldSampleRate = gDevice_SampleRate;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			theOldSampleRate = theDevice->mSampleRate;
+			pthread_mutex_unlock(&theDevice->mStateMutex);
 			if(*((const Float64*)inData) != theOldSampleRate)
 			{
+				//	we dispatch this so that the change can happen asynchronously
+				theNewSampleRate = (UInt64)*((const Float64*)inData);
+				theAnswer = NullAudio_ScheduleConfigurationChangeRequest(theDevice->mObjectID, theNewSampleRate, NULL);
+				FailIf(theAnswer != 0, Done, "NullAudio_SetDevicePropertyData: failed to schedule the sample rate change");
 				*outNumberPropertiesChanged = 1;
 				outChangedAddresses[0].mSelector = kAudioDevicePropertyNominalSampleRate;
 				outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
 				outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-				//	we dispatch this so that the change can happen asynchronously
-				theOldSampleRate = *((const Float64*)inData);
-				theNewSampleRate = (UInt64)theOldSampleRate;
-				dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ gPlugIn_Host->RequestDeviceConfigurationChange(gPlugIn_Host, kObjectID_Device, theNewSampleRate, NULL); });
+			}
+			break;
+		
+		case kDevice_PlayThruLatencyPropertyID:
+			//	The latency doesn't change the timing of the device, so it can be changed directly,
+			//	even while IO is running.
+			{
+				FailWithAction(inDataSize != sizeof(CFPropertyListRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetDevicePropertyData: wrong size for the data for kDevice_PlayThruLatencyPropertyID");
+				FailWithAction((inData == NULL) || (*((const CFPropertyListRef*)inData) == NULL) || (CFGetTypeID(*((const CFPropertyListRef*)inData)) != CFNumberGetTypeID()), theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: the data for kDevice_PlayThruLatencyPropertyID isn't a number");
+				SInt32 theNewLatency = 0;
+				CFNumberGetValue(*((const CFNumberRef*)inData), kCFNumberSInt32Type, &theNewLatency);
+				FailWithAction((theNewLatency < 0) || ((UInt32)theNewLatency > kDevice_MaxPlayThruLatency), theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetDevicePropertyData: unsupported value for kDevice_PlayThruLatencyPropertyID");
+				pthread_mutex_lock(&theDevice->mStateMutex);
+				if(atomic_load_explicit(&theDevice->mPlayThruLatency, memory_order_relaxed) != (UInt32)theNewLatency)
+				{
+					atomic_store_explicit(&theDevice->mPlayThruLatency, (UInt32)theNewLatency, memory_order_relaxed);
+					*outNumberPropertiesChanged = 1;
+					outChangedAddresses[0].mSelector = kDevice_PlayThruLatencyPropertyID;
+					outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
+					outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
+				}
+				pthread_mutex_unlock(&theDevice->mStateMutex);
 			}
 			break;
 		
@@ -2584,42 +4304,44 @@ Done:
 
 #pragma mark Stream Property Operations
 
+static const NullAudio_PropertyInfo	kStream_Properties[] =
+{
+	{ kAudioObjectPropertyBaseClass,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),																											false,	NULL },
+	{ kAudioObjectPropertyClass,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),																											false,	NULL },
+	{ kAudioObjectPropertyOwner,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),																											false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,				kPropertyScope_Any,	kPropertyElement_Any,	0,																																false,	NULL },
+	{ kAudioObjectPropertyName,						kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),																											false,	NULL },
+	{ kAudioStreamPropertyIsActive,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),																													true,	NULL },
+	{ kAudioStreamPropertyDirection,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),																													false,	NULL },
+	{ kAudioStreamPropertyTerminalType,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),																													false,	NULL },
+	{ kAudioStreamPropertyStartingChannel,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),																													false,	NULL },
+	{ kAudioStreamPropertyLatency,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),																													false,	NULL },
+	{ kAudioStreamPropertyVirtualFormat,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioStreamBasicDescription),																							true,	NULL },
+	{ kAudioStreamPropertyPhysicalFormat,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioStreamBasicDescription),																							true,	NULL },
+	{ kAudioStreamPropertyAvailableVirtualFormats,	kPropertyScope_Any,	kPropertyElement_Any,	kDevice_MaxChannelsPerFrame * kDevice_NumberSampleRates * sizeof(AudioStreamRangedDescription),									false,	NULL },
+	{ kAudioStreamPropertyAvailablePhysicalFormats,	kPropertyScope_Any,	kPropertyElement_Any,	kDevice_MaxChannelsPerFrame * kSampleFormat_NumberFormats * kDevice_NumberSampleRates * sizeof(AudioStreamRangedDescription),	false,	NULL },
+};
+
 static Boolean	NullAudio_HasStreamProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
 {
-	//	This method returns whether or not the given object has the given property.
+	//	This method returns whether or not the stream object has the given property.
 	
 	#pragma unused(inClientProcessID)
 	
 	//	declare the local variables
 	Boolean theAnswer = false;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
 	
 	//	check the arguments
 	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasStreamProperty: bad driver reference");
 	FailIf(inAddress == NULL, Done, "NullAudio_HasStreamProperty: no address");
-	FailIf((inObjectID != kObjectID_Stream_Input) && (inObjectID != kObjectID_Stream_Output), Done, "NullAudio_HasStreamProperty: not a stream object");
+	FailIf((theDevice == NULL) || ((theObjectKind != kObjectID_Stream_Input) && (theObjectKind != kObjectID_Stream_Output)), Done, "NullAudio_HasStreamProperty: not a stream object");
 	
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required. There is more detailed commentary about each
 	//	property in the NullAudio_GetStreamPropertyData() method.
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioObjectPropertyName:
-		case kAudioStreamPropertyIsActive:
-		case kAudioStreamPropertyDirection:
-		case kAudioStreamPropertyTerminalType:
-		case kAudioStreamPropertyStartingChannel:
-		case kAudioStreamPropertyLatency:
-		case kAudioStreamPropertyVirtualFormat:
-		case kAudioStreamPropertyPhysicalFormat:
-		case kAudioStreamPropertyAvailableVirtualFormats:
-		case kAudioStreamPropertyAvailablePhysicalFormats:
-			theAnswer = true;
-			break;
-	};
+	theAnswer = NullAudio_FindPropertyInfo(kStream_Properties, NullAudio_NumberProperties(kStream_Properties), inAddress) != NULL;
 
 Done:
 	return theAnswer;
@@ -2627,49 +4349,33 @@ Done:
 
 static OSStatus	NullAudio_IsStreamPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
 {
-	//	This method returns whether or not the given property on the object can have its value
+	//	This method returns whether or not the given property on the stream object can have its value
 	//	changed.
 	
 	#pragma unused(inClientProcessID)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsStreamPropertySettable: bad driver reference");
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsStreamPropertySettable: no address");
 	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsStreamPropertySettable: no place to put the return value");
-	FailWithAction((inObjectID != kObjectID_Stream_Input) && (inObjectID != kObjectID_Stream_Output), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsStreamPropertySettable: not a stream object");
+	FailWithAction((theDevice == NULL) || ((theObjectKind != kObjectID_Stream_Input) && (theObjectKind != kObjectID_Stream_Output)), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsStreamPropertySettable: not a stream object");
 	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetStreamPropertyData() method.
-	switch(inAddress->mSelector)
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kStream_Properties, NullAudio_NumberProperties(kStream_Properties), inAddress);
+	if(theInfo != NULL)
 	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioObjectPropertyName:
-		case kAudioStreamPropertyDirection:
-		case kAudioStreamPropertyTerminalType:
-		case kAudioStreamPropertyStartingChannel:
-		case kAudioStreamPropertyLatency:
-		case kAudioStreamPropertyAvailableVirtualFormats:
-		case kAudioStreamPropertyAvailablePhysicalFormats:
-			*outIsSettable = false;
-			break;
-		
-		case kAudioStreamPropertyIsActive:
-		case kAudioStreamPropertyVirtualFormat:
-		case kAudioStreamPropertyPhysicalFormat:
-			*outIsSettable = true;
-			break;
-		
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+		*outIsSettable = theInfo->mIsSettable;
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -2679,76 +4385,30 @@ static OSStatus	NullAudio_GetStreamPropertyDataSize(AudioServerPlugInDriverRef i
 {
 	//	This method returns the byte size of the property's data.
 	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
+	#pragma unused(inClientProcessID)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetStreamPropertyDataSize: bad driver reference");
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetStreamPropertyDataSize: no address");
 	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetStreamPropertyDataSize: no place to put the return value");
-	FailWithAction((inObjectID != kObjectID_Stream_Input) && (inObjectID != kObjectID_Stream_Output), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetStreamPropertyDataSize: not a stream object");
+	FailWithAction((theDevice == NULL) || ((theObjectKind != kObjectID_Stream_Input) && (theObjectKind != kObjectID_Stream_Output)), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetStreamPropertyDataSize: not a stream object");
 	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetStreamPropertyData() method.
-	switch(inAddress->mSelector)
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(kStream_Properties, NullAudio_NumberProperties(kStream_Properties), inAddress);
+	if(theInfo != NULL)
 	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-
-		case kAudioObjectPropertyOwnedObjects:
-			*outDataSize = 0 * sizeof(AudioObjectID);
-			break;
-
-		case kAudioObjectPropertyName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-
-		case kAudioStreamPropertyIsActive:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioStreamPropertyDirection:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioStreamPropertyTerminalType:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioStreamPropertyStartingChannel:
-			*outDataSize = sizeof(UInt32);
-			break;
-		
-		case kAudioStreamPropertyLatency:
-			*outDataSize = sizeof(UInt32);
-			break;
-
-		case kAudioStreamPropertyVirtualFormat:
-		case kAudioStreamPropertyPhysicalFormat:
-			*outDataSize = sizeof(AudioStreamBasicDescription);
-			break;
-
-		case kAudioStreamPropertyAvailableVirtualFormats:
-		case kAudioStreamPropertyAvailablePhysicalFormats:
-			*outDataSize = 2 * sizeof(AudioStreamRangedDescription);
-			break;
-
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+		theAnswer = NullAudio_GetPropertyInfoDataSize(theInfo, inObjectID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -2760,14 +4420,18 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
 	UInt32 theNumberItemsToFetch;
+	UInt32 theNumberSampleFormats;
+	UInt32 theItemIndex;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetStreamPropertyData: bad driver reference");
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetStreamPropertyData: no address");
 	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetStreamPropertyData: no place to put the return value size");
 	FailWithAction(outData == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetStreamPropertyData: no place to put the return value");
-	FailWithAction((inObjectID != kObjectID_Stream_Input) && (inObjectID != kObjectID_Stream_Output), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetStreamPropertyData: not a stream object");
+	FailWithAction((theDevice == NULL) || ((theObjectKind != kObjectID_Stream_Input) && (theObjectKind != kObjectID_Stream_Output)), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetStreamPropertyData: not a stream object");
 	
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required.
@@ -2793,7 +4457,7 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 		case kAudioObjectPropertyOwner:
 			//	The stream's owner is the device object
 			FailWithAction(inDataSize < sizeof(AudioObjectID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetStreamPropertyData: not enough space for the return value of kAudioObjectPropertyOwner for the stream");
-			*((AudioObjectID*)outData) = kObjectID_Device;
+			*((AudioObjectID*)outData) = theDevice->mObjectID;
 			*outDataSize = sizeof(AudioObjectID);
 			break;
 			
@@ -2805,7 +4469,7 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 		case kAudioObjectPropertyName:
 			//	This is the human readable name of the stream
 			FailWithAction(inDataSize < sizeof(CFStringRef), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetStreamPropertyData: not enough space for the return value of kAudioObjectPropertyName for the stream");
-			*((CFStringRef*)outData) = (inObjectID == kObjectID_Stream_Input) ? CFSTR("InputStreamName") : CFSTR("OutputStreamName");
+			*((CFStringRef*)outData) = (theObjectKind == kObjectID_Stream_Input) ? CFSTR("InputStreamName") : CFSTR("OutputStreamName");
 			*outDataSize = sizeof(CFStringRef);
 			break;
 
@@ -2814,16 +4478,16 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 			//	be used for IO. Note that we need to take the state lock to examine this
 			//	value.
 			FailWithAction(inDataSize < sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetStreamPropertyData: not enough space for the return value of kAudioStreamPropertyIsActive for the stream");
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((UInt32*)outData) = (inObjectID == kObjectID_Stream_Input) ? gStream_Input_IsActive : gStream_Output_IsActive;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			*((UInt32*)outData) = (theObjectKind == kObjectID_Stream_Input) ? theDevice->mStream_Input_IsActive : theDevice->mStream_Output_IsActive;
+			pthread_mutex_unlock(&theDevice->mStateMutex);
 			*outDataSize = sizeof(UInt32);
 			break;
 
 		case kAudioStreamPropertyDirection:
 			//	This returns whether the stream is an input stream or an output stream.
 			FailWithAction(inDataSize < sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetStreamPropertyData: not enough space for the return value of kAudioStreamPropertyDirection for the stream");
-			*((UInt32*)outData) = (inObjectID == kObjectID_Stream_Input) ? 1 : 0;
+			*((UInt32*)outData) = (theObjectKind == kObjectID_Stream_Input) ? 1 : 0;
 			*outDataSize = sizeof(UInt32);
 			break;
 
@@ -2832,7 +4496,7 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 			//	such as a speaker or headphones, or a microphone. Values for this property
 			//	are defined in <CoreAudio/AudioHardwareBase.h>
 			FailWithAction(inDataSize < sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetStreamPropertyData: not enough space for the return value of kAudioStreamPropertyTerminalType for the stream");
-			*((UInt32*)outData) = (inObjectID == kObjectID_Stream_Input) ? kAudioStreamTerminalTypeMicrophone : kAudioStreamTerminalTypeSpeaker;
+			*((UInt32*)outData) = (theObjectKind == kObjectID_Stream_Input) ? kAudioStreamTerminalTypeMicrophone : kAudioStreamTerminalTypeSpeaker;
 			*outDataSize = sizeof(UInt32);
 			break;
 
@@ -2858,26 +4522,22 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 			//	This returns the current format of the stream in an
 			//	AudioStreamBasicDescription. Note that we need to hold the state lock to get
 			//	this value.
-			//	Note that for devices that don't override the mix operation, the virtual
-			//	format has to be the same as the physical format.
+			//	Note that the virtual format is always 32 bit float, and the driver does the
+			//	conversion to and from the physical format itself in the ConvertInput and
+			//	ConvertMix operations.
 			FailWithAction(inDataSize < sizeof(AudioStreamBasicDescription), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetStreamPropertyData: not enough space for the return value of kAudioStreamPropertyVirtualFormat for the stream");
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			((AudioStreamBasicDescription*)outData)->mSampleRate = gDevice_SampleRate;
-			((AudioStreamBasicDescription*)outData)->mFormatID = kAudioFormatLinearPCM;
-			((AudioStreamBasicDescription*)outData)->mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
-			((AudioStreamBasicDescription*)outData)->mBytesPerPacket = 8;
-			((AudioStreamBasicDescription*)outData)->mFramesPerPacket = 1;
-			((AudioStreamBasicDescription*)outData)->mBytesPerFrame = 8;
-			((AudioStreamBasicDescription*)outData)->mChannelsPerFrame = 2;
-			((AudioStreamBasicDescription*)outData)->mBitsPerChannel = 32;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			NullAudio_FillOutFormat((AudioStreamBasicDescription*)outData, theDevice->mSampleRate, (inAddress->mSelector == kAudioStreamPropertyVirtualFormat) ? kSampleFormat_Float32 : theDevice->mSampleFormat, theDevice->mChannelsPerFrame);
+			pthread_mutex_unlock(&theDevice->mStateMutex);
 			*outDataSize = sizeof(AudioStreamBasicDescription);
 			break;
 
 		case kAudioStreamPropertyAvailableVirtualFormats:
 		case kAudioStreamPropertyAvailablePhysicalFormats:
 			//	This returns an array of AudioStreamRangedDescriptions that describe what
-			//	formats are supported.
+			//	formats are supported. There is one item for every combination of channel
+			//	count, sample format and sample rate. The virtual formats are only 32 bit float.
+			theNumberSampleFormats = (inAddress->mSelector == kAudioStreamPropertyAvailableVirtualFormats) ? 1 : kSampleFormat_NumberFormats;
 
 			//	Calculate the number of items that have been requested. Note that this
 			//	number is allowed to be smaller than the actual size of the list. In such
@@ -2885,37 +4545,20 @@ static OSStatus	NullAudio_GetStreamPropertyData(AudioServerPlugInDriverRef inDri
 			theNumberItemsToFetch = inDataSize / sizeof(AudioStreamRangedDescription);
 			
 			//	clamp it to the number of items we have
-			if(theNumberItemsToFetch > 2)
+			if(theNumberItemsToFetch > (kDevice_MaxChannelsPerFrame * theNumberSampleFormats * kDevice_NumberSampleRates))
 			{
-				theNumberItemsToFetch = 2;
+				theNumberItemsToFetch = kDevice_MaxChannelsPerFrame * theNumberSampleFormats * kDevice_NumberSampleRates;
 			}
 			
 			//	fill out the return array
-			if(theNumberItemsToFetch > 0)
-			{
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mSampleRate = 44100.0;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mFormatID = kAudioFormatLinearPCM;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mBytesPerPacket = 8;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mFramesPerPacket = 1;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mBytesPerFrame = 8;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mChannelsPerFrame = 2;
-				((AudioStreamRangedDescription*)outData)[0].mFormat.mBitsPerChannel = 32;
-				((AudioStreamRangedDescription*)outData)[0].mSampleRateRange.mMinimum = 44100.0;
-				((AudioStreamRangedDescription*)outData)[0].mSampleRateRange.mMaximum = 44100.0;
-			}
-			if(theNumberItemsToFetch > 1)
+			for(theItemIndex = 0; theItemIndex < theNumberItemsToFetch; ++theItemIndex)
 			{
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mSampleRate = 48000.0;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mFormatID = kAudioFormatLinearPCM;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mBytesPerPacket = 8;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mFramesPerPacket = 1;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mBytesPerFrame = 8;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mChannelsPerFrame = 2;
-				((AudioStreamRangedDescription*)outData)[1].mFormat.mBitsPerChannel = 32;
-				((AudioStreamRangedDescription*)outData)[1].mSampleRateRange.mMinimum = 48000.0;
-				((AudioStreamRangedDescription*)outData)[1].mSampleRateRange.mMaximum = 48000.0;
+				Float64 theSampleRate = kDevice_SampleRates[theItemIndex % kDevice_NumberSampleRates];
+				UInt32 theSampleFormat = (theItemIndex / kDevice_NumberSampleRates) % theNumberSampleFormats;
+				UInt32 theChannelsPerFrame = 1 + (theItemIndex / (kDevice_NumberSampleRates * theNumberSampleFormats));
+				NullAudio_FillOutFormat(&((AudioStreamRangedDescription*)outData)[theItemIndex].mFormat, theSampleRate, theSampleFormat, theChannelsPerFrame);
+				((AudioStreamRangedDescription*)outData)[theItemIndex].mSampleRateRange.mMinimum = theSampleRate;
+				((AudioStreamRangedDescription*)outData)[theItemIndex].mSampleRateRange.mMaximum = theSampleRate;
 			}
 			
 			//	report how much we wrote
@@ -2937,15 +4580,18 @@ static OSStatus	NullAudio_SetStreamPropertyData(AudioServerPlugInDriverRef inDri
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
-	Float64 theOldSampleRate;
-	UInt64 theNewSampleRate;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
+	UInt32 theNewSampleFormat;
+	NullAudio_FormatChange theNewFormat;
+	bool theFormatIsDifferent;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_SetStreamPropertyData: bad driver reference");
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetStreamPropertyData: no address");
 	FailWithAction(outNumberPropertiesChanged == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetStreamPropertyData: no place to return the number of properties that changed");
 	FailWithAction(outChangedAddresses == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetStreamPropertyData: no place to return the properties that changed");
-	FailWithAction((inObjectID != kObjectID_Stream_Input) && (inObjectID != kObjectID_Stream_Output), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_SetStreamPropertyData: not a stream object");
+	FailWithAction((theDevice == NULL) || ((theObjectKind != kObjectID_Stream_Input) && (theObjectKind != kObjectID_Stream_Output)), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_SetStreamPropertyData: not a stream object");
 	
 	//	initialize the returned number of changed properties
 	*outNumberPropertiesChanged = 0;
@@ -2959,12 +4605,12 @@ static OSStatus	NullAudio_SetStreamPropertyData(AudioServerPlugInDriverRef inDri
 			//	Changing the active state of a stream doesn't affect IO or change the structure
 			//	so we can just save the state and send the notification.
 			FailWithAction(inDataSize != sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetStreamPropertyData: wrong size for the data for kAudioDevicePropertyNominalSampleRate");
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			if(inObjectID == kObjectID_Stream_Input)
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			if(theObjectKind == kObjectID_Stream_Input)
 			{
-				if(gStream_Input_IsActive != (*((const UInt32*)inData) != 0))
+				if(theDevice->mStream_Input_IsActive != (*((const UInt32*)inData) != 0))
 				{
-					gStream_Input_IsActive = *((const UInt32*)inData) != 0;
+					theDevice->mStream_Input_IsActive = *((const UInt32*)inData) != 0;
 					*outNumberPropertiesChanged = 1;
 					outChangedAddresses[0].mSelector = kAudioStreamPropertyIsActive;
 					outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -2973,403 +4619,221 @@ static OSStatus	NullAudio_SetStreamPropertyData(AudioServerPlugInDriverRef inDri
 			}
 			else
 			{
-				if(gStream_Output_IsActive != (*((const UInt32*)inData) != 0))
+				if(theDevice->mStream_Output_IsActive != (*((const UInt32*)inData) != 0))
 				{
-					gStream_Output_IsActive = *((const UInt32*)inData) != 0;
+					theDevice->mStream_Output_IsActive = *((const UInt32*)inData) != 0;
 					*outNumberPropertiesChanged = 1;
 					outChangedAddresses[0].mSelector = kAudioStreamPropertyIsActive;
 					outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
 					outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
 				}
 			}
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			break;
-			
-		case kAudioStreamPropertyVirtualFormat:
-		case kAudioStreamPropertyPhysicalFormat:
-			//	Changing the stream format needs to be handled via the
-			//	RequestConfigChange/PerformConfigChange machinery. Note that because this
-			//	device only supports 2 channel 32 bit float data, the only thing that can
-			//	change is the sample rate.
-			FailWithAction(inDataSize != sizeof(AudioStreamBasicDescription), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetStreamPropertyData: wrong size for the data for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mFormatID != kAudioFormatLinearPCM, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported format ID for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mFormatFlags != (kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked), theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported format flags for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mBytesPerPacket != 8, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported bytes per packet for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mFramesPerPacket != 1, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported frames per packet for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mBytesPerFrame != 8, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported bytes per frame for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mChannelsPerFrame != 2, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported channels per frame for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction(((const AudioStreamBasicDescription*)inData)->mBitsPerChannel != 32, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported bits per channel for kAudioStreamPropertyPhysicalFormat");
-			FailWithAction((((const AudioStreamBasicDescription*)inData)->mSampleRate != 44100.0) && (((const AudioStreamBasicDescription*)inData)->mSampleRate != 48000.0), theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetStreamPropertyData: unsupported sample rate for kAudioStreamPropertyPhysicalFormat");
-			
-			//	If we made it this far, the requested format is something we support, so make sure the sample rate is actually different
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			theOldSampleRate = gDevice_SampleRate;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			if(((const AudioStreamBasicDescription*)inData)->mSampleRate != theOldSampleRate)
-			{
-				//	we dispatch this so that the change can happen asynchronously
-				theOldSampleRate = ((const AudioStreamBasicDescription*)inData)->mSampleRate;
-				theNewSampleRate = (UInt64)theOldSampleRate;
-				dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ gPlugIn_Host->RequestDeviceConfigurationChange(gPlugIn_Host, kObjectID_Device, theNewSampleRate, NULL); });
-			}
-			break;
-		
-		default:
-			theAnswer = kAudioHardwareUnknownPropertyError;
-			break;
-	};
-
-Done:
-	return theAnswer;
-}
-
-#pragma mark Control Property Operations
-
-static Boolean	NullAudio_HasControlProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
-{
-	//	This method returns whether or not the given object has the given property.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	Boolean theAnswer = false;
-	
-	//	check the arguments
-	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasControlProperty: bad driver reference");
-	FailIf(inAddress == NULL, Done, "NullAudio_HasControlProperty: no address");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetControlPropertyData() method.
-	switch(inObjectID)
-	{
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-				case kAudioObjectPropertyClass:
-				case kAudioObjectPropertyOwner:
-				case kAudioObjectPropertyOwnedObjects:
-				case kAudioControlPropertyScope:
-				case kAudioControlPropertyElement:
-				case kAudioLevelControlPropertyScalarValue:
-				case kAudioLevelControlPropertyDecibelValue:
-				case kAudioLevelControlPropertyDecibelRange:
-				case kAudioLevelControlPropertyConvertScalarToDecibels:
-				case kAudioLevelControlPropertyConvertDecibelsToScalar:
-					theAnswer = true;
-					break;
-			};
-			break;
-		
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-				case kAudioObjectPropertyClass:
-				case kAudioObjectPropertyOwner:
-				case kAudioObjectPropertyOwnedObjects:
-				case kAudioControlPropertyScope:
-				case kAudioControlPropertyElement:
-				case kAudioBooleanControlPropertyValue:
-					theAnswer = true;
-					break;
-			};
-			break;
-		
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-				case kAudioObjectPropertyClass:
-				case kAudioObjectPropertyOwner:
-				case kAudioObjectPropertyOwnedObjects:
-				case kAudioControlPropertyScope:
-				case kAudioControlPropertyElement:
-				case kAudioSelectorControlPropertyCurrentItem:
-				case kAudioSelectorControlPropertyAvailableItems:
-				case kAudioSelectorControlPropertyItemName:
-					theAnswer = true;
-					break;
-			};
-			break;
-	};
-
-Done:
-	return theAnswer;
-}
-
-static OSStatus	NullAudio_IsControlPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
-{
-	//	This method returns whether or not the given property on the object can have its value
-	//	changed.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsControlPropertySettable: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsControlPropertySettable: no address");
-	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsControlPropertySettable: no place to put the return value");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetControlPropertyData() method.
-	switch(inObjectID)
-	{
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-				case kAudioObjectPropertyClass:
-				case kAudioObjectPropertyOwner:
-				case kAudioObjectPropertyOwnedObjects:
-				case kAudioControlPropertyScope:
-				case kAudioControlPropertyElement:
-				case kAudioLevelControlPropertyDecibelRange:
-				case kAudioLevelControlPropertyConvertScalarToDecibels:
-				case kAudioLevelControlPropertyConvertDecibelsToScalar:
-					*outIsSettable = false;
-					break;
-				
-				case kAudioLevelControlPropertyScalarValue:
-				case kAudioLevelControlPropertyDecibelValue:
-					*outIsSettable = true;
-					break;
-				
-				default:
-					theAnswer = kAudioHardwareUnknownPropertyError;
-					break;
-			};
-			break;
-		
-		case kObjectID_Mute_Input_Master:
-		case kObjectID_Mute_Output_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-				case kAudioObjectPropertyClass:
-				case kAudioObjectPropertyOwner:
-				case kAudioObjectPropertyOwnedObjects:
-				case kAudioControlPropertyScope:
-				case kAudioControlPropertyElement:
-					*outIsSettable = false;
-					break;
-				
-				case kAudioBooleanControlPropertyValue:
-					*outIsSettable = true;
-					break;
-				
-				default:
-					theAnswer = kAudioHardwareUnknownPropertyError;
-					break;
-			};
-			break;
-		
-		case kObjectID_DataSource_Input_Master:
-		case kObjectID_DataSource_Output_Master:
-		case kObjectID_DataDestination_PlayThru_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-				case kAudioObjectPropertyClass:
-				case kAudioObjectPropertyOwner:
-				case kAudioObjectPropertyOwnedObjects:
-				case kAudioControlPropertyScope:
-				case kAudioControlPropertyElement:
-				case kAudioSelectorControlPropertyAvailableItems:
-				case kAudioSelectorControlPropertyItemName:
-					*outIsSettable = false;
-					break;
-				
-				case kAudioSelectorControlPropertyCurrentItem:
-					*outIsSettable = true;
-					break;
-				
-				default:
-					theAnswer = kAudioHardwareUnknownPropertyError;
-					break;
-			};
-			break;
-				
-		default:
-			theAnswer = kAudioHardwareBadObjectError;
-			break;
-	};
-
-Done:
-	return theAnswer;
-}
-
-static OSStatus	NullAudio_GetControlPropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
-{
-	//	This method returns the byte size of the property's data.
-	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus theAnswer = 0;
-	
-	//	check the arguments
-	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetControlPropertyDataSize: bad driver reference");
-	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyDataSize: no address");
-	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyDataSize: no place to put the return value");
-	
-	//	Note that for each object, this driver implements all the required properties plus a few
-	//	extras that are useful but not required. There is more detailed commentary about each
-	//	property in the NullAudio_GetControlPropertyData() method.
-	switch(inObjectID)
-	{
-		case kObjectID_Volume_Input_Master:
-		case kObjectID_Volume_Output_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-					*outDataSize = sizeof(AudioClassID);
-					break;
-
-				case kAudioObjectPropertyClass:
-					*outDataSize = sizeof(AudioClassID);
-					break;
-
-				case kAudioObjectPropertyOwner:
-					*outDataSize = sizeof(AudioObjectID);
-					break;
-
-				case kAudioObjectPropertyOwnedObjects:
-					*outDataSize = 0 * sizeof(AudioObjectID);
-					break;
-
-				case kAudioControlPropertyScope:
-					*outDataSize = sizeof(AudioObjectPropertyScope);
-					break;
-
-				case kAudioControlPropertyElement:
-					*outDataSize = sizeof(AudioObjectPropertyElement);
-					break;
+			pthread_mutex_unlock(&theDevice->mStateMutex);
+			break;
+			
+		case kAudioStreamPropertyVirtualFormat:
+		case kAudioStreamPropertyPhysicalFormat:
+			//	Changing the stream format needs to be handled via the
+			//	RequestConfigChange/PerformConfigChange machinery. Note that both streams
+			//	always share the same format, so this changes the other stream's format too.
+			//	Setting the virtual format can only change the sample rate and the number of
+			//	channels since the virtual format is always 32 bit float.
+			FailWithAction(inDataSize != sizeof(AudioStreamBasicDescription), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetStreamPropertyData: wrong size for the data for kAudioStreamPropertyPhysicalFormat");
+			theNewSampleFormat = NullAudio_GetSampleFormat((const AudioStreamBasicDescription*)inData);
+			FailWithAction(theNewSampleFormat == kSampleFormat_NumberFormats, theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported format for kAudioStreamPropertyPhysicalFormat");
+			FailWithAction((inAddress->mSelector == kAudioStreamPropertyVirtualFormat) && (theNewSampleFormat != kSampleFormat_Float32), theAnswer = kAudioDeviceUnsupportedFormatError, Done, "NullAudio_SetStreamPropertyData: unsupported format for kAudioStreamPropertyVirtualFormat");
+			FailWithAction(!NullAudio_IsSupportedSampleRate(((const AudioStreamBasicDescription*)inData)->mSampleRate), theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetStreamPropertyData: unsupported sample rate for kAudioStreamPropertyPhysicalFormat");
+			
+			//	If we made it this far, the requested format is something we support, so make sure it is actually different
+			pthread_mutex_lock(&theDevice->mStateMutex);
+			theNewFormat.mSampleRate = ((const AudioStreamBasicDescription*)inData)->mSampleRate;
+			theNewFormat.mSampleFormat = (inAddress->mSelector == kAudioStreamPropertyVirtualFormat) ? theDevice->mSampleFormat : theNewSampleFormat;
+			theNewFormat.mChannelsPerFrame = ((const AudioStreamBasicDescription*)inData)->mChannelsPerFrame;
+			theFormatIsDifferent = (theNewFormat.mSampleRate != theDevice->mSampleRate) || (theNewFormat.mSampleFormat != theDevice->mSampleFormat) || (theNewFormat.mChannelsPerFrame != theDevice->mChannelsPerFrame);
+			pthread_mutex_unlock(&theDevice->mStateMutex);
+			if(theFormatIsDifferent)
+			{
+				//	The new format is passed in a heap block that NullAudio_PerformDeviceConfigurationChange()
+				//	or NullAudio_AbortDeviceConfigurationChange() frees. We dispatch this so that the
+				//	change can happen asynchronously.
+				NullAudio_FormatChange* theFormatChange = (NullAudio_FormatChange*)malloc(sizeof(NullAudio_FormatChange));
+				FailWithAction(theFormatChange == NULL, theAnswer = kAudioHardwareUnspecifiedError, Done, "NullAudio_SetStreamPropertyData: failed to allocate the format change");
+				*theFormatChange = theNewFormat;
+				theAnswer = NullAudio_ScheduleConfigurationChangeRequest(theDevice->mObjectID, 0, theFormatChange);
+				FailWithAction(theAnswer != 0, free(theFormatChange), Done, "NullAudio_SetStreamPropertyData: failed to schedule the format change");
+			}
+			break;
+		
+		default:
+			theAnswer = kAudioHardwareUnknownPropertyError;
+			break;
+	};
 
-				case kAudioLevelControlPropertyScalarValue:
-					*outDataSize = sizeof(Float32);
-					break;
+Done:
+	return theAnswer;
+}
 
-				case kAudioLevelControlPropertyDecibelValue:
-					*outDataSize = sizeof(Float32);
-					break;
+#pragma mark Control Property Operations
 
-				case kAudioLevelControlPropertyDecibelRange:
-					*outDataSize = sizeof(AudioValueRange);
-					break;
+static const NullAudio_PropertyInfo	kVolumeControl_Properties[] =
+{
+	{ kAudioObjectPropertyBaseClass,						kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),				false,	NULL },
+	{ kAudioObjectPropertyClass,							kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),				false,	NULL },
+	{ kAudioObjectPropertyOwner,							kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),				false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,						kPropertyScope_Any,	kPropertyElement_Any,	0,									false,	NULL },
+	{ kAudioControlPropertyScope,							kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectPropertyScope),	false,	NULL },
+	{ kAudioControlPropertyElement,							kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectPropertyElement),	false,	NULL },
+	{ kAudioLevelControlPropertyScalarValue,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(Float32),					true,	NULL },
+	{ kAudioLevelControlPropertyDecibelValue,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(Float32),					true,	NULL },
+	{ kAudioLevelControlPropertyDecibelRange,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioValueRange),			false,	NULL },
+	{ kAudioLevelControlPropertyConvertScalarToDecibels,	kPropertyScope_Any,	kPropertyElement_Any,	sizeof(Float32),					false,	NULL },
+	{ kAudioLevelControlPropertyConvertDecibelsToScalar,	kPropertyScope_Any,	kPropertyElement_Any,	sizeof(Float32),					false,	NULL },
+};
 
-				case kAudioLevelControlPropertyConvertScalarToDecibels:
-					*outDataSize = sizeof(Float32);
-					break;
+static const NullAudio_PropertyInfo	kMuteControl_Properties[] =
+{
+	{ kAudioObjectPropertyBaseClass,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),				false,	NULL },
+	{ kAudioObjectPropertyClass,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),				false,	NULL },
+	{ kAudioObjectPropertyOwner,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),				false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,		kPropertyScope_Any,	kPropertyElement_Any,	0,									false,	NULL },
+	{ kAudioControlPropertyScope,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectPropertyScope),	false,	NULL },
+	{ kAudioControlPropertyElement,			kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectPropertyElement),	false,	NULL },
+	{ kAudioBooleanControlPropertyValue,	kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),						true,	NULL },
+};
 
-				case kAudioLevelControlPropertyConvertDecibelsToScalar:
-					*outDataSize = sizeof(Float32);
-					break;
+static const NullAudio_PropertyInfo	kSelectorControl_Properties[] =
+{
+	{ kAudioObjectPropertyBaseClass,				kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),						false,	NULL },
+	{ kAudioObjectPropertyClass,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioClassID),						false,	NULL },
+	{ kAudioObjectPropertyOwner,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectID),						false,	NULL },
+	{ kAudioObjectPropertyOwnedObjects,				kPropertyScope_Any,	kPropertyElement_Any,	0,											false,	NULL },
+	{ kAudioControlPropertyScope,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectPropertyScope),			false,	NULL },
+	{ kAudioControlPropertyElement,					kPropertyScope_Any,	kPropertyElement_Any,	sizeof(AudioObjectPropertyElement),			false,	NULL },
+	{ kAudioSelectorControlPropertyCurrentItem,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(UInt32),								true,	NULL },
+	{ kAudioSelectorControlPropertyAvailableItems,	kPropertyScope_Any,	kPropertyElement_Any,	kDataSource_NumberItems * sizeof(UInt32),	false,	NULL },
+	{ kAudioSelectorControlPropertyItemName,		kPropertyScope_Any,	kPropertyElement_Any,	sizeof(CFStringRef),						false,	NULL },
+};
 
-				default:
-					theAnswer = kAudioHardwareUnknownPropertyError;
-					break;
-			};
+//	Each kind of control has its own table. The data source and data destination controls are both
+//	selector controls with the same properties. Objects that aren't controls have no table.
+static const NullAudio_PropertyInfo*	NullAudio_GetControlProperties(AudioObjectID inObjectKind, UInt32* outNumberProperties)
+{
+	const NullAudio_PropertyInfo* theAnswer = NULL;
+	*outNumberProperties = 0;
+	switch(inObjectKind)
+	{
+		case kObjectID_Volume_Input_Master:
+		case kObjectID_Volume_Output_Master:
+			theAnswer = kVolumeControl_Properties;
+			*outNumberProperties = NullAudio_NumberProperties(kVolumeControl_Properties);
 			break;
 		
 		case kObjectID_Mute_Input_Master:
 		case kObjectID_Mute_Output_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-					*outDataSize = sizeof(AudioClassID);
-					break;
-
-				case kAudioObjectPropertyClass:
-					*outDataSize = sizeof(AudioClassID);
-					break;
-
-				case kAudioObjectPropertyOwner:
-					*outDataSize = sizeof(AudioObjectID);
-					break;
-
-				case kAudioObjectPropertyOwnedObjects:
-					*outDataSize = 0 * sizeof(AudioObjectID);
-					break;
-
-				case kAudioControlPropertyScope:
-					*outDataSize = sizeof(AudioObjectPropertyScope);
-					break;
-
-				case kAudioControlPropertyElement:
-					*outDataSize = sizeof(AudioObjectPropertyElement);
-					break;
-
-				case kAudioBooleanControlPropertyValue:
-					*outDataSize = sizeof(UInt32);
-					break;
-
-				default:
-					theAnswer = kAudioHardwareUnknownPropertyError;
-					break;
-			};
+			theAnswer = kMuteControl_Properties;
+			*outNumberProperties = NullAudio_NumberProperties(kMuteControl_Properties);
 			break;
 		
 		case kObjectID_DataSource_Input_Master:
 		case kObjectID_DataSource_Output_Master:
 		case kObjectID_DataDestination_PlayThru_Master:
-			switch(inAddress->mSelector)
-			{
-				case kAudioObjectPropertyBaseClass:
-					*outDataSize = sizeof(AudioClassID);
-					break;
-
-				case kAudioObjectPropertyClass:
-					*outDataSize = sizeof(AudioClassID);
-					break;
-
-				case kAudioObjectPropertyOwner:
-					*outDataSize = sizeof(AudioObjectID);
-					break;
-
-				case kAudioObjectPropertyOwnedObjects:
-					*outDataSize = 0 * sizeof(AudioObjectID);
-					break;
-
-				case kAudioControlPropertyScope:
-					*outDataSize = sizeof(AudioObjectPropertyScope);
-					break;
+			theAnswer = kSelectorControl_Properties;
+			*outNumberProperties = NullAudio_NumberProperties(kSelectorControl_Properties);
+			break;
+	};
+	return theAnswer;
+}
 
-				case kAudioControlPropertyElement:
-					*outDataSize = sizeof(AudioObjectPropertyElement);
-					break;
+static Boolean	NullAudio_HasControlProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+{
+	//	This method returns whether or not the control object has the given property.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	Boolean theAnswer = false;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	UInt32 theNumberProperties = 0;
+	const NullAudio_PropertyInfo* theProperties = NullAudio_GetControlProperties(NullAudio_GetObjectKind(inObjectID), &theNumberProperties);
+	
+	//	check the arguments
+	FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "NullAudio_HasControlProperty: bad driver reference");
+	FailIf(inAddress == NULL, Done, "NullAudio_HasControlProperty: no address");
+	FailIf((theDevice == NULL) || (theProperties == NULL), Done, "NullAudio_HasControlProperty: not a control object");
+	
+	//	Note that for each object, this driver implements all the required properties plus a few
+	//	extras that are useful but not required. There is more detailed commentary about each
+	//	property in the NullAudio_GetControlPropertyData() method.
+	theAnswer = NullAudio_FindPropertyInfo(theProperties, theNumberProperties, inAddress) != NULL;
 
-				case kAudioSelectorControlPropertyCurrentItem:
-					*outDataSize = sizeof(UInt32);
-					break;
+Done:
+	return theAnswer;
+}
 
-				case kAudioSelectorControlPropertyAvailableItems:
-					*outDataSize = kDataSource_NumberItems * sizeof(UInt32);
-					break;
+static OSStatus	NullAudio_IsControlPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+{
+	//	This method returns whether or not the given property on the control object can have its value
+	//	changed.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	UInt32 theNumberProperties = 0;
+	const NullAudio_PropertyInfo* theProperties = NullAudio_GetControlProperties(NullAudio_GetObjectKind(inObjectID), &theNumberProperties);
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsControlPropertySettable: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsControlPropertySettable: no address");
+	FailWithAction(outIsSettable == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_IsControlPropertySettable: no place to put the return value");
+	FailWithAction((theDevice == NULL) || (theProperties == NULL), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_IsControlPropertySettable: not a control object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(theProperties, theNumberProperties, inAddress);
+	if(theInfo != NULL)
+	{
+		*outIsSettable = theInfo->mIsSettable;
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
-				case kAudioSelectorControlPropertyItemName:
-					*outDataSize = sizeof(CFStringRef);
-					break;
+Done:
+	return theAnswer;
+}
 
-				default:
-					theAnswer = kAudioHardwareUnknownPropertyError;
-					break;
-			};
-			break;
-				
-		default:
-			theAnswer = kAudioHardwareBadObjectError;
-			break;
-	};
+static OSStatus	NullAudio_GetControlPropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+{
+	//	This method returns the byte size of the property's data.
+	
+	#pragma unused(inClientProcessID)
+	
+	//	declare the local variables
+	OSStatus theAnswer = 0;
+	const NullAudio_PropertyInfo* theInfo = NULL;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	UInt32 theNumberProperties = 0;
+	const NullAudio_PropertyInfo* theProperties = NullAudio_GetControlProperties(NullAudio_GetObjectKind(inObjectID), &theNumberProperties);
+	
+	//	check the arguments
+	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetControlPropertyDataSize: bad driver reference");
+	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyDataSize: no address");
+	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyDataSize: no place to put the return value");
+	FailWithAction((theDevice == NULL) || (theProperties == NULL), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetControlPropertyDataSize: not a control object");
+	
+	//	look the property up
+	theInfo = NullAudio_FindPropertyInfo(theProperties, theNumberProperties, inAddress);
+	if(theInfo != NULL)
+	{
+		theAnswer = NullAudio_GetPropertyInfoDataSize(theInfo, inObjectID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
+	}
+	else
+	{
+		theAnswer = kAudioHardwareUnknownPropertyError;
+	}
 
 Done:
 	return theAnswer;
@@ -3381,6 +4845,8 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
 	UInt32 theNumberItemsToFetch;
 	UInt32 theItemIndex;
 	
@@ -3389,13 +4855,14 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyData: no address");
 	FailWithAction(outDataSize == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyData: no place to put the return value size");
 	FailWithAction(outData == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_GetControlPropertyData: no place to put the return value");
+	FailWithAction(theDevice == NULL, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetControlPropertyData: not a control object");
 	
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required.
 	//
 	//	Also, since most of the data that will get returned is static, there are few instances where
 	//	it is necessary to lock the state mutex.
-	switch(inObjectID)
+	switch(theObjectKind)
 	{
 		case kObjectID_Volume_Input_Master:
 		case kObjectID_Volume_Output_Master:
@@ -3418,7 +4885,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 				case kAudioObjectPropertyOwner:
 					//	The control's owner is the device object
 					FailWithAction(inDataSize < sizeof(AudioObjectID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioObjectPropertyOwner for the volume control");
-					*((AudioObjectID*)outData) = kObjectID_Device;
+					*((AudioObjectID*)outData) = theDevice->mObjectID;
 					*outDataSize = sizeof(AudioObjectID);
 					break;
 					
@@ -3430,7 +4897,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 				case kAudioControlPropertyScope:
 					//	This property returns the scope that the control is attached to.
 					FailWithAction(inDataSize < sizeof(AudioObjectPropertyScope), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioControlPropertyScope for the volume control");
-					*((AudioObjectPropertyScope*)outData) = (inObjectID == kObjectID_Volume_Input_Master) ? kAudioObjectPropertyScopeInput : kAudioObjectPropertyScopeOutput;
+					*((AudioObjectPropertyScope*)outData) = (theObjectKind == kObjectID_Volume_Input_Master) ? kAudioObjectPropertyScopeInput : kAudioObjectPropertyScopeOutput;
 					*outDataSize = sizeof(AudioObjectPropertyScope);
 					break;
 
@@ -3445,9 +4912,9 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 					//	This returns the value of the control in the normalized range of 0 to 1.
 					//	Note that we need to take the state lock to examine the value.
 					FailWithAction(inDataSize < sizeof(Float32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioLevelControlPropertyScalarValue for the volume control");
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					*((Float32*)outData) = (inObjectID == kObjectID_Volume_Input_Master) ? gVolume_Input_Master_Value : gVolume_Output_Master_Value;
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					*((Float32*)outData) = (theObjectKind == kObjectID_Volume_Input_Master) ? theDevice->mVolume_Input_Master_Value : theDevice->mVolume_Output_Master_Value;
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					*outDataSize = sizeof(Float32);
 					break;
 
@@ -3455,9 +4922,9 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 					//	This returns the dB value of the control.
 					//	Note that we need to take the state lock to examine the value.
 					FailWithAction(inDataSize < sizeof(Float32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioLevelControlPropertyDecibelValue for the volume control");
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					*((Float32*)outData) = (inObjectID == kObjectID_Volume_Input_Master) ? gVolume_Input_Master_Value : gVolume_Output_Master_Value;
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					*((Float32*)outData) = (theObjectKind == kObjectID_Volume_Input_Master) ? theDevice->mVolume_Input_Master_Value : theDevice->mVolume_Output_Master_Value;
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					
 					//	Note that we square the scalar value before converting to dB so as to
 					//	provide a better curve for the slider
@@ -3550,7 +5017,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 				case kAudioObjectPropertyOwner:
 					//	The control's owner is the device object
 					FailWithAction(inDataSize < sizeof(AudioObjectID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioObjectPropertyOwner for the mute control");
-					*((AudioObjectID*)outData) = kObjectID_Device;
+					*((AudioObjectID*)outData) = theDevice->mObjectID;
 					*outDataSize = sizeof(AudioObjectID);
 					break;
 					
@@ -3562,7 +5029,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 				case kAudioControlPropertyScope:
 					//	This property returns the scope that the control is attached to.
 					FailWithAction(inDataSize < sizeof(AudioObjectPropertyScope), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioControlPropertyScope for the mute control");
-					*((AudioObjectPropertyScope*)outData) = (inObjectID == kObjectID_Mute_Input_Master) ? kAudioObjectPropertyScopeInput : kAudioObjectPropertyScopeOutput;
+					*((AudioObjectPropertyScope*)outData) = (theObjectKind == kObjectID_Mute_Input_Master) ? kAudioObjectPropertyScopeInput : kAudioObjectPropertyScopeOutput;
 					*outDataSize = sizeof(AudioObjectPropertyScope);
 					break;
 
@@ -3578,9 +5045,9 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 					//	and audio can be heard and 1 means that mute is on and audio cannot be heard.
 					//	Note that we need to take the state lock to examine this value.
 					FailWithAction(inDataSize < sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioBooleanControlPropertyValue for the mute control");
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					*((UInt32*)outData) = (inObjectID == kObjectID_Mute_Input_Master) ? (gMute_Input_Master_Value ? 1 : 0) : (gMute_Output_Master_Value ? 1 : 0);
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					*((UInt32*)outData) = (theObjectKind == kObjectID_Mute_Input_Master) ? (theDevice->mMute_Input_Master_Value ? 1 : 0) : (theDevice->mMute_Output_Master_Value ? 1 : 0);
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					*outDataSize = sizeof(UInt32);
 					break;
 
@@ -3606,7 +5073,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 					//	Data Source controls are of the class, kAudioDataSourceControlClassID
 					FailWithAction(inDataSize < sizeof(AudioClassID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioObjectPropertyClass for the data source control");
 					*((AudioClassID*)outData) = kAudioDataSourceControlClassID;
-					switch(inObjectID)
+					switch(theObjectKind)
 					{
 						case kObjectID_DataSource_Input_Master:
 						case kObjectID_DataSource_Output_Master:
@@ -3624,7 +5091,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 				case kAudioObjectPropertyOwner:
 					//	The control's owner is the device object
 					FailWithAction(inDataSize < sizeof(AudioObjectID), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioObjectPropertyOwner for the data source control");
-					*((AudioObjectID*)outData) = kObjectID_Device;
+					*((AudioObjectID*)outData) = theDevice->mObjectID;
 					*outDataSize = sizeof(AudioObjectID);
 					break;
 					
@@ -3636,7 +5103,7 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 				case kAudioControlPropertyScope:
 					//	This property returns the scope that the control is attached to.
 					FailWithAction(inDataSize < sizeof(AudioObjectPropertyScope), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioControlPropertyScope for the data source control");
-					switch(inObjectID)
+					switch(theObjectKind)
 					{
 						case kObjectID_DataSource_Input_Master:
 							*((AudioObjectPropertyScope*)outData) = kAudioObjectPropertyScopeInput;
@@ -3665,23 +5132,23 @@ static OSStatus	NullAudio_GetControlPropertyData(AudioServerPlugInDriverRef inDr
 					//	This returns the value of the data source selector.
 					//	Note that we need to take the state lock to examine this value.
 					FailWithAction(inDataSize < sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_GetControlPropertyData: not enough space for the return value of kAudioSelectorControlPropertyCurrentItem for the data source control");
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					switch(inObjectID)
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					switch(theObjectKind)
 					{
 						case kObjectID_DataSource_Input_Master:
-							*((UInt32*)outData) = gDataSource_Input_Master_Value;
+							*((UInt32*)outData) = theDevice->mDataSource_Input_Master_Value;
 							break;
 							
 						case kObjectID_DataSource_Output_Master:
-							*((UInt32*)outData) = gDataSource_Output_Master_Value;
+							*((UInt32*)outData) = theDevice->mDataSource_Output_Master_Value;
 							break;
 							
 						case kObjectID_DataDestination_PlayThru_Master:
-							*((UInt32*)outData) = gDataDestination_PlayThru_Master_Value;
+							*((UInt32*)outData) = theDevice->mDataDestination_PlayThru_Master_Value;
 							break;
 							
 					};
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					*outDataSize = sizeof(UInt32);
 					break;
 
@@ -3739,6 +5206,8 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inObjectID);
+	AudioObjectID theObjectKind = NullAudio_GetObjectKind(inObjectID);
 	Float32 theNewVolume;
 	
 	//	check the arguments
@@ -3746,6 +5215,7 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 	FailWithAction(inAddress == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetControlPropertyData: no address");
 	FailWithAction(outNumberPropertiesChanged == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetControlPropertyData: no place to return the number of properties that changed");
 	FailWithAction(outChangedAddresses == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetControlPropertyData: no place to return the properties that changed");
+	FailWithAction(theDevice == NULL, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_SetControlPropertyData: not a control object");
 	
 	//	initialize the returned number of changed properties
 	*outNumberPropertiesChanged = 0;
@@ -3753,7 +5223,7 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 	//	Note that for each object, this driver implements all the required properties plus a few
 	//	extras that are useful but not required. There is more detailed commentary about each
 	//	property in the NullAudio_GetControlPropertyData() method.
-	switch(inObjectID)
+	switch(theObjectKind)
 	{
 		case kObjectID_Volume_Input_Master:
 		case kObjectID_Volume_Output_Master:
@@ -3772,12 +5242,13 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 					{
 						theNewVolume = 1.0;
 					}
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					if(inObjectID == kObjectID_Volume_Input_Master)
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					if(theObjectKind == kObjectID_Volume_Input_Master)
 					{
-						if(gVolume_Input_Master_Value != theNewVolume)
+						if(theDevice->mVolume_Input_Master_Value != theNewVolume)
 						{
-							gVolume_Input_Master_Value = theNewVolume;
+							theDevice->mVolume_Input_Master_Value = theNewVolume;
+							NullAudio_UpdateGains(theDevice);
 							*outNumberPropertiesChanged = 2;
 							outChangedAddresses[0].mSelector = kAudioLevelControlPropertyScalarValue;
 							outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3789,9 +5260,10 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 					}
 					else
 					{
-						if(gVolume_Output_Master_Value != theNewVolume)
+						if(theDevice->mVolume_Output_Master_Value != theNewVolume)
 						{
-							gVolume_Output_Master_Value = theNewVolume;
+							theDevice->mVolume_Output_Master_Value = theNewVolume;
+							NullAudio_UpdateGains(theDevice);
 							*outNumberPropertiesChanged = 2;
 							outChangedAddresses[0].mSelector = kAudioLevelControlPropertyScalarValue;
 							outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3801,7 +5273,7 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 							outChangedAddresses[1].mElement = kAudioObjectPropertyElementMain;
 						}
 					}
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					break;
 				
 				case kAudioLevelControlPropertyDecibelValue:
@@ -3823,12 +5295,13 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 					theNewVolume = theNewVolume - kVolume_MinDB;
 					theNewVolume /= kVolume_MaxDB - kVolume_MinDB;
 					theNewVolume = sqrtf(theNewVolume);
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					if(inObjectID == kObjectID_Volume_Input_Master)
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					if(theObjectKind == kObjectID_Volume_Input_Master)
 					{
-						if(gVolume_Input_Master_Value != theNewVolume)
+						if(theDevice->mVolume_Input_Master_Value != theNewVolume)
 						{
-							gVolume_Input_Master_Value = theNewVolume;
+							theDevice->mVolume_Input_Master_Value = theNewVolume;
+							NullAudio_UpdateGains(theDevice);
 							*outNumberPropertiesChanged = 2;
 							outChangedAddresses[0].mSelector = kAudioLevelControlPropertyScalarValue;
 							outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3840,9 +5313,10 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 					}
 					else
 					{
-						if(gVolume_Output_Master_Value != theNewVolume)
+						if(theDevice->mVolume_Output_Master_Value != theNewVolume)
 						{
-							gVolume_Output_Master_Value = theNewVolume;
+							theDevice->mVolume_Output_Master_Value = theNewVolume;
+							NullAudio_UpdateGains(theDevice);
 							*outNumberPropertiesChanged = 2;
 							outChangedAddresses[0].mSelector = kAudioLevelControlPropertyScalarValue;
 							outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3852,7 +5326,7 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 							outChangedAddresses[1].mElement = kAudioObjectPropertyElementMain;
 						}
 					}
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					break;
 				
 				default:
@@ -3867,12 +5341,13 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 			{
 				case kAudioBooleanControlPropertyValue:
 					FailWithAction(inDataSize != sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetControlPropertyData: wrong size for the data for kAudioBooleanControlPropertyValue");
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					if(inObjectID == kObjectID_Mute_Input_Master)
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					if(theObjectKind == kObjectID_Mute_Input_Master)
 					{
-						if(gMute_Input_Master_Value != (*((const UInt32*)inData) != 0))
+						if(theDevice->mMute_Input_Master_Value != (*((const UInt32*)inData) != 0))
 						{
-							gMute_Input_Master_Value = *((const UInt32*)inData) != 0;
+							theDevice->mMute_Input_Master_Value = *((const UInt32*)inData) != 0;
+							NullAudio_UpdateGains(theDevice);
 							*outNumberPropertiesChanged = 1;
 							outChangedAddresses[0].mSelector = kAudioBooleanControlPropertyValue;
 							outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3881,16 +5356,17 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 					}
 					else
 					{
-						if(gMute_Output_Master_Value != (*((const UInt32*)inData) != 0))
+						if(theDevice->mMute_Output_Master_Value != (*((const UInt32*)inData) != 0))
 						{
-							gMute_Output_Master_Value = *((const UInt32*)inData) != 0;
+							theDevice->mMute_Output_Master_Value = *((const UInt32*)inData) != 0;
+							NullAudio_UpdateGains(theDevice);
 							*outNumberPropertiesChanged = 1;
 							outChangedAddresses[0].mSelector = kAudioBooleanControlPropertyValue;
 							outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
 							outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
 						}
 					}
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					break;
 				
 				default:
@@ -3909,14 +5385,14 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 					//	available items list and just store the value.
 					FailWithAction(inDataSize != sizeof(UInt32), theAnswer = kAudioHardwareBadPropertySizeError, Done, "NullAudio_SetControlPropertyData: wrong size for the data for kAudioSelectorControlPropertyCurrentItem");
 					FailWithAction(*((const UInt32*)inData) >= kDataSource_NumberItems, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_SetControlPropertyData: requested item not in available items list for kAudioSelectorControlPropertyCurrentItem");
-					pthread_mutex_lock(&gPlugIn_StateMutex);
-					switch(inObjectID)
+					pthread_mutex_lock(&theDevice->mStateMutex);
+					switch(theObjectKind)
 					{
 						case kObjectID_DataSource_Input_Master:
 							{
-								if(gDataSource_Input_Master_Value != *((const UInt32*)inData))
+								if(theDevice->mDataSource_Input_Master_Value != *((const UInt32*)inData))
 								{
-									gDataSource_Input_Master_Value = *((const UInt32*)inData);
+									theDevice->mDataSource_Input_Master_Value = *((const UInt32*)inData);
 									*outNumberPropertiesChanged = 1;
 									outChangedAddresses[0].mSelector = kAudioSelectorControlPropertyCurrentItem;
 									outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3927,9 +5403,9 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 							
 						case kObjectID_DataSource_Output_Master:
 							{
-								if(gDataSource_Output_Master_Value != *((const UInt32*)inData))
+								if(theDevice->mDataSource_Output_Master_Value != *((const UInt32*)inData))
 								{
-									gDataSource_Output_Master_Value = *((const UInt32*)inData);
+									theDevice->mDataSource_Output_Master_Value = *((const UInt32*)inData);
 									*outNumberPropertiesChanged = 1;
 									outChangedAddresses[0].mSelector = kAudioSelectorControlPropertyCurrentItem;
 									outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3940,9 +5416,9 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 							
 						case kObjectID_DataDestination_PlayThru_Master:
 							{
-								if(gDataDestination_PlayThru_Master_Value != *((const UInt32*)inData))
+								if(theDevice->mDataDestination_PlayThru_Master_Value != *((const UInt32*)inData))
 								{
-									gDataDestination_PlayThru_Master_Value = *((const UInt32*)inData);
+									theDevice->mDataDestination_PlayThru_Master_Value = *((const UInt32*)inData);
 									*outNumberPropertiesChanged = 1;
 									outChangedAddresses[0].mSelector = kAudioSelectorControlPropertyCurrentItem;
 									outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
@@ -3951,7 +5427,7 @@ static OSStatus	NullAudio_SetControlPropertyData(AudioServerPlugInDriverRef inDr
 							}
 							break;
 					};
-					pthread_mutex_unlock(&gPlugIn_StateMutex);
+					pthread_mutex_unlock(&theDevice->mStateMutex);
 					break;
 				
 				default:
@@ -3983,36 +5459,43 @@ static OSStatus	NullAudio_StartIO(AudioServerPlugInDriverRef inDriver, AudioObje
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_StartIO: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_StartIO: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_StartIO: bad device ID");
 
 	//	we need to hold the state lock
-	pthread_mutex_lock(&gPlugIn_StateMutex);
+	pthread_mutex_lock(&theDevice->mStateMutex);
 	
 	//	figure out what we need to do
-	if(gDevice_IOIsRunning == UINT64_MAX)
+	if(theDevice->mIOIsRunning == UINT64_MAX)
 	{
 		//	overflowing is an error
 		theAnswer = kAudioHardwareIllegalOperationError;
 	}
-	else if(gDevice_IOIsRunning == 0)
+	else if(theDevice->mIOIsRunning == 0)
 	{
-		//	We need to start the hardware, which in this case is just anchoring the time line.
-		gDevice_IOIsRunning = 1;
-		gDevice_NumberTimeStamps = 0;
-		gDevice_AnchorSampleTime = 0;
-		gDevice_AnchorHostTime = mach_absolute_time();
+		//	We need to start the hardware, which in this case is just anchoring the time line and
+		//	clearing out anything left in the rings and the mix from the last time IO was
+		//	running. Publishing a new anchor also tells the IO thread to reset its time stamp count.
+		//	The telemetry keeps accumulating across starts, but the gap since the last cycle of the
+		//	previous run isn't jitter.
+		theDevice->mIOIsRunning = 1;
+		memset(theDevice->mLoopbackRingBuffer, 0, theDevice->mLoopbackRingBufferByteSize);
+		memset(theDevice->mPlayThruRingBuffer, 0, theDevice->mPlayThruRingBufferByteSize);
+		theDevice->mMixHasData = false;
+		theDevice->mTelemetry.mLastCycleStartTime = 0;
+		NullAudio_PublishClockAnchor(theDevice, NullAudio_GetCurrentHostTime(), 0.0, NullAudio_GetHostTicksPerRingBuffer(theDevice->mSampleRate));
 	}
 	else
 	{
 		//	IO is already running, so just bump the counter
-		++gDevice_IOIsRunning;
+		++theDevice->mIOIsRunning;
 	}
 	
 	//	unlock the state lock
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	pthread_mutex_unlock(&theDevice->mStateMutex);
 	
 Done:
 	return theAnswer;
@@ -4027,33 +5510,34 @@ static OSStatus	NullAudio_StopIO(AudioServerPlugInDriverRef inDriver, AudioObjec
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_StopIO: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_StopIO: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_StopIO: bad device ID");
 
 	//	we need to hold the state lock
-	pthread_mutex_lock(&gPlugIn_StateMutex);
+	pthread_mutex_lock(&theDevice->mStateMutex);
 	
 	//	figure out what we need to do
-	if(gDevice_IOIsRunning == 0)
+	if(theDevice->mIOIsRunning == 0)
 	{
 		//	underflowing is an error
 		theAnswer = kAudioHardwareIllegalOperationError;
 	}
-	else if(gDevice_IOIsRunning == 1)
+	else if(theDevice->mIOIsRunning == 1)
 	{
 		//	We need to stop the hardware, which in this case means that there's nothing to do.
-		gDevice_IOIsRunning = 0;
+		theDevice->mIOIsRunning = 0;
 	}
 	else
 	{
 		//	IO is still running, so just bump the counter
-		--gDevice_IOIsRunning;
+		--theDevice->mIOIsRunning;
 	}
 	
 	//	unlock the state lock
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	pthread_mutex_unlock(&theDevice->mStateMutex);
 	
 Done:
 	return theAnswer;
@@ -4068,46 +5552,59 @@ static OSStatus	NullAudio_GetZeroTimeStamp(AudioServerPlugInDriverRef inDriver,
 	//	where the zero time stamp is updated when wrapping around the ring buffer.
 	//
 	//	For this device, the zero time stamps' sample time increments every kDevice_RingBufferSize
-	//	frames and the host time increments by kDevice_RingBufferSize * gDevice_HostTicksPerFrame.
+	//	frames and the host time increments by the exact number of host ticks in that many frames.
+	//	The IO thread keeps the current time stamp's host time as a whole number of ticks past the
+	//	anchor plus a remainder, so no error builds up as the count of time stamps grows.
+	//
+	//	This method is called on the IO thread every cycle, so it doesn't take any locks. The anchor
+	//	is read through the sequence lock and the count of time stamps is only ever touched by the IO
+	//	thread. The count is reset whenever the anchor's generation changes.
 	
 	#pragma unused(inClientID)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	NullAudio_ClockAnchor theAnchor;
 	UInt64 theCurrentHostTime;
-	Float64 theHostTicksPerRingBuffer;
-	Float64 theHostTickOffset;
-	UInt64 theNextHostTime;
+	UInt64 theNextHostOffset;
+	UInt64 theNextHostOffsetRemainder;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetZeroTimeStamp: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetZeroTimeStamp: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_GetZeroTimeStamp: bad device ID");
 
-	//	we need to hold the locks
-	pthread_mutex_lock(&gDevice_IOMutex);
+	//	get a consistent copy of the anchor
+	NullAudio_CopyClockAnchor(theDevice, &theAnchor);
+	if(theAnchor.mGeneration != theDevice->mNumberTimeStampsGeneration)
+	{
+		theDevice->mNumberTimeStampsGeneration = theAnchor.mGeneration;
+		theDevice->mNumberTimeStamps = 0;
+		theDevice->mZeroTimeStampHostOffset = 0;
+		theDevice->mZeroTimeStampHostOffsetRemainder = 0;
+	}
 	
 	//	get the current host time
-	theCurrentHostTime = mach_absolute_time();
+	theCurrentHostTime = NullAudio_GetCurrentHostTime();
 	
 	//	calculate the next host time
-	theHostTicksPerRingBuffer = gDevice_HostTicksPerFrame * ((Float64)kDevice_RingBufferSize);
-	theHostTickOffset = ((Float64)(gDevice_NumberTimeStamps + 1)) * theHostTicksPerRingBuffer;
-	theNextHostTime = gDevice_AnchorHostTime + ((UInt64)theHostTickOffset);
+	theNextHostOffset = theDevice->mZeroTimeStampHostOffset;
+	theNextHostOffsetRemainder = theDevice->mZeroTimeStampHostOffsetRemainder;
+	NullAudio_AdvanceHostOffset(&theAnchor.mHostTicksPerRingBuffer, &theNextHostOffset, &theNextHostOffsetRemainder);
 	
 	//	go to the next time if the next host time is less than the current time
-	if(theNextHostTime <= theCurrentHostTime)
+	if((theAnchor.mHostTime + theNextHostOffset) <= theCurrentHostTime)
 	{
-		++gDevice_NumberTimeStamps;
+		++theDevice->mNumberTimeStamps;
+		theDevice->mZeroTimeStampHostOffset = theNextHostOffset;
+		theDevice->mZeroTimeStampHostOffsetRemainder = theNextHostOffsetRemainder;
 	}
 	
 	//	set the return values
-	*outSampleTime = gDevice_NumberTimeStamps * kDevice_RingBufferSize;
-	*outHostTime = gDevice_AnchorHostTime + (((Float64)gDevice_NumberTimeStamps) * theHostTicksPerRingBuffer);
+	*outSampleTime = theAnchor.mSampleTime + (theDevice->mNumberTimeStamps * kDevice_RingBufferSize);
+	*outHostTime = theAnchor.mHostTime + theDevice->mZeroTimeStampHostOffset;
 	*outSeed = 1;
 	
-	//	unlock the state lock
-	pthread_mutex_unlock(&gDevice_IOMutex);
-	
 Done:
 	return theAnswer;
 }
@@ -4115,16 +5612,21 @@ Done:
 static OSStatus	NullAudio_WillDoIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, Boolean* outWillDo, Boolean* outWillDoInPlace)
 {
 	//	This method returns whether or not the device will do a given IO operation. For this device,
-	//	we only support reading input data and writing output data.
+	//	we support reading input data and writing output data, plus converting between the physical
+	//	format and the float virtual format, which are all done in place. We also mix the clients'
+	//	output ourselves, which can't be done in place since it needs both the client's buffer and
+	//	the mix buffer. The cycle operation is only used to time the whole IO cycle for the
+	//	telemetry. It never gets a DoIOOperation call.
 	
 	#pragma unused(inClientID)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_WillDoIOOperation: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_WillDoIOOperation: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_WillDoIOOperation: bad device ID");
 
 	//	figure out if we support the operation
 	bool willDo = false;
@@ -4141,6 +5643,26 @@ static OSStatus	NullAudio_WillDoIOOperation(AudioServerPlugInDriverRef inDriver,
 			willDoInPlace = true;
 			break;
 			
+		case kAudioServerPlugInIOOperationConvertInput:
+			willDo = true;
+			willDoInPlace = true;
+			break;
+			
+		case kAudioServerPlugInIOOperationConvertMix:
+			willDo = true;
+			willDoInPlace = true;
+			break;
+			
+		case kAudioServerPlugInIOOperationMixOutput:
+			willDo = true;
+			willDoInPlace = false;
+			break;
+			
+		case kAudioServerPlugInIOOperationCycle:
+			willDo = true;
+			willDoInPlace = true;
+			break;
+			
 	};
 	
 	//	fill out the return values
@@ -4159,17 +5681,48 @@ Done:
 
 static OSStatus	NullAudio_BeginIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo)
 {
-	//	This is called at the beginning of an IO operation. This device doesn't do anything, so just
-	//	check the arguments and return.
+	//	This is called at the beginning of an IO operation. This device just notes the time for the
+	//	telemetry. At the start of a cycle, it also records how far the time since the start of the
+	//	last cycle is from one IO buffer's worth of time at the nominal rate.
 	
-	#pragma unused(inClientID, inOperationID, inIOBufferFrameSize, inIOCycleInfo)
+	#pragma unused(inClientID, inIOCycleInfo)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	NullAudio_Telemetry* theTelemetry = NULL;
+	NullAudio_ClockAnchor theAnchor;
+	UInt64 theCurrentTime = 0;
+	UInt64 theExpectedInterval = 0;
+	UInt64 theInterval = 0;
+	UInt32 theOperation = 0;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_BeginIOOperation: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_BeginIOOperation: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_BeginIOOperation: bad device ID");
+	
+	theTelemetry = &theDevice->mTelemetry;
+	theCurrentTime = NullAudio_GetCurrentHostTime();
+	if(inOperationID == kAudioServerPlugInIOOperationCycle)
+	{
+		if(theTelemetry->mLastCycleStartTime != 0)
+		{
+			NullAudio_CopyClockAnchor(theDevice, &theAnchor);
+			theExpectedInterval = NullAudio_GetHostTicksPerIOCycle(&theAnchor.mHostTicksPerRingBuffer, inIOBufferFrameSize);
+			theInterval = theCurrentTime - theTelemetry->mLastCycleStartTime;
+			NullAudio_RecordHistogramValue(&theTelemetry->mCycleJitter, (theInterval > theExpectedInterval) ? (theInterval - theExpectedInterval) : (theExpectedInterval - theInterval));
+		}
+		theTelemetry->mCycleStartTime = theCurrentTime;
+		theTelemetry->mLastCycleStartTime = theCurrentTime;
+	}
+	else
+	{
+		theOperation = NullAudio_GetTelemetryOperation(inOperationID);
+		if(theOperation < kTelemetry_NumberOperations)
+		{
+			theTelemetry->mOperationStartTime[theOperation] = theCurrentTime;
+		}
+	}
 
 Done:
 	return theAnswer;
@@ -4177,25 +5730,80 @@ Done:
 
 static OSStatus	NullAudio_DoIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioObjectID inStreamObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo, void* ioMainBuffer, void* ioSecondaryBuffer)
 {
-	//	This is called to actuall perform a given operation. For this device, all we need to do is
-	//	clear the buffer for the ReadInput operation.
-	
-	#pragma unused(inClientID, inIOCycleInfo, ioSecondaryBuffer)
+	//	This is called to actuall perform a given operation. For this device, that means moving the
+	//	data through the loopback ring. MixOutput sums each client's output into the mix. ConvertMix
+	//	adds in the play-through, applies the output volume and mute to the float mix and converts it
+	//	to the physical format, and WriteMix puts it in the ring at the output time.
+	//	ReadInput takes it back out of the ring at the input time, and ConvertInput converts it back
+	//	to float, applies the input volume and mute and saves it for play-through.
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	NullAudio_Client* theClient = NULL;
+	Float32 theGain = 0.0;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DoIOOperation: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DoIOOperation: bad device ID");
-	FailWithAction((inStreamObjectID != kObjectID_Stream_Input) && (inStreamObjectID != kObjectID_Stream_Output), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DoIOOperation: bad stream ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DoIOOperation: bad device ID");
+	FailWithAction((inStreamObjectID != NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Input)) && (inStreamObjectID != NullAudio_GetDeviceObjectID(theDevice, kObjectID_Stream_Output)), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_DoIOOperation: bad stream ID");
 
-	//	clear the buffer if this iskAudioServerPlugInIOOperationReadInput
-	if(inOperationID == kAudioServerPlugInIOOperationReadInput)
+	FailWithAction(inIOBufferFrameSize > kDevice_RingBufferSize, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_DoIOOperation: the IO buffer is larger than the loopback ring");
+
+	//	The format can't change while IO is running, so it is safe to look at it without the lock.
+	//	ReadInput and WriteMix see the physical format, ConvertInput and ConvertMix see both.
+	switch(inOperationID)
 	{
-		//	we are always dealing with a 2 channel 32 bit float buffer
-		memset(ioMainBuffer, 0, inIOBufferFrameSize * 8);
-	}
+		case kAudioServerPlugInIOOperationReadInput:
+			NullAudio_ReadFromLoopbackRingBuffer(theDevice, inIOCycleInfo->mInputTime.mSampleTime, inIOBufferFrameSize, ioMainBuffer);
+			break;
+			
+		case kAudioServerPlugInIOOperationConvertInput:
+			NullAudio_ConvertToFloat(ioMainBuffer, theDevice->mSampleFormat, (Float32*)ioMainBuffer, inIOBufferFrameSize * theDevice->mChannelsPerFrame);
+			theGain = atomic_load_explicit(&theDevice->mGain_Input_Master, memory_order_relaxed);
+			NullAudio_ApplyGain((Float32*)ioMainBuffer, inIOBufferFrameSize, theDevice->mChannelsPerFrame, theDevice->mAppliedGain_Input_Master, theGain);
+			theDevice->mAppliedGain_Input_Master = theGain;
+			NullAudio_WriteToPlayThruRingBuffer(theDevice, inIOCycleInfo->mInputTime.mSampleTime, inIOBufferFrameSize, (const Float32*)ioMainBuffer);
+			break;
+			
+		case kAudioServerPlugInIOOperationMixOutput:
+			FailWithAction(ioSecondaryBuffer == NULL, theAnswer = kAudioHardwareIllegalOperationError, Done, "NullAudio_DoIOOperation: no mix buffer for MixOutput");
+			if(theDevice->mMixCycleCounter != inIOCycleInfo->mIOCycleCounter)
+			{
+				//	the first client in this cycle starts the mix
+				theDevice->mMixCycleCounter = inIOCycleInfo->mIOCycleCounter;
+				theDevice->mMixHasData = true;
+				memcpy(ioSecondaryBuffer, ioMainBuffer, inIOBufferFrameSize * theDevice->mChannelsPerFrame * sizeof(Float32));
+			}
+			else
+			{
+				NullAudio_AccumulateSamples((const Float32*)ioMainBuffer, (Float32*)ioSecondaryBuffer, inIOBufferFrameSize * theDevice->mChannelsPerFrame);
+			}
+			theClient = NullAudio_FindClient(theDevice, inClientID);
+			if(theClient != NULL)
+			{
+				theClient->mMixCycleCounter = inIOCycleInfo->mIOCycleCounter;
+				theClient->mNumberFramesMixed += inIOBufferFrameSize;
+			}
+			break;
+			
+		case kAudioServerPlugInIOOperationConvertMix:
+			if(!theDevice->mMixHasData || (theDevice->mMixCycleCounter != inIOCycleInfo->mIOCycleCounter))
+			{
+				//	no client mixed anything this cycle
+				memset(ioMainBuffer, 0, inIOBufferFrameSize * theDevice->mChannelsPerFrame * sizeof(Float32));
+			}
+			NullAudio_MixFromPlayThruRingBuffer(theDevice, inIOCycleInfo->mInputTime.mSampleTime, inIOCycleInfo->mOutputTime.mSampleTime, inIOBufferFrameSize, (Float32*)ioMainBuffer);
+			theGain = atomic_load_explicit(&theDevice->mGain_Output_Master, memory_order_relaxed);
+			NullAudio_ApplyGain((Float32*)ioMainBuffer, inIOBufferFrameSize, theDevice->mChannelsPerFrame, theDevice->mAppliedGain_Output_Master, theGain);
+			theDevice->mAppliedGain_Output_Master = theGain;
+			NullAudio_ConvertFromFloat((const Float32*)ioMainBuffer, theDevice->mSampleFormat, ioMainBuffer, inIOBufferFrameSize * theDevice->mChannelsPerFrame);
+			break;
+			
+		case kAudioServerPlugInIOOperationWriteMix:
+			NullAudio_WriteToLoopbackRingBuffer(theDevice, inIOCycleInfo->mOutputTime.mSampleTime, inIOBufferFrameSize, ioMainBuffer);
+			break;
+	};
 
 Done:
 	return theAnswer;
@@ -4203,17 +5811,45 @@ Done:
 
 static OSStatus	NullAudio_EndIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo)
 {
-	//	This is called at the end of an IO operation. This device doesn't do anything, so just check
-	//	the arguments and return.
+	//	This is called at the end of an IO operation. This device just records how long the operation
+	//	took for the telemetry. A cycle that took longer than one IO buffer's worth of time at the
+	//	nominal rate counts as an overload.
 	
-	#pragma unused(inClientID, inOperationID, inIOBufferFrameSize, inIOCycleInfo)
+	#pragma unused(inClientID, inIOCycleInfo)
 	
 	//	declare the local variables
 	OSStatus theAnswer = 0;
+	NullAudio_Device* theDevice = NullAudio_FindDevice(inDeviceObjectID);
+	NullAudio_Telemetry* theTelemetry = NULL;
+	NullAudio_ClockAnchor theAnchor;
+	UInt64 theCurrentTime = 0;
+	UInt64 theDuration = 0;
+	UInt32 theOperation = 0;
 	
 	//	check the arguments
 	FailWithAction(inDriver != gAudioServerPlugInDriverRef, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_EndIOOperation: bad driver reference");
-	FailWithAction(inDeviceObjectID != kObjectID_Device, theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_EndIOOperation: bad device ID");
+	FailWithAction((theDevice == NULL) || (theDevice->mObjectID != inDeviceObjectID), theAnswer = kAudioHardwareBadObjectError, Done, "NullAudio_EndIOOperation: bad device ID");
+	
+	theTelemetry = &theDevice->mTelemetry;
+	theCurrentTime = NullAudio_GetCurrentHostTime();
+	if(inOperationID == kAudioServerPlugInIOOperationCycle)
+	{
+		theDuration = theCurrentTime - theTelemetry->mCycleStartTime;
+		NullAudio_RecordHistogramValue(&theTelemetry->mCycleDuration, theDuration);
+		NullAudio_CopyClockAnchor(theDevice, &theAnchor);
+		if(theDuration > NullAudio_GetHostTicksPerIOCycle(&theAnchor.mHostTicksPerRingBuffer, inIOBufferFrameSize))
+		{
+			atomic_fetch_add_explicit(&theTelemetry->mNumberOverloads, 1, memory_order_relaxed);
+		}
+	}
+	else
+	{
+		theOperation = NullAudio_GetTelemetryOperation(inOperationID);
+		if(theOperation < kTelemetry_NumberOperations)
+		{
+			NullAudio_RecordHistogramValue(&theTelemetry->mOperationDuration[theOperation], theCurrentTime - theTelemetry->mOperationStartTime[theOperation]);
+		}
+	}
 
 Done:
 	return theAnswer;
@@ -0,0 +1,165 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Runs NullAudio's zero time stamps through 30 days on the simulated clock and checks that they never drift.
+*/
+
+/*==================================================================================================
+	ClockDrift.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include "NullAudioHost.h"
+
+#include <mach/mach_time.h>
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Clock Drift
+//==================================================================================================
+
+//	The clock runs with the 125/3 timebase of Apple silicon, where a ring buffer is never a whole
+//	number of host ticks. The test works out when each zero time stamp is due from the exact
+//	fraction, independently of the driver, and moves the simulated clock to one tick before that
+//	time and then to that time. The driver must hold the previous time stamp at the first and move
+//	to the new one, with exactly the expected host time, at the second. A time stamp that's a tick
+//	early or late anywhere in the 30 days is a failure.
+
+static const UInt32		kTimebaseNumerator		= 125;
+static const UInt32		kTimebaseDenominator	= 3;
+static const UInt64		kRingBufferSize			= 16384;
+static const UInt64		kSimulatedSeconds		= 30ULL * 24ULL * 60ULL * 60ULL;
+static const UInt64		kStartHostTime			= 1000000000007ULL;
+static const Float64	kSampleRates[]			= { 44100.0, 48000.0, 96000.0 };
+static const UInt64		kSampleRateChangeTimeout	= 10ULL * 1000ULL * 1000ULL * 1000ULL;
+#define					kNumberSampleRates		(sizeof(kSampleRates) / sizeof(kSampleRates[0]))
+
+static UInt64	gNumberFailures = 0;
+
+static UInt64	ClockDrift_GetExpectedHostTime(UInt64 inNumberTimeStamps, Float64 inSampleRate)
+{
+	//	ticks = n * ring buffer size * 10^9 * denom / (numer * rate), rounded down, in 128 bits
+	unsigned __int128 theNumerator = (unsigned __int128)inNumberTimeStamps * kRingBufferSize * 1000000000ULL * kTimebaseDenominator;
+	unsigned __int128 theDenominator = (unsigned __int128)kTimebaseNumerator * (UInt64)inSampleRate;
+	return kStartHostTime + (UInt64)(theNumerator / theDenominator);
+}
+
+static void	ClockDrift_Check(AudioServerPlugInDriverRef inDriver, AudioObjectID inDevice, Float64 inSampleRate, UInt64 inNumberTimeStamps, UInt64* ioNumberMismatches)
+{
+	Float64 theSampleTime = 0;
+	UInt64 theHostTime = 0;
+	UInt64 theSeed = 0;
+	OSStatus theError = (*inDriver)->GetZeroTimeStamp(inDriver, inDevice, 1, &theSampleTime, &theHostTime, &theSeed);
+	if((theError != 0) || (theSampleTime != (Float64)(inNumberTimeStamps * kRingBufferSize)) || (theHostTime != ClockDrift_GetExpectedHostTime(inNumberTimeStamps, inSampleRate)))
+	{
+		if(*ioNumberMismatches == 0)
+		{
+			fprintf(stderr, "ClockDrift: %.0f Hz, time stamp %llu: got sample time %.0f at host time %llu, expected %llu at %llu\n", inSampleRate, (unsigned long long)inNumberTimeStamps, theSampleTime, (unsigned long long)theHostTime, (unsigned long long)(inNumberTimeStamps * kRingBufferSize), (unsigned long long)ClockDrift_GetExpectedHostTime(inNumberTimeStamps, inSampleRate));
+		}
+		++*ioNumberMismatches;
+	}
+}
+
+static void	ClockDrift_Run(AudioServerPlugInDriverRef inDriver, AudioObjectID inDevice, Float64 inSampleRate)
+{
+	//	set the sample rate while IO is stopped
+	AudioObjectPropertyAddress theAddress = { kAudioDevicePropertyNominalSampleRate, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	if((*inDriver)->SetPropertyData(inDriver, inDevice, 0, &theAddress, 0, NULL, sizeof(Float64), &inSampleRate) != 0)
+	{
+		fprintf(stderr, "ClockDrift: couldn't set the sample rate to %.0f Hz\n", inSampleRate);
+		++gNumberFailures;
+		return;
+	}
+	
+	//	the driver asks for the change from another thread, so wait for it to be performed
+	Float64 theSampleRate = 0;
+	UInt64 theWaitStartTime = NullAudioHost_GetNanoseconds();
+	while(theSampleRate != inSampleRate)
+	{
+		UInt32 theDataSize = sizeof(Float64);
+		if(((*inDriver)->GetPropertyData(inDriver, inDevice, 0, &theAddress, 0, NULL, theDataSize, &theDataSize, &theSampleRate) != 0) || ((NullAudioHost_GetNanoseconds() - theWaitStartTime) > kSampleRateChangeTimeout))
+		{
+			fprintf(stderr, "ClockDrift: the sample rate never changed to %.0f Hz\n", inSampleRate);
+			++gNumberFailures;
+			return;
+		}
+		sched_yield();
+	}
+
+	//	start IO, which anchors the time line at the current simulated time
+	NullAudioHost_SetSimulatedTime(kStartHostTime);
+	NullAudioHost_IOContext theContext;
+	if(NullAudioHost_StartIO(&theContext, inDriver, inDevice, 1, 512) != 0)
+	{
+		fprintf(stderr, "ClockDrift: StartIO failed at %.0f Hz\n", inSampleRate);
+		++gNumberFailures;
+		return;
+	}
+
+	UInt64 theNumberTimeStamps = (UInt64)(kSimulatedSeconds * inSampleRate) / kRingBufferSize;
+	UInt64 theNumberMismatches = 0;
+	UInt64 theStartTime = NullAudioHost_GetNanoseconds();
+	ClockDrift_Check(inDriver, inDevice, inSampleRate, 0, &theNumberMismatches);
+	for(UInt64 theTimeStamp = 1; theTimeStamp <= theNumberTimeStamps; ++theTimeStamp)
+	{
+		UInt64 theDueTime = ClockDrift_GetExpectedHostTime(theTimeStamp, inSampleRate);
+		NullAudioHost_SetSimulatedTime(theDueTime - 1);
+		ClockDrift_Check(inDriver, inDevice, inSampleRate, theTimeStamp - 1, &theNumberMismatches);
+		NullAudioHost_SetSimulatedTime(theDueTime);
+		ClockDrift_Check(inDriver, inDevice, inSampleRate, theTimeStamp, &theNumberMismatches);
+	}
+	UInt64 theElapsedTime = NullAudioHost_GetNanoseconds() - theStartTime;
+	NullAudioHost_StopIO(&theContext);
+
+	//	How far the last time stamp is from the true time of its sample time. This can only be the
+	//	rounding down to a whole tick, so it must be less than one tick.
+	Float64 theTrueNanoseconds = ((Float64)(theNumberTimeStamps * kRingBufferSize) * 1.0e9) / inSampleRate;
+	Float64 theStampNanoseconds = ((Float64)(ClockDrift_GetExpectedHostTime(theNumberTimeStamps, inSampleRate) - kStartHostTime) * kTimebaseNumerator) / kTimebaseDenominator;
+	Float64 theOffset = theTrueNanoseconds - theStampNanoseconds;
+
+	printf("%8.0f %12llu %12llu %14.1f %10.2f\n", inSampleRate, (unsigned long long)theNumberTimeStamps, (unsigned long long)theNumberMismatches, theOffset, theElapsedTime / 1.0e9);
+	if(theNumberMismatches != 0)
+	{
+		++gNumberFailures;
+	}
+	if((theOffset < 0.0) || (theOffset >= ((Float64)kTimebaseNumerator / kTimebaseDenominator)))
+	{
+		fprintf(stderr, "ClockDrift: %.0f Hz: the last time stamp is %.1f ns from the true time\n", inSampleRate, theOffset);
+		++gNumberFailures;
+	}
+}
+
+int	main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	NullAudioHost_SetTimebase(kTimebaseNumerator, kTimebaseDenominator);
+	NullAudioHost_UseSimulatedClock(true);
+	NullAudioHost_SetSimulatedTime(kStartHostTime);
+	AudioServerPlugInDriverRef theDriver = NullAudioHost_OpenDriver(1);
+	AudioObjectID theDevice = kAudioObjectUnknown;
+	if(NullAudioHost_CopyDeviceList(theDriver, &theDevice, 1) != 1)
+	{
+		fprintf(stderr, "ClockDrift: the driver has no devices\n");
+		return 1;
+	}
+
+	printf("NullAudio zero time stamps over %llu simulated days, %u/%u timebase\n", (unsigned long long)(kSimulatedSeconds / (24 * 60 * 60)), kTimebaseNumerator, kTimebaseDenominator);
+	printf("%8s %12s %12s %14s %10s\n", "rate", "time stamps", "mismatches", "last error ns", "seconds");
+	for(UInt32 theRateIndex = 0; theRateIndex < kNumberSampleRates; ++theRateIndex)
+	{
+		ClockDrift_Run(theDriver, theDevice, kSampleRates[theRateIndex]);
+	}
+
+	printf("ClockDrift: %llu failures\n", (unsigned long long)gNumberFailures);
+	return (gNumberFailures == 0) ? 0 : 1;
+}
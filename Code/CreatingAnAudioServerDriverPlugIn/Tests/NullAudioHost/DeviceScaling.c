@@ -0,0 +1,317 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Runs IO on up to 64 NullAudio devices at once, with property traffic on other devices, and checks that the IO never waits.
+*/
+
+/*==================================================================================================
+	DeviceScaling.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	for RUSAGE_THREAD
+#define _GNU_SOURCE
+
+#include "NullAudioHost.h"
+
+#include <sys/resource.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Device Scaling
+//==================================================================================================
+
+//	Each device doing IO gets its own thread, standing in for the HAL's IO thread for that device,
+//	which runs a fixed number of IO cycles as fast as it can. The property threads share the devices
+//	that aren't doing IO and loop over changing their sample rate, volume, and mute until the last
+//	IO thread is done, which takes each device's mStateMutex and runs configuration changes. The IO
+//	path takes no locks at all, so no IO thread may ever wait, which shows as voluntary context
+//	switches. The cycle times include time spent preempted by the other threads, so they only say
+//	how the load is spread, not what one cycle costs.
+
+#define					kNumberDevices			64
+static const UInt32		kIOBufferFrameSize		= 512;
+static const UInt32		kNumberCycles			= 2000;
+#define					kNumberPropertyThreads	4
+static const Float64	kSampleRates[]			= { 44100.0, 48000.0, 96000.0 };
+
+typedef struct DeviceScaling_Configuration
+{
+	const char*	mName;
+	UInt32		mNumberIODevices;
+	bool		mHasPropertyTraffic;
+} DeviceScaling_Configuration;
+
+static const DeviceScaling_Configuration	kConfigurations[] =
+{
+	{ "one device",							1,	false },
+	{ "64 devices",							64,	false },
+	{ "48 devices, traffic on 16 others",	48,	true }
+};
+#define										kNumberConfigurations	(sizeof(kConfigurations) / sizeof(kConfigurations[0]))
+
+typedef struct DeviceScaling_Thread
+{
+	AudioServerPlugInDriverRef	mDriver;
+	const AudioObjectID*		mDevices;
+	UInt32						mNumberDevices;
+	pthread_barrier_t*			mBarrier;
+	pthread_t					mThread;
+	NullAudioHost_Samples		mCycleTimes;
+	UInt64						mStartTime;
+	UInt64						mEndTime;
+	UInt64						mNumberCalls;
+	UInt64						mNumberWaits;
+	UInt64						mNumberFailures;
+} DeviceScaling_Thread;
+
+static _Atomic UInt32	gIOThreads_NumberRunning = 0;
+static UInt64			gNumberFailures = 0;
+
+static UInt64	DeviceScaling_GetNumberVoluntarySwitches(void)
+{
+	struct rusage theUsage;
+	getrusage(RUSAGE_THREAD, &theUsage);
+	return (UInt64)theUsage.ru_nvcsw;
+}
+
+static void*	DeviceScaling_RunIO(void* inThread)
+{
+	DeviceScaling_Thread* theThread = (DeviceScaling_Thread*)inThread;
+	NullAudioHost_IOContext theContext;
+	if(NullAudioHost_StartIO(&theContext, theThread->mDriver, theThread->mDevices[0], 1, kIOBufferFrameSize) != 0)
+	{
+		++theThread->mNumberFailures;
+	}
+
+	pthread_barrier_wait(theThread->mBarrier);
+	theThread->mStartTime = NullAudioHost_GetNanoseconds();
+	UInt64 theSwitchesBefore = DeviceScaling_GetNumberVoluntarySwitches();
+	for(UInt32 theCycle = 0; theCycle < kNumberCycles; ++theCycle)
+	{
+		UInt64 theStartTime = NullAudioHost_GetNanoseconds();
+		if(NullAudioHost_RunIOCycle(&theContext, kIOBufferFrameSize, NULL) != 0)
+		{
+			++theThread->mNumberFailures;
+		}
+		NullAudioHost_AddSample(&theThread->mCycleTimes, NullAudioHost_GetNanoseconds() - theStartTime);
+	}
+	theThread->mNumberWaits = DeviceScaling_GetNumberVoluntarySwitches() - theSwitchesBefore;
+	theThread->mEndTime = NullAudioHost_GetNanoseconds();
+	theThread->mNumberCalls = kNumberCycles;
+	atomic_fetch_sub_explicit(&gIOThreads_NumberRunning, 1, memory_order_relaxed);
+
+	NullAudioHost_StopIO(&theContext);
+	return NULL;
+}
+
+static void*	DeviceScaling_RunProperties(void* inThread)
+{
+	DeviceScaling_Thread* theThread = (DeviceScaling_Thread*)inThread;
+	AudioServerPlugInDriverRef theDriver = theThread->mDriver;
+	AudioObjectPropertyAddress theRateAddress = { kAudioDevicePropertyNominalSampleRate, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	AudioObjectPropertyAddress theVolumeAddress = { kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	AudioObjectPropertyAddress theMuteAddress = { kAudioBooleanControlPropertyValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+
+	pthread_barrier_wait(theThread->mBarrier);
+	while(atomic_load_explicit(&gIOThreads_NumberRunning, memory_order_relaxed) != 0)
+	{
+		AudioObjectID theDevice = theThread->mDevices[theThread->mNumberCalls % theThread->mNumberDevices];
+		Float64 theSampleRate = kSampleRates[theThread->mNumberCalls % (sizeof(kSampleRates) / sizeof(kSampleRates[0]))];
+		Float32 theVolume = ((theThread->mNumberCalls & 1) != 0) ? 0.25f : 0.75f;
+		UInt32 theMute = (UInt32)(theThread->mNumberCalls & 1);
+		AudioObjectID theVolumeControl = NullAudioHost_GetControl(theDriver, theDevice, kAudioVolumeControlClassID, kAudioObjectPropertyScopeOutput);
+		AudioObjectID theMuteControl = NullAudioHost_GetControl(theDriver, theDevice, kAudioMuteControlClassID, kAudioObjectPropertyScopeOutput);
+		if(((*theDriver)->SetPropertyData(theDriver, theDevice, 0, &theRateAddress, 0, NULL, sizeof(Float64), &theSampleRate) != 0) ||
+		   ((*theDriver)->SetPropertyData(theDriver, theVolumeControl, 0, &theVolumeAddress, 0, NULL, sizeof(Float32), &theVolume) != 0) ||
+		   ((*theDriver)->SetPropertyData(theDriver, theMuteControl, 0, &theMuteAddress, 0, NULL, sizeof(UInt32), &theMute) != 0))
+		{
+			++theThread->mNumberFailures;
+		}
+		theThread->mNumberCalls += 3;
+	}
+	return NULL;
+}
+
+static Float32	DeviceScaling_GetVolume(AudioServerPlugInDriverRef inDriver, AudioObjectID inDevice)
+{
+	AudioObjectPropertyAddress theAddress = { kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	AudioObjectID theVolumeControl = NullAudioHost_GetControl(inDriver, inDevice, kAudioVolumeControlClassID, kAudioObjectPropertyScopeOutput);
+	Float32 theVolume = -1.0f;
+	UInt32 theDataSize = 0;
+	(*inDriver)->GetPropertyData(inDriver, theVolumeControl, 0, &theAddress, 0, NULL, sizeof(Float32), &theDataSize, &theVolume);
+	return theVolume;
+}
+
+static void	DeviceScaling_Run(AudioServerPlugInDriverRef inDriver, const AudioObjectID* inDevices, const DeviceScaling_Configuration* inConfiguration)
+{
+	UInt32 theNumberIODevices = inConfiguration->mNumberIODevices;
+	UInt32 theNumberPropertyThreads = inConfiguration->mHasPropertyTraffic ? kNumberPropertyThreads : 0;
+	DeviceScaling_Thread theThreads[kNumberDevices + kNumberPropertyThreads];
+	pthread_barrier_t theBarrier;
+	pthread_barrier_init(&theBarrier, NULL, theNumberIODevices + theNumberPropertyThreads + 1);
+	atomic_store_explicit(&gIOThreads_NumberRunning, theNumberIODevices, memory_order_relaxed);
+
+	//	the traffic must not reach the devices doing IO
+	Float32 theVolumesBefore[kNumberDevices];
+	for(UInt32 theDeviceIndex = 0; theDeviceIndex < theNumberIODevices; ++theDeviceIndex)
+	{
+		theVolumesBefore[theDeviceIndex] = DeviceScaling_GetVolume(inDriver, inDevices[theDeviceIndex]);
+	}
+
+	for(UInt32 theThreadIndex = 0; theThreadIndex < theNumberIODevices + theNumberPropertyThreads; ++theThreadIndex)
+	{
+		DeviceScaling_Thread* theThread = &theThreads[theThreadIndex];
+		memset(theThread, 0, sizeof(DeviceScaling_Thread));
+		theThread->mDriver = inDriver;
+		theThread->mBarrier = &theBarrier;
+		if(theThreadIndex < theNumberIODevices)
+		{
+			theThread->mDevices = &inDevices[theThreadIndex];
+			theThread->mNumberDevices = 1;
+			NullAudioHost_InitSamples(&theThread->mCycleTimes, kNumberCycles);
+			pthread_create(&theThread->mThread, NULL, DeviceScaling_RunIO, theThread);
+		}
+		else
+		{
+			theThread->mDevices = &inDevices[theNumberIODevices];
+			theThread->mNumberDevices = kNumberDevices - theNumberIODevices;
+			pthread_create(&theThread->mThread, NULL, DeviceScaling_RunProperties, theThread);
+		}
+	}
+
+	//	wait for everything to finish, timing the IO from the first thread's start to the last one's end
+	pthread_barrier_wait(&theBarrier);
+	UInt64 theStartTime = UINT64_MAX;
+	UInt64 theEndTime = 0;
+	NullAudioHost_Samples theCycleTimes;
+	NullAudioHost_InitSamples(&theCycleTimes, theNumberIODevices * kNumberCycles);
+	UInt64 theNumberWaits = 0;
+	for(UInt32 theThreadIndex = 0; theThreadIndex < theNumberIODevices; ++theThreadIndex)
+	{
+		DeviceScaling_Thread* theThread = &theThreads[theThreadIndex];
+		pthread_join(theThread->mThread, NULL);
+		for(UInt32 theIndex = 0; theIndex < theThread->mCycleTimes.mNumberValues; ++theIndex)
+		{
+			NullAudioHost_AddSample(&theCycleTimes, theThread->mCycleTimes.mValues[theIndex]);
+		}
+		NullAudioHost_FreeSamples(&theThread->mCycleTimes);
+		theNumberWaits += theThread->mNumberWaits;
+		theStartTime = (theThread->mStartTime < theStartTime) ? theThread->mStartTime : theStartTime;
+		theEndTime = (theThread->mEndTime > theEndTime) ? theThread->mEndTime : theEndTime;
+		gNumberFailures += theThread->mNumberFailures;
+	}
+	UInt64 theElapsedTime = theEndTime - theStartTime;
+	UInt64 theNumberPropertyCalls = 0;
+	for(UInt32 theThreadIndex = theNumberIODevices; theThreadIndex < theNumberIODevices + theNumberPropertyThreads; ++theThreadIndex)
+	{
+		pthread_join(theThreads[theThreadIndex].mThread, NULL);
+		theNumberPropertyCalls += theThreads[theThreadIndex].mNumberCalls;
+		gNumberFailures += theThreads[theThreadIndex].mNumberFailures;
+	}
+	pthread_barrier_destroy(&theBarrier);
+
+	printf("%-34s %12.0f %12.0f %8llu %8llu %8llu %6llu\n", inConfiguration->mName, (theCycleTimes.mNumberValues * 1.0e9) / theElapsedTime, (theNumberPropertyCalls * 1.0e9) / theElapsedTime, (unsigned long long)NullAudioHost_GetPercentile(&theCycleTimes, 50.0), (unsigned long long)NullAudioHost_GetPercentile(&theCycleTimes, 99.0), (unsigned long long)NullAudioHost_GetPercentile(&theCycleTimes, 99.9), (unsigned long long)theNumberWaits);
+	NullAudioHost_FreeSamples(&theCycleTimes);
+
+	if(theNumberWaits != 0)
+	{
+		fprintf(stderr, "DeviceScaling: %s: the IO threads waited %llu times\n", inConfiguration->mName, (unsigned long long)theNumberWaits);
+		++gNumberFailures;
+	}
+	if(inConfiguration->mHasPropertyTraffic && (theNumberPropertyCalls == 0))
+	{
+		fprintf(stderr, "DeviceScaling: %s: no property calls ran during the IO\n", inConfiguration->mName);
+		++gNumberFailures;
+	}
+	for(UInt32 theDeviceIndex = 0; theDeviceIndex < theNumberIODevices; ++theDeviceIndex)
+	{
+		if(DeviceScaling_GetVolume(inDriver, inDevices[theDeviceIndex]) != theVolumesBefore[theDeviceIndex])
+		{
+			fprintf(stderr, "DeviceScaling: %s: the volume of device %u changed\n", inConfiguration->mName, theDeviceIndex);
+			++gNumberFailures;
+		}
+	}
+}
+
+static SInt64	DeviceScaling_GetNotificationCounter(CFDictionaryRef inNotifications, CFStringRef inKey)
+{
+	SInt64 theAnswer = -1;
+	CFNumberRef theNumber = (inNotifications != NULL) ? (CFNumberRef)CFDictionaryGetValue(inNotifications, inKey) : NULL;
+	if((theNumber == NULL) || !CFNumberGetValue(theNumber, kCFNumberSInt64Type, &theAnswer))
+	{
+		theAnswer = -1;
+	}
+	return theAnswer;
+}
+
+static void	DeviceScaling_CheckNotifications(AudioServerPlugInDriverRef inDriver)
+{
+	//	after all the property traffic, every notification must have been either sent or suppressed
+	AudioObjectPropertyAddress theAddress = { 'PCst', kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	CFDictionaryRef theTelemetry = NULL;
+	UInt32 theDataSize = sizeof(CFDictionaryRef);
+	if(((*inDriver)->GetPropertyData(inDriver, kAudioObjectPlugInObject, 0, &theAddress, 0, NULL, theDataSize, &theDataSize, &theTelemetry) != 0) || (theTelemetry == NULL))
+	{
+		fprintf(stderr, "DeviceScaling: couldn't get the telemetry\n");
+		++gNumberFailures;
+		return;
+	}
+	
+	CFDictionaryRef theNotifications = (CFDictionaryRef)CFDictionaryGetValue(theTelemetry, CFSTR("notifications"));
+	SInt64 theNumberEmitted = DeviceScaling_GetNotificationCounter(theNotifications, CFSTR("emitted"));
+	SInt64 theNumberSuppressed = DeviceScaling_GetNotificationCounter(theNotifications, CFSTR("suppressed"));
+	SInt64 theNumberDropped = DeviceScaling_GetNotificationCounter(theNotifications, CFSTR("dropped"));
+	printf("notifications: %lld emitted, %lld suppressed, %lld dropped\n", (long long)theNumberEmitted, (long long)theNumberSuppressed, (long long)theNumberDropped);
+	if((theNumberEmitted < 0) || (theNumberSuppressed < 0) || (theNumberDropped < 0))
+	{
+		fprintf(stderr, "DeviceScaling: the telemetry is missing a notification counter\n");
+		++gNumberFailures;
+	}
+	else if(theNumberEmitted + theNumberSuppressed == 0)
+	{
+		fprintf(stderr, "DeviceScaling: the property traffic didn't produce any notifications\n");
+		++gNumberFailures;
+	}
+	if(theNumberDropped != 0)
+	{
+		fprintf(stderr, "DeviceScaling: %lld notifications were dropped\n", (long long)theNumberDropped);
+		++gNumberFailures;
+	}
+	CFRelease(theTelemetry);
+}
+
+int	main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	AudioServerPlugInDriverRef theDriver = NullAudioHost_OpenDriver(kNumberDevices);
+	AudioObjectID theDevices[kNumberDevices];
+	if(NullAudioHost_CopyDeviceList(theDriver, theDevices, kNumberDevices) != kNumberDevices)
+	{
+		fprintf(stderr, "DeviceScaling: the driver doesn't have %u devices\n", kNumberDevices);
+		return 1;
+	}
+
+	printf("NullAudio IO on many devices at once, %u cycles of %u frames per device, nanoseconds\n", kNumberCycles, kIOBufferFrameSize);
+	printf("%-34s %12s %12s %8s %8s %8s %6s\n", "configuration", "cycles/s", "properties/s", "p50", "p99", "p99.9", "waits");
+	for(UInt32 theConfigurationIndex = 0; theConfigurationIndex < kNumberConfigurations; ++theConfigurationIndex)
+	{
+		DeviceScaling_Run(theDriver, theDevices, &kConfigurations[theConfigurationIndex]);
+	}
+	DeviceScaling_CheckNotifications(theDriver);
+
+	printf("DeviceScaling: %llu failures\n", (unsigned long long)gNumberFailures);
+	return (gNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Measures how long each of NullAudio's IO calls takes across the range of IO buffer sizes.
+*/
+
+/*==================================================================================================
+	IOCycleLatency.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include "NullAudioHost.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark IO Cycle Latency
+//==================================================================================================
+
+//	The driver runs on the simulated clock, which moves forward by exactly one IO buffer each cycle,
+//	so the zero time stamps advance the way they do in real time. The calls themselves are timed
+//	with the real clock. Each buffer size gets a fresh start of IO and some warm up cycles that
+//	aren't counted.
+
+static const UInt32		kIOBufferFrameSizes[]	= { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+#define					kNumberIOBufferFrameSizes	(sizeof(kIOBufferFrameSizes) / sizeof(kIOBufferFrameSizes[0]))
+static const UInt32		kNumberWarmUpCycles		= 256;
+static const UInt32		kNumberCycles			= 20000;
+static const Float64	kSampleRate				= 44100.0;
+
+int	main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	NullAudioHost_UseSimulatedClock(true);
+	NullAudioHost_SetSimulatedTime(1000000000ULL);
+	AudioServerPlugInDriverRef theDriver = NullAudioHost_OpenDriver(1);
+	AudioObjectID theDevice = kAudioObjectUnknown;
+	if(NullAudioHost_CopyDeviceList(theDriver, &theDevice, 1) != 1)
+	{
+		fprintf(stderr, "IOCycleLatency: the driver has no devices\n");
+		return 1;
+	}
+
+	printf("NullAudio IO call latency, %u cycles per buffer size, nanoseconds\n", kNumberCycles);
+	printf("%6s  %-28s %8s %8s %8s\n", "frames", "call", "p50", "p99", "max");
+
+	NullAudioHost_Samples theSamples[kNullAudioHost_NumberCalls];
+	for(UInt32 theCall = 0; theCall < kNullAudioHost_NumberCalls; ++theCall)
+	{
+		NullAudioHost_InitSamples(&theSamples[theCall], kNumberCycles);
+	}
+
+	for(UInt32 theSizeIndex = 0; theSizeIndex < kNumberIOBufferFrameSizes; ++theSizeIndex)
+	{
+		UInt32 theIOBufferFrameSize = kIOBufferFrameSizes[theSizeIndex];
+		UInt64 theHostTicksPerCycle = (UInt64)((theIOBufferFrameSize * 1000000000.0) / kSampleRate);
+		NullAudioHost_IOContext theContext;
+		if(NullAudioHost_StartIO(&theContext, theDriver, theDevice, 1, theIOBufferFrameSize) != 0)
+		{
+			fprintf(stderr, "IOCycleLatency: StartIO failed\n");
+			return 1;
+		}
+		for(UInt32 theCall = 0; theCall < kNullAudioHost_NumberCalls; ++theCall)
+		{
+			theSamples[theCall].mNumberValues = 0;
+		}
+
+		for(UInt32 theCycle = 0; theCycle < (kNumberWarmUpCycles + kNumberCycles); ++theCycle)
+		{
+			UInt64 theCallTimes[kNullAudioHost_NumberCalls];
+			NullAudioHost_AdvanceSimulatedTime(theHostTicksPerCycle);
+			if(NullAudioHost_RunIOCycle(&theContext, theIOBufferFrameSize, theCallTimes) != 0)
+			{
+				fprintf(stderr, "IOCycleLatency: an IO call failed at %u frames\n", theIOBufferFrameSize);
+				return 1;
+			}
+			if(theCycle >= kNumberWarmUpCycles)
+			{
+				for(UInt32 theCall = 0; theCall < kNullAudioHost_NumberCalls; ++theCall)
+				{
+					NullAudioHost_AddSample(&theSamples[theCall], theCallTimes[theCall]);
+				}
+			}
+		}
+
+		for(UInt32 theCall = 0; theCall < kNullAudioHost_NumberCalls; ++theCall)
+		{
+			printf("%6u  %-28s %8llu %8llu %8llu\n", theIOBufferFrameSize, kNullAudioHost_CallNames[theCall], (unsigned long long)NullAudioHost_GetPercentile(&theSamples[theCall], 50.0), (unsigned long long)NullAudioHost_GetPercentile(&theSamples[theCall], 99.0), (unsigned long long)NullAudioHost_GetPercentile(&theSamples[theCall], 100.0));
+		}
+		NullAudioHost_StopIO(&theContext);
+	}
+
+	for(UInt32 theCall = 0; theCall < kNullAudioHost_NumberCalls; ++theCall)
+	{
+		NullAudioHost_FreeSamples(&theSamples[theCall]);
+	}
+	return 0;
+}
@@ -0,0 +1,388 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A stand-in for coreaudiod that loads NullAudio and drives it the way the HAL does.
+*/
+
+/*==================================================================================================
+	NullAudioHost.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include "NullAudioHost.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//	NullAudio.c only exports its factory function
+extern void*	NullAudio_Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Host
+//==================================================================================================
+
+static pthread_mutex_t				gStorage_Mutex						= PTHREAD_MUTEX_INITIALIZER;
+static CFMutableDictionaryRef		gStorage							= NULL;
+static AudioServerPlugInDriverRef	gDriver								= NULL;
+static _Atomic UInt64				gNumberPropertiesChangedCalls		= 0;
+static _Atomic UInt64				gNumberPropertiesChanged			= 0;
+static _Atomic UInt64				gNumberStorageWrites				= 0;
+static _Atomic UInt64				gNumberConfigurationChanges			= 0;
+
+static OSStatus	NullAudioHost_PropertiesChanged(AudioServerPlugInHostRef inHost, AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress* inAddresses)
+{
+	(void)inHost;
+	(void)inObjectID;
+	(void)inAddresses;
+	atomic_fetch_add_explicit(&gNumberPropertiesChangedCalls, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&gNumberPropertiesChanged, inNumberAddresses, memory_order_relaxed);
+	return 0;
+}
+
+static OSStatus	NullAudioHost_CopyFromStorage(AudioServerPlugInHostRef inHost, CFStringRef inKey, CFPropertyListRef* outData)
+{
+	(void)inHost;
+	pthread_mutex_lock(&gStorage_Mutex);
+	*outData = CFDictionaryGetValue(gStorage, inKey);
+	if(*outData != NULL)
+	{
+		CFRetain(*outData);
+	}
+	pthread_mutex_unlock(&gStorage_Mutex);
+	return 0;
+}
+
+static OSStatus	NullAudioHost_WriteToStorage(AudioServerPlugInHostRef inHost, CFStringRef inKey, CFPropertyListRef inData)
+{
+	(void)inHost;
+	pthread_mutex_lock(&gStorage_Mutex);
+	CFDictionarySetValue(gStorage, inKey, inData);
+	pthread_mutex_unlock(&gStorage_Mutex);
+	atomic_fetch_add_explicit(&gNumberStorageWrites, 1, memory_order_relaxed);
+	return 0;
+}
+
+static OSStatus	NullAudioHost_DeleteFromStorage(AudioServerPlugInHostRef inHost, CFStringRef inKey)
+{
+	(void)inHost;
+	(void)inKey;
+	return 0;
+}
+
+static OSStatus	NullAudioHost_RequestDeviceConfigurationChange(AudioServerPlugInHostRef inHost, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
+{
+	(void)inHost;
+	atomic_fetch_add_explicit(&gNumberConfigurationChanges, 1, memory_order_relaxed);
+	return (*gDriver)->PerformDeviceConfigurationChange(gDriver, inDeviceObjectID, inChangeAction, inChangeInfo);
+}
+
+static const AudioServerPlugInHostInterface	gHostInterface =
+{
+	NullAudioHost_PropertiesChanged,
+	NullAudioHost_CopyFromStorage,
+	NullAudioHost_WriteToStorage,
+	NullAudioHost_DeleteFromStorage,
+	NullAudioHost_RequestDeviceConfigurationChange
+};
+
+AudioServerPlugInDriverRef	NullAudioHost_OpenDriver(UInt32 inNumberDevices)
+{
+	//	seed the storage with the number of devices to make
+	gStorage = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	CFMutableDictionaryRef theSettings = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	SInt32 theNumberDevices = (SInt32)inNumberDevices;
+	CFNumberRef theNumber = CFNumberCreate(NULL, kCFNumberSInt32Type, &theNumberDevices);
+	CFDictionarySetValue(theSettings, CFSTR("device count"), theNumber);
+	CFDictionarySetValue(gStorage, CFSTR("settings"), theSettings);
+	CFRelease(theNumber);
+	CFRelease(theSettings);
+
+	//	load the driver the way the HAL does, through the factory and QueryInterface
+	AudioServerPlugInDriverRef theFactoryDriver = (AudioServerPlugInDriverRef)NullAudio_Create(NULL, kAudioServerPlugInTypeUUID);
+	if(theFactoryDriver == NULL)
+	{
+		fprintf(stderr, "NullAudioHost_OpenDriver: the factory didn't return a driver\n");
+		exit(1);
+	}
+	CFUUIDBytes theInterfaceUUID = CFUUIDGetUUIDBytes(kAudioServerPlugInDriverInterfaceUUID);
+	void* theInterface = NULL;
+	if(((*theFactoryDriver)->QueryInterface(theFactoryDriver, theInterfaceUUID, &theInterface) != 0) || (theInterface == NULL))
+	{
+		fprintf(stderr, "NullAudioHost_OpenDriver: the driver doesn't have the driver interface\n");
+		exit(1);
+	}
+	gDriver = (AudioServerPlugInDriverRef)theInterface;
+	if((*gDriver)->Initialize(gDriver, &gHostInterface) != 0)
+	{
+		fprintf(stderr, "NullAudioHost_OpenDriver: Initialize failed\n");
+		exit(1);
+	}
+	return gDriver;
+}
+
+void	NullAudioHost_GetCounters(NullAudioHost_Counters* outCounters)
+{
+	outCounters->mNumberPropertiesChangedCalls = atomic_load_explicit(&gNumberPropertiesChangedCalls, memory_order_relaxed);
+	outCounters->mNumberPropertiesChanged = atomic_load_explicit(&gNumberPropertiesChanged, memory_order_relaxed);
+	outCounters->mNumberStorageWrites = atomic_load_explicit(&gNumberStorageWrites, memory_order_relaxed);
+	outCounters->mNumberConfigurationChanges = atomic_load_explicit(&gNumberConfigurationChanges, memory_order_relaxed);
+}
+
+UInt32	NullAudioHost_CopyDeviceList(AudioServerPlugInDriverRef inDriver, AudioObjectID* outDeviceList, UInt32 inMaxNumberDevices)
+{
+	AudioObjectPropertyAddress theAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	UInt32 theDataSize = 0;
+	if((*inDriver)->GetPropertyData(inDriver, kAudioObjectPlugInObject, 0, &theAddress, 0, NULL, inMaxNumberDevices * (UInt32)sizeof(AudioObjectID), &theDataSize, outDeviceList) != 0)
+	{
+		theDataSize = 0;
+	}
+	return theDataSize / (UInt32)sizeof(AudioObjectID);
+}
+
+AudioObjectID	NullAudioHost_GetStream(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioObjectPropertyScope inScope)
+{
+	AudioObjectID theAnswer = kAudioObjectUnknown;
+	AudioObjectPropertyAddress theAddress = { kAudioDevicePropertyStreams, inScope, kAudioObjectPropertyElementMain };
+	UInt32 theDataSize = 0;
+	if(((*inDriver)->GetPropertyData(inDriver, inDeviceObjectID, 0, &theAddress, 0, NULL, sizeof(AudioObjectID), &theDataSize, &theAnswer) != 0) || (theDataSize != sizeof(AudioObjectID)))
+	{
+		theAnswer = kAudioObjectUnknown;
+	}
+	return theAnswer;
+}
+
+AudioObjectID	NullAudioHost_GetControl(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioClassID inClassID, AudioObjectPropertyScope inScope)
+{
+	AudioObjectID theAnswer = kAudioObjectUnknown;
+	AudioObjectID theControls[32];
+	AudioObjectPropertyAddress theAddress = { kAudioObjectPropertyControlList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	UInt32 theDataSize = 0;
+	if((*inDriver)->GetPropertyData(inDriver, inDeviceObjectID, 0, &theAddress, 0, NULL, sizeof(theControls), &theDataSize, theControls) == 0)
+	{
+		for(UInt32 theIndex = 0; (theAnswer == kAudioObjectUnknown) && (theIndex < (theDataSize / sizeof(AudioObjectID))); ++theIndex)
+		{
+			AudioClassID theClassID = 0;
+			AudioObjectPropertyScope theScope = 0;
+			UInt32 theSize = 0;
+			theAddress.mSelector = kAudioObjectPropertyClass;
+			(*inDriver)->GetPropertyData(inDriver, theControls[theIndex], 0, &theAddress, 0, NULL, sizeof(theClassID), &theSize, &theClassID);
+			theAddress.mSelector = kAudioControlPropertyScope;
+			(*inDriver)->GetPropertyData(inDriver, theControls[theIndex], 0, &theAddress, 0, NULL, sizeof(theScope), &theSize, &theScope);
+			if((theClassID == inClassID) && (theScope == inScope))
+			{
+				theAnswer = theControls[theIndex];
+			}
+		}
+	}
+	return theAnswer;
+}
+
+UInt64	NullAudioHost_GetNanoseconds(void)
+{
+	struct timespec theTime;
+	clock_gettime(CLOCK_MONOTONIC, &theTime);
+	return ((UInt64)theTime.tv_sec * 1000000000ULL) + (UInt64)theTime.tv_nsec;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark IO
+//==================================================================================================
+
+const char* const	kNullAudioHost_CallNames[kNullAudioHost_NumberCalls] =
+{
+	"GetZeroTimeStamp",
+	"BeginIOOperation(Cycle)",
+	"DoIOOperation(ReadInput)",
+	"DoIOOperation(ConvertInput)",
+	"DoIOOperation(MixOutput)",
+	"DoIOOperation(ConvertMix)",
+	"DoIOOperation(WriteMix)",
+	"EndIOOperation(Cycle)"
+};
+
+OSStatus	NullAudioHost_StartIO(NullAudioHost_IOContext* outContext, AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inMaxIOBufferFrameSize)
+{
+	OSStatus theAnswer = 0;
+	memset(outContext, 0, sizeof(NullAudioHost_IOContext));
+	outContext->mDriver = inDriver;
+	outContext->mDeviceObjectID = inDeviceObjectID;
+	outContext->mInputStreamObjectID = NullAudioHost_GetStream(inDriver, inDeviceObjectID, kAudioObjectPropertyScopeInput);
+	outContext->mOutputStreamObjectID = NullAudioHost_GetStream(inDriver, inDeviceObjectID, kAudioObjectPropertyScopeOutput);
+	outContext->mClientID = inClientID;
+	outContext->mMaxIOBufferFrameSize = inMaxIOBufferFrameSize;
+
+	//	the buffers are big enough for the most channels the device supports
+	AudioStreamBasicDescription theFormat;
+	AudioObjectPropertyAddress theAddress = { kAudioStreamPropertyVirtualFormat, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	UInt32 theDataSize = 0;
+	theAnswer = (*inDriver)->GetPropertyData(inDriver, outContext->mOutputStreamObjectID, 0, &theAddress, 0, NULL, sizeof(theFormat), &theDataSize, &theFormat);
+	if(theAnswer == 0)
+	{
+		outContext->mChannelsPerFrame = theFormat.mChannelsPerFrame;
+		outContext->mInputBuffer = (Float32*)calloc((size_t)inMaxIOBufferFrameSize * 32, sizeof(Float32));
+		outContext->mOutputBuffer = (Float32*)calloc((size_t)inMaxIOBufferFrameSize * 32, sizeof(Float32));
+		outContext->mMixBuffer = (Float32*)calloc((size_t)inMaxIOBufferFrameSize * 32, sizeof(Float32));
+
+		AudioServerPlugInClientInfo theClientInfo = { inClientID, getpid(), true, CFSTR("com.example.NullAudioHost") };
+		theAnswer = (*inDriver)->AddDeviceClient(inDriver, inDeviceObjectID, &theClientInfo);
+	}
+	if(theAnswer == 0)
+	{
+		theAnswer = (*inDriver)->StartIO(inDriver, inDeviceObjectID, inClientID);
+	}
+	return theAnswer;
+}
+
+OSStatus	NullAudioHost_StopIO(NullAudioHost_IOContext* ioContext)
+{
+	OSStatus theAnswer = (*ioContext->mDriver)->StopIO(ioContext->mDriver, ioContext->mDeviceObjectID, ioContext->mClientID);
+	AudioServerPlugInClientInfo theClientInfo = { ioContext->mClientID, getpid(), true, CFSTR("com.example.NullAudioHost") };
+	(*ioContext->mDriver)->RemoveDeviceClient(ioContext->mDriver, ioContext->mDeviceObjectID, &theClientInfo);
+	free(ioContext->mInputBuffer);
+	free(ioContext->mOutputBuffer);
+	free(ioContext->mMixBuffer);
+	ioContext->mInputBuffer = NULL;
+	ioContext->mOutputBuffer = NULL;
+	ioContext->mMixBuffer = NULL;
+	return theAnswer;
+}
+
+static OSStatus	NullAudioHost_RunIOOperation(NullAudioHost_IOContext* ioContext, UInt32 inOperationID, AudioObjectID inStreamObjectID, UInt32 inIOBufferFrameSize, void* ioMainBuffer, void* ioSecondaryBuffer, UInt64* outCallTime)
+{
+	//	The HAL brackets each operation with Begin and End, so the time includes all three calls.
+	AudioServerPlugInDriverRef theDriver = ioContext->mDriver;
+	UInt64 theStartTime = NullAudioHost_GetNanoseconds();
+	OSStatus theAnswer = (*theDriver)->BeginIOOperation(theDriver, ioContext->mDeviceObjectID, ioContext->mClientID, inOperationID, inIOBufferFrameSize, &ioContext->mCycleInfo);
+	if(theAnswer == 0)
+	{
+		theAnswer = (*theDriver)->DoIOOperation(theDriver, ioContext->mDeviceObjectID, inStreamObjectID, ioContext->mClientID, inOperationID, inIOBufferFrameSize, &ioContext->mCycleInfo, ioMainBuffer, ioSecondaryBuffer);
+	}
+	if(theAnswer == 0)
+	{
+		theAnswer = (*theDriver)->EndIOOperation(theDriver, ioContext->mDeviceObjectID, ioContext->mClientID, inOperationID, inIOBufferFrameSize, &ioContext->mCycleInfo);
+	}
+	*outCallTime = NullAudioHost_GetNanoseconds() - theStartTime;
+	return theAnswer;
+}
+
+OSStatus	NullAudioHost_RunIOCycle(NullAudioHost_IOContext* ioContext, UInt32 inIOBufferFrameSize, UInt64 outCallTimes[kNullAudioHost_NumberCalls])
+{
+	AudioServerPlugInDriverRef theDriver = ioContext->mDriver;
+	UInt64 theCallTimes[kNullAudioHost_NumberCalls];
+	UInt64 theSeed = 0;
+	UInt64 theStartTime = 0;
+	OSStatus theAnswer = 0;
+
+	//	get the zero time stamp
+	theStartTime = NullAudioHost_GetNanoseconds();
+	theAnswer = (*theDriver)->GetZeroTimeStamp(theDriver, ioContext->mDeviceObjectID, ioContext->mClientID, &ioContext->mZeroTimeStampSampleTime, &ioContext->mZeroTimeStampHostTime, &theSeed);
+	theCallTimes[kNullAudioHost_Call_GetZeroTimeStamp] = NullAudioHost_GetNanoseconds() - theStartTime;
+
+	//	The input time is the buffer that just finished and the output time is the buffer after the
+	//	one that is playing, which is all the driver looks at.
+	ioContext->mCycleInfo.mIOCycleCounter += 1;
+	ioContext->mCycleInfo.mNominalIOBufferFrameSize = inIOBufferFrameSize;
+	ioContext->mCycleInfo.mInputTime.mSampleTime = (Float64)((ioContext->mCycleInfo.mIOCycleCounter - 1) * inIOBufferFrameSize);
+	ioContext->mCycleInfo.mOutputTime.mSampleTime = ioContext->mCycleInfo.mInputTime.mSampleTime + (2.0 * inIOBufferFrameSize);
+	ioContext->mCycleInfo.mMainTime = ioContext->mCycleInfo.mOutputTime;
+
+	if(theAnswer == 0)
+	{
+		theStartTime = NullAudioHost_GetNanoseconds();
+		theAnswer = (*theDriver)->BeginIOOperation(theDriver, ioContext->mDeviceObjectID, ioContext->mClientID, kAudioServerPlugInIOOperationCycle, inIOBufferFrameSize, &ioContext->mCycleInfo);
+		theCallTimes[kNullAudioHost_Call_BeginCycle] = NullAudioHost_GetNanoseconds() - theStartTime;
+	}
+	if(theAnswer == 0)
+	{
+		theAnswer = NullAudioHost_RunIOOperation(ioContext, kAudioServerPlugInIOOperationReadInput, ioContext->mInputStreamObjectID, inIOBufferFrameSize, ioContext->mInputBuffer, NULL, &theCallTimes[kNullAudioHost_Call_ReadInput]);
+	}
+	if(theAnswer == 0)
+	{
+		theAnswer = NullAudioHost_RunIOOperation(ioContext, kAudioServerPlugInIOOperationConvertInput, ioContext->mInputStreamObjectID, inIOBufferFrameSize, ioContext->mInputBuffer, NULL, &theCallTimes[kNullAudioHost_Call_ConvertInput]);
+	}
+	if(theAnswer == 0)
+	{
+		//	the client's output is its input played back, so there is always something to mix
+		memcpy(ioContext->mOutputBuffer, ioContext->mInputBuffer, (size_t)inIOBufferFrameSize * ioContext->mChannelsPerFrame * sizeof(Float32));
+		theAnswer = NullAudioHost_RunIOOperation(ioContext, kAudioServerPlugInIOOperationMixOutput, ioContext->mOutputStreamObjectID, inIOBufferFrameSize, ioContext->mOutputBuffer, ioContext->mMixBuffer, &theCallTimes[kNullAudioHost_Call_MixOutput]);
+	}
+	if(theAnswer == 0)
+	{
+		theAnswer = NullAudioHost_RunIOOperation(ioContext, kAudioServerPlugInIOOperationConvertMix, ioContext->mOutputStreamObjectID, inIOBufferFrameSize, ioContext->mMixBuffer, NULL, &theCallTimes[kNullAudioHost_Call_ConvertMix]);
+	}
+	if(theAnswer == 0)
+	{
+		theAnswer = NullAudioHost_RunIOOperation(ioContext, kAudioServerPlugInIOOperationWriteMix, ioContext->mOutputStreamObjectID, inIOBufferFrameSize, ioContext->mMixBuffer, NULL, &theCallTimes[kNullAudioHost_Call_WriteMix]);
+	}
+	if(theAnswer == 0)
+	{
+		theStartTime = NullAudioHost_GetNanoseconds();
+		theAnswer = (*theDriver)->EndIOOperation(theDriver, ioContext->mDeviceObjectID, ioContext->mClientID, kAudioServerPlugInIOOperationCycle, inIOBufferFrameSize, &ioContext->mCycleInfo);
+		theCallTimes[kNullAudioHost_Call_EndCycle] = NullAudioHost_GetNanoseconds() - theStartTime;
+	}
+
+	if((theAnswer == 0) && (outCallTimes != NULL))
+	{
+		memcpy(outCallTimes, theCallTimes, sizeof(theCallTimes));
+	}
+	return theAnswer;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Statistics
+//==================================================================================================
+
+void	NullAudioHost_InitSamples(NullAudioHost_Samples* outSamples, UInt32 inCapacity)
+{
+	outSamples->mValues = (UInt64*)malloc((size_t)inCapacity * sizeof(UInt64));
+	outSamples->mNumberValues = 0;
+	outSamples->mCapacity = inCapacity;
+}
+
+void	NullAudioHost_FreeSamples(NullAudioHost_Samples* ioSamples)
+{
+	free(ioSamples->mValues);
+	ioSamples->mValues = NULL;
+	ioSamples->mNumberValues = 0;
+	ioSamples->mCapacity = 0;
+}
+
+void	NullAudioHost_AddSample(NullAudioHost_Samples* ioSamples, UInt64 inValue)
+{
+	if(ioSamples->mNumberValues < ioSamples->mCapacity)
+	{
+		ioSamples->mValues[ioSamples->mNumberValues] = inValue;
+		++ioSamples->mNumberValues;
+	}
+}
+
+static int	NullAudioHost_CompareSamples(const void* inValue1, const void* inValue2)
+{
+	UInt64 theValue1 = *((const UInt64*)inValue1);
+	UInt64 theValue2 = *((const UInt64*)inValue2);
+	return (theValue1 < theValue2) ? -1 : ((theValue1 > theValue2) ? 1 : 0);
+}
+
+UInt64	NullAudioHost_GetPercentile(NullAudioHost_Samples* ioSamples, Float64 inPercentile)
+{
+	UInt64 theAnswer = 0;
+	if(ioSamples->mNumberValues > 0)
+	{
+		qsort(ioSamples->mValues, ioSamples->mNumberValues, sizeof(UInt64), NullAudioHost_CompareSamples);
+		UInt32 theIndex = (UInt32)((inPercentile / 100.0) * (ioSamples->mNumberValues - 1) + 0.5);
+		theAnswer = ioSamples->mValues[theIndex];
+	}
+	return theAnswer;
+}
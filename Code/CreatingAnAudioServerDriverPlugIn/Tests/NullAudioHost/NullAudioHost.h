@@ -0,0 +1,119 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A stand-in for coreaudiod that loads NullAudio and drives it the way the HAL does.
+*/
+
+/*==================================================================================================
+	NullAudioHost.h
+==================================================================================================*/
+#if !defined(__NullAudioHost_h__)
+#define __NullAudioHost_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <CoreAudio/AudioServerPlugIn.h>
+#include <mach/mach_time.h>
+
+#include <stdbool.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Host
+//==================================================================================================
+
+//	The host keeps the driver's storage in a dictionary and counts what the driver tells it. A
+//	configuration change request is performed right away on the thread that made it, which is what
+//	the HAL does once it has stopped IO. The tests that make requests are responsible for stopping
+//	IO first.
+
+typedef struct NullAudioHost_Counters
+{
+	UInt64	mNumberPropertiesChangedCalls;
+	UInt64	mNumberPropertiesChanged;
+	UInt64	mNumberStorageWrites;
+	UInt64	mNumberConfigurationChanges;
+} NullAudioHost_Counters;
+
+//	This loads the driver and initializes it with storage that asks for the given number of devices.
+//	The driver can only be opened once per process.
+AudioServerPlugInDriverRef	NullAudioHost_OpenDriver(UInt32 inNumberDevices);
+
+void			NullAudioHost_GetCounters(NullAudioHost_Counters* outCounters);
+UInt32			NullAudioHost_CopyDeviceList(AudioServerPlugInDriverRef inDriver, AudioObjectID* outDeviceList, UInt32 inMaxNumberDevices);
+AudioObjectID	NullAudioHost_GetStream(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioObjectPropertyScope inScope);
+AudioObjectID	NullAudioHost_GetControl(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioClassID inClassID, AudioObjectPropertyScope inScope);
+UInt64			NullAudioHost_GetNanoseconds(void);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark IO
+//==================================================================================================
+
+//	An IO context is one client doing IO on one device. Each cycle is timed call by call with the
+//	real clock, whatever clock the driver is using.
+
+enum
+{
+	kNullAudioHost_Call_GetZeroTimeStamp	= 0,
+	kNullAudioHost_Call_BeginCycle			= 1,
+	kNullAudioHost_Call_ReadInput			= 2,
+	kNullAudioHost_Call_ConvertInput		= 3,
+	kNullAudioHost_Call_MixOutput			= 4,
+	kNullAudioHost_Call_ConvertMix			= 5,
+	kNullAudioHost_Call_WriteMix			= 6,
+	kNullAudioHost_Call_EndCycle			= 7,
+	kNullAudioHost_NumberCalls				= 8
+};
+
+extern const char* const	kNullAudioHost_CallNames[kNullAudioHost_NumberCalls];
+
+typedef struct NullAudioHost_IOContext
+{
+	AudioServerPlugInDriverRef		mDriver;
+	AudioObjectID					mDeviceObjectID;
+	AudioObjectID					mInputStreamObjectID;
+	AudioObjectID					mOutputStreamObjectID;
+	UInt32							mClientID;
+	UInt32							mChannelsPerFrame;
+	UInt32							mMaxIOBufferFrameSize;
+	Float32*						mInputBuffer;
+	Float32*						mOutputBuffer;
+	Float32*						mMixBuffer;
+	AudioServerPlugInIOCycleInfo	mCycleInfo;
+	Float64							mZeroTimeStampSampleTime;
+	UInt64							mZeroTimeStampHostTime;
+} NullAudioHost_IOContext;
+
+//	This adds a client to the device and starts IO for it.
+OSStatus	NullAudioHost_StartIO(NullAudioHost_IOContext* outContext, AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inMaxIOBufferFrameSize);
+OSStatus	NullAudioHost_StopIO(NullAudioHost_IOContext* ioContext);
+
+//	This runs one IO cycle: GetZeroTimeStamp followed by the cycle and each of the operations the
+//	driver does, in the HAL's order. The time each call took in nanoseconds goes in outCallTimes if
+//	it isn't NULL.
+OSStatus	NullAudioHost_RunIOCycle(NullAudioHost_IOContext* ioContext, UInt32 inIOBufferFrameSize, UInt64 outCallTimes[kNullAudioHost_NumberCalls]);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Statistics
+//==================================================================================================
+
+typedef struct NullAudioHost_Samples
+{
+	UInt64*	mValues;
+	UInt32	mNumberValues;
+	UInt32	mCapacity;
+} NullAudioHost_Samples;
+
+void	NullAudioHost_InitSamples(NullAudioHost_Samples* outSamples, UInt32 inCapacity);
+void	NullAudioHost_FreeSamples(NullAudioHost_Samples* ioSamples);
+void	NullAudioHost_AddSample(NullAudioHost_Samples* ioSamples, UInt64 inValue);
+
+//	The percentile is in [0, 100]. This sorts the samples.
+UInt64	NullAudioHost_GetPercentile(NullAudioHost_Samples* ioSamples, Float64 inPercentile);
+
+#endif	//	__NullAudioHost_h__
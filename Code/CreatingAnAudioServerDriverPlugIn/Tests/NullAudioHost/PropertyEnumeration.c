@@ -0,0 +1,292 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Checks that NullAudio's property tables agree with themselves and measures how long it takes to
+             enumerate every property of every object the way the HAL does.
+*/
+
+/*==================================================================================================
+	PropertyEnumeration.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include "NullAudioHost.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Property Enumeration
+//==================================================================================================
+
+//	The HAL finds out what an object implements by asking it about every selector it knows, in each
+//	scope, and then asking whether the ones it has are settable and how big their data is. This does
+//	the same over the plug-in, the box, the device, and everything the device owns. Every property
+//	an object says it has must also answer IsSettable and GetPropertyDataSize, and every one it says
+//	it doesn't have must be an unknown property to both.
+//
+//	After that, the properties the objects have are enumerated over and over until a million of
+//	them have been looked up, timing each kind of call with the real clock. The misses, selectors
+//	an object doesn't have, are timed separately since the HAL's probing is mostly misses.
+
+static const AudioObjectPropertySelector	kSelectors[] =
+{
+	kAudioObjectPropertyBaseClass,
+	kAudioObjectPropertyClass,
+	kAudioObjectPropertyOwner,
+	kAudioObjectPropertyName,
+	kAudioObjectPropertyModelName,
+	kAudioObjectPropertyManufacturer,
+	kAudioObjectPropertyElementName,
+	kAudioObjectPropertyOwnedObjects,
+	kAudioObjectPropertyIdentify,
+	kAudioObjectPropertySerialNumber,
+	kAudioObjectPropertyFirmwareVersion,
+	kAudioObjectPropertyControlList,
+	kAudioObjectPropertyCustomPropertyInfoList,
+	kAudioPlugInPropertyBoxList,
+	kAudioPlugInPropertyTranslateUIDToBox,
+	kAudioPlugInPropertyDeviceList,
+	kAudioPlugInPropertyTranslateUIDToDevice,
+	kAudioPlugInPropertyResourceBundle,
+	kAudioBoxPropertyBoxUID,
+	kAudioBoxPropertyTransportType,
+	kAudioBoxPropertyHasAudio,
+	kAudioBoxPropertyHasVideo,
+	kAudioBoxPropertyHasMIDI,
+	kAudioBoxPropertyIsProtected,
+	kAudioBoxPropertyAcquired,
+	kAudioBoxPropertyAcquisitionFailed,
+	kAudioBoxPropertyDeviceList,
+	kAudioDevicePropertyDeviceUID,
+	kAudioDevicePropertyModelUID,
+	kAudioDevicePropertyTransportType,
+	kAudioDevicePropertyRelatedDevices,
+	kAudioDevicePropertyClockDomain,
+	kAudioDevicePropertyDeviceIsAlive,
+	kAudioDevicePropertyDeviceIsRunning,
+	kAudioDevicePropertyDeviceCanBeDefaultDevice,
+	kAudioDevicePropertyDeviceCanBeDefaultSystemDevice,
+	kAudioDevicePropertyLatency,
+	kAudioDevicePropertyStreams,
+	kAudioDevicePropertySafetyOffset,
+	kAudioDevicePropertyNominalSampleRate,
+	kAudioDevicePropertyAvailableNominalSampleRates,
+	kAudioDevicePropertyIsHidden,
+	kAudioDevicePropertyPreferredChannelsForStereo,
+	kAudioDevicePropertyPreferredChannelLayout,
+	kAudioDevicePropertyZeroTimeStampPeriod,
+	kAudioDevicePropertyIcon,
+	kAudioStreamPropertyIsActive,
+	kAudioStreamPropertyDirection,
+	kAudioStreamPropertyTerminalType,
+	kAudioStreamPropertyStartingChannel,
+	kAudioStreamPropertyLatency,
+	kAudioStreamPropertyVirtualFormat,
+	kAudioStreamPropertyPhysicalFormat,
+	kAudioStreamPropertyAvailableVirtualFormats,
+	kAudioStreamPropertyAvailablePhysicalFormats,
+	kAudioControlPropertyScope,
+	kAudioControlPropertyElement,
+	kAudioLevelControlPropertyScalarValue,
+	kAudioLevelControlPropertyDecibelValue,
+	kAudioLevelControlPropertyDecibelRange,
+	kAudioLevelControlPropertyConvertScalarToDecibels,
+	kAudioLevelControlPropertyConvertDecibelsToScalar,
+	kAudioBooleanControlPropertyValue,
+	kAudioSelectorControlPropertyCurrentItem,
+	kAudioSelectorControlPropertyAvailableItems,
+	kAudioSelectorControlPropertyItemName,
+	'PCst',
+	'PTlt',
+	'none'
+};
+#define	kNumberSelectors	(sizeof(kSelectors) / sizeof(kSelectors[0]))
+
+static const AudioObjectPropertyScope	kScopes[]			= { kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyScopeInput, kAudioObjectPropertyScopeOutput };
+#define									kNumberScopes		(sizeof(kScopes) / sizeof(kScopes[0]))
+static const UInt32						kMaxNumberObjects	= 16;
+static const UInt64						kNumberLookUps		= 1000000;
+
+typedef struct PropertyEnumeration_Property
+{
+	AudioObjectID				mObjectID;
+	AudioObjectPropertyAddress	mAddress;
+} PropertyEnumeration_Property;
+
+static UInt32	PropertyEnumeration_CopyObjects(AudioServerPlugInDriverRef inDriver, AudioObjectID* outObjects)
+{
+	//	the plug-in, the box, the device, and what the device owns
+	UInt32 theNumberObjects = 0;
+	outObjects[theNumberObjects++] = kAudioObjectPlugInObject;
+
+	AudioObjectPropertyAddress theAddress = { kAudioPlugInPropertyBoxList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	UInt32 theDataSize = 0;
+	if((*inDriver)->GetPropertyData(inDriver, kAudioObjectPlugInObject, 0, &theAddress, 0, NULL, sizeof(AudioObjectID), &theDataSize, &outObjects[theNumberObjects]) == 0)
+	{
+		theNumberObjects += theDataSize / sizeof(AudioObjectID);
+	}
+
+	AudioObjectID theDevice = kAudioObjectUnknown;
+	if(NullAudioHost_CopyDeviceList(inDriver, &theDevice, 1) == 1)
+	{
+		outObjects[theNumberObjects++] = theDevice;
+		theAddress.mSelector = kAudioObjectPropertyOwnedObjects;
+		if((*inDriver)->GetPropertyData(inDriver, theDevice, 0, &theAddress, 0, NULL, (kMaxNumberObjects - theNumberObjects) * (UInt32)sizeof(AudioObjectID), &theDataSize, &outObjects[theNumberObjects]) == 0)
+		{
+			theNumberObjects += theDataSize / sizeof(AudioObjectID);
+		}
+	}
+	return theNumberObjects;
+}
+
+static const char*	PropertyEnumeration_FourCC(UInt32 inCode, char outString[5])
+{
+	outString[0] = (char)((inCode >> 24) & 0xFF);
+	outString[1] = (char)((inCode >> 16) & 0xFF);
+	outString[2] = (char)((inCode >> 8) & 0xFF);
+	outString[3] = (char)(inCode & 0xFF);
+	outString[4] = 0;
+	return outString;
+}
+
+static Boolean	PropertyEnumeration_IsSettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, AudioObjectPropertySelector inSelector, AudioObjectPropertyScope inScope)
+{
+	AudioObjectPropertyAddress theAddress = { inSelector, inScope, kAudioObjectPropertyElementMain };
+	Boolean theIsSettable = false;
+	return ((*inDriver)->IsPropertySettable(inDriver, inObjectID, 0, &theAddress, &theIsSettable) == 0) && theIsSettable;
+}
+
+int	main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	AudioServerPlugInDriverRef theDriver = NullAudioHost_OpenDriver(1);
+	AudioObjectID theObjects[kMaxNumberObjects];
+	UInt32 theNumberObjects = PropertyEnumeration_CopyObjects(theDriver, theObjects);
+	if(theNumberObjects != 12)
+	{
+		fprintf(stderr, "PropertyEnumeration: expected 12 objects, found %u\n", theNumberObjects);
+		return 1;
+	}
+
+	//	probe every selector in every scope on every object, and check that the answers agree
+	PropertyEnumeration_Property* theProperties = malloc(theNumberObjects * kNumberSelectors * kNumberScopes * sizeof(PropertyEnumeration_Property));
+	PropertyEnumeration_Property* theMisses = malloc(theNumberObjects * kNumberSelectors * kNumberScopes * sizeof(PropertyEnumeration_Property));
+	UInt32 theNumberProperties = 0;
+	UInt32 theNumberMisses = 0;
+	UInt32 theNumberFailures = 0;
+	for(UInt32 theObjectIndex = 0; theObjectIndex < theNumberObjects; ++theObjectIndex)
+	{
+		for(UInt32 theSelectorIndex = 0; theSelectorIndex < kNumberSelectors; ++theSelectorIndex)
+		{
+			for(UInt32 theScopeIndex = 0; theScopeIndex < kNumberScopes; ++theScopeIndex)
+			{
+				PropertyEnumeration_Property theProperty = { theObjects[theObjectIndex], { kSelectors[theSelectorIndex], kScopes[theScopeIndex], kAudioObjectPropertyElementMain } };
+				Boolean theIsSettable = false;
+				UInt32 theDataSize = 0;
+				char theSelectorString[5];
+				char theScopeString[5];
+				Boolean theHasProperty = (*theDriver)->HasProperty(theDriver, theProperty.mObjectID, 0, &theProperty.mAddress);
+				OSStatus theSettableError = (*theDriver)->IsPropertySettable(theDriver, theProperty.mObjectID, 0, &theProperty.mAddress, &theIsSettable);
+				OSStatus theSizeError = (*theDriver)->GetPropertyDataSize(theDriver, theProperty.mObjectID, 0, &theProperty.mAddress, 0, NULL, &theDataSize);
+				if(theHasProperty)
+				{
+					theProperties[theNumberProperties++] = theProperty;
+					if((theSettableError != 0) || (theSizeError != 0))
+					{
+						fprintf(stderr, "PropertyEnumeration: object %u has '%s' in scope '%s' but IsPropertySettable returned %d and GetPropertyDataSize returned %d\n", theProperty.mObjectID, PropertyEnumeration_FourCC(theProperty.mAddress.mSelector, theSelectorString), PropertyEnumeration_FourCC(theProperty.mAddress.mScope, theScopeString), (int)theSettableError, (int)theSizeError);
+						++theNumberFailures;
+					}
+				}
+				else
+				{
+					theMisses[theNumberMisses++] = theProperty;
+					if((theSettableError != kAudioHardwareUnknownPropertyError) || (theSizeError != kAudioHardwareUnknownPropertyError))
+					{
+						fprintf(stderr, "PropertyEnumeration: object %u doesn't have '%s' in scope '%s' but IsPropertySettable returned %d and GetPropertyDataSize returned %d\n", theProperty.mObjectID, PropertyEnumeration_FourCC(theProperty.mAddress.mSelector, theSelectorString), PropertyEnumeration_FourCC(theProperty.mAddress.mScope, theScopeString), (int)theSettableError, (int)theSizeError);
+						++theNumberFailures;
+					}
+				}
+			}
+		}
+	}
+
+	//	spot check what the tables say against what the driver is known to do
+	AudioObjectID theDevice = theObjects[2];
+	AudioObjectID theVolume = NullAudioHost_GetControl(theDriver, theDevice, kAudioVolumeControlClassID, kAudioObjectPropertyScopeOutput);
+	AudioObjectPropertyAddress theLatencyAddress = { kAudioDevicePropertyLatency, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	AudioObjectPropertyAddress theElementNameAddress = { kAudioObjectPropertyElementName, kAudioObjectPropertyScopeGlobal, 3 };
+	if(!PropertyEnumeration_IsSettable(theDriver, theDevice, kAudioDevicePropertyNominalSampleRate, kAudioObjectPropertyScopeGlobal) || PropertyEnumeration_IsSettable(theDriver, theDevice, kAudioDevicePropertyDeviceUID, kAudioObjectPropertyScopeGlobal) || !PropertyEnumeration_IsSettable(theDriver, theVolume, kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal) || PropertyEnumeration_IsSettable(theDriver, theVolume, kAudioLevelControlPropertyDecibelRange, kAudioObjectPropertyScopeGlobal) || !PropertyEnumeration_IsSettable(theDriver, kAudioObjectPlugInObject, 'PCst', kAudioObjectPropertyScopeGlobal))
+	{
+		fprintf(stderr, "PropertyEnumeration: a property's settability is wrong\n");
+		++theNumberFailures;
+	}
+	if((*theDriver)->HasProperty(theDriver, theDevice, 0, &theLatencyAddress) || (*theDriver)->HasProperty(theDriver, theDevice, 0, &theElementNameAddress))
+	{
+		fprintf(stderr, "PropertyEnumeration: the device has a property outside of the scope or element it applies to\n");
+		++theNumberFailures;
+	}
+	if(theNumberFailures != 0)
+	{
+		return 1;
+	}
+
+	//	time the look ups
+	UInt64 theHasTime = 0;
+	UInt64 theSettableTime = 0;
+	UInt64 theSizeTime = 0;
+	UInt64 theMissTime = 0;
+	UInt64 theNumberLookUps = 0;
+	UInt64 theNumberMissLookUps = 0;
+	while(theNumberLookUps < kNumberLookUps)
+	{
+		UInt64 theStartTime = NullAudioHost_GetNanoseconds();
+		for(UInt32 theIndex = 0; theIndex < theNumberProperties; ++theIndex)
+		{
+			(*theDriver)->HasProperty(theDriver, theProperties[theIndex].mObjectID, 0, &theProperties[theIndex].mAddress);
+		}
+		UInt64 theHasEndTime = NullAudioHost_GetNanoseconds();
+		for(UInt32 theIndex = 0; theIndex < theNumberProperties; ++theIndex)
+		{
+			Boolean theIsSettable = false;
+			(*theDriver)->IsPropertySettable(theDriver, theProperties[theIndex].mObjectID, 0, &theProperties[theIndex].mAddress, &theIsSettable);
+		}
+		UInt64 theSettableEndTime = NullAudioHost_GetNanoseconds();
+		for(UInt32 theIndex = 0; theIndex < theNumberProperties; ++theIndex)
+		{
+			UInt32 theDataSize = 0;
+			(*theDriver)->GetPropertyDataSize(theDriver, theProperties[theIndex].mObjectID, 0, &theProperties[theIndex].mAddress, 0, NULL, &theDataSize);
+		}
+		UInt64 theSizeEndTime = NullAudioHost_GetNanoseconds();
+		for(UInt32 theIndex = 0; theIndex < theNumberMisses; ++theIndex)
+		{
+			(*theDriver)->HasProperty(theDriver, theMisses[theIndex].mObjectID, 0, &theMisses[theIndex].mAddress);
+		}
+		UInt64 theMissEndTime = NullAudioHost_GetNanoseconds();
+
+		theHasTime += theHasEndTime - theStartTime;
+		theSettableTime += theSettableEndTime - theHasEndTime;
+		theSizeTime += theSizeEndTime - theSettableEndTime;
+		theMissTime += theMissEndTime - theSizeEndTime;
+		theNumberLookUps += theNumberProperties;
+		theNumberMissLookUps += theNumberMisses;
+	}
+
+	printf("NullAudio property enumeration, %u objects, %u properties, %llu look ups\n", theNumberObjects, theNumberProperties, (unsigned long long)theNumberLookUps);
+	printf("%-28s %10s\n", "call", "ns/call");
+	printf("%-28s %10.1f\n", "HasProperty", (Float64)theHasTime / theNumberLookUps);
+	printf("%-28s %10.1f\n", "IsPropertySettable", (Float64)theSettableTime / theNumberLookUps);
+	printf("%-28s %10.1f\n", "GetPropertyDataSize", (Float64)theSizeTime / theNumberLookUps);
+	printf("%-28s %10.1f\n", "HasProperty (miss)", (Float64)theMissTime / theNumberMissLookUps);
+
+	free(theProperties);
+	free(theMisses);
+	return 0;
+}
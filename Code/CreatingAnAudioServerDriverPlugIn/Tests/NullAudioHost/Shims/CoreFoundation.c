@@ -0,0 +1,582 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The subset of CoreFoundation that NullAudio uses, for building the driver outside of macOS.
+*/
+
+/*==================================================================================================
+	CoreFoundation.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Objects
+//==================================================================================================
+
+enum
+{
+	kTypeID_String		= 1,
+	kTypeID_Number		= 2,
+	kTypeID_Boolean		= 3,
+	kTypeID_Array		= 4,
+	kTypeID_Dictionary	= 5,
+	kTypeID_UUID		= 6
+};
+
+//	Every object starts with this header. Objects that live for the life of the process, like the
+//	CFSTR() strings and the booleans, have a retain count of -1 and ignore retain and release.
+typedef struct Object
+{
+	CFTypeID		mTypeID;
+	_Atomic long	mRetainCount;
+} Object;
+
+struct __CFString
+{
+	Object	mObject;
+	char*	mCString;
+};
+
+struct __CFNumber
+{
+	Object			mObject;
+	CFNumberType	mType;
+	SInt64			mIntegerValue;
+	Float64			mFloatValue;
+};
+
+struct __CFBoolean
+{
+	Object	mObject;
+	Boolean	mValue;
+};
+
+struct __CFArray
+{
+	Object		mObject;
+	CFIndex		mCount;
+	CFIndex		mCapacity;
+	CFTypeRef*	mValues;
+};
+
+struct __CFDictionary
+{
+	Object		mObject;
+	CFIndex		mCount;
+	CFIndex		mCapacity;
+	CFTypeRef*	mKeys;
+	CFTypeRef*	mValues;
+};
+
+struct __CFUUID
+{
+	Object		mObject;
+	CFUUIDBytes	mBytes;
+};
+
+static void*	AllocateObject(size_t inSize, CFTypeID inTypeID)
+{
+	Object* theObject = (Object*)calloc(1, inSize);
+	if(theObject == NULL)
+	{
+		abort();
+	}
+	theObject->mTypeID = inTypeID;
+	atomic_init(&theObject->mRetainCount, 1);
+	return theObject;
+}
+
+static void	FreeObject(Object* inObject)
+{
+	switch(inObject->mTypeID)
+	{
+		case kTypeID_String:
+			free(((struct __CFString*)inObject)->mCString);
+			break;
+
+		case kTypeID_Array:
+			{
+				struct __CFArray* theArray = (struct __CFArray*)inObject;
+				for(CFIndex theIndex = 0; theIndex < theArray->mCount; ++theIndex)
+				{
+					CFRelease(theArray->mValues[theIndex]);
+				}
+				free(theArray->mValues);
+			}
+			break;
+
+		case kTypeID_Dictionary:
+			{
+				struct __CFDictionary* theDictionary = (struct __CFDictionary*)inObject;
+				for(CFIndex theIndex = 0; theIndex < theDictionary->mCount; ++theIndex)
+				{
+					CFRelease(theDictionary->mKeys[theIndex]);
+					CFRelease(theDictionary->mValues[theIndex]);
+				}
+				free(theDictionary->mKeys);
+				free(theDictionary->mValues);
+			}
+			break;
+	};
+	free(inObject);
+}
+
+CFTypeRef	CFRetain(CFTypeRef inObject)
+{
+	Object* theObject = (Object*)inObject;
+	if(atomic_load_explicit(&theObject->mRetainCount, memory_order_relaxed) >= 0)
+	{
+		atomic_fetch_add_explicit(&theObject->mRetainCount, 1, memory_order_relaxed);
+	}
+	return inObject;
+}
+
+void	CFRelease(CFTypeRef inObject)
+{
+	Object* theObject = (Object*)inObject;
+	if(atomic_load_explicit(&theObject->mRetainCount, memory_order_relaxed) >= 0)
+	{
+		if(atomic_fetch_sub_explicit(&theObject->mRetainCount, 1, memory_order_acq_rel) == 1)
+		{
+			FreeObject(theObject);
+		}
+	}
+}
+
+CFIndex	CFGetRetainCount(CFTypeRef inObject)
+{
+	return atomic_load_explicit(&((Object*)inObject)->mRetainCount, memory_order_relaxed);
+}
+
+CFTypeID	CFGetTypeID(CFTypeRef inObject)
+{
+	return ((const Object*)inObject)->mTypeID;
+}
+
+Boolean	CFEqual(CFTypeRef inObject1, CFTypeRef inObject2)
+{
+	Boolean theAnswer = inObject1 == inObject2;
+	if(!theAnswer && (inObject1 != NULL) && (inObject2 != NULL) && (CFGetTypeID(inObject1) == CFGetTypeID(inObject2)))
+	{
+		switch(CFGetTypeID(inObject1))
+		{
+			case kTypeID_String:
+				theAnswer = strcmp(((CFStringRef)inObject1)->mCString, ((CFStringRef)inObject2)->mCString) == 0;
+				break;
+
+			case kTypeID_Number:
+				theAnswer = ((CFNumberRef)inObject1)->mFloatValue == ((CFNumberRef)inObject2)->mFloatValue;
+				break;
+
+			case kTypeID_Boolean:
+				theAnswer = ((CFBooleanRef)inObject1)->mValue == ((CFBooleanRef)inObject2)->mValue;
+				break;
+
+			case kTypeID_UUID:
+				theAnswer = memcmp(&((CFUUIDRef)inObject1)->mBytes, &((CFUUIDRef)inObject2)->mBytes, sizeof(CFUUIDBytes)) == 0;
+				break;
+		};
+	}
+	return theAnswer;
+}
+
+void	CFShow(CFTypeRef inObject)
+{
+	if(inObject == NULL)
+	{
+		printf("(null)\n");
+	}
+	else if(CFGetTypeID(inObject) == kTypeID_String)
+	{
+		printf("%s\n", ((CFStringRef)inObject)->mCString);
+	}
+	else if(CFGetTypeID(inObject) == kTypeID_Number)
+	{
+		printf("%g\n", ((CFNumberRef)inObject)->mFloatValue);
+	}
+	else
+	{
+		printf("<object %p of type %lu>\n", inObject, CFGetTypeID(inObject));
+	}
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFString
+//==================================================================================================
+
+//	The constant strings are kept in a list so that each literal only makes one object.
+typedef struct ConstantString
+{
+	struct ConstantString*	mNext;
+	struct __CFString*		mString;
+} ConstantString;
+
+static pthread_mutex_t	gConstantStrings_Mutex	= PTHREAD_MUTEX_INITIALIZER;
+static ConstantString*	gConstantStrings		= NULL;
+
+static struct __CFString*	CreateString(const char* inCString)
+{
+	struct __CFString* theString = (struct __CFString*)AllocateObject(sizeof(struct __CFString), kTypeID_String);
+	theString->mCString = strdup(inCString);
+	return theString;
+}
+
+CFStringRef	__NullAudioHost_CFStringMakeConstant(const char* inCString)
+{
+	struct __CFString* theAnswer = NULL;
+	pthread_mutex_lock(&gConstantStrings_Mutex);
+	for(ConstantString* theEntry = gConstantStrings; (theAnswer == NULL) && (theEntry != NULL); theEntry = theEntry->mNext)
+	{
+		if(strcmp(theEntry->mString->mCString, inCString) == 0)
+		{
+			theAnswer = theEntry->mString;
+		}
+	}
+	if(theAnswer == NULL)
+	{
+		theAnswer = CreateString(inCString);
+		atomic_store_explicit(&theAnswer->mObject.mRetainCount, -1, memory_order_relaxed);
+		ConstantString* theEntry = (ConstantString*)malloc(sizeof(ConstantString));
+		theEntry->mString = theAnswer;
+		theEntry->mNext = gConstantStrings;
+		gConstantStrings = theEntry;
+	}
+	pthread_mutex_unlock(&gConstantStrings_Mutex);
+	return theAnswer;
+}
+
+CFTypeID	CFStringGetTypeID(void)
+{
+	return kTypeID_String;
+}
+
+CFStringRef	CFStringCreateWithFormat(CFAllocatorRef inAllocator, CFDictionaryRef inFormatOptions, CFStringRef inFormat, ...)
+{
+	//	Only the printf conversions are supported, not %@.
+	(void)inAllocator;
+	(void)inFormatOptions;
+	char theBuffer[1024];
+	va_list theArguments;
+	va_start(theArguments, inFormat);
+	vsnprintf(theBuffer, sizeof(theBuffer), inFormat->mCString, theArguments);
+	va_end(theArguments);
+	return CreateString(theBuffer);
+}
+
+CFStringRef	CFStringCreateWithCString(CFAllocatorRef inAllocator, const char* inCString, UInt32 inEncoding)
+{
+	(void)inAllocator;
+	(void)inEncoding;
+	return CreateString(inCString);
+}
+
+CFComparisonResult	CFStringCompare(CFStringRef inString1, CFStringRef inString2, CFOptionFlags inCompareOptions)
+{
+	(void)inCompareOptions;
+	int theComparison = strcmp(inString1->mCString, inString2->mCString);
+	return (theComparison < 0) ? kCFCompareLessThan : ((theComparison > 0) ? kCFCompareGreaterThan : kCFCompareEqualTo);
+}
+
+const char*	CFStringGetCStringPtr(CFStringRef inString, UInt32 inEncoding)
+{
+	(void)inEncoding;
+	return inString->mCString;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFNumber and CFBoolean
+//==================================================================================================
+
+CFTypeID	CFNumberGetTypeID(void)
+{
+	return kTypeID_Number;
+}
+
+CFNumberRef	CFNumberCreate(CFAllocatorRef inAllocator, CFNumberType inType, const void* inValue)
+{
+	(void)inAllocator;
+	struct __CFNumber* theNumber = (struct __CFNumber*)AllocateObject(sizeof(struct __CFNumber), kTypeID_Number);
+	theNumber->mType = inType;
+	switch(inType)
+	{
+		case kCFNumberSInt8Type:
+			theNumber->mIntegerValue = *((const int8_t*)inValue);
+			break;
+
+		case kCFNumberSInt16Type:
+			theNumber->mIntegerValue = *((const SInt16*)inValue);
+			break;
+
+		case kCFNumberSInt32Type:
+			theNumber->mIntegerValue = *((const SInt32*)inValue);
+			break;
+
+		case kCFNumberSInt64Type:
+			theNumber->mIntegerValue = *((const SInt64*)inValue);
+			break;
+
+		case kCFNumberFloat32Type:
+			theNumber->mFloatValue = *((const Float32*)inValue);
+			theNumber->mIntegerValue = (SInt64)theNumber->mFloatValue;
+			break;
+
+		case kCFNumberFloat64Type:
+			theNumber->mFloatValue = *((const Float64*)inValue);
+			theNumber->mIntegerValue = (SInt64)theNumber->mFloatValue;
+			break;
+	};
+	if((inType != kCFNumberFloat32Type) && (inType != kCFNumberFloat64Type))
+	{
+		theNumber->mFloatValue = (Float64)theNumber->mIntegerValue;
+	}
+	return theNumber;
+}
+
+Boolean	CFNumberGetValue(CFNumberRef inNumber, CFNumberType inType, void* outValue)
+{
+	switch(inType)
+	{
+		case kCFNumberSInt8Type:
+			*((int8_t*)outValue) = (int8_t)inNumber->mIntegerValue;
+			break;
+
+		case kCFNumberSInt16Type:
+			*((SInt16*)outValue) = (SInt16)inNumber->mIntegerValue;
+			break;
+
+		case kCFNumberSInt32Type:
+			*((SInt32*)outValue) = (SInt32)inNumber->mIntegerValue;
+			break;
+
+		case kCFNumberSInt64Type:
+			*((SInt64*)outValue) = inNumber->mIntegerValue;
+			break;
+
+		case kCFNumberFloat32Type:
+			*((Float32*)outValue) = (Float32)inNumber->mFloatValue;
+			break;
+
+		case kCFNumberFloat64Type:
+			*((Float64*)outValue) = inNumber->mFloatValue;
+			break;
+	};
+	return true;
+}
+
+static struct __CFBoolean	gBooleanTrue	= { { kTypeID_Boolean, -1 }, true };
+static struct __CFBoolean	gBooleanFalse	= { { kTypeID_Boolean, -1 }, false };
+const CFBooleanRef			kCFBooleanTrue	= &gBooleanTrue;
+const CFBooleanRef			kCFBooleanFalse	= &gBooleanFalse;
+
+CFTypeID	CFBooleanGetTypeID(void)
+{
+	return kTypeID_Boolean;
+}
+
+Boolean	CFBooleanGetValue(CFBooleanRef inBoolean)
+{
+	return inBoolean->mValue;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFArray and CFDictionary
+//==================================================================================================
+
+const CFArrayCallBacks				kCFTypeArrayCallBacks			= { 0 };
+const CFDictionaryKeyCallBacks		kCFTypeDictionaryKeyCallBacks	= { 0 };
+const CFDictionaryValueCallBacks	kCFTypeDictionaryValueCallBacks	= { 0 };
+
+CFTypeID	CFArrayGetTypeID(void)
+{
+	return kTypeID_Array;
+}
+
+CFMutableArrayRef	CFArrayCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity, const CFArrayCallBacks* inCallBacks)
+{
+	(void)inAllocator;
+	(void)inCapacity;
+	(void)inCallBacks;
+	return (CFMutableArrayRef)AllocateObject(sizeof(struct __CFArray), kTypeID_Array);
+}
+
+void	CFArrayAppendValue(CFMutableArrayRef inArray, const void* inValue)
+{
+	if(inArray->mCount == inArray->mCapacity)
+	{
+		inArray->mCapacity = (inArray->mCapacity == 0) ? 8 : (2 * inArray->mCapacity);
+		inArray->mValues = (CFTypeRef*)realloc(inArray->mValues, inArray->mCapacity * sizeof(CFTypeRef));
+	}
+	inArray->mValues[inArray->mCount] = CFRetain(inValue);
+	++inArray->mCount;
+}
+
+CFIndex	CFArrayGetCount(CFArrayRef inArray)
+{
+	return inArray->mCount;
+}
+
+const void*	CFArrayGetValueAtIndex(CFArrayRef inArray, CFIndex inIndex)
+{
+	return ((inIndex >= 0) && (inIndex < inArray->mCount)) ? inArray->mValues[inIndex] : NULL;
+}
+
+CFTypeID	CFDictionaryGetTypeID(void)
+{
+	return kTypeID_Dictionary;
+}
+
+CFMutableDictionaryRef	CFDictionaryCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity, const CFDictionaryKeyCallBacks* inKeyCallBacks, const CFDictionaryValueCallBacks* inValueCallBacks)
+{
+	(void)inAllocator;
+	(void)inCapacity;
+	(void)inKeyCallBacks;
+	(void)inValueCallBacks;
+	return (CFMutableDictionaryRef)AllocateObject(sizeof(struct __CFDictionary), kTypeID_Dictionary);
+}
+
+CFMutableDictionaryRef	CFDictionaryCreateMutableCopy(CFAllocatorRef inAllocator, CFIndex inCapacity, CFDictionaryRef inDictionary)
+{
+	CFMutableDictionaryRef theAnswer = CFDictionaryCreateMutable(inAllocator, inCapacity, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	for(CFIndex theIndex = 0; theIndex < inDictionary->mCount; ++theIndex)
+	{
+		CFDictionarySetValue(theAnswer, inDictionary->mKeys[theIndex], inDictionary->mValues[theIndex]);
+	}
+	return theAnswer;
+}
+
+CFDictionaryRef	CFDictionaryCreateCopy(CFAllocatorRef inAllocator, CFDictionaryRef inDictionary)
+{
+	return CFDictionaryCreateMutableCopy(inAllocator, 0, inDictionary);
+}
+
+CFIndex	CFDictionaryGetCount(CFDictionaryRef inDictionary)
+{
+	return inDictionary->mCount;
+}
+
+const void*	CFDictionaryGetValue(CFDictionaryRef inDictionary, const void* inKey)
+{
+	const void* theAnswer = NULL;
+	for(CFIndex theIndex = 0; (theAnswer == NULL) && (theIndex < inDictionary->mCount); ++theIndex)
+	{
+		if(CFEqual(inDictionary->mKeys[theIndex], inKey))
+		{
+			theAnswer = inDictionary->mValues[theIndex];
+		}
+	}
+	return theAnswer;
+}
+
+void	CFDictionarySetValue(CFMutableDictionaryRef inDictionary, const void* inKey, const void* inValue)
+{
+	for(CFIndex theIndex = 0; theIndex < inDictionary->mCount; ++theIndex)
+	{
+		if(CFEqual(inDictionary->mKeys[theIndex], inKey))
+		{
+			CFRetain(inValue);
+			CFRelease(inDictionary->mValues[theIndex]);
+			inDictionary->mValues[theIndex] = inValue;
+			return;
+		}
+	}
+	if(inDictionary->mCount == inDictionary->mCapacity)
+	{
+		inDictionary->mCapacity = (inDictionary->mCapacity == 0) ? 8 : (2 * inDictionary->mCapacity);
+		inDictionary->mKeys = (CFTypeRef*)realloc(inDictionary->mKeys, inDictionary->mCapacity * sizeof(CFTypeRef));
+		inDictionary->mValues = (CFTypeRef*)realloc(inDictionary->mValues, inDictionary->mCapacity * sizeof(CFTypeRef));
+	}
+	inDictionary->mKeys[inDictionary->mCount] = CFRetain(inKey);
+	inDictionary->mValues[inDictionary->mCount] = CFRetain(inValue);
+	++inDictionary->mCount;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFUUID, CFURL and CFBundle
+//==================================================================================================
+
+typedef struct ConstantUUID
+{
+	struct ConstantUUID*	mNext;
+	struct __CFUUID*		mUUID;
+} ConstantUUID;
+
+static pthread_mutex_t	gConstantUUIDs_Mutex	= PTHREAD_MUTEX_INITIALIZER;
+static ConstantUUID*	gConstantUUIDs			= NULL;
+
+CFTypeID	CFUUIDGetTypeID(void)
+{
+	return kTypeID_UUID;
+}
+
+CFUUIDRef	CFUUIDGetConstantUUIDWithBytes(CFAllocatorRef inAllocator, UInt8 inByte0, UInt8 inByte1, UInt8 inByte2, UInt8 inByte3, UInt8 inByte4, UInt8 inByte5, UInt8 inByte6, UInt8 inByte7, UInt8 inByte8, UInt8 inByte9, UInt8 inByte10, UInt8 inByte11, UInt8 inByte12, UInt8 inByte13, UInt8 inByte14, UInt8 inByte15)
+{
+	(void)inAllocator;
+	CFUUIDBytes theBytes = { inByte0, inByte1, inByte2, inByte3, inByte4, inByte5, inByte6, inByte7, inByte8, inByte9, inByte10, inByte11, inByte12, inByte13, inByte14, inByte15 };
+	struct __CFUUID* theAnswer = NULL;
+	pthread_mutex_lock(&gConstantUUIDs_Mutex);
+	for(ConstantUUID* theEntry = gConstantUUIDs; (theAnswer == NULL) && (theEntry != NULL); theEntry = theEntry->mNext)
+	{
+		if(memcmp(&theEntry->mUUID->mBytes, &theBytes, sizeof(CFUUIDBytes)) == 0)
+		{
+			theAnswer = theEntry->mUUID;
+		}
+	}
+	if(theAnswer == NULL)
+	{
+		theAnswer = (struct __CFUUID*)AllocateObject(sizeof(struct __CFUUID), kTypeID_UUID);
+		atomic_store_explicit(&theAnswer->mObject.mRetainCount, -1, memory_order_relaxed);
+		theAnswer->mBytes = theBytes;
+		ConstantUUID* theEntry = (ConstantUUID*)malloc(sizeof(ConstantUUID));
+		theEntry->mUUID = theAnswer;
+		theEntry->mNext = gConstantUUIDs;
+		gConstantUUIDs = theEntry;
+	}
+	pthread_mutex_unlock(&gConstantUUIDs_Mutex);
+	return theAnswer;
+}
+
+CFUUIDRef	CFUUIDCreateFromUUIDBytes(CFAllocatorRef inAllocator, CFUUIDBytes inBytes)
+{
+	(void)inAllocator;
+	struct __CFUUID* theAnswer = (struct __CFUUID*)AllocateObject(sizeof(struct __CFUUID), kTypeID_UUID);
+	theAnswer->mBytes = inBytes;
+	return theAnswer;
+}
+
+CFUUIDBytes	CFUUIDGetUUIDBytes(CFUUIDRef inUUID)
+{
+	return inUUID->mBytes;
+}
+
+CFBundleRef	CFBundleGetBundleWithIdentifier(CFStringRef inBundleID)
+{
+	(void)inBundleID;
+	return NULL;
+}
+
+CFURLRef	CFBundleCopyResourceURL(CFBundleRef inBundle, CFStringRef inResourceName, CFStringRef inResourceType, CFStringRef inSubDirName)
+{
+	(void)inBundle;
+	(void)inResourceName;
+	(void)inResourceType;
+	(void)inSubDirName;
+	return NULL;
+}
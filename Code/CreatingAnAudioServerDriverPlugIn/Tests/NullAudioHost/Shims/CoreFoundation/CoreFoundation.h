@@ -0,0 +1,189 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The subset of CoreFoundation that NullAudio uses, for building the driver outside of macOS.
+*/
+
+/*==================================================================================================
+	CoreFoundation.h
+==================================================================================================*/
+#if !defined(__NullAudioHost_CoreFoundation_h__)
+#define __NullAudioHost_CoreFoundation_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Basic Types
+//==================================================================================================
+
+//	This only has what the driver and the harness need. Every object is reference counted the same
+//	way real CF objects are, and the collections always retain their keys and values, which is what
+//	the kCFType callbacks do. The CFSTR() strings live for the life of the process.
+
+#define	TARGET_RT_BIG_ENDIAN	0
+
+typedef uint8_t		Boolean;
+typedef uint8_t		Byte;
+typedef uint8_t		UInt8;
+typedef int16_t		SInt16;
+typedef uint16_t	UInt16;
+typedef int32_t		SInt32;
+typedef uint32_t	UInt32;
+typedef int64_t		SInt64;
+typedef uint64_t	UInt64;
+typedef float		Float32;
+typedef double		Float64;
+typedef SInt32		OSStatus;
+
+typedef long			CFIndex;
+typedef unsigned long	CFTypeID;
+typedef unsigned long	CFOptionFlags;
+
+typedef const void*						CFTypeRef;
+typedef const void*						CFPropertyListRef;
+typedef const struct __CFAllocator*		CFAllocatorRef;
+typedef const struct __CFString*		CFStringRef;
+typedef const struct __CFNumber*		CFNumberRef;
+typedef const struct __CFBoolean*		CFBooleanRef;
+typedef const struct __CFArray*			CFArrayRef;
+typedef struct __CFArray*				CFMutableArrayRef;
+typedef const struct __CFDictionary*	CFDictionaryRef;
+typedef struct __CFDictionary*			CFMutableDictionaryRef;
+typedef const struct __CFUUID*			CFUUIDRef;
+typedef const struct __CFURL*			CFURLRef;
+typedef struct __CFBundle*				CFBundleRef;
+
+typedef enum
+{
+	kCFCompareLessThan		= -1,
+	kCFCompareEqualTo		= 0,
+	kCFCompareGreaterThan	= 1
+} CFComparisonResult;
+
+CFTypeRef	CFRetain(CFTypeRef inObject);
+void		CFRelease(CFTypeRef inObject);
+CFTypeID	CFGetTypeID(CFTypeRef inObject);
+Boolean		CFEqual(CFTypeRef inObject1, CFTypeRef inObject2);
+CFIndex		CFGetRetainCount(CFTypeRef inObject);
+void		CFShow(CFTypeRef inObject);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFString
+//==================================================================================================
+
+#define	CFSTR(inCString)	__NullAudioHost_CFStringMakeConstant("" inCString "")
+
+CFStringRef			__NullAudioHost_CFStringMakeConstant(const char* inCString);
+CFTypeID			CFStringGetTypeID(void);
+CFStringRef			CFStringCreateWithFormat(CFAllocatorRef inAllocator, CFDictionaryRef inFormatOptions, CFStringRef inFormat, ...);
+CFStringRef			CFStringCreateWithCString(CFAllocatorRef inAllocator, const char* inCString, UInt32 inEncoding);
+CFComparisonResult	CFStringCompare(CFStringRef inString1, CFStringRef inString2, CFOptionFlags inCompareOptions);
+const char*			CFStringGetCStringPtr(CFStringRef inString, UInt32 inEncoding);
+
+#define	kCFStringEncodingUTF8	0x08000100
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFNumber and CFBoolean
+//==================================================================================================
+
+typedef enum
+{
+	kCFNumberSInt8Type		= 1,
+	kCFNumberSInt16Type		= 2,
+	kCFNumberSInt32Type		= 3,
+	kCFNumberSInt64Type		= 4,
+	kCFNumberFloat32Type	= 5,
+	kCFNumberFloat64Type	= 6
+} CFNumberType;
+
+CFTypeID	CFNumberGetTypeID(void);
+CFNumberRef	CFNumberCreate(CFAllocatorRef inAllocator, CFNumberType inType, const void* inValue);
+Boolean		CFNumberGetValue(CFNumberRef inNumber, CFNumberType inType, void* outValue);
+
+extern const CFBooleanRef	kCFBooleanTrue;
+extern const CFBooleanRef	kCFBooleanFalse;
+
+CFTypeID	CFBooleanGetTypeID(void);
+Boolean		CFBooleanGetValue(CFBooleanRef inBoolean);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFArray and CFDictionary
+//==================================================================================================
+
+typedef struct { CFIndex version; } CFArrayCallBacks;
+typedef struct { CFIndex version; } CFDictionaryKeyCallBacks;
+typedef struct { CFIndex version; } CFDictionaryValueCallBacks;
+
+extern const CFArrayCallBacks			kCFTypeArrayCallBacks;
+extern const CFDictionaryKeyCallBacks	kCFTypeDictionaryKeyCallBacks;
+extern const CFDictionaryValueCallBacks	kCFTypeDictionaryValueCallBacks;
+
+CFTypeID			CFArrayGetTypeID(void);
+CFMutableArrayRef	CFArrayCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity, const CFArrayCallBacks* inCallBacks);
+void				CFArrayAppendValue(CFMutableArrayRef inArray, const void* inValue);
+CFIndex				CFArrayGetCount(CFArrayRef inArray);
+const void*			CFArrayGetValueAtIndex(CFArrayRef inArray, CFIndex inIndex);
+
+CFTypeID				CFDictionaryGetTypeID(void);
+CFMutableDictionaryRef	CFDictionaryCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity, const CFDictionaryKeyCallBacks* inKeyCallBacks, const CFDictionaryValueCallBacks* inValueCallBacks);
+CFMutableDictionaryRef	CFDictionaryCreateMutableCopy(CFAllocatorRef inAllocator, CFIndex inCapacity, CFDictionaryRef inDictionary);
+CFDictionaryRef			CFDictionaryCreateCopy(CFAllocatorRef inAllocator, CFDictionaryRef inDictionary);
+CFIndex					CFDictionaryGetCount(CFDictionaryRef inDictionary);
+const void*				CFDictionaryGetValue(CFDictionaryRef inDictionary, const void* inKey);
+void					CFDictionarySetValue(CFMutableDictionaryRef inDictionary, const void* inKey, const void* inValue);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFUUID, CFURL and CFBundle
+//==================================================================================================
+
+typedef struct
+{
+	UInt8	byte0, byte1, byte2, byte3, byte4, byte5, byte6, byte7, byte8, byte9, byte10, byte11, byte12, byte13, byte14, byte15;
+} CFUUIDBytes;
+
+CFTypeID	CFUUIDGetTypeID(void);
+CFUUIDRef	CFUUIDGetConstantUUIDWithBytes(CFAllocatorRef inAllocator, UInt8 inByte0, UInt8 inByte1, UInt8 inByte2, UInt8 inByte3, UInt8 inByte4, UInt8 inByte5, UInt8 inByte6, UInt8 inByte7, UInt8 inByte8, UInt8 inByte9, UInt8 inByte10, UInt8 inByte11, UInt8 inByte12, UInt8 inByte13, UInt8 inByte14, UInt8 inByte15);
+CFUUIDRef	CFUUIDCreateFromUUIDBytes(CFAllocatorRef inAllocator, CFUUIDBytes inBytes);
+CFUUIDBytes	CFUUIDGetUUIDBytes(CFUUIDRef inUUID);
+
+//	There is no bundle outside of coreaudiod, so these always fail.
+CFBundleRef	CFBundleGetBundleWithIdentifier(CFStringRef inBundleID);
+CFURLRef	CFBundleCopyResourceURL(CFBundleRef inBundle, CFStringRef inResourceName, CFStringRef inResourceType, CFStringRef inSubDirName);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CFPlugInCOM
+//==================================================================================================
+
+typedef SInt32		HRESULT;
+typedef UInt32		ULONG;
+typedef void*		LPVOID;
+typedef CFUUIDBytes	REFIID;
+
+#define	S_OK			((HRESULT)0x00000000L)
+#define	E_NOINTERFACE	((HRESULT)0x80000004L)
+
+#define	IUnknownUUID	CFUUIDGetConstantUUIDWithBytes(NULL, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46)
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif	//	__NullAudioHost_CoreFoundation_h__
@@ -0,0 +1,192 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The subset of libdispatch that NullAudio uses, for building the driver outside of macOS.
+*/
+
+/*==================================================================================================
+	dispatch.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <dispatch/dispatch.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Queues
+//==================================================================================================
+
+//	The work items are kept in a list sorted by when they are due, with items that are due at the
+//	same time kept in the order they were added. The queue's thread sleeps until the first one is due.
+
+typedef struct WorkItem
+{
+	struct WorkItem*	mNext;
+	dispatch_time_t		mWhen;
+	void*				mContext;
+	dispatch_function_t	mWork;
+} WorkItem;
+
+struct NullAudioHost_DispatchQueue
+{
+	pthread_mutex_t	mMutex;
+	pthread_cond_t	mCondition;
+	pthread_t		mThread;
+	WorkItem*		mItems;
+};
+
+static dispatch_time_t	GetCurrentTime(void)
+{
+	struct timespec theTime;
+	clock_gettime(CLOCK_MONOTONIC, &theTime);
+	return ((dispatch_time_t)theTime.tv_sec * 1000000000ULL) + (dispatch_time_t)theTime.tv_nsec;
+}
+
+static void*	RunQueue(void* inQueue)
+{
+	dispatch_queue_t theQueue = (dispatch_queue_t)inQueue;
+	pthread_mutex_lock(&theQueue->mMutex);
+	while(true)
+	{
+		if(theQueue->mItems == NULL)
+		{
+			pthread_cond_wait(&theQueue->mCondition, &theQueue->mMutex);
+		}
+		else if(theQueue->mItems->mWhen > GetCurrentTime())
+		{
+			struct timespec theDeadline;
+			clock_gettime(CLOCK_MONOTONIC, &theDeadline);
+			dispatch_time_t theDelay = theQueue->mItems->mWhen - GetCurrentTime();
+			theDeadline.tv_sec += (time_t)(theDelay / 1000000000ULL);
+			theDeadline.tv_nsec += (long)(theDelay % 1000000000ULL);
+			if(theDeadline.tv_nsec >= 1000000000L)
+			{
+				theDeadline.tv_sec += 1;
+				theDeadline.tv_nsec -= 1000000000L;
+			}
+			pthread_cond_timedwait(&theQueue->mCondition, &theQueue->mMutex, &theDeadline);
+		}
+		else
+		{
+			WorkItem* theItem = theQueue->mItems;
+			theQueue->mItems = theItem->mNext;
+			pthread_mutex_unlock(&theQueue->mMutex);
+			theItem->mWork(theItem->mContext);
+			free(theItem);
+			pthread_mutex_lock(&theQueue->mMutex);
+		}
+	}
+	return NULL;
+}
+
+dispatch_queue_t	dispatch_queue_create(const char* inLabel, dispatch_queue_attr_t inAttributes)
+{
+	(void)inLabel;
+	(void)inAttributes;
+	dispatch_queue_t theQueue = (dispatch_queue_t)calloc(1, sizeof(struct NullAudioHost_DispatchQueue));
+	if(theQueue == NULL)
+	{
+		abort();
+	}
+	pthread_mutex_init(&theQueue->mMutex, NULL);
+	pthread_condattr_t theConditionAttributes;
+	pthread_condattr_init(&theConditionAttributes);
+	pthread_condattr_setclock(&theConditionAttributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&theQueue->mCondition, &theConditionAttributes);
+	pthread_condattr_destroy(&theConditionAttributes);
+	pthread_create(&theQueue->mThread, NULL, RunQueue, theQueue);
+	pthread_detach(theQueue->mThread);
+	return theQueue;
+}
+
+static pthread_once_t	gGlobalQueue_Once	= PTHREAD_ONCE_INIT;
+static dispatch_queue_t	gGlobalQueue		= NULL;
+
+static void	CreateGlobalQueue(void)
+{
+	gGlobalQueue = dispatch_queue_create("global", DISPATCH_QUEUE_SERIAL);
+}
+
+dispatch_queue_t	dispatch_get_global_queue(long inPriority, unsigned long inFlags)
+{
+	(void)inPriority;
+	(void)inFlags;
+	pthread_once(&gGlobalQueue_Once, CreateGlobalQueue);
+	return gGlobalQueue;
+}
+
+dispatch_time_t	dispatch_time(dispatch_time_t inWhen, int64_t inDelta)
+{
+	dispatch_time_t theBase = (inWhen == DISPATCH_TIME_NOW) ? GetCurrentTime() : inWhen;
+	return (inDelta < 0) ? (theBase - (dispatch_time_t)(-inDelta)) : (theBase + (dispatch_time_t)inDelta);
+}
+
+void	dispatch_after_f(dispatch_time_t inWhen, dispatch_queue_t inQueue, void* inContext, dispatch_function_t inWork)
+{
+	WorkItem* theItem = (WorkItem*)malloc(sizeof(WorkItem));
+	if(theItem == NULL)
+	{
+		abort();
+	}
+	theItem->mWhen = inWhen;
+	theItem->mContext = inContext;
+	theItem->mWork = inWork;
+
+	pthread_mutex_lock(&inQueue->mMutex);
+	WorkItem** theLink = &inQueue->mItems;
+	while((*theLink != NULL) && ((*theLink)->mWhen <= inWhen))
+	{
+		theLink = &(*theLink)->mNext;
+	}
+	theItem->mNext = *theLink;
+	*theLink = theItem;
+	pthread_cond_signal(&inQueue->mCondition);
+	pthread_mutex_unlock(&inQueue->mMutex);
+}
+
+void	dispatch_async_f(dispatch_queue_t inQueue, void* inContext, dispatch_function_t inWork)
+{
+	dispatch_after_f(GetCurrentTime(), inQueue, inContext, inWork);
+}
+
+typedef struct SyncItem
+{
+	pthread_mutex_t		mMutex;
+	pthread_cond_t		mCondition;
+	bool				mIsDone;
+	void*				mContext;
+	dispatch_function_t	mWork;
+} SyncItem;
+
+static void	RunSyncItem(void* inSyncItem)
+{
+	SyncItem* theSyncItem = (SyncItem*)inSyncItem;
+	theSyncItem->mWork(theSyncItem->mContext);
+	pthread_mutex_lock(&theSyncItem->mMutex);
+	theSyncItem->mIsDone = true;
+	pthread_cond_signal(&theSyncItem->mCondition);
+	pthread_mutex_unlock(&theSyncItem->mMutex);
+}
+
+void	dispatch_sync_f(dispatch_queue_t inQueue, void* inContext, dispatch_function_t inWork)
+{
+	//	This runs after everything that is already due on the queue, which makes it a handy way to
+	//	wait for the queue to catch up.
+	SyncItem theSyncItem = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false, inContext, inWork };
+	dispatch_async_f(inQueue, &theSyncItem, RunSyncItem);
+	pthread_mutex_lock(&theSyncItem.mMutex);
+	while(!theSyncItem.mIsDone)
+	{
+		pthread_cond_wait(&theSyncItem.mCondition, &theSyncItem.mMutex);
+	}
+	pthread_mutex_unlock(&theSyncItem.mMutex);
+}
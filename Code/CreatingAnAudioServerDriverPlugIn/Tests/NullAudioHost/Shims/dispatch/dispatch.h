@@ -0,0 +1,55 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+The subset of libdispatch that NullAudio uses, for building the driver outside of macOS.
+*/
+
+/*==================================================================================================
+	dispatch.h
+==================================================================================================*/
+#if !defined(__NullAudioHost_dispatch_h__)
+#define __NullAudioHost_dispatch_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Queues
+//==================================================================================================
+
+//	Each queue is serial and has its own thread, including the global queue. That is stricter than
+//	libdispatch, which is fine since the driver never relies on work running concurrently. Times are
+//	nanoseconds on the real monotonic clock, so delayed work runs on schedule even when the driver's
+//	host clock is simulated.
+
+typedef struct NullAudioHost_DispatchQueue*	dispatch_queue_t;
+typedef const struct NullAudioHost_DispatchQueueAttributes*	dispatch_queue_attr_t;
+typedef uint64_t							dispatch_time_t;
+typedef void								(*dispatch_function_t)(void* inContext);
+
+#define	DISPATCH_QUEUE_SERIAL				((dispatch_queue_attr_t)0)
+#define	DISPATCH_QUEUE_PRIORITY_DEFAULT		0
+#define	DISPATCH_TIME_NOW					((dispatch_time_t)0)
+#define	DISPATCH_TIME_FOREVER				(~(dispatch_time_t)0)
+
+dispatch_queue_t	dispatch_queue_create(const char* inLabel, dispatch_queue_attr_t inAttributes);
+dispatch_queue_t	dispatch_get_global_queue(long inPriority, unsigned long inFlags);
+dispatch_time_t		dispatch_time(dispatch_time_t inWhen, int64_t inDelta);
+void				dispatch_async_f(dispatch_queue_t inQueue, void* inContext, dispatch_function_t inWork);
+void				dispatch_after_f(dispatch_time_t inWhen, dispatch_queue_t inQueue, void* inContext, dispatch_function_t inWork);
+void				dispatch_sync_f(dispatch_queue_t inQueue, void* inContext, dispatch_function_t inWork);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif	//	__NullAudioHost_dispatch_h__
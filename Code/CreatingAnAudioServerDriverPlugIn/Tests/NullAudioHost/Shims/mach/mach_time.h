@@ -0,0 +1,59 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A host clock for building NullAudio outside of macOS that the harness can simulate.
+*/
+
+/*==================================================================================================
+	mach_time.h
+==================================================================================================*/
+#if !defined(__NullAudioHost_mach_time_h__)
+#define __NullAudioHost_mach_time_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark mach_time
+//==================================================================================================
+
+struct mach_timebase_info
+{
+	uint32_t	numer;
+	uint32_t	denom;
+};
+typedef struct mach_timebase_info*	mach_timebase_info_t;
+
+int			mach_timebase_info(mach_timebase_info_t outInfo);
+uint64_t	mach_absolute_time(void);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Harness Controls
+//==================================================================================================
+
+//	By default the clock follows the real monotonic clock with a 1/1 timebase, like an Intel Mac.
+//	The harness can change the timebase, for example to the 125/3 of Apple silicon, and can switch to
+//	a simulated clock that only moves when it is told to. The timebase must only be changed while
+//	no device is running.
+
+void		NullAudioHost_SetTimebase(uint32_t inNumerator, uint32_t inDenominator);
+void		NullAudioHost_UseSimulatedClock(bool inUseSimulatedClock);
+void		NullAudioHost_SetSimulatedTime(uint64_t inHostTime);
+void		NullAudioHost_AdvanceSimulatedTime(uint64_t inHostTicks);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif	//	__NullAudioHost_mach_time_h__
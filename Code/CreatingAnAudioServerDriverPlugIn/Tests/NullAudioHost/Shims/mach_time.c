@@ -0,0 +1,80 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+A host clock for building NullAudio outside of macOS that the harness can simulate.
+*/
+
+/*==================================================================================================
+	mach_time.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#include <mach/mach_time.h>
+
+#include <stdatomic.h>
+#include <time.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark mach_time
+//==================================================================================================
+
+static _Atomic uint32_t	gTimebase_Numerator		= 1;
+static _Atomic uint32_t	gTimebase_Denominator	= 1;
+static _Atomic bool		gClock_IsSimulated		= false;
+static _Atomic uint64_t	gClock_SimulatedTime	= 0;
+
+int	mach_timebase_info(mach_timebase_info_t outInfo)
+{
+	outInfo->numer = atomic_load_explicit(&gTimebase_Numerator, memory_order_relaxed);
+	outInfo->denom = atomic_load_explicit(&gTimebase_Denominator, memory_order_relaxed);
+	return 0;
+}
+
+uint64_t	mach_absolute_time(void)
+{
+	uint64_t theAnswer = 0;
+	if(atomic_load_explicit(&gClock_IsSimulated, memory_order_relaxed))
+	{
+		theAnswer = atomic_load_explicit(&gClock_SimulatedTime, memory_order_relaxed);
+	}
+	else
+	{
+		//	ticks = nanoseconds * denom / numer, done in 128 bits so it can't overflow
+		struct timespec theTime;
+		clock_gettime(CLOCK_MONOTONIC, &theTime);
+		unsigned __int128 theNanoseconds = ((unsigned __int128)theTime.tv_sec * 1000000000U) + (unsigned __int128)theTime.tv_nsec;
+		theAnswer = (uint64_t)((theNanoseconds * atomic_load_explicit(&gTimebase_Denominator, memory_order_relaxed)) / atomic_load_explicit(&gTimebase_Numerator, memory_order_relaxed));
+	}
+	return theAnswer;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Harness Controls
+//==================================================================================================
+
+void	NullAudioHost_SetTimebase(uint32_t inNumerator, uint32_t inDenominator)
+{
+	atomic_store_explicit(&gTimebase_Numerator, inNumerator, memory_order_relaxed);
+	atomic_store_explicit(&gTimebase_Denominator, inDenominator, memory_order_relaxed);
+}
+
+void	NullAudioHost_UseSimulatedClock(bool inUseSimulatedClock)
+{
+	atomic_store_explicit(&gClock_IsSimulated, inUseSimulatedClock, memory_order_relaxed);
+}
+
+void	NullAudioHost_SetSimulatedTime(uint64_t inHostTime)
+{
+	atomic_store_explicit(&gClock_SimulatedTime, inHostTime, memory_order_relaxed);
+}
+
+void	NullAudioHost_AdvanceSimulatedTime(uint64_t inHostTicks)
+{
+	atomic_fetch_add_explicit(&gClock_SimulatedTime, inHostTicks, memory_order_relaxed);
+}
@@ -0,0 +1,199 @@
+/*
+See LICENSE folder for this sample’s licensing information.
+
+Abstract:
+Measures NullAudio_GetZeroTimeStamp while other threads hammer the device's state lock with property changes.
+*/
+
+/*==================================================================================================
+	StateContention.c
+==================================================================================================*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	for RUSAGE_THREAD
+#define _GNU_SOURCE
+
+#include "NullAudioHost.h"
+
+#include <sys/resource.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark State Contention
+//==================================================================================================
+
+//	Each setter thread changes the output volume as fast as it can, which takes the device's
+//	mStateMutex every time. Meanwhile the main thread, standing in for the IO thread, times one call
+//	at a time to GetZeroTimeStamp, which reads the clock anchor through its sequence lock and never
+//	takes the mutex. For contrast it then times getting the volume, which does take the mutex. The
+//	driver uses the real clock so that the time stamps move while the test runs.
+//
+//	The slowest calls are dominated by the main thread being preempted, which looks the same for
+//	both calls, so the percentiles alone can't show blocking. The count of the main thread's
+//	voluntary context switches can: a thread only gives up the CPU voluntarily when it waits, so
+//	the time stamp calls must not add a single one.
+
+static const UInt32		kSetterThreadCounts[]		= { 0, 1, 2, 4, 8 };
+#define					kNumberSetterThreadCounts	(sizeof(kSetterThreadCounts) / sizeof(kSetterThreadCounts[0]))
+#define					kMaxNumberSetterThreads		8
+static const UInt32		kNumberCalls				= 200000;
+
+typedef struct StateContention_Setter
+{
+	AudioServerPlugInDriverRef	mDriver;
+	AudioObjectID				mVolume;
+	pthread_t					mThread;
+	UInt64						mNumberCalls;
+	UInt64						mNumberFailures;
+} StateContention_Setter;
+
+static _Atomic bool		gSetters_ShouldStop = false;
+static UInt64			gNumberFailures = 0;
+
+static UInt64	StateContention_GetNumberVoluntarySwitches(void)
+{
+	struct rusage theUsage;
+	getrusage(RUSAGE_THREAD, &theUsage);
+	return (UInt64)theUsage.ru_nvcsw;
+}
+
+static void*	StateContention_RunSetter(void* inSetter)
+{
+	StateContention_Setter* theSetter = (StateContention_Setter*)inSetter;
+	AudioObjectPropertyAddress theAddress = { kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	while(!atomic_load_explicit(&gSetters_ShouldStop, memory_order_relaxed))
+	{
+		//	alternate between two levels so that every call changes the value
+		Float32 theVolume = ((theSetter->mNumberCalls & 1) != 0) ? 0.25f : 0.75f;
+		if((*theSetter->mDriver)->SetPropertyData(theSetter->mDriver, theSetter->mVolume, 0, &theAddress, 0, NULL, sizeof(Float32), &theVolume) != 0)
+		{
+			++theSetter->mNumberFailures;
+		}
+		++theSetter->mNumberCalls;
+	}
+	return NULL;
+}
+
+static void	StateContention_PrintPercentiles(const char* inCallName, UInt32 inNumberSetters, Float64 inSetterCallsPerSecond, NullAudioHost_Samples* ioSamples, UInt64 inNumberWaits)
+{
+	printf("%7u %12.0f  %-20s %8llu %8llu %8llu %10llu %7llu\n", inNumberSetters, inSetterCallsPerSecond, inCallName, (unsigned long long)NullAudioHost_GetPercentile(ioSamples, 50.0), (unsigned long long)NullAudioHost_GetPercentile(ioSamples, 99.0), (unsigned long long)NullAudioHost_GetPercentile(ioSamples, 99.9), (unsigned long long)NullAudioHost_GetPercentile(ioSamples, 100.0), (unsigned long long)inNumberWaits);
+}
+
+int	main(int argc, const char* argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	AudioServerPlugInDriverRef theDriver = NullAudioHost_OpenDriver(1);
+	AudioObjectID theDevice = kAudioObjectUnknown;
+	if(NullAudioHost_CopyDeviceList(theDriver, &theDevice, 1) != 1)
+	{
+		fprintf(stderr, "StateContention: the driver has no devices\n");
+		return 1;
+	}
+	AudioObjectID theVolume = NullAudioHost_GetControl(theDriver, theDevice, kAudioVolumeControlClassID, kAudioObjectPropertyScopeOutput);
+	if(theVolume == kAudioObjectUnknown)
+	{
+		fprintf(stderr, "StateContention: the device has no output volume control\n");
+		return 1;
+	}
+	NullAudioHost_IOContext theContext;
+	if(NullAudioHost_StartIO(&theContext, theDriver, theDevice, 1, 512) != 0)
+	{
+		fprintf(stderr, "StateContention: StartIO failed\n");
+		return 1;
+	}
+
+	printf("NullAudio calls from the IO thread with setter threads on the state lock, %u calls, nanoseconds\n", kNumberCalls);
+	printf("%7s %12s  %-20s %8s %8s %8s %10s %7s\n", "setters", "setters/s", "call", "p50", "p99", "p99.9", "max", "waits");
+
+	NullAudioHost_Samples theSamples;
+	NullAudioHost_InitSamples(&theSamples, kNumberCalls);
+	AudioObjectPropertyAddress theVolumeAddress = { kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+	for(UInt32 theCountIndex = 0; theCountIndex < kNumberSetterThreadCounts; ++theCountIndex)
+	{
+		//	start the setters
+		UInt32 theNumberSetters = kSetterThreadCounts[theCountIndex];
+		StateContention_Setter theSetters[kMaxNumberSetterThreads];
+		atomic_store_explicit(&gSetters_ShouldStop, false, memory_order_relaxed);
+		for(UInt32 theSetterIndex = 0; theSetterIndex < theNumberSetters; ++theSetterIndex)
+		{
+			StateContention_Setter theSetter = { theDriver, theVolume, 0, 0, 0 };
+			theSetters[theSetterIndex] = theSetter;
+			pthread_create(&theSetters[theSetterIndex].mThread, NULL, StateContention_RunSetter, &theSetters[theSetterIndex]);
+		}
+		UInt64 theStartTime = NullAudioHost_GetNanoseconds();
+
+		//	time the zero time stamps, which must never go backwards
+		theSamples.mNumberValues = 0;
+		Float64 theLastSampleTime = 0;
+		UInt64 theSwitchesBefore = StateContention_GetNumberVoluntarySwitches();
+		for(UInt32 theCall = 0; theCall < kNumberCalls; ++theCall)
+		{
+			Float64 theSampleTime = 0;
+			UInt64 theHostTime = 0;
+			UInt64 theSeed = 0;
+			UInt64 theCallStartTime = NullAudioHost_GetNanoseconds();
+			OSStatus theError = (*theDriver)->GetZeroTimeStamp(theDriver, theDevice, 1, &theSampleTime, &theHostTime, &theSeed);
+			NullAudioHost_AddSample(&theSamples, NullAudioHost_GetNanoseconds() - theCallStartTime);
+			if((theError != 0) || (theSampleTime < theLastSampleTime))
+			{
+				++gNumberFailures;
+			}
+			theLastSampleTime = theSampleTime;
+		}
+		UInt64 theZeroTimeStampWaits = StateContention_GetNumberVoluntarySwitches() - theSwitchesBefore;
+		if(theZeroTimeStampWaits != 0)
+		{
+			fprintf(stderr, "StateContention: GetZeroTimeStamp waited %llu times with %u setters\n", (unsigned long long)theZeroTimeStampWaits, theNumberSetters);
+			++gNumberFailures;
+		}
+
+		//	time getting the volume, which takes the lock
+		NullAudioHost_Samples theLockedSamples;
+		NullAudioHost_InitSamples(&theLockedSamples, kNumberCalls);
+		theSwitchesBefore = StateContention_GetNumberVoluntarySwitches();
+		for(UInt32 theCall = 0; theCall < kNumberCalls; ++theCall)
+		{
+			Float32 theValue = 0;
+			UInt32 theDataSize = 0;
+			UInt64 theCallStartTime = NullAudioHost_GetNanoseconds();
+			OSStatus theError = (*theDriver)->GetPropertyData(theDriver, theVolume, 0, &theVolumeAddress, 0, NULL, sizeof(Float32), &theDataSize, &theValue);
+			NullAudioHost_AddSample(&theLockedSamples, NullAudioHost_GetNanoseconds() - theCallStartTime);
+			if(theError != 0)
+			{
+				++gNumberFailures;
+			}
+		}
+
+		UInt64 theLockedWaits = StateContention_GetNumberVoluntarySwitches() - theSwitchesBefore;
+
+		//	stop the setters
+		atomic_store_explicit(&gSetters_ShouldStop, true, memory_order_relaxed);
+		UInt64 theNumberSetterCalls = 0;
+		for(UInt32 theSetterIndex = 0; theSetterIndex < theNumberSetters; ++theSetterIndex)
+		{
+			pthread_join(theSetters[theSetterIndex].mThread, NULL);
+			theNumberSetterCalls += theSetters[theSetterIndex].mNumberCalls;
+			gNumberFailures += theSetters[theSetterIndex].mNumberFailures;
+		}
+		Float64 theSetterCallsPerSecond = (theNumberSetterCalls * 1.0e9) / (NullAudioHost_GetNanoseconds() - theStartTime);
+
+		StateContention_PrintPercentiles("GetZeroTimeStamp", theNumberSetters, theSetterCallsPerSecond, &theSamples, theZeroTimeStampWaits);
+		StateContention_PrintPercentiles("GetVolume (locked)", theNumberSetters, theSetterCallsPerSecond, &theLockedSamples, theLockedWaits);
+		NullAudioHost_FreeSamples(&theLockedSamples);
+	}
+	NullAudioHost_FreeSamples(&theSamples);
+	NullAudioHost_StopIO(&theContext);
+
+	printf("StateContention: %llu failures\n", (unsigned long long)gNumberFailures);
+	return (gNumberFailures == 0) ? 0 : 1;
+}